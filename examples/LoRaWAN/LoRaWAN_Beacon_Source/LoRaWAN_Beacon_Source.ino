@@ -0,0 +1,91 @@
+/*
+  RadioLib LoRaWAN Beacon Source Example
+
+  This example simulates class B beacon of a LoRaWAN gateway,
+  so that class B devices can be tested without such gateway.
+  Every 128 seconds, it transmits the beacon frame with the current
+  GPS time on the EU-868 beacon channel. There is no GPS receiver,
+  so the time starts from an arbitrary value. A class B node
+  has to search for this beacon without DeviceTimeAns,
+  which may take up to a full beacon period.
+  Ping slot downlinks are not sent, only the beacon itself.
+
+  For default module settings, see the wiki page
+  https://github.com/jgromes/RadioLib/wiki/Default-configuration
+
+  For full API reference, see the GitHub Pages
+  https://jgromes.github.io/RadioLib/
+*/
+
+// include the library
+#include <RadioLib.h>
+
+// SX1278 has the following connections:
+// NSS pin:   10
+// DIO0 pin:  2
+// RESET pin: 9
+// DIO1 pin:  3
+SX1278 radio = new Module(10, 2, 9, 3);
+
+// GPS time of the next beacon, must be a multiple of 128 seconds
+uint32_t gpsTime = 1300000000UL - (1300000000UL % 128);
+
+// timestamp of the next beacon
+unsigned long nextBeacon = 0;
+
+void setup() {
+  Serial.begin(9600);
+
+  // initialize SX1278 for EU-868 beacon:
+  // carrier frequency:           869.525 MHz
+  // bandwidth:                   125.0 kHz
+  // spreading factor:            9
+  // coding rate:                 5
+  // sync word:                   0x34 (public LoRaWAN network)
+  // output power:                14 dBm
+  // preamble length:             10 symbols
+  Serial.print(F("[SX1278] Initializing ... "));
+  int state = radio.begin(869.525, 125.0, 9, 5, RADIOLIB_LORAWAN_LORA_SYNC_WORD, 14, 10);
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while(true);
+  }
+
+  // beacon has no header and no CRC,
+  // both parts of it are protected by their own CRC instead
+  uint8_t beacon[RADIOLIB_LORAWAN_BEACON_MAX_LEN];
+  size_t len = LoRaWANNode::buildBeacon(&EU868, gpsTime, NULL, beacon);
+  radio.implicitHeader(len);
+  radio.setCRC(false);
+
+  nextBeacon = millis();
+}
+
+void loop() {
+  // wait for the start of the beacon period
+  if((long)(millis() - nextBeacon) < 0) {
+    return;
+  }
+  nextBeacon += RADIOLIB_LORAWAN_BEACON_PERIOD_MS;
+
+  // the gateway-specific part can carry e.g. gateway location
+  // here, it is just left empty
+  uint8_t beacon[RADIOLIB_LORAWAN_BEACON_MAX_LEN];
+  size_t len = LoRaWANNode::buildBeacon(&EU868, gpsTime, NULL, beacon);
+
+  Serial.print(F("[SX1278] Transmitting beacon, GPS time "));
+  Serial.print(gpsTime);
+  Serial.print(F(" ... "));
+  int state = radio.transmit(beacon, len);
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+  }
+
+  gpsTime += RADIOLIB_LORAWAN_BEACON_PERIOD_S;
+}
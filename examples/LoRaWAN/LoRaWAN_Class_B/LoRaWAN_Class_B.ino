@@ -0,0 +1,188 @@
+/*
+  RadioLib LoRaWAN Class B Example
+
+  This example joins a LoRaWAN network and switches
+  to class B, so that the network can send downlinks
+  in periodic ping slots, not just after uplinks.
+  This keeps the downlink latency bounded, while the radio
+  only receives for a few milliseconds at a time.
+  The ping slots are synchronized to the beacon broadcast
+  by the gateways every 128 seconds. To find the beacon faster,
+  the node first asks the network for the current time.
+  Before you start, you will have to register your device
+  at https://www.thethingsnetwork.org/ as a class B device,
+  and the gateways in range have to transmit beacons.
+  For testing without such gateway, see LoRaWAN_Beacon_Source example.
+
+  NOTE: LoRaWAN requires storing some parameters persistently!
+        RadioLib does this by using EEPROM, by default
+        starting at address 0 and using 32 bytes.
+        If you already use EEPROM in your application,
+        you will have to either avoid this range, or change it
+        by setting a different start address by changing the value of
+        RADIOLIB_HAL_PERSISTENT_STORAGE_BASE macro, either
+        during build or in src/BuildOpt.h.
+
+  For default module settings, see the wiki page
+  https://github.com/jgromes/RadioLib/wiki/Default-configuration
+
+  For full API reference, see the GitHub Pages
+  https://jgromes.github.io/RadioLib/
+*/
+
+// include the library
+#include <RadioLib.h>
+
+// SX1278 has the following connections:
+// NSS pin:   10
+// DIO0 pin:  2
+// RESET pin: 9
+// DIO1 pin:  3
+SX1278 radio = new Module(10, 2, 9, 3);
+
+// create the node instance on the EU-868 band
+// using the radio module and the encryption key
+// make sure you are using the correct band
+// based on your geographical location!
+LoRaWANNode node(&radio, &EU868);
+
+// application identifier, device identifier and the keys
+// see LoRaWAN_End_Device example for details
+uint64_t joinEUI = 0x12AD1011B0C0FFEE;
+uint64_t devEUI = 0x70B3D57ED005E120;
+const char nwkKey[] = "topSecretKey1234";
+const char appKey[] = "aDifferentKeyABC";
+
+// flags set from the event callback
+volatile bool joined = false;
+volatile bool idle = false;
+volatile bool classB = false;
+
+// timestamp of the last uplink
+unsigned long lastUplink = 0;
+
+// this function is called by the node whenever
+// something happens in its state machine
+// IMPORTANT: this function MUST be 'void' type
+//            and MUST NOT have any arguments except those below!
+void onEvent(LoRaWANNode* n, uint8_t event) {
+  switch(event) {
+    case(RADIOLIB_LORAWAN_EVENT_JOINED):
+      Serial.println(F("[LoRaWAN] Joined!"));
+      joined = true;
+      idle = true;
+      break;
+    case(RADIOLIB_LORAWAN_EVENT_BEACON): {
+      // the beacon carries GPS time, ping slots are open from now on
+      uint32_t gpsTime = 0;
+      n->getBeacon(&gpsTime, NULL);
+      Serial.print(F("[LoRaWAN] Beacon, GPS time "));
+      Serial.println(gpsTime);
+    } break;
+    case(RADIOLIB_LORAWAN_EVENT_BEACON_LOST):
+      // the node is class A again, get the current time again and repeat the search
+      Serial.println(F("[LoRaWAN] Beacon lost!"));
+      classB = false;
+      lastUplink = 0;
+      break;
+    case(RADIOLIB_LORAWAN_EVENT_DOWNLINK): {
+      // this can be either the reply to the last uplink,
+      // or a downlink sent in a ping slot
+      uint8_t data[256];
+      size_t len = 0;
+      n->readDownlink(data, &len);
+      Serial.print(F("[LoRaWAN] Received downlink, length "));
+      Serial.println(len);
+      idle = true;
+    } break;
+    case(RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK):
+    case(RADIOLIB_LORAWAN_EVENT_ERROR):
+      // the join procedure will have to be repeated if it failed
+      idle = true;
+      break;
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  // initialize SX1278 with default settings
+  Serial.print(F("[SX1278] Initializing ... "));
+  int state = radio.begin();
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while(true);
+  }
+
+  // set the function that will be called
+  // when the node state machine raises an event
+  node.onEvent(onEvent);
+
+  // start the activation, the rest of it
+  // will be handled by calling poll() in the loop
+  Serial.print(F("[LoRaWAN] Starting over-the-air activation ... "));
+  state = node.startJoin(joinEUI, devEUI, (uint8_t*)nwkKey, (uint8_t*)appKey);
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while(true);
+  }
+}
+
+void loop() {
+  // let the node do its work, this never blocks
+  // in class B, this must be called every few milliseconds
+  // so that the beacon and ping slots are not missed
+  node.poll();
+
+  // wait until the previous transaction is finished
+  if(!idle) {
+    return;
+  }
+
+  // duty cycle limits may not allow transmitting yet
+  if(node.timeUntilUplink() > 0) {
+    return;
+  }
+
+  if(!joined) {
+    // join failed, try again
+    idle = false;
+    node.startJoin(joinEUI, devEUI, (uint8_t*)nwkKey, (uint8_t*)appKey);
+    return;
+  }
+
+  // send uplink to port 10 every 10 minutes
+  // until the node is class B, ask for the current time as well
+  if((lastUplink == 0) || (millis() - lastUplink >= 600000UL)) {
+    lastUplink = millis();
+    if(!classB) {
+      node.sendMacCommandReq(RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_REQ);
+    }
+    int state = node.startUplink((uint8_t*)"Hello!", 6, 10);
+    if(state == RADIOLIB_ERR_NONE) {
+      idle = false;
+      return;
+    } else {
+      Serial.print(F("[LoRaWAN] Uplink failed, code "));
+      Serial.println(state);
+    }
+  }
+
+  // switch to class B once the network sent the current time
+  // the beacon can then be found within a single beacon period
+  uint32_t gpsEpoch = 0;
+  uint8_t fraction = 0;
+  if(!classB && (node.getMacDeviceTimeAns(&gpsEpoch, &fraction) == RADIOLIB_ERR_NONE)) {
+    Serial.println(F("[LoRaWAN] Searching for beacon"));
+    node.setClass(RADIOLIB_LORAWAN_CLASS_B);
+    classB = true;
+  }
+
+  // the rest of the loop is free to do other things
+}
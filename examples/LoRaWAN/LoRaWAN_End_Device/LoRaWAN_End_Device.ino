@@ -123,6 +123,21 @@ void loop() {
     Serial.println(state);
   }
 
+  // uplink can also be sent as confirmed, i.e. the server has to acknowledge it
+  // it will be retransmitted automatically if the server requested that (NbTrans)
+  // and the outcome can be checked afterwards
+  /*
+    state = node.uplink(strUp, 10, true);
+    LoRaWANUplinkResult_t res = node.getUplinkResult();
+    Serial.print(F("[LoRaWAN] Acknowledged:\t"));
+    Serial.println(res.acked);
+    Serial.print(F("[LoRaWAN] Retries:\t"));
+    Serial.println(res.retries);
+    Serial.print(F("[LoRaWAN] Airtime:\t"));
+    Serial.print(res.airtime);
+    Serial.println(F(" ms"));
+  */
+
   // after uplink, you can call downlink(),
   // to receive any possible reply from the server
   // this function must be called within a few seconds
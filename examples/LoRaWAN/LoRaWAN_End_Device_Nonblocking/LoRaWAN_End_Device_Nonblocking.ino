@@ -0,0 +1,158 @@
+/*
+  RadioLib LoRaWAN End Device Non-blocking Example
+
+  This example joins a LoRaWAN network and will send
+  uplink packets without blocking the main loop.
+  Joining, transmission and the receive windows are all
+  handled by periodically calling poll(), and the application
+  is notified about their progress by callback.
+  Before you start, you will have to register your device
+  at https://www.thethingsnetwork.org/
+  After your device is registered, you can run this example.
+
+  NOTE: LoRaWAN requires storing some parameters persistently!
+        RadioLib does this by using EEPROM, by default
+        starting at address 0 and using 32 bytes.
+        If you already use EEPROM in your application,
+        you will have to either avoid this range, or change it
+        by setting a different start address by changing the value of
+        RADIOLIB_HAL_PERSISTENT_STORAGE_BASE macro, either
+        during build or in src/BuildOpt.h.
+
+  For default module settings, see the wiki page
+  https://github.com/jgromes/RadioLib/wiki/Default-configuration
+
+  For full API reference, see the GitHub Pages
+  https://jgromes.github.io/RadioLib/
+*/
+
+// include the library
+#include <RadioLib.h>
+
+// SX1278 has the following connections:
+// NSS pin:   10
+// DIO0 pin:  2
+// RESET pin: 9
+// DIO1 pin:  3
+SX1278 radio = new Module(10, 2, 9, 3);
+
+// create the node instance on the EU-868 band
+// using the radio module and the encryption key
+// make sure you are using the correct band
+// based on your geographical location!
+LoRaWANNode node(&radio, &EU868);
+
+// application identifier, device identifier and the keys
+// see LoRaWAN_End_Device example for details
+uint64_t joinEUI = 0x12AD1011B0C0FFEE;
+uint64_t devEUI = 0x70B3D57ED005E120;
+const char nwkKey[] = "topSecretKey1234";
+const char appKey[] = "aDifferentKeyABC";
+
+// flags set from the event callback
+volatile bool joined = false;
+volatile bool idle = false;
+
+// this function is called by the node whenever
+// something happens in its state machine
+// IMPORTANT: this function MUST be 'void' type
+//            and MUST NOT have any arguments except those below!
+void onEvent(LoRaWANNode* n, uint8_t event) {
+  switch(event) {
+    case(RADIOLIB_LORAWAN_EVENT_TX_DONE):
+      Serial.println(F("[LoRaWAN] Uplink sent"));
+      break;
+    case(RADIOLIB_LORAWAN_EVENT_JOINED):
+      Serial.println(F("[LoRaWAN] Joined!"));
+      joined = true;
+      idle = true;
+      break;
+    case(RADIOLIB_LORAWAN_EVENT_DOWNLINK): {
+      uint8_t data[256];
+      size_t len = 0;
+      n->readDownlink(data, &len);
+      Serial.print(F("[LoRaWAN] Received downlink, length "));
+      Serial.println(len);
+      idle = true;
+    } break;
+    case(RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK):
+    case(RADIOLIB_LORAWAN_EVENT_ERROR):
+      // the join procedure will have to be repeated if it failed
+      idle = true;
+      break;
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  // initialize SX1278 with default settings
+  Serial.print(F("[SX1278] Initializing ... "));
+  int state = radio.begin();
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while(true);
+  }
+
+  // set the function that will be called
+  // when the node state machine raises an event
+  node.onEvent(onEvent);
+
+  // start the activation, the rest of it
+  // will be handled by calling poll() in the loop
+  Serial.print(F("[LoRaWAN] Starting over-the-air activation ... "));
+  state = node.startJoin(joinEUI, devEUI, (uint8_t*)nwkKey, (uint8_t*)appKey);
+  if(state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while(true);
+  }
+}
+
+// counter to keep track of transmitted packets
+int count = 0;
+
+// timestamp of the last uplink
+unsigned long lastUplink = 0;
+
+void loop() {
+  // let the node do its work, this never blocks
+  node.poll();
+
+  // wait until the previous transaction is finished
+  if(!idle) {
+    return;
+  }
+
+  // duty cycle limits may not allow transmitting yet
+  if(node.timeUntilUplink() > 0) {
+    return;
+  }
+
+  if(!joined) {
+    // join failed, try again
+    idle = false;
+    node.startJoin(joinEUI, devEUI, (uint8_t*)nwkKey, (uint8_t*)appKey);
+    return;
+  }
+
+  // send uplink to port 10 every 10 seconds
+  if(millis() - lastUplink >= 10000) {
+    lastUplink = millis();
+    String strUp = "Hello World! #" + String(count++);
+    int state = node.startUplink((uint8_t*)strUp.c_str(), strUp.length(), 10);
+    if(state == RADIOLIB_ERR_NONE) {
+      idle = false;
+    } else {
+      Serial.print(F("[LoRaWAN] Uplink failed, code "));
+      Serial.println(state);
+    }
+  }
+
+  // the rest of the loop is free to do other things
+}
@@ -0,0 +1,156 @@
+/*
+   RadioLib SX128x Ranging Session Example
+
+   This example measures distance to several SX1280 slaves
+   without blocking. Each slave is ranged multiple times
+   back-to-back, hopping over a list of channels, and
+   the median, mean and variance of the results are reported.
+   Exchanges are restarted directly from the interrupt service,
+   so the measurement rate is limited only by the radio.
+
+   Only SX1280 and SX1282 without external RF switch support ranging!
+
+   Each slave has to run a session in slave mode with its own address,
+   the same channel list and the same number of exchanges.
+   The channel changes after every exchange of the session, so the slaves
+   also follow the master during exchanges with the other slaves.
+   Note that to get accurate ranging results, calibration is needed!
+   The process is described in Semtech SX1280 Application Note AN1200.29
+
+   For default module settings, see the wiki page
+   https://github.com/jgromes/RadioLib/wiki/Default-configuration#sx128x---lora-modem
+
+   For full API reference, see the GitHub Pages
+   https://jgromes.github.io/RadioLib/
+*/
+
+// include the library
+#include <RadioLib.h>
+
+// SX1280 has the following connections:
+// NSS pin:   10
+// DIO1 pin:  2
+// NRST pin:  3
+// BUSY pin:  9
+SX1280 radio = new Module(10, 2, 3, 9);
+
+// or using RadioShield
+// https://github.com/jgromes/RadioShield
+//SX1280 radio = RadioShield.ModuleA;
+
+// addresses of the slaves
+uint32_t addrs[] = { 0x12345678, 0x12345679 };
+#define NUM_SLAVES (sizeof(addrs) / sizeof(addrs[0]))
+
+// channels to hop over, one channel per exchange
+float freqs[] = { 2402.0, 2426.0, 2450.0, 2474.0 };
+#define NUM_FREQS (sizeof(freqs) / sizeof(freqs[0]))
+
+// number of exchanges with each slave
+#define NUM_EXCHANGES 16
+
+// slaves move to the next channel when no request arrives
+// for 100 ms (in units of 15.625 us), this has to be
+// a bit longer than the interval between exchanges of the master
+#define SLAVE_TIMEOUT 6400
+
+// results for each slave
+SX1280RangingStats_t stats[NUM_SLAVES];
+
+// distances of the slave that is being ranged, used for the median
+float samples[NUM_EXCHANGES];
+
+// flag to indicate that an exchange was finished
+volatile bool rangingFlag = false;
+
+// this function is called when an exchange is finished
+// IMPORTANT: this function MUST be 'void' type
+//            and MUST NOT have any arguments!
+#if defined(ESP8266) || defined(ESP32)
+  ICACHE_RAM_ATTR
+#endif
+void setFlag(void) {
+  rangingFlag = true;
+}
+
+void startSession() {
+  Serial.print(F("[SX1280] Starting ranging session ... "));
+  int state = radio.startRangingSession(true, addrs, NUM_SLAVES, stats, samples, NUM_EXCHANGES, freqs, NUM_FREQS);
+
+  // the slave would start its session like this
+  /*
+    int state = radio.startRangingSession(false, &addrs[0], 1, stats, NULL, NUM_EXCHANGES, freqs, NUM_FREQS, SLAVE_TIMEOUT);
+  */
+
+  if (state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while (true);
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+
+  // initialize SX1280 with default settings
+  Serial.print(F("[SX1280] Initializing ... "));
+  int state = radio.begin();
+  if (state == RADIOLIB_ERR_NONE) {
+    Serial.println(F("success!"));
+  } else {
+    Serial.print(F("failed, code "));
+    Serial.println(state);
+    while (true);
+  }
+
+  // set the function that will be called
+  // when an exchange is finished
+  radio.setDio1Action(setFlag);
+
+  startSession();
+}
+
+void loop() {
+  // check if an exchange was finished
+  if (!rangingFlag) {
+    return;
+  }
+  rangingFlag = false;
+
+  // process the result and start the next exchange
+  if (!radio.serviceRanging()) {
+    return;
+  }
+
+  // the session is finished, print the results
+  for (size_t i = 0; i < NUM_SLAVES; i++) {
+    Serial.print(F("[SX1280] Slave 0x"));
+    Serial.print(stats[i].addr, HEX);
+    Serial.print(F(": "));
+    Serial.print(stats[i].valid);
+    Serial.print(F(" valid, "));
+    Serial.print(stats[i].timeouts);
+    Serial.println(F(" timed out"));
+    if (stats[i].valid == 0) {
+      continue;
+    }
+    Serial.print(F("[SX1280] Median:\t\t\t"));
+    Serial.print(stats[i].median);
+    Serial.println(F(" meters (raw)"));
+    Serial.print(F("[SX1280] Mean:\t\t\t"));
+    Serial.print(stats[i].mean);
+    Serial.println(F(" meters (raw)"));
+    Serial.print(F("[SX1280] Variance:\t\t\t"));
+    Serial.print(stats[i].variance);
+    Serial.println(F(" m^2"));
+    Serial.print(F("[SX1280] RSSI:\t\t\t"));
+    Serial.print(stats[i].rssi);
+    Serial.println(F(" dBm"));
+  }
+
+  // wait for a second before the next session
+  delay(1000);
+  startSession();
+}
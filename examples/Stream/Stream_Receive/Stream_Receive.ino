@@ -2,17 +2,21 @@
    RadioLib Stream Receive Example
 
    This example shows how to receive data in "Stream" mode.
-   In this mode, arbitrary length of data may be sent, up to
-   "infinite" continuous transmission between two devices.
+   In this mode, packets much longer than the radio FIFO
+   can be received. The payload is passed to a callback
+   in chunks, whenever there is enough data in FIFO.
 
    Caveats:
-    - CRC of the payload is not supported
     - the length of the payload must be known in advance
+    - CRC of the payload is only supported up to a certain length
+      (2047 bytes for SX127x, 255 bytes for RF69/SX1231)
 
    Modules that can be used for Stream are:
     - SX127x/RFM9x (FSK mode only)
     - RF69
     - SX1231
+    - CC1101
+    - Si443x/RFM2x (up to 255 bytes)
 
    For default module settings, see the wiki page
    https://github.com/jgromes/RadioLib/wiki/Default-configuration#sx127xrfm9x---lora-modem
@@ -35,6 +39,22 @@ SX1278 radio = new Module(10, 2, 9, 3);
 // https://github.com/jgromes/RadioShield
 //SX1278 radio = RadioShield.ModuleA;
 
+// how many bytes are there in total
+const size_t totalLength = 512;
+
+// counter to keep track of how many bytes have been received so far
+size_t receivedLength = 0;
+
+// buffer to save the received data into
+uint8_t rxBuffer[totalLength + 1];
+
+// this function is called whenever there is enough data
+// in the radio receive buffer, 'len' bytes of it are in 'data'
+void fifoGet(uint8_t* data, size_t len) {
+  memcpy(&rxBuffer[receivedLength], data, len);
+  receivedLength += len;
+}
+
 void setup() {
   Serial.begin(9600);
 
@@ -54,16 +74,9 @@ void setup() {
     while (true);
   }
 
-  // set the function that will be called
-  // when receive buffer is full
-  radio.setFifoFullAction(fifoGet);
-
-  // fixed packet length mode is required
-  radio.fixedPacketLengthMode(0);
-
   // start listening for packets
   Serial.print(F("[SX1278] Starting to listen ... "));
-  state = radio.startReceive();
+  state = radio.startReceiveStream(totalLength, fifoGet);
   if (state == RADIOLIB_ERR_NONE) {
     Serial.println(F("success!"));
   } else {
@@ -83,45 +96,33 @@ void setup() {
   // radio.scanChannel();
 }
 
-// flag to indicate that a packet was received
-volatile bool receivedFlag = false;
-
-// how many bytes are there in total
-const int totalLength = 512;
-
-// counter to keep track of how many bytes have been received so far
-volatile int receivedLength = 0;
-
-// buffer to save the received data into
-volatile uint8_t rxBuffer[totalLength + 1];
-
-// this function is called when the radio receive buffer
-// is full and ready to be read
-// IMPORTANT: this function MUST be 'void' type
-//            and MUST NOT have any arguments!
-#if defined(ESP8266) || defined(ESP32)
-  ICACHE_RAM_ATTR
-#endif
-void fifoGet(void) {
-  // set the flag when we receive the full packet
-  receivedFlag = radio.fifoGet(rxBuffer, totalLength, &receivedLength);
-}
-
 void loop() {
-  // check if the flag is set
-  if(receivedFlag) {
-    // packet was successfully received
-    Serial.println(F("[SX1278] Received packet!"));
-
-    // print data of the packet
-    Serial.print(F("[SX1278] Data:\t\t"));
-    Serial.println((char*)rxBuffer);
-      
-    // reset flag
-    receivedFlag = false;
-    receivedLength = 0;
-    
+  // keep emptying the receive buffer, this has to be called
+  // often enough so that the radio never runs out of space
+  int16_t state = radio.serviceStream();
+  if(state != RADIOLIB_STREAM_IN_PROGRESS) {
+    if (state == RADIOLIB_ERR_NONE) {
+      // packet was successfully received
+      Serial.println(F("[SX1278] Received packet!"));
+
+      // print data of the packet
+      rxBuffer[receivedLength] = 0;
+      Serial.print(F("[SX1278] Data:\t\t"));
+      Serial.println((char*)rxBuffer);
+
+    } else if (state == RADIOLIB_ERR_CRC_MISMATCH) {
+      // packet was received, but is malformed
+      Serial.println(F("[SX1278] CRC error!"));
+
+    } else {
+      // some other error occurred
+      Serial.print(F("[SX1278] Failed, code "));
+      Serial.println(state);
+
+    }
+
     // put module back to listen mode
-    radio.startReceive();
+    receivedLength = 0;
+    radio.startReceiveStream(totalLength, fifoGet);
   }
 }
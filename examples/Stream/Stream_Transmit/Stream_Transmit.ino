@@ -2,17 +2,21 @@
    RadioLib Stream Transmit Example
 
    This example shows how to transmit data in "Stream" mode.
-   In this mode, arbitrary length of data may be sent, up to
-   "infinite" continuous transmission between two devices.
+   In this mode, packets much longer than the radio FIFO
+   can be sent. The payload is requested from a callback
+   in chunks, whenever there is enough space in FIFO.
 
    Caveats:
-    - CRC of the payload is not supported
     - the length of the payload must be known in advance
+    - CRC of the payload is only supported up to a certain length
+      (2047 bytes for SX127x, 255 bytes for RF69/SX1231)
 
    Modules that can be used for Stream are:
     - SX127x/RFM9x (FSK mode only)
     - RF69
     - SX1231
+    - CC1101
+    - Si443x/RFM2x (up to 255 bytes)
 
    For default module settings, see the wiki page
    https://github.com/jgromes/RadioLib/wiki/Default-configuration#sx127xrfm9x---lora-modem
@@ -49,6 +53,18 @@ String longPacket = "Lorem ipsum dolor sit amet, consectetur adipiscing elit.\
  venenatis arcu sit amet pellentesque. Nulla posuere sit amet turpis\
  id pharetra. Curabitur nec.";
 
+// counter to keep track of how many bytes were already given to the radio
+size_t sentLength = 0;
+
+// this function is called whenever there is space in the radio
+// transmit buffer, it has to copy at most 'len' bytes to 'data'
+// and return the number of bytes it actually copied
+size_t fifoAdd(uint8_t* data, size_t len) {
+  memcpy(data, longPacket.c_str() + sentLength, len);
+  sentLength += len;
+  return(len);
+}
+
 void setup() {
   Serial.begin(9600);
 
@@ -68,59 +84,19 @@ void setup() {
     while (true);
   }
 
-  // set the function that will be called
-  // when transmit buffer is empty
-  radio.setFifoEmptyAction(fifoAdd);
-
-  // fixed packet length mode is required
-  radio.fixedPacketLengthMode(0);
-
   // start transmitting the long packet
   Serial.print(F("[SX1278] Sending a very long packet ... "));
-  transmissionState = radio.startTransmit(longPacket);
-}
-
-// flag to indicate we can keep adding more bytes to FIFO
-volatile bool fifoEmpty = false;
-
-// flag to indicate that a packet was sent
-bool transmittedFlag = false;
-
-// how many bytes are there in total
-int totalLength = longPacket.length();
-
-// counter to keep track of how many bytes still need to be sent
-int remLength = totalLength;
-
-// this function is called when the radio transmit buffer
-// is empty and ready to be refilled
-// IMPORTANT: this function MUST be 'void' type
-//            and MUST NOT have any arguments!
-#if defined(ESP8266) || defined(ESP32)
-  ICACHE_RAM_ATTR
-#endif
-void fifoAdd(void) {
-  // we can send more bytes
-  fifoEmpty = true;
+  transmissionState = radio.startTransmitStream(longPacket.length(), fifoAdd);
 }
 
 void loop() {
-  if(fifoEmpty) {
-    // reset flag
-    fifoEmpty = false;
-
-    // add more bytes to the transmit buffer
-    uint8_t* txBuffPtr = (uint8_t*)longPacket.c_str();
-    transmittedFlag = radio.fifoAdd(txBuffPtr, totalLength, &remLength);
-  }
-
-  // check if the previous transmission finished
-  if(transmittedFlag) {
-    // reset flag
-    transmittedFlag = false;
-
-    // reset the counter
-    remLength = totalLength;
+  // keep refilling the transmit buffer, this has to be called
+  // often enough so that the radio never runs out of data
+  int16_t state = radio.serviceStream();
+  if(state != RADIOLIB_STREAM_IN_PROGRESS) {
+    if(transmissionState == RADIOLIB_ERR_NONE) {
+      transmissionState = state;
+    }
 
     if (transmissionState == RADIOLIB_ERR_NONE) {
       // packet was successfully sent
@@ -136,16 +112,17 @@ void loop() {
 
     }
 
-    // NOTE: in FSK mode, SX127x will not automatically
-    //       turn transmitter off after sending a packet
-    //       set mode to standby to ensure we don't jam others
-    radio.standby();
+    // clean up after transmission is finished
+    // this will ensure transmitter is disabled,
+    // RF switch is powered down etc.
+    radio.finishTransmit();
 
     // wait a second before transmitting again
     delay(1000);
 
     // send another one
     Serial.print(F("[SX1278] Sending another long packet ... "));
-    transmissionState = radio.startTransmit(longPacket);
+    sentLength = 0;
+    transmissionState = radio.startTransmitStream(longPacket.length(), fifoAdd);
   }
 }
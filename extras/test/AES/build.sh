@@ -0,0 +1,8 @@
+#!/bin/bash
+
+set -e
+mkdir -p build
+cd build
+cmake -G "CodeBlocks - Unix Makefiles" ..
+make -j4
+cd ..
@@ -0,0 +1,185 @@
+// this is a host test of the AES-128 implementation
+// checks the block cipher, CMAC and CTR mode against published known-answer tests:
+// FIPS-197 appendix C.1, RFC 4493 section 4 and NIST SP 800-38A F.5.1,
+// both with a RadioLibAES128 object and with a compact expanded key
+// then measures the time per block of each mode, in CPU cycles where the timestamp counter is available
+
+#define RADIOLIB_TEST_NAME "AES"
+#include "../TestHal.h"
+
+#include <string.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+#endif
+
+// number of blocks per benchmark call
+#define BENCH_BLOCKS        (64)
+
+// FIPS-197 appendix C.1
+uint8_t fipsKey[] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+uint8_t fipsPlain[] = {
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+uint8_t fipsCipher[] = {
+  0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+// key and message shared by RFC 4493 and SP 800-38A
+uint8_t key[] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+uint8_t msg[] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10
+};
+
+// RFC 4493 section 4, examples 1 - 4
+const size_t cmacLens[] = { 0, 16, 40, 64 };
+uint8_t cmacs[][16] = {
+  { 0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46 },
+  { 0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c },
+  { 0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27 },
+  { 0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe }
+};
+
+// SP 800-38A F.5.1, CTR-AES128.Encrypt
+uint8_t ctrInit[] = {
+  0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+};
+uint8_t ctrCipher[] = {
+  0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+  0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+  0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+  0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee
+};
+
+// measure the time per block of an operation over BENCH_BLOCKS blocks, in ns and cycles
+template<typename F> void benchmark(const char* name, F func) {
+  size_t total = 0;
+  double elapsed = 0;
+  uint64_t cycles = 0;
+  auto start = std::chrono::steady_clock::now();
+  while(elapsed < 0.2) {
+    #if defined(__x86_64__) || defined(__i386__)
+    uint64_t tsc = __rdtsc();
+    func();
+    cycles += __rdtsc() - tsc;
+    #else
+    func();
+    #endif
+    total += BENCH_BLOCKS;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  printf("  %-12s %8.1f ns/block", name, elapsed * 1e9 / total);
+  if(cycles) {
+    printf(" %8.1f cycles/block", (double)cycles / total);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  RadioLibAES128 aes;
+  uint8_t out[sizeof(msg)];
+  uint8_t mac[RADIOLIB_AES128_BLOCK_SIZE];
+
+  // block cipher, switching keys in between to check the round keys are regenerated
+  aes.init(fipsKey);
+  RADIOLIB_TEST_ASSERT(aes.encryptECB(fipsPlain, 16, out) == 16, "ECB length");
+  RADIOLIB_TEST_ASSERT(memcmp(out, fipsCipher, 16) == 0, "ECB encrypt");
+  aes.decryptECB(fipsCipher, 16, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, fipsPlain, 16) == 0, "ECB decrypt");
+  aes.init(key);
+  aes.decryptECB(fipsCipher, 16, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, fipsPlain, 16) != 0, "ECB decrypt with other key");
+  aes.init(fipsKey);
+  aes.decryptECB(fipsCipher, 16, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, fipsPlain, 16) == 0, "ECB decrypt after key change");
+  printf("[AES] Test:ECB passed\n");
+
+  // CMAC, both in one call and split into chunks of every size
+  aes.init(key);
+  for(size_t i = 0; i < sizeof(cmacLens) / sizeof(cmacLens[0]); i++) {
+    aes.generateCMAC(msg, cmacLens[i], mac);
+    RADIOLIB_TEST_ASSERT(memcmp(mac, cmacs[i], 16) == 0, "CMAC");
+    RADIOLIB_TEST_ASSERT(aes.verifyCMAC(msg, cmacLens[i], cmacs[i]), "CMAC verify");
+    for(size_t chunk = 1; chunk <= cmacLens[i]; chunk++) {
+      aes.cmacInit();
+      for(size_t pos = 0; pos < cmacLens[i]; pos += chunk) {
+        aes.cmacUpdate(&msg[pos], (cmacLens[i] - pos) < chunk ? (cmacLens[i] - pos) : chunk);
+      }
+      aes.cmacFinal(mac);
+      RADIOLIB_TEST_ASSERT(memcmp(mac, cmacs[i], 16) == 0, "CMAC incremental");
+    }
+  }
+  mac[0] ^= 0x01;
+  RADIOLIB_TEST_ASSERT(!aes.verifyCMAC(msg, 16, mac), "CMAC reject");
+  printf("[AES] Test:CMAC passed\n");
+
+  // CTR in one call, then as a continued keystream over odd-sized pieces, then in place
+  uint8_t ctr[RADIOLIB_AES128_BLOCK_SIZE];
+  memcpy(ctr, ctrInit, sizeof(ctr));
+  RADIOLIB_TEST_ASSERT(aes.encryptCTR(msg, sizeof(msg), ctr, out) == sizeof(msg), "CTR length");
+  RADIOLIB_TEST_ASSERT(memcmp(out, ctrCipher, sizeof(msg)) == 0, "CTR encrypt");
+  RADIOLIB_TEST_ASSERT(ctr[15] == 0x03 && ctr[14] == 0xff && ctr[13] == 0xfd, "CTR counter carry");
+  memcpy(ctr, ctrInit, sizeof(ctr));
+  aes.encryptCTR(msg, 32, ctr, out);
+  aes.encryptCTR(&msg[32], 32, ctr, &out[32]);
+  RADIOLIB_TEST_ASSERT(memcmp(out, ctrCipher, sizeof(msg)) == 0, "CTR continued");
+  memcpy(out, ctrCipher, sizeof(msg));
+  memcpy(ctr, ctrInit, sizeof(ctr));
+  aes.encryptCTR(out, 23, ctr, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, msg, 23) == 0, "CTR decrypt in place");
+  printf("[AES] Test:CTR passed\n");
+
+  // the same operations with a compact expanded key, which must be much smaller than the whole object
+  RadioLibAES128Key_t ctx;
+  RADIOLIB_TEST_ASSERT(sizeof(ctx) < sizeof(aes), "key context size");
+  RadioLibAES128::initKey(&ctx, fipsKey);
+  RadioLibAES128::encryptECB(&ctx, fipsPlain, 16, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, fipsCipher, 16) == 0, "key context ECB");
+  RadioLibAES128::initKey(&ctx, key);
+  for(size_t i = 0; i < sizeof(cmacLens) / sizeof(cmacLens[0]); i++) {
+    RadioLibAES128::generateCMAC(&ctx, msg, cmacLens[i], mac);
+    RADIOLIB_TEST_ASSERT(memcmp(mac, cmacs[i], 16) == 0, "key context CMAC");
+  }
+  for(size_t len = 0; len <= sizeof(msg); len++) {
+    uint8_t ref[RADIOLIB_AES128_BLOCK_SIZE];
+    aes.generateCMAC(msg, len, ref);
+    RadioLibAES128::generateCMAC(&ctx, msg, len, mac);
+    RADIOLIB_TEST_ASSERT(memcmp(mac, ref, 16) == 0, "key context CMAC length");
+  }
+  memcpy(ctr, ctrInit, sizeof(ctr));
+  RadioLibAES128::encryptCTR(&ctx, msg, sizeof(msg), ctr, out);
+  RADIOLIB_TEST_ASSERT(memcmp(out, ctrCipher, sizeof(msg)) == 0, "key context CTR");
+  printf("[AES] Test:key context passed (%lu bytes per key)\n", (unsigned long)sizeof(ctx));
+
+  // timing, the key schedule is counted as one block
+  static uint8_t buff[BENCH_BLOCKS*RADIOLIB_AES128_BLOCK_SIZE];
+  for(size_t i = 0; i < sizeof(buff); i++) {
+    buff[i] = rand();
+  }
+  #if defined(RADIOLIB_AES128_T_TABLES)
+  printf("[AES] Timing with T-tables:\n");
+  #else
+  printf("[AES] Timing:\n");
+  #endif
+  benchmark("key schedule", [&]() {
+    for(size_t i = 0; i < BENCH_BLOCKS; i++) {
+      aes.init(&buff[i*RADIOLIB_AES128_BLOCK_SIZE]);
+    }
+  });
+  aes.init(key);
+  benchmark("ECB encrypt", [&]() { aes.encryptECB(buff, sizeof(buff), buff); });
+  benchmark("ECB decrypt", [&]() { aes.decryptECB(buff, sizeof(buff), buff); });
+  benchmark("CTR", [&]() { aes.encryptCTR(buff, sizeof(buff), ctr, buff); });
+  benchmark("CMAC", [&]() { aes.generateCMAC(buff, sizeof(buff), mac); });
+
+  return(0);
+}
@@ -0,0 +1,82 @@
+// this is a host test of the BCH(31, 21) decoder used by POCSAG
+// checks the encoder against known POCSAG code words, then corrects all 1- and 2-bit errors
+// and detects all 3-bit errors in them, and measures the decoding throughput
+
+#define RADIOLIB_TEST_NAME "BCH"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <chrono>
+
+// valid POCSAG code words: frame synchronization, idle and all-zero
+const uint32_t vectors[] = { 0x7CD215D8, 0x7A89C197, 0x00000000 };
+
+// number of code words used for throughput measurement
+#define BENCH_LEN           (1024)
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  RadioLibBCH bch;
+  bch.begin(RADIOLIB_PAGER_BCH_N, RADIOLIB_PAGER_BCH_K, RADIOLIB_PAGER_BCH_PRIMITIVE_POLY);
+
+  // the encoder must reproduce known code words from their data bits
+  for(uint32_t cw : vectors) {
+    RADIOLIB_TEST_ASSERT(bch.encode(cw & 0xFFFFF800) == cw, "encode vector");
+    uint32_t dec = cw;
+    RADIOLIB_TEST_ASSERT((bch.decode(&dec) == 0) && (dec == cw), "decode error-free vector");
+  }
+  printf("[BCH] Test:vectors passed\n");
+
+  // all error patterns with up to 3 bits in the vectors and random code words
+  srand(1);
+  uint32_t corrected = 0;
+  uint32_t detected = 0;
+  for(int n = 0; n < 100; n++) {
+    uint32_t cw = (n < 3) ? vectors[n] : bch.encode(((uint32_t)rand() << 16) ^ rand());
+    for(uint8_t i = 0; i < 32; i++) {
+      for(uint8_t j = i; j < 32; j++) {
+        for(uint8_t k = j; k < 32; k++) {
+          uint32_t err = ((uint32_t)1 << i) | ((uint32_t)1 << j) | ((uint32_t)1 << k);
+          uint8_t numErrors = 1 + (j != i) + ((k != j) && (k != i));
+          uint32_t dec = cw ^ err;
+          int16_t res = bch.decode(&dec);
+          if(numErrors <= 2) {
+            RADIOLIB_TEST_ASSERT((res == numErrors) && (dec == cw), "correct error");
+            corrected++;
+          } else {
+            RADIOLIB_TEST_ASSERT((res == RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD) && (dec == (cw ^ err)), "detect error");
+            detected++;
+          }
+        }
+      }
+    }
+  }
+  printf("[BCH] Test:error patterns passed (%lu corrected, %lu detected)\n", (unsigned long)corrected, (unsigned long)detected);
+
+  // throughput with a mix of error-free, 1-bit and 2-bit errors
+  static uint32_t words[BENCH_LEN];
+  for(size_t i = 0; i < BENCH_LEN; i++) {
+    words[i] = bch.encode(((uint32_t)rand() << 16) ^ rand());
+    if(i % 3 >= 1) {
+      words[i] ^= (uint32_t)1 << (rand() % 32);
+    }
+    if(i % 3 == 2) {
+      words[i] ^= (uint32_t)1 << (rand() % 32);
+    }
+  }
+  size_t total = 0;
+  double elapsed = 0;
+  auto start = std::chrono::steady_clock::now();
+  while(elapsed < 0.2) {
+    for(size_t i = 0; i < BENCH_LEN; i++) {
+      uint32_t dec = words[i];
+      bch.decode(&dec);
+    }
+    total += BENCH_LEN;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  printf("[BCH] Decoding throughput %.2f M code words/s\n", total / elapsed / 1e6);
+
+  return(0);
+}
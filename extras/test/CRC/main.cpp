@@ -0,0 +1,168 @@
+// this is a host test of the CRC engine
+// checks known-answer vectors, compares table-driven RadioLibCRC and RadioLibCRCDescriptor
+// against the original bit-serial implementation, checks sharing of the lookup tables between instances,
+// and measures their throughput
+
+#define RADIOLIB_TEST_NAME "CRC"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <chrono>
+
+// size of the buffer used for throughput measurement
+#define BENCH_LEN           (4096)
+
+// the original bit-serial implementation, used as reference
+uint32_t crcBitSerial(uint8_t size, uint32_t poly, uint32_t init, uint32_t out, bool refIn, bool refOut, const uint8_t* buff, size_t len) {
+  uint32_t crc = init;
+  size_t pos = 0;
+  for(size_t i = 0; i < 8*len; i++) {
+    if(i % 8 == 0) {
+      uint32_t in = buff[pos++];
+      if(refIn) {
+        in = Module::reflect(in, 8);
+      }
+      crc ^= (in << (size - 8));
+    }
+
+    if(crc & ((uint32_t)1 << (size - 1))) {
+      crc <<= (uint32_t)1;
+      crc ^= poly;
+    } else {
+      crc <<= (uint32_t)1;
+    }
+  }
+
+  crc ^= out;
+  if(refOut) {
+    crc = Module::reflect(crc, size);
+  }
+  crc &= (uint32_t)0xFFFFFFFF >> (32 - size);
+  return(crc);
+}
+
+// CRC-32 as used by e.g. Ethernet
+typedef RadioLibCRCDescriptor<32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true> CRC32;
+
+// CRC-8 and reflected CRC-16 (Kermit), to check the narrow table entries
+typedef RadioLibCRCDescriptor<8, 0x07, 0x00, 0x00, false, false> CRC8;
+typedef RadioLibCRCDescriptor<16, 0x1021, 0x0000, 0x0000, true, true> CRC16Kermit;
+
+// measure throughput of a checksum function in MB/s
+template<typename F> double throughput(F func) {
+  static uint8_t buff[BENCH_LEN];
+  for(size_t i = 0; i < BENCH_LEN; i++) {
+    buff[i] = rand();
+  }
+  volatile uint32_t sink = 0;
+  size_t total = 0;
+  auto start = std::chrono::steady_clock::now();
+  double elapsed = 0;
+  while(elapsed < 0.2) {
+    sink = sink + func(buff, BENCH_LEN);
+    total += BENCH_LEN;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  return(total / elapsed / 1e6);
+}
+
+// known-answer tests from the CRC catalogue
+int testKAT() {
+  const uint8_t check[] = "123456789";
+
+  // the lookup tables are shared, so instances are small even in static-only mode
+  RADIOLIB_TEST_ASSERT(sizeof(RadioLibCRC) <= 32, "instance size");
+
+  // more configurations than there are shared tables,
+  // the ones that do not get a table are calculated bit-by-bit
+  RadioLibCRC crc32(32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true);
+  RadioLibCRC ccitt(16, RADIOLIB_CRC_CCITT_POLY, RADIOLIB_CRC_CCITT_INIT, RADIOLIB_CRC_CCITT_OUT, false, false);
+  RadioLibCRC crc8(8, 0x07, 0x00, 0x00, false, false);
+  RadioLibCRC crc32Other(32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true);
+  RADIOLIB_TEST_ASSERT(crc32.checksum((uint8_t*)check, 9) == 0xCBF43926, "CRC-32 KAT");
+  RADIOLIB_TEST_ASSERT(crc32Other.checksum((uint8_t*)check, 9) == 0xCBF43926, "CRC-32 shared table KAT");
+  RADIOLIB_TEST_ASSERT(CRC32::checksum(check, 9) == 0xCBF43926, "CRC-32 descriptor KAT");
+  RADIOLIB_TEST_ASSERT(ccitt.checksum((uint8_t*)check, 9) == 0xD64E, "CCITT-16 KAT");
+  RADIOLIB_TEST_ASSERT(RadioLibCRCCCITT::checksum(check, 9) == 0xD64E, "CCITT-16 descriptor KAT");
+  RADIOLIB_TEST_ASSERT(crc8.checksum((uint8_t*)check, 9) == 0xF4, "CRC-8 KAT");
+
+  // changing configuration releases the table, so the next configuration can use it
+  crc32.size = 8;
+  crc32.poly = 0x07;
+  crc32.init = 0x00;
+  crc32.out = 0x00;
+  crc32.refIn = false;
+  crc32.refOut = false;
+  RADIOLIB_TEST_ASSERT(crc32.checksum((uint8_t*)check, 9) == 0xF4, "reconfigured KAT");
+  RADIOLIB_TEST_ASSERT(crc32Other.checksum((uint8_t*)check, 9) == 0xCBF43926, "CRC-32 after reconfiguration KAT");
+  RADIOLIB_TEST_ASSERT(ccitt.checksum((uint8_t*)check, 9) == 0xD64E, "CCITT-16 after reconfiguration KAT");
+  RADIOLIB_TEST_ASSERT(CRC8::checksum(check, 9) == 0xF4, "CRC-8 descriptor KAT");
+  RADIOLIB_TEST_ASSERT(sizeof(CRC8::table) == 256, "CRC-8 descriptor table size");
+  RADIOLIB_TEST_ASSERT(CRC16Kermit::checksum(check, 9) == 0x2189, "CRC-16/KERMIT descriptor KAT");
+  RADIOLIB_TEST_ASSERT(sizeof(CRC16Kermit::table) == 512, "CRC-16 descriptor table size");
+  printf("[CRC] Test:KAT passed\n");
+  return(0);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  if(testKAT()) {
+    return(1);
+  }
+
+  // random configurations and lengths against the reference, including incremental updates
+  srand(1);
+  for(int n = 0; n < 20000; n++) {
+    uint8_t size = 8 + rand() % 25;
+    uint32_t mask = (uint32_t)0xFFFFFFFF >> (32 - size);
+    uint32_t poly = (((uint32_t)rand() << 16) ^ rand()) & mask;
+    uint32_t init = (((uint32_t)rand() << 16) ^ rand()) & mask;
+    uint32_t out = (((uint32_t)rand() << 16) ^ rand()) & mask;
+    bool refIn = rand() & 1;
+    bool refOut = rand() & 1;
+    uint8_t buff[64];
+    size_t len = rand() % sizeof(buff);
+    for(size_t i = 0; i < len; i++) {
+      buff[i] = rand();
+    }
+
+    // every other configuration finds the tables taken, unless there are more of them
+    RadioLibCRC other(16, RADIOLIB_CRC_CCITT_POLY, RADIOLIB_CRC_CCITT_INIT, RADIOLIB_CRC_CCITT_OUT, false, false);
+    if(n % 2) {
+      other.reset();
+    }
+
+    RadioLibCRC crc(size, poly, init, out, refIn, refOut);
+    uint32_t expected = crcBitSerial(size, poly, init, out, refIn, refOut, buff, len);
+    RADIOLIB_TEST_ASSERT(crc.checksum(buff, len) == expected, "random configuration");
+
+    size_t split = len ? rand() % len : 0;
+    crc.reset();
+    crc.update(buff, split);
+    crc.update(&buff[split], len - split);
+    RADIOLIB_TEST_ASSERT(crc.finalize() == expected, "incremental update");
+  }
+  printf("[CRC] Test:random configurations passed\n");
+
+  // throughput
+  printf("[CRC] Throughput with %d table slices:\n", RADIOLIB_CRC_TABLE_SLICES);
+  printf("  CCITT-16 bit-serial  %8.1f MB/s\n", throughput([](const uint8_t* b, size_t l) {
+    return(crcBitSerial(16, RADIOLIB_CRC_CCITT_POLY, RADIOLIB_CRC_CCITT_INIT, RADIOLIB_CRC_CCITT_OUT, false, false, b, l)); }));
+  RadioLibCRC ccitt(16, RADIOLIB_CRC_CCITT_POLY, RADIOLIB_CRC_CCITT_INIT, RADIOLIB_CRC_CCITT_OUT, false, false);
+  printf("  CCITT-16 RadioLibCRC %8.1f MB/s\n", throughput([&](const uint8_t* b, size_t l) { return(ccitt.checksum((uint8_t*)b, l)); }));
+  printf("  CCITT-16 descriptor  %8.1f MB/s\n", throughput([](const uint8_t* b, size_t l) { return(RadioLibCRCCCITT::checksum(b, l)); }));
+  printf("  CRC-32 bit-serial    %8.1f MB/s\n", throughput([](const uint8_t* b, size_t l) {
+    return(crcBitSerial(32, 0x04C11DB7, 0xFFFFFFFF, 0xFFFFFFFF, true, true, b, l)); }));
+  ccitt.size = 32;
+  ccitt.poly = 0x04C11DB7;
+  ccitt.init = 0xFFFFFFFF;
+  ccitt.out = 0xFFFFFFFF;
+  ccitt.refIn = true;
+  ccitt.refOut = true;
+  printf("  CRC-32 RadioLibCRC   %8.1f MB/s\n", throughput([&](const uint8_t* b, size_t l) { return(ccitt.checksum((uint8_t*)b, l)); }));
+  printf("  CRC-32 descriptor    %8.1f MB/s\n", throughput([](const uint8_t* b, size_t l) { return(CRC32::checksum(b, l)); }));
+
+  return(0);
+}
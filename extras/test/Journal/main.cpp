@@ -0,0 +1,210 @@
+// this is a host test of the persistent storage journal used for LoRaWAN counters
+// the storage is simulated with power loss injected at random points of a write,
+// which leaves the record partially written, and the number of writes to each byte is counted
+
+#define RADIOLIB_TEST_NAME "Journal"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// number of simulated power cycles and counter updates per cycle
+#define NUM_BOOTS           (2000)
+#define MAX_WRITES          (64)
+
+// simple deterministic generator, so that failures can be reproduced
+static uint32_t rngState = 0x12345678;
+static uint32_t rng() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return(rngState);
+}
+
+// persistent storage that loses power after a given number of bytes
+class MockHal : public TestHal {
+  public:
+    uint8_t storage[RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE];
+    uint32_t wear[RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE];
+
+    // bytes left until power is lost, negative means never
+    int32_t budget = -1;
+    bool dead = false;
+
+    MockHal() {
+      memset(storage, 0xFF, sizeof(storage));
+      memset(wear, 0, sizeof(wear));
+    }
+
+    void readPersistentStorage(uint32_t addr, uint8_t* buff, size_t len) override {
+      memcpy(buff, &this->storage[addr], len);
+    }
+
+    void writePersistentStorage(uint32_t addr, uint8_t* buff, size_t len) override {
+      for(size_t i = 0; i < len; i++) {
+        if(this->dead) {
+          return;
+        }
+
+        // the byte being programmed when power is lost ends up with an undefined value
+        if(this->budget == 0) {
+          this->storage[addr + i] = (uint8_t)rng();
+          this->dead = true;
+          return;
+        }
+        if(this->budget > 0) {
+          this->budget--;
+        }
+        this->storage[addr + i] = buff[i];
+        this->wear[addr + i]++;
+      }
+    }
+};
+
+MockHal hal;
+
+// interrupted writes must never move a counter back, and completed ones must never be lost
+int testPowerLoss() {
+  uint32_t committed[RADIOLIB_JOURNAL_NUM_IDS] = { 0 };
+  uint32_t numWrites = 0;
+  uint32_t numLost = 0;
+  for(uint32_t boot = 0; boot < NUM_BOOTS; boot++) {
+    // power up, half of the cycles are cut somewhere during the updates
+    hal.dead = false;
+    hal.budget = (boot % 2) ? (int32_t)(rng() % (MAX_WRITES*RADIOLIB_JOURNAL_RECORD_LEN)) : -1;
+    RadioLibJournal journal;
+    journal.begin(&hal, 0, sizeof(hal.storage));
+    for(uint8_t id = 0; id < RADIOLIB_JOURNAL_NUM_IDS; id++) {
+      RADIOLIB_TEST_ASSERT(journal.read(id) >= committed[id], "counter moved back");
+      committed[id] = journal.read(id);
+    }
+
+    uint32_t cnt = rng() % MAX_WRITES;
+    for(uint32_t i = 0; i < cnt; i++) {
+      // DevNonce changes only on join, so its record is often the oldest one in the journal
+      uint8_t id = RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE;
+      while((id == RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE) && (rng() % 64)) {
+        id = rng() % RADIOLIB_JOURNAL_NUM_IDS;
+      }
+      uint32_t value = journal.read(id) + 1 + (rng() % 16);
+      journal.write(id, value);
+      if(hal.dead) {
+        numLost++;
+        break;
+      }
+      numWrites++;
+      committed[id] = value;
+      RADIOLIB_TEST_ASSERT(journal.read(id) == value, "read back");
+    }
+
+    // without power loss, everything is restored exactly
+    if(!hal.dead) {
+      journal.begin(&hal, 0, sizeof(hal.storage));
+      for(uint8_t id = 0; id < RADIOLIB_JOURNAL_NUM_IDS; id++) {
+        RADIOLIB_TEST_ASSERT(journal.read(id) == committed[id], "restore");
+      }
+    }
+  }
+
+  // updates rotate across the free slots, so no byte is written much more often than the average
+  uint32_t maxWear = 0;
+  for(size_t i = 0; i < sizeof(hal.storage); i++) {
+    if(hal.wear[i] > maxWear) {
+      maxWear = hal.wear[i];
+    }
+  }
+  uint32_t freeSlots = sizeof(hal.storage)/RADIOLIB_JOURNAL_RECORD_LEN - RADIOLIB_JOURNAL_NUM_IDS;
+  RADIOLIB_TEST_ASSERT(maxWear <= 2*(numWrites + numLost)/freeSlots + 1, "wear leveling");
+
+  printf("[Journal] Test:power loss passed (%lu writes, %lu interrupted, at most %lu writes per byte)\n",
+    (unsigned long)numWrites, (unsigned long)numLost, (unsigned long)maxWear);
+  return(0);
+}
+
+// reset counters start from 0 again and the other counters are kept
+int testReset() {
+  hal.dead = false;
+  hal.budget = -1;
+  RadioLibJournal journal;
+  journal.begin(&hal, 0, sizeof(hal.storage));
+  uint32_t devNonce = journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE);
+  journal.reset(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP);
+  journal.begin(&hal, 0, sizeof(hal.storage));
+  RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP) == 0, "reset counter");
+  RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE) == devNonce, "other counter kept");
+
+  journal.write(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP, 1);
+  journal.begin(&hal, 0, sizeof(hal.storage));
+  RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP) == 1, "write after reset");
+
+  printf("[Journal] Test:reset passed\n");
+  return(0);
+}
+
+// reset interrupted by power loss must either happen completely or not at all,
+// and the old values must not come back once the journal rotates over the reset
+int testResetPowerLoss() {
+  uint32_t numDone = 0;
+  uint32_t numLost = 0;
+  uint32_t numSlots = sizeof(hal.storage)/RADIOLIB_JOURNAL_RECORD_LEN;
+  for(uint32_t boot = 0; boot < NUM_BOOTS/4; boot++) {
+    memset(hal.storage, 0xFF, sizeof(hal.storage));
+    hal.dead = false;
+    hal.budget = -1;
+    RadioLibJournal journal;
+    journal.begin(&hal, 0, sizeof(hal.storage));
+
+    // many records of the same counter, the journal wraps around so the newest one may be anywhere
+    uint32_t cnt = 1 + rng() % (3*numSlots);
+    for(uint32_t i = 0; i < cnt; i++) {
+      uint8_t id = (rng() % 2) ? RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN : RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP;
+      journal.write(id, journal.read(id) + 1 + (rng() % 16));
+    }
+    uint32_t old = journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN);
+
+    // cut the power somewhere during reset
+    hal.budget = (int32_t)(rng() % (numSlots*RADIOLIB_JOURNAL_RECORD_LEN));
+    journal.reset(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN);
+    bool lost = hal.dead;
+    hal.dead = false;
+    hal.budget = -1;
+    journal.begin(&hal, 0, sizeof(hal.storage));
+    uint32_t value = journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN);
+    RADIOLIB_TEST_ASSERT((value == 0) || (lost && (value == old)), "interrupted reset");
+    numDone += (value == 0);
+    numLost += lost;
+
+    // a few new values after reset, then rotate the journal a few times with the other counter
+    uint32_t fresh = rng() % 3;
+    if(value == 0) {
+      for(uint32_t i = 0; i < fresh; i++) {
+        journal.write(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN, i + 1);
+      }
+      value = fresh;
+    }
+    for(uint32_t i = 0; i < 3*numSlots; i++) {
+      journal.write(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP, journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP) + 1);
+      if((rng() % 8) == 0) {
+        journal.begin(&hal, 0, sizeof(hal.storage));
+        RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN) == value, "old value after reset");
+      }
+    }
+    journal.begin(&hal, 0, sizeof(hal.storage));
+    RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN) == value, "old value after reset");
+  }
+
+  printf("[Journal] Test:reset with power loss passed (%lu completed, %lu interrupted)\n",
+    (unsigned long)numDone, (unsigned long)numLost);
+  return(0);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  if(testPowerLoss() || testReset() || testResetPowerLoss()) {
+    return(1);
+  }
+
+  return(0);
+}
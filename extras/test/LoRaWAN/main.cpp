@@ -0,0 +1,748 @@
+// this is a host test of the LoRaWAN MAC layer against a simulated network server
+// the radio is emulated by a mock PhysicalLayer on a simulated clock, which delivers downlinks
+// prepared by the network server when the node listens on the right frequency and data rate at the right time
+
+#define RADIOLIB_TEST_NAME "LoRaWAN"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IRQ_PIN             (2)
+#define NEVER               (0xFFFFFFFF)
+
+// emulated radio with simulated clock and persistent storage
+class MockHal : public TestHal {
+  public:
+    uint32_t now = 0;
+    uint8_t storage[RADIOLIB_HAL_PERSISTENT_STORAGE_BASE + RADIOLIB_HAL_PERSISTENT_STORAGE_SIZE];
+    bool (*irq)(void) = NULL;
+
+    MockHal() {
+      memset(storage, 0xFF, sizeof(storage));
+    }
+
+    uint32_t digitalRead(uint32_t pin) override { return((pin == IRQ_PIN) && this->irq && this->irq()); }
+    void delay(unsigned long ms) override { this->now += ms; }
+    unsigned long millis() override { return(this->now); }
+    unsigned long micros() override { return(this->now * 1000UL); }
+
+    // every pass of the blocking loops in LoRaWANNode takes a millisecond
+    void yield() override { this->now++; }
+
+    void readPersistentStorage(uint32_t addr, uint8_t* buff, size_t len) override {
+      memcpy(buff, &this->storage[addr], len);
+    }
+
+    void writePersistentStorage(uint32_t addr, uint8_t* buff, size_t len) override {
+      memcpy(&this->storage[addr], buff, len);
+    }
+};
+
+// LoRa-only radio, one downlink can be on air at a time
+class MockRadio : public PhysicalLayer {
+  public:
+    MockHal* hal;
+    Module* mod;
+
+    // current configuration
+    uint32_t frf = 0;
+    uint8_t sf = 0;
+    float bw = 0;
+    bool iqInverted = false;
+    bool implicit = false;
+    int8_t power = 0;
+
+    // interrupt pin goes high at this time
+    uint32_t irqAt = NEVER;
+    bool receiving = false;
+
+    // the last transmitted frame
+    uint8_t txBuff[256];
+    size_t txLen = 0;
+    void (*txCb)(uint8_t* frame, size_t len, uint32_t end) = NULL;
+
+    // downlink on air, with the parameters needed to receive it
+    uint8_t dlBuff[256];
+    size_t dlLen = 0;
+    uint32_t dlStart = NEVER;
+    uint32_t dlEnd = NEVER;
+    uint32_t dlFrf = 0;
+    uint8_t dlSf = 0;
+    float dlBw = 0;
+    bool dlIq = true;
+    bool dlImplicit = false;
+    bool dlReceived = false;
+
+    MockRadio(MockHal* hal) : PhysicalLayer(61.03515625, 256) {
+      this->hal = hal;
+      this->mod = new Module(hal, 10, IRQ_PIN, 9);
+    }
+
+    Module* getMod() override { return(this->mod); }
+
+    int16_t setFrequency(float freq) override { this->frf = (uint32_t)(freq * 1000000.0 / this->getFreqStep() + 0.5); return(RADIOLIB_ERR_NONE); }
+    int16_t setFrequencyRaw(uint32_t frf) override { this->frf = frf; return(RADIOLIB_ERR_NONE); }
+    int16_t setDataRate(DataRate_t dr) override { this->sf = dr.lora.spreadingFactor; this->bw = dr.lora.bandwidth; return(RADIOLIB_ERR_NONE); }
+    int16_t setOutputPower(int8_t power) override { this->power = power; return(RADIOLIB_ERR_NONE); }
+    int16_t invertIQ(bool enable) override { this->iqInverted = enable; return(RADIOLIB_ERR_NONE); }
+    int16_t implicitHeader(size_t len) override { (void)len; this->implicit = true; return(RADIOLIB_ERR_NONE); }
+    int16_t explicitHeader() override { this->implicit = false; return(RADIOLIB_ERR_NONE); }
+    int16_t setSyncWord(uint8_t* sync, size_t len) override { (void)sync; (void)len; return(RADIOLIB_ERR_NONE); }
+    int16_t setPreambleLength(size_t len) override { (void)len; return(RADIOLIB_ERR_NONE); }
+    int16_t standby() override { this->irqAt = NEVER; this->receiving = false; return(RADIOLIB_ERR_NONE); }
+    uint8_t randomByte() override { return((uint8_t)rand()); }
+    float getSNR() override { return(5.0); }
+    float getRSSI() override { return(-80.0); }
+
+    // LoRa time-on-air with 8 symbol preamble, explicit header, CRC and coding rate 4/5
+    uint32_t getTimeOnAir(size_t len) override {
+      float tSym = (float)((uint32_t)1 << this->sf) / this->bw;
+      int32_t de = ((this->sf >= 11) && (this->bw < 200)) ? 1 : 0;
+      int32_t num = 8*(int32_t)len - 4*this->sf + 28 + 16;
+      int32_t den = 4*(this->sf - 2*de);
+      int32_t payloadSym = 8 + ((num > 0) ? ((num + den - 1) / den) * 5 : 0);
+      return((uint32_t)((8 + 4.25 + payloadSym) * tSym * 1000.0));
+    }
+
+    int16_t startTransmit(uint8_t* data, size_t len, uint8_t addr = 0) override {
+      (void)addr;
+      memcpy(this->txBuff, data, len);
+      this->txLen = len;
+      this->receiving = false;
+      this->irqAt = this->hal->now + this->getTimeOnAir(len)/1000;
+      if(this->txCb) {
+        this->txCb(this->txBuff, this->txLen, this->irqAt);
+      }
+      return(RADIOLIB_ERR_NONE);
+    }
+
+    int16_t finishTransmit() override {
+      this->irqAt = NEVER;
+      return(RADIOLIB_ERR_NONE);
+    }
+
+    // the downlink can be received only with the same settings, synthesizer values may differ by rounding
+    bool isTuned() {
+      uint32_t frfDiff = (this->frf > this->dlFrf) ? this->frf - this->dlFrf : this->dlFrf - this->frf;
+      return(!this->dlReceived && (frfDiff <= 1) && (this->sf == this->dlSf) && (this->bw == this->dlBw) &&
+             (this->iqInverted == this->dlIq) && (this->implicit == this->dlImplicit));
+    }
+
+    // channel activity is only detected while the downlink is on air
+    bool canHear() {
+      return(this->isTuned() && (this->hal->now >= this->dlStart) && (this->hal->now < this->dlEnd));
+    }
+
+    int16_t startChannelScan() override {
+      this->receiving = false;
+      this->irqAt = this->hal->now + 2*((uint32_t)1 << this->sf) / (uint32_t)this->bw + 1;
+      return(RADIOLIB_ERR_NONE);
+    }
+
+    int16_t getChannelScanResult() override {
+      this->irqAt = NEVER;
+      return(this->canHear() ? RADIOLIB_LORA_DETECTED : RADIOLIB_CHANNEL_FREE);
+    }
+
+    // the receiver also catches a downlink that starts later, as long as it stays on
+    int16_t startReceive() override {
+      this->receiving = true;
+      this->irqAt = (this->isTuned() && (this->hal->now < this->dlEnd)) ? this->dlEnd : NEVER;
+      return(RADIOLIB_ERR_NONE);
+    }
+
+    size_t getPacketLength(bool update = true) override {
+      (void)update;
+      return(this->dlLen);
+    }
+
+    int16_t readData(uint8_t* data, size_t len) override {
+      memcpy(data, this->dlBuff, (len < this->dlLen) ? len : this->dlLen);
+      this->dlReceived = true;
+      this->irqAt = NEVER;
+      this->receiving = false;
+      return(RADIOLIB_ERR_NONE);
+    }
+
+    // put a frame on air with the given settings
+    void scheduleDownlink(uint8_t* frame, size_t len, uint32_t start, uint32_t frf, uint8_t sf, float bw, bool iq = true, bool implicit = false) {
+      uint8_t curSf = this->sf;
+      float curBw = this->bw;
+      this->sf = sf;
+      this->bw = bw;
+      uint32_t toa = this->getTimeOnAir(len)/1000;
+      this->sf = curSf;
+      this->bw = curBw;
+
+      memcpy(this->dlBuff, frame, len);
+      this->dlLen = len;
+      this->dlStart = start;
+      this->dlEnd = start + toa;
+      this->dlFrf = frf;
+      this->dlSf = sf;
+      this->dlBw = bw;
+      this->dlIq = iq;
+      this->dlImplicit = implicit;
+      this->dlReceived = false;
+      if(this->receiving) {
+        this->startReceive();
+      }
+    }
+};
+
+// network server for a single device, activated by ABP or by the join procedure
+class NetworkServer {
+  public:
+    uint32_t devAddr;
+    uint8_t nwkSKey[16];
+    uint8_t appSKey[16];
+    uint32_t fcntDown = 0;
+
+    // join server, the session keys are always derived as in LoRaWAN 1.0
+    uint8_t nwkKey[16];
+    uint8_t appKey[16];
+    bool rev11 = false;
+    bool corruptJoinMic = false;
+    uint32_t joins = 0;
+    uint32_t joinNonce = 0x000100;
+
+    // the last received uplink, frames are counted even when the MIC cannot be checked
+    uint32_t frames = 0;
+    uint32_t uplinks = 0;
+    uint32_t micErrors = 0;
+    uint8_t fctrl = 0;
+    uint32_t fcnt = 0;
+    uint8_t fopts[15];
+    size_t foptsLen = 0;
+    uint8_t port = 0;
+    uint8_t payload[256];
+    size_t payloadLen = 0;
+    uint8_t sf = 0;
+    int8_t power = 0;
+
+    // downlink to send in RX1 of the next uplink
+    bool queued = false;
+    uint8_t dlFctrl = 0;
+    uint8_t dlFOpts[15];
+    size_t dlFOptsLen = 0;
+    int16_t dlPort = -1;
+    uint8_t dlPayload[64];
+    size_t dlPayloadLen = 0;
+
+    void queue(uint8_t fctrl, const uint8_t* fopts, size_t foptsLen, int16_t port, const uint8_t* payload, size_t payloadLen) {
+      this->dlFctrl = fctrl;
+      if(foptsLen) {
+        memcpy(this->dlFOpts, fopts, foptsLen);
+      }
+      this->dlFOptsLen = foptsLen;
+      this->dlPort = port;
+      if(payloadLen) {
+        memcpy(this->dlPayload, payload, payloadLen);
+      }
+      this->dlPayloadLen = payloadLen;
+      this->queued = true;
+    }
+
+    void receive(MockRadio* radio, uint8_t* frame, size_t len, uint32_t end) {
+      if((len == RADIOLIB_LORAWAN_JOIN_REQUEST_LEN) && ((frame[0] & RADIOLIB_LORAWAN_MHDR_MTYPE_MASK) == RADIOLIB_LORAWAN_MHDR_MTYPE_JOIN_REQUEST)) {
+        this->receiveJoinRequest(radio, frame, len, end);
+        return;
+      }
+
+      // MHDR, DevAddr, FCtrl, FCnt, FOpts, FPort, FRMPayload, MIC
+      if((len < 12) || (getLE(&frame[1], 4) != this->devAddr)) {
+        return;
+      }
+      this->frames++;
+      uint32_t fcnt = (this->fcnt & 0xFFFF0000) | getLE(&frame[6], 2);
+      if(fcnt < this->fcnt) {
+        fcnt += 0x10000;
+      }
+      if(mic(frame, len - 4, 0, fcnt) != getLE(&frame[len - 4], 4)) {
+        this->micErrors++;
+        return;
+      }
+      this->uplinks++;
+      this->fcnt = fcnt;
+      this->fctrl = frame[5];
+      this->foptsLen = this->fctrl & 0x0F;
+      memcpy(this->fopts, &frame[8], this->foptsLen);
+      size_t pos = 8 + this->foptsLen;
+      this->payloadLen = 0;
+      if(pos < len - 4) {
+        this->port = frame[pos++];
+        this->payloadLen = len - 4 - pos;
+        crypt((this->port == 0) ? this->nwkSKey : this->appSKey, &frame[pos], this->payloadLen, 0, fcnt, this->payload);
+      }
+      this->sf = radio->sf;
+      this->power = radio->power;
+
+      if(!this->queued) {
+        return;
+      }
+
+      // reply in RX1, on the uplink channel and data rate
+      uint8_t dl[64];
+      size_t dlLen = this->buildDownlink(dl);
+      radio->scheduleDownlink(dl, dlLen, end + RADIOLIB_LORAWAN_RECEIVE_DELAY_1_MS, radio->frf, radio->sf, radio->bw);
+    }
+
+    // reply to a join request in the first join accept window
+    void receiveJoinRequest(MockRadio* radio, uint8_t* frame, size_t len, uint32_t end) {
+      // MHDR, JoinEUI, DevEUI, DevNonce, MIC
+      RadioLibAES128 aes;
+      uint8_t cmac[16];
+      aes.init(this->nwkKey);
+      aes.generateCMAC(frame, len - 4, cmac);
+      if(getLE(cmac, 4) != getLE(&frame[len - 4], 4)) {
+        this->micErrors++;
+        return;
+      }
+      this->joins++;
+      this->joinNonce++;
+
+      // MHDR, JoinNonce, NetID, DevAddr, DLSettings, RxDelay, MIC
+      uint8_t ja[17];
+      ja[0] = RADIOLIB_LORAWAN_MHDR_MTYPE_JOIN_ACCEPT | RADIOLIB_LORAWAN_MHDR_MAJOR_R1;
+      setLE(&ja[1], this->joinNonce, 3);
+      setLE(&ja[4], 0x000013, 3);
+      setLE(&ja[7], this->devAddr, 4);
+      ja[11] = this->rev11 ? RADIOLIB_LORAWAN_JOIN_ACCEPT_R_1_1 : RADIOLIB_LORAWAN_JOIN_ACCEPT_R_1_0;
+      ja[12] = 1;
+      if(this->rev11) {
+        // the MIC uses JSIntKey and also covers the join request type, JoinEUI and DevNonce
+        uint8_t blk[16] = { RADIOLIB_LORAWAN_JOIN_ACCEPT_JS_INT_KEY };
+        memcpy(&blk[1], &frame[9], 8);
+        uint8_t jsIntKey[16];
+        aes.encryptECB(blk, 16, jsIntKey);
+        aes.init(jsIntKey);
+        uint8_t joinReqType = RADIOLIB_LORAWAN_JOIN_REQUEST_TYPE;
+        aes.cmacInit();
+        aes.cmacUpdate(&joinReqType, 1);
+        aes.cmacUpdate(&frame[1], 8);
+        aes.cmacUpdate(&frame[17], 2);
+        aes.cmacUpdate(ja, 13);
+        aes.cmacFinal(cmac);
+        aes.init(this->nwkKey);
+      } else {
+        aes.generateCMAC(ja, 13, cmac);
+      }
+      memcpy(&ja[13], cmac, 4);
+      if(this->corruptJoinMic) {
+        ja[13] ^= 0x01;
+      }
+
+      // encrypted with AES decryption, so that the device decrypts it with encryption
+      uint8_t enc[17];
+      enc[0] = ja[0];
+      aes.decryptECB(&ja[1], 16, &enc[1]);
+      radio->scheduleDownlink(enc, sizeof(enc), end + RADIOLIB_LORAWAN_JOIN_ACCEPT_DELAY_1_MS, radio->frf, radio->sf, radio->bw);
+
+      // new session, with the keys derived from JoinNonce, NetID and DevNonce
+      uint8_t blk[16] = { RADIOLIB_LORAWAN_JOIN_ACCEPT_F_NWK_S_INT_KEY };
+      memcpy(&blk[1], &ja[1], 6);
+      memcpy(&blk[7], &frame[17], 2);
+      aes.encryptECB(blk, 16, this->nwkSKey);
+      blk[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_APP_S_KEY;
+      aes.encryptECB(blk, 16, this->appSKey);
+      this->fcnt = 0;
+      this->fcntDown = 0;
+    }
+
+    // build the queued downlink frame
+    size_t buildDownlink(uint8_t* dl) {
+      this->queued = false;
+      size_t dlLen = 0;
+      dl[dlLen++] = RADIOLIB_LORAWAN_MHDR_MTYPE_UNCONF_DATA_DOWN | RADIOLIB_LORAWAN_MHDR_MAJOR_R1;
+      setLE(&dl[dlLen], this->devAddr, 4);
+      dlLen += 4;
+      dl[dlLen++] = this->dlFctrl | this->dlFOptsLen;
+      setLE(&dl[dlLen], this->fcntDown, 2);
+      dlLen += 2;
+      memcpy(&dl[dlLen], this->dlFOpts, this->dlFOptsLen);
+      dlLen += this->dlFOptsLen;
+      if(this->dlPort >= 0) {
+        dl[dlLen++] = (uint8_t)this->dlPort;
+        crypt((this->dlPort == 0) ? this->nwkSKey : this->appSKey, this->dlPayload, this->dlPayloadLen, 1, this->fcntDown, &dl[dlLen]);
+        dlLen += this->dlPayloadLen;
+      }
+      setLE(&dl[dlLen], mic(dl, dlLen, 1, this->fcntDown), 4);
+      dlLen += 4;
+      this->fcntDown++;
+      return(dlLen);
+    }
+
+  private:
+    static uint32_t getLE(const uint8_t* buff, size_t len) {
+      uint32_t val = 0;
+      for(size_t i = 0; i < len; i++) {
+        val |= (uint32_t)buff[i] << 8*i;
+      }
+      return(val);
+    }
+
+    static void setLE(uint8_t* buff, uint32_t val, size_t len) {
+      for(size_t i = 0; i < len; i++) {
+        buff[i] = (uint8_t)(val >> 8*i);
+      }
+    }
+
+    // block used for both MIC (B0) and encryption (Ai)
+    void block(uint8_t* blk, uint8_t magic, uint8_t dir, uint32_t fcnt) {
+      memset(blk, 0, 16);
+      blk[0] = magic;
+      blk[5] = dir;
+      setLE(&blk[6], this->devAddr, 4);
+      setLE(&blk[10], fcnt, 4);
+    }
+
+    uint32_t mic(uint8_t* msg, size_t len, uint8_t dir, uint32_t fcnt) {
+      uint8_t b0[16];
+      block(b0, 0x49, dir, fcnt);
+      b0[15] = (uint8_t)len;
+      uint8_t cmac[16];
+      RadioLibAES128 aes;
+      aes.init(this->nwkSKey);
+      aes.cmacInit();
+      aes.cmacUpdate(b0, sizeof(b0));
+      aes.cmacUpdate(msg, len);
+      aes.cmacFinal(cmac);
+      return(getLE(cmac, 4));
+    }
+
+    void crypt(uint8_t* key, uint8_t* in, size_t len, uint8_t dir, uint32_t fcnt, uint8_t* out) {
+      uint8_t a[16];
+      block(a, 0x01, dir, fcnt);
+      a[15] = 1;
+      RadioLibAES128 aes;
+      aes.init(key);
+      aes.encryptCTR(in, len, a, out);
+    }
+};
+
+// simulated gateway beacon, sent at the start of every beacon period on the EU868 beacon channel
+class BeaconSource {
+  public:
+    bool enabled = true;
+
+    // local time and GPS time of the next beacon
+    uint32_t nextAt = NEVER;
+    uint32_t gpsTime = 0;
+    uint8_t gwSpecific[RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN] = { 0x00, 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC };
+
+    void poll(MockHal* hal, MockRadio* radio) {
+      if((this->nextAt == NEVER) || (hal->now < this->nextAt)) {
+        return;
+      }
+
+      // beacons go out with implicit header and without inverted IQ, at DR3 (SF9, 125 kHz)
+      if(this->enabled) {
+        uint8_t beacon[RADIOLIB_LORAWAN_BEACON_MAX_LEN];
+        size_t len = LoRaWANNode::buildBeacon(&EU868, this->gpsTime, this->gwSpecific, beacon);
+        radio->scheduleDownlink(beacon, len, this->nextAt, getFrf(radio), 9, 125.0, false, true);
+      }
+      this->nextAt += RADIOLIB_LORAWAN_BEACON_PERIOD_MS;
+      this->gpsTime += RADIOLIB_LORAWAN_BEACON_PERIOD_S;
+    }
+
+    static uint32_t getFrf(MockRadio* radio) {
+      return((uint32_t)(EU868.beaconChannel.freqStart * 1000000.0 / radio->getFreqStep() + 0.5));
+    }
+};
+
+MockHal hal;
+MockRadio radio(&hal);
+NetworkServer ns;
+BeaconSource beacons;
+
+bool radioIrq() {
+  return(hal.now >= radio.irqAt);
+}
+
+void radioTx(uint8_t* frame, size_t len, uint32_t end) {
+  ns.receive(&radio, frame, len, end);
+}
+
+uint8_t nwkSKey[] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+uint8_t appSKey[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F };
+const uint32_t devAddr = 0x260B1234;
+
+// send an uplink and wait until both Rx windows are over
+int16_t exchange(LoRaWANNode* node, uint8_t* data, size_t* len) {
+  uint8_t msg[] = { 'H', 'e', 'l', 'l', 'o' };
+  int16_t state = node->uplink(msg, sizeof(msg), 1);
+  if(state != RADIOLIB_ERR_NONE) {
+    return(state);
+  }
+  return(node->downlink(data, len));
+}
+
+// adaptive data rate controlled by the network server, and backoff once the server goes silent
+int testAdr() {
+  LoRaWANNode node(&radio, &EU868);
+  RADIOLIB_TEST_ASSERT(node.beginAPB(devAddr, nwkSKey, appSKey) == RADIOLIB_ERR_NONE, "ADR begin");
+  node.setDutyCycle(false);
+  node.setADR(true);
+  uint8_t data[256];
+  size_t len = 0;
+
+  // LinkADRReq to DR5 and power step 3 on channels 0 - 2
+  const uint8_t linkAdrReq[] = { RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ, 0x53, 0x07, 0x00, 0x01 };
+  ns.queue(RADIOLIB_LORAWAN_FCTRL_ADR_ENABLED, NULL, 0, RADIOLIB_LORAWAN_FPORT_MAC_COMMAND, linkAdrReq, sizeof(linkAdrReq));
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_NONE, "ADR LinkADRReq downlink");
+  RADIOLIB_TEST_ASSERT((ns.uplinks == 1) && (ns.micErrors == 0) && (ns.payloadLen == 5), "ADR first uplink");
+  RADIOLIB_TEST_ASSERT((ns.fctrl & RADIOLIB_LORAWAN_FCTRL_ADR_ENABLED) && !(ns.fctrl & RADIOLIB_LORAWAN_FCTRL_ADR_ACK_REQ), "ADR first uplink FCtrl");
+  RADIOLIB_TEST_ASSERT(node.getDataRate() == 5, "ADR data rate applied");
+
+  // the answer is piggybacked on the next uplink, which uses the new settings
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "ADR silent server");
+  RADIOLIB_TEST_ASSERT((ns.foptsLen == 2) && (ns.fopts[0] == RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_ANS) && (ns.fopts[1] == 0x07), "ADR LinkADRAns");
+  RADIOLIB_TEST_ASSERT((ns.sf == 7) && (ns.power == EU868.powerMax - 2*3), "ADR new settings");
+
+  // with no downlink, ADRACKReq is set after ADR_ACK_LIMIT uplinks,
+  // ADR_ACK_DELAY uplinks later the power is restored, and after another ADR_ACK_DELAY the data rate is lowered
+  for(uint32_t cnt = 1; cnt <= RADIOLIB_LORAWAN_ADR_ACK_LIMIT + 2*RADIOLIB_LORAWAN_ADR_ACK_DELAY; cnt++) {
+    RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "ADR backoff uplink");
+    bool ackReq = (ns.fctrl & RADIOLIB_LORAWAN_FCTRL_ADR_ACK_REQ);
+    RADIOLIB_TEST_ASSERT(ackReq == (cnt >= RADIOLIB_LORAWAN_ADR_ACK_LIMIT), "ADR ADRACKReq");
+    int8_t power = (cnt < RADIOLIB_LORAWAN_ADR_ACK_LIMIT + RADIOLIB_LORAWAN_ADR_ACK_DELAY) ? EU868.powerMax - 2*3 : EU868.powerMax;
+    uint8_t sf = (cnt < RADIOLIB_LORAWAN_ADR_ACK_LIMIT + 2*RADIOLIB_LORAWAN_ADR_ACK_DELAY) ? 7 : 8;
+    RADIOLIB_TEST_ASSERT((ns.power == power) && (ns.sf == sf), "ADR backoff settings");
+  }
+  RADIOLIB_TEST_ASSERT(node.getDataRate() == 4, "ADR backoff data rate");
+
+  // any downlink restarts the backoff, even one where the server is not able to manage data rate
+  // the device then keeps ADR enabled and relies on the backoff
+  ns.queue(0, NULL, 0, -1, NULL, 0);
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_NONE, "ADR empty downlink");
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "ADR uplink after downlink");
+  RADIOLIB_TEST_ASSERT((ns.fctrl & RADIOLIB_LORAWAN_FCTRL_ADR_ENABLED) && !(ns.fctrl & RADIOLIB_LORAWAN_FCTRL_ADR_ACK_REQ), "ADR backoff restarted");
+  RADIOLIB_TEST_ASSERT(ns.micErrors == 0, "ADR MIC");
+
+  printf("[LoRaWAN] Test:ADR passed (%lu uplinks, %lu s simulated)\n", (unsigned long)ns.uplinks, (unsigned long)(hal.now / 1000));
+  return(0);
+}
+
+// LoRaWAN 1.0 downlink with MAC commands in plaintext FOpts and application payload
+int testDownlink10() {
+  LoRaWANNode node(&radio, &EU868);
+  RADIOLIB_TEST_ASSERT(node.beginAPB(devAddr, nwkSKey, appSKey) == RADIOLIB_ERR_NONE, "1.0 begin");
+  node.setDutyCycle(false);
+  uint8_t data[256];
+  size_t len = 0;
+
+  // LinkCheckAns with 20 dB margin seen by 3 gateways, followed by DevStatusReq
+  const uint8_t fopts[] = { RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_ANS, 20, 3, RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_REQ };
+  const uint8_t payload[] = { 'W', 'o', 'r', 'l', 'd' };
+  ns.queue(0, fopts, sizeof(fopts), 5, payload, sizeof(payload));
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_NONE, "1.0 downlink");
+  RADIOLIB_TEST_ASSERT((len == sizeof(payload)) && (memcmp(data, payload, len) == 0), "1.0 downlink payload");
+  uint8_t margin = 0;
+  uint8_t gwCnt = 0;
+  RADIOLIB_TEST_ASSERT(node.getMacLinkCheckAns(&margin, &gwCnt) == RADIOLIB_ERR_NONE, "1.0 LinkCheckAns");
+  RADIOLIB_TEST_ASSERT((margin == 20) && (gwCnt == 3), "1.0 LinkCheckAns values");
+
+  // DevStatusAns goes back in plaintext FOpts as well
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "1.0 uplink after downlink");
+  RADIOLIB_TEST_ASSERT((ns.foptsLen == 3) && (ns.fopts[0] == RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_ANS) && (ns.fopts[2] == 5), "1.0 DevStatusAns");
+  RADIOLIB_TEST_ASSERT(ns.micErrors == 0, "1.0 MIC");
+
+  printf("[LoRaWAN] Test:1.0 downlink passed\n");
+  return(0);
+}
+
+// counters saved in place by older versions are moved into the journal
+int testLegacyCounters() {
+  // device updated from an older version, with an empty journal region
+  uint8_t* legacy = &hal.storage[RADIOLIB_HAL_PERSISTENT_STORAGE_BASE];
+  memset(&legacy[hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_JOURNAL_ID)], 0xFF, RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE);
+  uint32_t fcntUp = 1000;
+  uint16_t devNonce = 0x1234;
+  memcpy(&legacy[hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID)], &fcntUp, sizeof(fcntUp));
+  memcpy(&legacy[hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID)], &devNonce, sizeof(devNonce));
+
+  LoRaWANNode node(&radio, &EU868);
+  RADIOLIB_TEST_ASSERT(node.beginAPB(devAddr, nwkSKey, appSKey) == RADIOLIB_ERR_NONE, "legacy begin");
+  node.setDutyCycle(false);
+  uint8_t data[256];
+  size_t len = 0;
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "legacy uplink");
+  RADIOLIB_TEST_ASSERT(ns.fcnt == fcntUp + 1, "legacy frame counter continued");
+
+  // the old values are cleared, so they are not picked up again once the counters are reset
+  const uint8_t zero[sizeof(uint32_t)] = { 0 };
+  RADIOLIB_TEST_ASSERT(memcmp(&legacy[hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID)], zero, sizeof(uint32_t)) == 0, "legacy frame counter cleared");
+  RADIOLIB_TEST_ASSERT(memcmp(&legacy[hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID)], zero, sizeof(uint16_t)) == 0, "legacy DevNonce cleared");
+  RadioLibJournal journal;
+  journal.begin(&hal, RADIOLIB_HAL_PERSISTENT_STORAGE_BASE + hal.getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_JOURNAL_ID), RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE);
+  RADIOLIB_TEST_ASSERT(journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE) == devNonce, "legacy DevNonce migrated");
+
+  // a restart with the cleared values keeps the journal
+  LoRaWANNode restarted(&radio, &EU868);
+  RADIOLIB_TEST_ASSERT(restarted.beginAPB(devAddr, nwkSKey, appSKey) == RADIOLIB_ERR_NONE, "legacy restart");
+  restarted.setDutyCycle(false);
+  RADIOLIB_TEST_ASSERT(exchange(&restarted, data, &len) == RADIOLIB_ERR_RX_TIMEOUT, "legacy uplink after restart");
+  RADIOLIB_TEST_ASSERT(ns.fcnt > fcntUp + 1, "legacy frame counter after restart");
+  RADIOLIB_TEST_ASSERT(ns.micErrors == 0, "legacy MIC");
+
+  printf("[LoRaWAN] Test:legacy counters passed\n");
+  return(0);
+}
+
+// class B events and a downlink waiting to be sent in a ping slot
+uint32_t beaconEvents = 0;
+uint32_t beaconLostEvents = 0;
+uint32_t downlinkEvents = 0;
+uint8_t pingDl[64];
+size_t pingDlLen = 0;
+uint32_t pingAt = NEVER;
+
+void classBEvent(LoRaWANNode* node, uint8_t event) {
+  (void)node;
+  beaconEvents += (event == RADIOLIB_LORAWAN_EVENT_BEACON);
+  beaconLostEvents += (event == RADIOLIB_LORAWAN_EVENT_BEACON_LOST);
+  downlinkEvents += (event == RADIOLIB_LORAWAN_EVENT_DOWNLINK);
+}
+
+// let the simulated time pass, with the node polled every millisecond
+void run(LoRaWANNode* node, uint32_t ms) {
+  for(uint32_t end = hal.now + ms; hal.now < end; hal.now++) {
+    beacons.poll(&hal, &radio);
+    if(hal.now >= pingAt) {
+      radio.scheduleDownlink(pingDl, pingDlLen, pingAt, BeaconSource::getFrf(&radio), 9, 125.0);
+      pingAt = NEVER;
+    }
+    node->poll();
+  }
+}
+
+// start of the ping slot in the beacon period, calculated as in LoRaWAN 1.0.4 class B specification
+uint32_t getPingSlot(uint32_t beaconAt, uint32_t beaconTime) {
+  uint8_t block[16] = { 0 };
+  uint8_t key[16] = { 0 };
+  for(size_t i = 0; i < 4; i++) {
+    block[i] = (uint8_t)(beaconTime >> 8*i);
+    block[4 + i] = (uint8_t)(devAddr >> 8*i);
+  }
+  uint8_t rand[16];
+  RadioLibAES128 aes;
+  aes.init(key);
+  aes.encryptECB(block, sizeof(block), rand);
+
+  // one ping slot per period, slots are 30 ms long and start after the beacon reserved time
+  uint32_t pingOffset = ((uint32_t)rand[0] + 256*(uint32_t)rand[1]) % 4096;
+  return(beaconAt + 2120 + 30*pingOffset);
+}
+
+// beacon acquisition without device time, beacon tracking, ping slot downlink and beacon loss
+int testClassB() {
+  LoRaWANNode node(&radio, &EU868);
+  RADIOLIB_TEST_ASSERT(node.beginAPB(devAddr, nwkSKey, appSKey) == RADIOLIB_ERR_NONE, "class B begin");
+  node.setDutyCycle(false);
+  node.onEvent(classBEvent);
+
+  // the search covers a whole beacon period, the first beacon comes somewhere in the middle
+  beacons.gpsTime = 1300000000UL - (1300000000UL % RADIOLIB_LORAWAN_BEACON_PERIOD_S);
+  beacons.nextAt = hal.now + 50000;
+  RADIOLIB_TEST_ASSERT(node.setClass(RADIOLIB_LORAWAN_CLASS_B) == RADIOLIB_ERR_NONE, "class B set");
+  run(&node, 60000);
+  RADIOLIB_TEST_ASSERT(beaconEvents == 1, "class B beacon acquired");
+  uint32_t gpsTime = 0;
+  uint8_t gwSpecific[RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN];
+  RADIOLIB_TEST_ASSERT(node.getBeacon(&gpsTime, gwSpecific) == RADIOLIB_ERR_NONE, "class B getBeacon");
+  RADIOLIB_TEST_ASSERT(gpsTime == beacons.gpsTime - RADIOLIB_LORAWAN_BEACON_PERIOD_S, "class B beacon time");
+  RADIOLIB_TEST_ASSERT(memcmp(gwSpecific, beacons.gwSpecific, sizeof(gwSpecific)) == 0, "class B gateway-specific part");
+
+  // once locked, every beacon is received
+  run(&node, 3*RADIOLIB_LORAWAN_BEACON_PERIOD_MS);
+  RADIOLIB_TEST_ASSERT(beaconEvents == 4, "class B beacon tracking");
+
+  // downlink in the ping slot of the next period
+  const uint8_t payload[] = { 'P', 'i', 'n', 'g' };
+  ns.queue(0, NULL, 0, 7, payload, sizeof(payload));
+  pingDlLen = ns.buildDownlink(pingDl);
+  pingAt = getPingSlot(beacons.nextAt, beacons.gpsTime);
+  run(&node, pingAt - hal.now + 1000);
+  RADIOLIB_TEST_ASSERT((beaconEvents == 5) && (downlinkEvents == 1), "class B ping slot downlink");
+  uint8_t data[256];
+  size_t len = 0;
+  RADIOLIB_TEST_ASSERT(node.readDownlink(data, &len) == RADIOLIB_ERR_NONE, "class B read downlink");
+  RADIOLIB_TEST_ASSERT((len == sizeof(payload)) && (memcmp(data, payload, len) == 0), "class B downlink payload");
+
+  // a few missed beacons are bridged with a wider window
+  beacons.enabled = false;
+  run(&node, 2*RADIOLIB_LORAWAN_BEACON_PERIOD_MS);
+  beacons.enabled = true;
+  run(&node, RADIOLIB_LORAWAN_BEACON_PERIOD_MS);
+  RADIOLIB_TEST_ASSERT((beaconEvents == 6) && (beaconLostEvents == 0), "class B missed beacons");
+
+  // without beacons, ping slots are only kept for a limited time
+  beacons.enabled = false;
+  run(&node, (RADIOLIB_LORAWAN_BEACON_LESS_MAX_PERIODS + 1)*RADIOLIB_LORAWAN_BEACON_PERIOD_MS);
+  RADIOLIB_TEST_ASSERT((beaconLostEvents == 1) && (beaconEvents == 6), "class B beacon lost");
+  beacons.nextAt = NEVER;
+  node.onEvent(NULL);
+
+  printf("[LoRaWAN] Test:class B passed (%lu beacons, %lu s simulated)\n", (unsigned long)beaconEvents, (unsigned long)(hal.now / 1000));
+  return(0);
+}
+
+// over-the-air activation, the join accept MIC is checked for both LoRaWAN 1.0 and 1.1
+int testJoin() {
+  const uint64_t joinEUI = 0x0000000000000001;
+  const uint64_t devEUI = 0x70B3D57ED0000001;
+  const uint8_t hello[] = { 'H', 'e', 'l', 'l', 'o' };
+  uint8_t data[256];
+  size_t len = 0;
+
+  // 1.0, the session is checked by exchanging data with the derived keys
+  LoRaWANNode node(&radio, &EU868);
+  node.setDutyCycle(false);
+  ns.rev11 = false;
+  ns.corruptJoinMic = true;
+  RADIOLIB_TEST_ASSERT(node.beginOTAA(joinEUI, devEUI, ns.nwkKey, ns.appKey, true) != RADIOLIB_ERR_NONE, "1.0 join accept with wrong MIC");
+  ns.corruptJoinMic = false;
+  RADIOLIB_TEST_ASSERT(node.beginOTAA(joinEUI, devEUI, ns.nwkKey, ns.appKey, true) == RADIOLIB_ERR_NONE, "1.0 join");
+  RADIOLIB_TEST_ASSERT((ns.joins == 2) && (ns.micErrors == 0), "1.0 join requests");
+  uint32_t uplinks = ns.uplinks;
+  ns.queue(0, NULL, 0, 1, hello, sizeof(hello));
+  RADIOLIB_TEST_ASSERT(exchange(&node, data, &len) == RADIOLIB_ERR_NONE, "downlink after join");
+  RADIOLIB_TEST_ASSERT((len == sizeof(hello)) && (memcmp(data, hello, sizeof(hello)) == 0), "downlink payload after join");
+  RADIOLIB_TEST_ASSERT((ns.uplinks == uplinks + 1) && (ns.micErrors == 0), "uplink MIC after join");
+  RADIOLIB_TEST_ASSERT((ns.payloadLen == sizeof(hello)) && (memcmp(ns.payload, hello, sizeof(hello)) == 0), "uplink payload after join");
+
+  // 1.1, the server does not implement the rest of the exchange, so the join is only checked
+  // by the device sending RekeyInd, which it does only once the join accept passed the MIC check
+  LoRaWANNode node11(&radio, &EU868);
+  node11.setDutyCycle(false);
+  ns.rev11 = true;
+  ns.corruptJoinMic = true;
+  uint32_t frames = ns.frames;
+  node11.beginOTAA(joinEUI, devEUI, ns.nwkKey, ns.appKey, true);
+  RADIOLIB_TEST_ASSERT((ns.joins == 3) && (ns.frames == frames), "1.1 join accept with wrong MIC");
+  ns.corruptJoinMic = false;
+  node11.beginOTAA(joinEUI, devEUI, ns.nwkKey, ns.appKey, true);
+  RADIOLIB_TEST_ASSERT((ns.joins == 4) && (ns.frames > frames), "1.1 join");
+
+  printf("[LoRaWAN] Test:join passed\n");
+  return(0);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  hal.irq = radioIrq;
+  radio.txCb = radioTx;
+  ns.devAddr = devAddr;
+  memcpy(ns.nwkSKey, nwkSKey, sizeof(nwkSKey));
+  memcpy(ns.appSKey, appSKey, sizeof(appSKey));
+  memcpy(ns.nwkKey, nwkSKey, sizeof(nwkSKey));
+  memcpy(ns.appKey, appSKey, sizeof(appSKey));
+
+  if(testAdr() || testDownlink10() || testLegacyCounters() || testClassB() || testJoin()) {
+    return(1);
+  }
+
+  return(0);
+}
@@ -0,0 +1,230 @@
+// this is a host benchmark of packet reception into RadioLibPacketRing
+// SX1262 is emulated by a mock HAL, which counts SPI transactions and bytes,
+// and simulates time spent on the bus with 8 MHz SPI clock
+// received packets are checked by a worker thread, as in a gateway
+
+#define RADIOLIB_TEST_NAME "PacketRing"
+#include "../TestHal.h"
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// number of packets per measurement
+#define NUM_PACKETS         (20000)
+
+// number of slots in the ring
+#define NUM_SLOTS           (16)
+
+// emulated SX1262
+class MockHal : public TestHal {
+  public:
+    // emulated radio state
+    uint8_t regs[0x1000];
+    uint8_t buff[256];
+    uint8_t rxLen = 0;
+    uint8_t rxOffset = 0;
+    uint8_t packetType = RADIOLIB_SX126X_PACKET_TYPE_LORA;
+    uint8_t packetStatus[3] = { 0, 0, 0 };
+    uint16_t irq = 0;
+
+    // statistics
+    uint32_t transactions = 0;
+    uint32_t bytes = 0;
+    double busTimeUs = 0;
+
+    MockHal() {
+      memset(regs, 0, sizeof(regs));
+      memcpy(&regs[RADIOLIB_SX126X_REG_VERSION_STRING & 0x0FFF], "SX1261 V2D 2D02", 16);
+    }
+
+    unsigned long micros() override { return((unsigned long)this->busTimeUs); }
+
+    // every transaction costs 2 us of chip select and BUSY handling
+    void spiBeginTransaction() override {
+      this->pos = 0;
+      this->transactions++;
+      this->busTimeUs += 2.0;
+    }
+
+    void spiTransfer(uint8_t* out, size_t len, uint8_t* in) override {
+      this->bytes += len;
+      this->busTimeUs += len;
+      for(size_t i = 0; i < len; i++) {
+        in[i] = respond(out[i]);
+        this->pos++;
+      }
+    }
+
+  private:
+    size_t pos = 0;
+    uint8_t op = 0;
+    uint16_t addr = 0;
+
+    uint8_t respond(uint8_t out) {
+      const uint8_t status = 0x22;
+      if(this->pos == 0) {
+        this->op = out;
+        return(status);
+      }
+      switch(this->op) {
+        case(RADIOLIB_SX126X_CMD_READ_REGISTER):
+        case(RADIOLIB_SX126X_CMD_WRITE_REGISTER):
+          if(this->pos <= 2) {
+            this->addr = (this->addr << 8) | out;
+            return(status);
+          }
+          if(this->op == RADIOLIB_SX126X_CMD_WRITE_REGISTER) {
+            this->regs[(this->addr + this->pos - 3) & 0x0FFF] = out;
+            return(status);
+          }
+          return((this->pos == 3) ? status : this->regs[(this->addr + this->pos - 4) & 0x0FFF]);
+        case(RADIOLIB_SX126X_CMD_READ_BUFFER):
+          if(this->pos == 1) {
+            this->addr = out;
+          }
+          return((this->pos <= 2) ? status : this->buff[(this->addr + this->pos - 3) & 0xFF]);
+        case(RADIOLIB_SX126X_CMD_SET_PACKET_TYPE):
+          this->packetType = out;
+          return(status);
+        case(RADIOLIB_SX126X_CMD_GET_PACKET_TYPE):
+          return((this->pos == 1) ? status : this->packetType);
+        case(RADIOLIB_SX126X_CMD_GET_IRQ_STATUS):
+          return((this->pos == 1) ? status : (uint8_t)(this->irq >> (8*(3 - this->pos))));
+        case(RADIOLIB_SX126X_CMD_GET_RX_BUFFER_STATUS):
+          return((this->pos == 1) ? status : ((this->pos == 2) ? this->rxLen : this->rxOffset));
+        case(RADIOLIB_SX126X_CMD_GET_PACKET_STATUS):
+          return((this->pos == 1) ? status : this->packetStatus[(this->pos - 2) % 3]);
+        default:
+          return(status);
+      }
+    }
+};
+
+MockHal* hal = new MockHal();
+SX1262 radio = new Module(hal, 10, 2, 9, 3);
+
+RadioLibPacket_t slots[NUM_SLOTS];
+RadioLibPacketRing ring(slots, NUM_SLOTS);
+
+// worker thread statistics
+std::atomic<bool> running(true);
+std::atomic<uint32_t> received(0);
+std::atomic<uint32_t> corrupted(0);
+
+// "receive" the next packet in the emulated radio
+void nextPacket(uint32_t n, uint8_t len, uint8_t offset) {
+  hal->rxLen = len;
+  hal->rxOffset = offset;
+  for(uint8_t i = 0; i < len; i++) {
+    hal->buff[(uint8_t)(offset + i)] = (uint8_t)(n + i);
+  }
+  hal->packetStatus[0] = 80;
+  hal->packetStatus[1] = (uint8_t)(-12);
+  hal->packetStatus[2] = 90;
+  hal->irq = RADIOLIB_SX126X_IRQ_RX_DONE;
+}
+
+// check the packet in a slot, the first byte holds the packet number
+bool checkPacket(RadioLibPacket_t* pkt, uint8_t len) {
+  if((pkt->len != len) || (pkt->rssi != -45.0) || (pkt->snr != -3.0)) {
+    return(false);
+  }
+  for(size_t i = 0; i < pkt->len; i++) {
+    if(pkt->data[i] != (uint8_t)(pkt->data[0] + i)) {
+      return(false);
+    }
+  }
+  return(true);
+}
+
+void worker(uint8_t len) {
+  while(running || ring.available()) {
+    RadioLibPacket_t* pkt = ring.front();
+    if(pkt == NULL) {
+      std::this_thread::yield();
+      continue;
+    }
+    if(!checkPacket(pkt, len)) {
+      corrupted++;
+    }
+    received++;
+    ring.release();
+  }
+}
+
+void bench(uint8_t len, bool useRing) {
+  running = true;
+  received = 0;
+  corrupted = 0;
+  std::thread t(worker, len);
+
+  hal->transactions = 0;
+  hal->bytes = 0;
+  hal->busTimeUs = 0;
+  auto start = std::chrono::steady_clock::now();
+  uint32_t full = 0;
+  for(uint32_t n = 0; n < NUM_PACKETS; n++) {
+    // readData resets the buffer base address, so with it the packet always starts at 0
+    // readData(ring) reads the packet from wherever the radio reports it
+    nextPacket(n, len, useRing ? (uint8_t)(n * 7) : 0);
+
+    int state = RADIOLIB_ERR_PACKET_RING_FULL;
+    while(state == RADIOLIB_ERR_PACKET_RING_FULL) {
+      if(useRing) {
+        // read directly into the ring
+        state = radio.readData(ring);
+      } else {
+        // read into a temporary buffer, then copy into the ring
+        RadioLibPacket_t* pkt = ring.reserve();
+        if(pkt == NULL) {
+          full++;
+          std::this_thread::yield();
+          continue;
+        }
+        uint8_t buff[256];
+        state = radio.readData(buff, 0);
+        pkt->len = radio.getPacketLength();
+        pkt->rssi = radio.getRSSI();
+        pkt->snr = radio.getSNR();
+        pkt->timestamp = hal->micros();
+        pkt->state = state;
+        memcpy(pkt->data, buff, pkt->len);
+        ring.commit();
+      }
+      if(state == RADIOLIB_ERR_PACKET_RING_FULL) {
+        full++;
+        std::this_thread::yield();
+      }
+    }
+  }
+  running = false;
+  t.join();
+  auto end = std::chrono::steady_clock::now();
+  double hostNs = std::chrono::duration<double, std::nano>(end - start).count() / NUM_PACKETS;
+
+  printf("%-12s len %3d: %5.2f transactions, %6.1f SPI bytes, %6.1f us on bus, %7.1f ns host time per packet; ",
+    useRing ? "readData(ring)" : "readData+copy", len,
+    (double)hal->transactions / NUM_PACKETS, (double)hal->bytes / NUM_PACKETS, hal->busTimeUs / NUM_PACKETS, hostNs);
+  printf("received %u, corrupted %u, ring full %u\n", (unsigned)received, (unsigned)corrupted, (unsigned)full);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  int state = radio.begin();
+  printf("[SX1262] begin() = %d\n", state);
+  if(state != RADIOLIB_ERR_NONE) {
+    return(1);
+  }
+
+  const uint8_t lens[] = { 16, 64, 255 };
+  for(uint8_t len : lens) {
+    bench(len, false);
+    bench(len, true);
+  }
+
+  return(0);
+}
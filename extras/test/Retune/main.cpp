@@ -0,0 +1,262 @@
+// this is a host test of the per-symbol frequency retune used by direct-mode protocols (RTTY, Morse, FSK4 etc.)
+// a mock HAL emulates the registers of SX127x/RF69-style and CC1101-style modules and advances a simulated clock
+// for every SPI transaction, including random latency, so that the time and jitter of each symbol can be checked
+
+#define RADIOLIB_TEST_NAME "Retune"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// number of symbols sent in each measurement
+#define NUM_SYMBOLS         (2000)
+
+// simulated SPI timing in ns: 8 MHz clock, fixed overhead and random latency of each transaction
+#define SPI_BYTE_NS         (1000)
+#define SPI_OVERHEAD_NS     (1500)
+#define SPI_LATENCY_NS      (3000)
+
+// GPIO access, e.g. chip select
+#define GPIO_NS             (200)
+
+// simple deterministic generator, so that failures can be reproduced
+static uint32_t rngState = 0x12345678;
+static uint32_t rng() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return(rngState);
+}
+
+class MockHal : public TestHal {
+  public:
+    // emulated module registers, CC1101 uses a different header format and command strobes
+    uint8_t regs[256];
+    bool cc = false;
+
+    // simulated time and statistics
+    uint32_t nowNs = 0;
+    uint32_t transactions = 0;
+    uint32_t bytes = 0;
+
+    // CC1101 calibrates the frequency synthesizer when going from IDLE to TX
+    uint32_t calibrations = 0;
+
+    MockHal() {
+      memset(regs, 0, sizeof(regs));
+    }
+
+    void digitalWrite(uint32_t pin, uint32_t value) override { (void)pin; (void)value; this->nowNs += GPIO_NS; }
+    uint32_t digitalRead(uint32_t pin) override { (void)pin; this->nowNs += GPIO_NS; return(0); }
+    void delay(unsigned long ms) override { this->nowNs += ms*1000000UL; }
+    void delayMicroseconds(unsigned long us) override { this->nowNs += us*1000UL; }
+    unsigned long millis() override { this->nowNs += 100; return(this->nowNs / 1000000UL); }
+    unsigned long micros() override { this->nowNs += 100; return(this->nowNs / 1000UL); }
+    void yield() override { this->nowNs += 500; }
+
+    void spiBeginTransaction() override {
+      this->pos = 0;
+      this->transactions++;
+      this->nowNs += SPI_OVERHEAD_NS + rng() % SPI_LATENCY_NS;
+    }
+
+    void spiTransfer(uint8_t* out, size_t len, uint8_t* in) override {
+      this->bytes += len;
+      this->nowNs += len*SPI_BYTE_NS;
+      for(size_t i = 0; i < len; i++) {
+        uint8_t b = out[i];
+        in[i] = this->cc ? respondCC(b) : respondReg(b);
+        this->pos++;
+      }
+    }
+
+    void spiEndTransaction() override {
+      // a transaction with just the header byte is a command strobe, the state changes immediately
+      if(this->cc && (this->pos == 1) && ((this->addr & 0x3F) >= 0x30)) {
+        this->lastStrobe = this->addr & 0x3F;
+        if(this->lastStrobe == RADIOLIB_CC1101_CMD_IDLE) {
+          this->regs[RADIOLIB_CC1101_REG_MARCSTATE] = RADIOLIB_CC1101_MARC_STATE_IDLE;
+        } else if(this->lastStrobe == RADIOLIB_CC1101_CMD_TX) {
+          if(this->regs[RADIOLIB_CC1101_REG_MARCSTATE] == RADIOLIB_CC1101_MARC_STATE_IDLE) {
+            this->calibrations++;
+          }
+          this->regs[RADIOLIB_CC1101_REG_MARCSTATE] = RADIOLIB_CC1101_MARC_STATE_TX;
+        }
+      }
+    }
+
+    void reset() {
+      this->transactions = 0;
+      this->bytes = 0;
+    }
+
+  private:
+    size_t pos = 0;
+    bool write = false;
+    uint8_t addr = 0;
+    uint8_t lastStrobe = 0;
+
+    // address byte with write flag in MSB, followed by data with address auto-increment
+    uint8_t respondReg(uint8_t out) {
+      if(this->pos == 0) {
+        this->write = out & 0x80;
+        this->addr = out & 0x7F;
+        return(0x00);
+      }
+      if(this->write) {
+        this->regs[this->addr++] = out;
+        return(0x00);
+      }
+      return(this->regs[this->addr++]);
+    }
+
+    // header byte with read and burst flags, address only increments in burst access
+    uint8_t respondCC(uint8_t out) {
+      const uint8_t status = 0x0F;
+      if(this->pos == 0) {
+        this->write = !(out & RADIOLIB_CC1101_CMD_READ);
+        this->addr = out;
+        return(status);
+      }
+      uint8_t reg = (this->addr & 0x3F) + ((this->addr & RADIOLIB_CC1101_CMD_BURST) ? (this->pos - 1) : 0);
+      if(this->write) {
+        this->regs[reg] = out;
+        return(status);
+      }
+      return(this->regs[reg]);
+    }
+};
+
+MockHal mockHal;
+MockHal* hal = &mockHal;
+
+// time of a single symbol
+struct SymbolStats {
+  uint32_t minNs;
+  uint32_t maxNs;
+  uint32_t meanNs;
+  uint32_t transactions;
+  uint32_t bytes;
+  bool freqOk;
+};
+
+// send alternating symbols, either with the full transmitDirect() or the retuneDirect() fast path
+template<typename T>
+SymbolStats measure(T* radio, bool retune, uint32_t frf, uint32_t shift, uint8_t freqReg) {
+  SymbolStats stats = { 0xFFFFFFFF, 0, 0, 0, 0, true };
+  uint64_t total = 0;
+  for(uint32_t i = 0; i < NUM_SYMBOLS; i++) {
+    uint32_t symFrf = frf + ((i % 2) ? shift : 0);
+    hal->reset();
+    uint32_t start = hal->nowNs;
+    if(retune) {
+      radio->retuneDirect(symFrf);
+    } else {
+      radio->transmitDirect(symFrf);
+    }
+    uint32_t len = hal->nowNs - start;
+    total += len;
+    stats.minNs = (len < stats.minNs) ? len : stats.minNs;
+    stats.maxNs = (len > stats.maxNs) ? len : stats.maxNs;
+    stats.transactions = hal->transactions;
+    stats.bytes = hal->bytes;
+
+    // the frequency must be set after every symbol
+    uint32_t regFrf = ((uint32_t)hal->regs[freqReg] << 16) | ((uint32_t)hal->regs[freqReg + 1] << 8) | hal->regs[freqReg + 2];
+    stats.freqOk &= (regFrf == symFrf);
+  }
+  stats.meanNs = total / NUM_SYMBOLS;
+  return(stats);
+}
+
+template<typename T>
+int testRetune(T* radio, const char* name, uint32_t frf, uint32_t shift, uint8_t freqReg, bool (*inTx)(), uint32_t numTransactions, uint32_t numBytes) {
+  char msg[64];
+  RADIOLIB_TEST_ASSERT(radio->transmitDirect(frf) == RADIOLIB_ERR_NONE, "start direct transmission");
+  SymbolStats full = measure(radio, false, frf, shift, freqReg);
+  uint32_t calibrations = hal->calibrations;
+  SymbolStats fast = measure(radio, true, frf, shift, freqReg);
+  snprintf(msg, sizeof(msg), "%s frequency", name);
+  RADIOLIB_TEST_ASSERT(full.freqOk && fast.freqOk, msg);
+
+  // while transmitting, the symbol is a burst write of the three frequency registers,
+  // CC1101 also has to go through IDLE so that the synthesizer is calibrated for every symbol
+  snprintf(msg, sizeof(msg), "%s retune transactions", name);
+  RADIOLIB_TEST_ASSERT((fast.transactions == numTransactions) && (fast.bytes == numBytes), msg);
+  snprintf(msg, sizeof(msg), "%s retune calibration", name);
+  RADIOLIB_TEST_ASSERT(!hal->cc || (hal->calibrations - calibrations == NUM_SYMBOLS), msg);
+
+  // so the only jitter left is the latency of those transactions
+  snprintf(msg, sizeof(msg), "%s retune jitter", name);
+  RADIOLIB_TEST_ASSERT(fast.maxNs - fast.minNs < numTransactions*SPI_LATENCY_NS, msg);
+  snprintf(msg, sizeof(msg), "%s retune time", name);
+  RADIOLIB_TEST_ASSERT((fast.maxNs <= numTransactions*(2*GPIO_NS + SPI_OVERHEAD_NS + SPI_LATENCY_NS) + numBytes*SPI_BYTE_NS) && (2*fast.meanNs < full.meanNs), msg);
+
+  // after a mode change, retune has to start the transmission again
+  radio->standby();
+  snprintf(msg, sizeof(msg), "%s standby", name);
+  RADIOLIB_TEST_ASSERT(!inTx(), msg);
+  hal->reset();
+  radio->retuneDirect(frf);
+  snprintf(msg, sizeof(msg), "%s retune after standby", name);
+  RADIOLIB_TEST_ASSERT(inTx() && (hal->transactions > numTransactions), msg);
+
+  // the same after reset, which puts the module back into standby
+  RADIOLIB_TEST_ASSERT(radio->transmitDirect(frf) == RADIOLIB_ERR_NONE, "restart direct transmission");
+  radio->reset();
+  hal->reset();
+  radio->retuneDirect(frf);
+  snprintf(msg, sizeof(msg), "%s retune after reset", name);
+  RADIOLIB_TEST_ASSERT(hal->transactions > numTransactions, msg);
+
+  printf("[Retune] Test:%s passed (transmitDirect %lu transactions, %lu ns; retuneDirect %lu transactions, %lu ns, %lu - %lu ns)\n",
+    name, (unsigned long)full.transactions, (unsigned long)full.meanNs, (unsigned long)fast.transactions,
+    (unsigned long)fast.meanNs, (unsigned long)fast.minNs, (unsigned long)fast.maxNs);
+  return(0);
+}
+
+bool sxInTx() {
+  return((hal->regs[RADIOLIB_SX127X_REG_OP_MODE] & 0x07) == RADIOLIB_SX127X_TX);
+}
+
+bool rfInTx() {
+  return((hal->regs[RADIOLIB_RF69_REG_OP_MODE] & 0x1C) == RADIOLIB_RF69_TX);
+}
+
+bool ccInTx() {
+  return(hal->regs[RADIOLIB_CC1101_REG_MARCSTATE] == RADIOLIB_CC1101_MARC_STATE_TX);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  // 7.110 MHz and 7.110 MHz + 183 Hz, like RTTY with 61 Hz synthesizer step
+  memset(hal->regs, 0, sizeof(hal->regs));
+  hal->regs[0x42] = 0x12;
+  SX1278 sx(new Module(hal, 10, 2, 9, 3));
+  RADIOLIB_TEST_ASSERT(sx.beginFSK() == RADIOLIB_ERR_NONE, "SX1278 begin");
+  if(testRetune(&sx, "SX1278", 116490, 3, RADIOLIB_SX127X_REG_FRF_MSB, sxInTx, 1, 4)) {
+    return(1);
+  }
+
+  memset(hal->regs, 0, sizeof(hal->regs));
+  hal->regs[RADIOLIB_RF69_REG_VERSION] = 0x24;
+  RF69 rf(new Module(hal, 10, 2, 9));
+  RADIOLIB_TEST_ASSERT(rf.begin() == RADIOLIB_ERR_NONE, "RF69 begin");
+  if(testRetune(&rf, "RF69", 116490, 3, RADIOLIB_RF69_REG_FRF_MSB, rfInTx, 1, 4)) {
+    return(1);
+  }
+
+  hal->cc = true;
+  memset(hal->regs, 0, sizeof(hal->regs));
+  hal->regs[RADIOLIB_CC1101_REG_VERSION] = 0x14;
+  // 433.6 MHz and 433.6 MHz + 397 Hz
+  CC1101 cc(new Module(hal, 10, 2, 9, 3));
+  RADIOLIB_TEST_ASSERT(cc.begin() == RADIOLIB_ERR_NONE, "CC1101 begin");
+  if(testRetune(&cc, "CC1101", 1093000, 1, RADIOLIB_CC1101_REG_FREQ2, ccInTx, 3, 6)) {
+    return(1);
+  }
+
+  return(0);
+}
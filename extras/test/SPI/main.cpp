@@ -0,0 +1,212 @@
+// this is a host test of SPI transfers in Module
+// a mock HAL emulates a register-addressed module (SX127x-style) and a command-addressed module (SX126x-style),
+// and counts SPI transactions, spiTransfer calls and bytes on the bus
+// heap allocations are counted as well, since SPI transfers must not use the heap
+
+#define RADIOLIB_TEST_NAME "SPI"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <chrono>
+
+// number of register reads used for timing measurement
+#define BENCH_LEN           (1000000)
+
+// count all heap allocations
+static size_t allocs = 0;
+void* operator new(size_t size) { allocs++; void* ptr = malloc(size); if(!ptr) { throw std::bad_alloc(); } return(ptr); }
+void* operator new[](size_t size) { allocs++; void* ptr = malloc(size); if(!ptr) { throw std::bad_alloc(); } return(ptr); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { (void)size; free(ptr); }
+void operator delete[](void* ptr, size_t size) noexcept { (void)size; free(ptr); }
+
+// command opcodes of the emulated stream module
+#define MOCK_CMD_WRITE_BUFFER   (0x0E)
+#define MOCK_CMD_READ_BUFFER    (0x1E)
+#define MOCK_CMD_GET_STATUS     (0xC0)
+
+class MockHal : public TestHal {
+  public:
+    // emulated module memory
+    uint8_t regs[256];
+    bool stream = false;
+
+    // statistics
+    uint32_t transactions = 0;
+    uint32_t transfers = 0;
+    uint32_t bytes = 0;
+
+    MockHal() {
+      memset(regs, 0, sizeof(regs));
+    }
+
+    void spiBeginTransaction() override {
+      this->pos = 0;
+      this->transactions++;
+    }
+
+    void spiTransfer(uint8_t* out, size_t len, uint8_t* in) override {
+      this->transfers++;
+      this->bytes += len;
+      for(size_t i = 0; i < len; i++) {
+        // out and in may be the same buffer
+        uint8_t b = out[i];
+        in[i] = this->stream ? respondStream(b) : respondReg(b);
+        this->pos++;
+      }
+    }
+
+    void reset() {
+      this->transactions = 0;
+      this->transfers = 0;
+      this->bytes = 0;
+    }
+
+  private:
+    size_t pos = 0;
+    uint8_t op = 0;
+    uint8_t addr = 0;
+
+    // address byte with write flag in MSB, followed by data with address auto-increment
+    uint8_t respondReg(uint8_t out) {
+      if(this->pos == 0) {
+        this->op = out & 0x80;
+        this->addr = out & 0x7F;
+        return(0x00);
+      }
+      if(this->op) {
+        this->regs[this->addr++] = out;
+        return(0x00);
+      }
+      return(this->regs[this->addr++]);
+    }
+
+    // opcode, offset and (for reads) a status byte, followed by data
+    uint8_t respondStream(uint8_t out) {
+      const uint8_t status = 0x22;
+      if(this->pos == 0) {
+        this->op = out;
+        return(status);
+      }
+      switch(this->op) {
+        case(MOCK_CMD_WRITE_BUFFER):
+          if(this->pos == 1) {
+            this->addr = out;
+          } else {
+            this->regs[this->addr++] = out;
+          }
+          return(status);
+        case(MOCK_CMD_READ_BUFFER):
+          if(this->pos == 1) {
+            this->addr = out;
+          }
+          return((this->pos <= 2) ? status : this->regs[this->addr++]);
+        default:
+          return(status);
+      }
+    }
+};
+
+MockHal mockHal;
+MockHal* hal = &mockHal;
+Module module(hal, 10, 2, 9);
+Module* mod = &module;
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  mod->init();
+  uint8_t data[200];
+  uint8_t check[200];
+  for(size_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i*7 + 3);
+  }
+
+  // register access, single bytes and bursts shorter than RADIOLIB_SPI_BUFF_SIZE are sent in one call
+  allocs = 0;
+  hal->reset();
+  mod->SPIwriteRegister(0x12, 0xA5);
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 1) && (hal->bytes == 2), "register write");
+  hal->reset();
+  RADIOLIB_TEST_ASSERT(mod->SPIreadRegister(0x12) == 0xA5, "register read value");
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 1) && (hal->bytes == 2), "register read");
+  hal->reset();
+  mod->SPIwriteRegisterBurst(0x00, data, 10);
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 1) && (hal->bytes == 11), "short burst write");
+  hal->reset();
+  mod->SPIreadRegisterBurst(0x00, 10, check);
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 1) && (hal->bytes == 11), "short burst read");
+  RADIOLIB_TEST_ASSERT(memcmp(data, check, 10) == 0, "short burst data");
+
+  // longer bursts send the header first, reads then go straight into the caller buffer
+  // writes are sent in chunks, since the received bytes are discarded in a stack buffer
+  const size_t longLen = 100;
+  const uint32_t writeChunks = (longLen + RADIOLIB_SPI_BUFF_SIZE - 1) / RADIOLIB_SPI_BUFF_SIZE;
+  hal->reset();
+  mod->SPIwriteRegisterBurst(0x00, data, longLen);
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 1 + writeChunks) && (hal->bytes == 1 + longLen), "long burst write");
+  hal->reset();
+  memset(check, 0, sizeof(check));
+  mod->SPIreadRegisterBurst(0x00, longLen, check);
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->transfers == 2) && (hal->bytes == 1 + longLen), "long burst read");
+  RADIOLIB_TEST_ASSERT(memcmp(data, check, longLen) == 0, "long burst data");
+  RADIOLIB_TEST_ASSERT(allocs == 0, "register access allocations");
+  printf("[SPI] Test:register access passed\n");
+
+  #if defined(RADIOLIB_SPI_BATCH)
+  // batched writes to adjacent registers go out as a single burst when the batch ends
+  mod->SPIburstAutoIncrement = true;
+  hal->reset();
+  mod->SPIbeginBatch();
+  for(uint8_t i = 0; i < 4; i++) {
+    mod->SPIwriteRegister(0x20 + i, data[i]);
+  }
+  RADIOLIB_TEST_ASSERT(hal->transactions == 0, "batch queued");
+  RADIOLIB_TEST_ASSERT(mod->SPIreadRegister(0x21) == data[1], "batch queued value");
+  RADIOLIB_TEST_ASSERT(mod->SPIendBatch() == RADIOLIB_ERR_NONE, "batch end");
+  RADIOLIB_TEST_ASSERT((hal->transactions == 1) && (hal->bytes == 5), "batch burst");
+  RADIOLIB_TEST_ASSERT(memcmp(&hal->regs[0x20], data, 4) == 0, "batch data");
+  mod->SPIburstAutoIncrement = false;
+  printf("[SPI] Test:batched writes passed\n");
+  #endif
+
+  // stream commands, with RADIOLIB_SPI_PARANOID each one is followed by a status transaction
+  #if defined(RADIOLIB_SPI_PARANOID)
+  const uint32_t streamTransactions = 2;
+  #else
+  const uint32_t streamTransactions = 1;
+  #endif
+  hal->stream = true;
+  mod->SPIstatusCommand = MOCK_CMD_GET_STATUS;
+  uint8_t cmd[] = { MOCK_CMD_WRITE_BUFFER, 0x10 };
+  const size_t streamLens[] = { 10, sizeof(data) };
+  for(size_t len : streamLens) {
+    hal->reset();
+    cmd[0] = MOCK_CMD_WRITE_BUFFER;
+    RADIOLIB_TEST_ASSERT(mod->SPIwriteStream(cmd, 2, data, len) == RADIOLIB_ERR_NONE, "stream write");
+    RADIOLIB_TEST_ASSERT(hal->transactions == streamTransactions, "stream write transactions");
+    hal->reset();
+    cmd[0] = MOCK_CMD_READ_BUFFER;
+    memset(check, 0, sizeof(check));
+    RADIOLIB_TEST_ASSERT(mod->SPIreadStream(cmd, 2, check, len) == RADIOLIB_ERR_NONE, "stream read");
+    RADIOLIB_TEST_ASSERT(hal->transactions == streamTransactions, "stream read transactions");
+    RADIOLIB_TEST_ASSERT(memcmp(data, check, len) == 0, "stream data");
+  }
+  RADIOLIB_TEST_ASSERT(allocs == 0, "stream allocations");
+  printf("[SPI] Test:stream access passed\n");
+
+  // time spent in Module per register read, with a mock HAL that does nothing else
+  hal->stream = false;
+  auto start = std::chrono::steady_clock::now();
+  uint8_t sum = 0;
+  for(uint32_t i = 0; i < BENCH_LEN; i++) {
+    sum += mod->SPIreadRegister(i & 0x7F);
+  }
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("[SPI] Register read takes %.1f ns (checksum %d)\n", elapsed / BENCH_LEN * 1e9, sum);
+
+  return(0);
+}
@@ -0,0 +1,323 @@
+// this is a host test of FIFO streaming on SX127x FSK modem
+// a mock HAL emulates the FIFO, shift register and FIFO flags of the module on a simulated clock,
+// with random main loop latency between calls to serviceStream
+// every byte that is lost (FIFO underflow or overflow, or mode change before the last byte was sent) is counted
+
+#define RADIOLIB_TEST_NAME "Stream"
+#include "../TestHal.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// bit rate of the simulated link and the time of one byte on air in ns
+#define BIT_RATE_KBPS       (50)
+#define BYTE_NS             (8000000UL / BIT_RATE_KBPS)
+
+// simulated SPI timing in ns
+#define SPI_BYTE_NS         (1000)
+#define SPI_OVERHEAD_NS     (1500)
+
+// maximum main loop latency between calls to serviceStream in us
+#define MAX_LATENCY_US      (500)
+
+// longest stream and the simulated time limit for one stream in ns
+#define MAX_STREAM_LEN      (5000)
+#define TIMEOUT_NS          (2*MAX_STREAM_LEN*BYTE_NS)
+
+// simple deterministic generator, so that failures can be reproduced
+static uint32_t rngState = 0x12345678;
+static uint32_t rng() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return(rngState);
+}
+
+class MockHal : public TestHal {
+  public:
+    // emulated module registers and FIFO
+    uint8_t regs[128];
+    uint8_t fifo[RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK];
+    size_t fifoLen = 0;
+
+    // simulated time
+    uint32_t nowNs = 0;
+
+    // bytes that left the shift register (TX) or are still to be received (RX)
+    uint8_t air[MAX_STREAM_LEN];
+    size_t airLen = 0;
+    size_t airPos = 0;
+
+    // number of bytes lost
+    uint32_t underflows = 0;
+    uint32_t overflows = 0;
+    uint32_t cutOff = 0;
+
+    MockHal() {
+      memset(regs, 0, sizeof(regs));
+    }
+
+    void delay(unsigned long ms) override { this->wait(ms*1000000UL); }
+    void delayMicroseconds(unsigned long us) override { this->wait(us*1000UL); }
+    unsigned long millis() override { this->wait(100); return(this->nowNs / 1000000UL); }
+    unsigned long micros() override { this->wait(100); return(this->nowNs / 1000UL); }
+
+    void spiBeginTransaction() override {
+      this->wait(SPI_OVERHEAD_NS);
+      this->pos = 0;
+    }
+
+    void spiTransfer(uint8_t* out, size_t len, uint8_t* in) override {
+      for(size_t i = 0; i < len; i++) {
+        this->wait(SPI_BYTE_NS);
+        uint8_t b = out[i];
+        in[i] = this->respond(b);
+        this->pos++;
+      }
+    }
+
+    // start a new stream, for reception the bytes will arrive once the module is in RX mode
+    void reset(uint8_t* data, size_t len) {
+      this->fifoLen = 0;
+      this->shifting = false;
+      this->mode = RADIOLIB_SX127X_STANDBY;
+      this->airLen = len;
+      this->airPos = 0;
+      if(data) {
+        memcpy(this->air, data, len);
+      }
+      this->underflows = 0;
+      this->overflows = 0;
+      this->cutOff = 0;
+    }
+
+  private:
+    size_t pos = 0;
+    bool write = false;
+    uint8_t addr = 0;
+    uint8_t mode = RADIOLIB_SX127X_STANDBY;
+
+    // byte being sent, or the time when the next one is received
+    bool shifting = false;
+    uint8_t shiftByte = 0;
+    uint32_t shiftEnd = 0;
+
+    void wait(uint32_t ns) {
+      this->nowNs += ns;
+      if(this->mode == RADIOLIB_SX127X_TX) {
+        this->transmit();
+      } else if(this->mode == RADIOLIB_SX127X_RX) {
+        this->receive();
+      }
+    }
+
+    // fixed packet length, zero means unlimited
+    size_t packetLen() {
+      return(((size_t)(this->regs[RADIOLIB_SX127X_REG_PACKET_CONFIG_2] & 0x07) << 8) | this->regs[RADIOLIB_SX127X_REG_PAYLOAD_LENGTH_FSK]);
+    }
+
+    // next byte is taken from FIFO as soon as the previous one is sent
+    void transmit() {
+      while(true) {
+        if(this->shifting) {
+          if((int32_t)(this->nowNs - this->shiftEnd) < 0) {
+            return;
+          }
+          this->air[this->airPos++] = this->shiftByte;
+          this->shifting = false;
+          if(this->fifoLen == 0) {
+            this->underflows += (this->airPos < this->airLen);
+            return;
+          }
+          this->shiftEnd += BYTE_NS;
+        } else {
+          if(this->fifoLen == 0) {
+            return;
+          }
+          this->shiftEnd = this->nowNs + BYTE_NS;
+        }
+        this->shiftByte = this->pop();
+        this->shifting = true;
+      }
+    }
+
+    void receive() {
+      while((this->airPos < this->airLen) && ((int32_t)(this->nowNs - this->shiftEnd) >= 0)) {
+        if(this->fifoLen == sizeof(this->fifo)) {
+          this->overflows++;
+        } else {
+          this->fifo[this->fifoLen++] = this->air[this->airPos];
+        }
+        this->airPos++;
+        this->shiftEnd += BYTE_NS;
+      }
+    }
+
+    uint8_t pop() {
+      uint8_t b = this->fifo[0];
+      this->fifoLen--;
+      memmove(&this->fifo[0], &this->fifo[1], this->fifoLen);
+      return(b);
+    }
+
+    uint8_t flags() {
+      uint8_t flags = 0;
+      flags |= (this->fifoLen == sizeof(this->fifo)) ? RADIOLIB_SX127X_FLAG_FIFO_FULL : 0;
+      flags |= (this->fifoLen == 0) ? RADIOLIB_SX127X_FLAG_FIFO_EMPTY : 0;
+      flags |= (this->fifoLen > (this->regs[RADIOLIB_SX127X_REG_FIFO_THRESH] & 0x3F)) ? RADIOLIB_SX127X_FLAG_FIFO_LEVEL : 0;
+      size_t len = this->packetLen();
+      bool done = (len > 0) && (this->airPos >= len);
+      if((this->mode == RADIOLIB_SX127X_TX) && done && !this->shifting) {
+        flags |= RADIOLIB_SX127X_FLAG_PACKET_SENT;
+      }
+      // payload ready and CRC flags are cleared once FIFO is empty
+      if((this->mode == RADIOLIB_SX127X_RX) && done && (this->fifoLen > 0)) {
+        flags |= RADIOLIB_SX127X_FLAG_PAYLOAD_READY | RADIOLIB_SX127X_FLAG_CRC_OK;
+      }
+      return(flags);
+    }
+
+    void setMode(uint8_t mode) {
+      // anything still in FIFO or in the shift register is lost on mode change
+      if((this->mode == RADIOLIB_SX127X_TX) && (mode != RADIOLIB_SX127X_TX)) {
+        this->cutOff += this->fifoLen + (this->shifting ? 1 : 0);
+        this->shifting = false;
+      }
+      if((this->mode != RADIOLIB_SX127X_RX) && (mode == RADIOLIB_SX127X_RX)) {
+        this->shiftEnd = this->nowNs + BYTE_NS;
+      }
+      this->mode = mode;
+    }
+
+    // address byte with write flag in MSB, followed by data with address auto-increment except for FIFO
+    uint8_t respond(uint8_t out) {
+      if(this->pos == 0) {
+        this->write = out & 0x80;
+        this->addr = out & 0x7F;
+        return(0x00);
+      }
+      uint8_t reg = this->addr;
+      if(reg != RADIOLIB_SX127X_REG_FIFO) {
+        this->addr++;
+      }
+
+      if(this->write) {
+        if(reg == RADIOLIB_SX127X_REG_FIFO) {
+          if(this->fifoLen == sizeof(this->fifo)) {
+            this->overflows++;
+          } else {
+            this->fifo[this->fifoLen++] = out;
+          }
+        } else if(reg == RADIOLIB_SX127X_REG_OP_MODE) {
+          this->setMode(out & 0x07);
+        }
+        this->regs[reg] = out;
+        if(this->mode == RADIOLIB_SX127X_TX) {
+          this->transmit();
+        }
+        return(0x00);
+      }
+
+      if(reg == RADIOLIB_SX127X_REG_FIFO) {
+        if(this->fifoLen == 0) {
+          this->underflows++;
+          return(0x00);
+        }
+        return(this->pop());
+      } else if(reg == RADIOLIB_SX127X_REG_IRQ_FLAGS_2) {
+        return(this->flags());
+      }
+      return(this->regs[reg]);
+    }
+};
+
+MockHal mockHal;
+MockHal* hal = &mockHal;
+SX1278 radio(new Module(hal, 10, 2, 9, 3));
+
+// stream data and the position of the callbacks in it
+uint8_t data[MAX_STREAM_LEN];
+uint8_t received[MAX_STREAM_LEN];
+size_t streamPos = 0;
+
+size_t produce(uint8_t* buff, size_t len) {
+  memcpy(buff, &data[streamPos], len);
+  streamPos += len;
+  return(len);
+}
+
+void consume(uint8_t* buff, size_t len) {
+  memcpy(&received[streamPos], buff, len);
+  streamPos += len;
+}
+
+// keep calling serviceStream with random latency, until the stream is finished or time runs out
+int16_t service() {
+  uint32_t start = hal->nowNs;
+  int16_t state = RADIOLIB_STREAM_IN_PROGRESS;
+  while(hal->nowNs - start < TIMEOUT_NS) {
+    state = radio.serviceStream();
+    if(state != RADIOLIB_STREAM_IN_PROGRESS) {
+      break;
+    }
+    hal->delayMicroseconds(rng() % MAX_LATENCY_US);
+  }
+  return(state);
+}
+
+// fixed length packets, and unlimited length for streams over 2047 bytes
+const size_t streamLens[] = { 10, 100, 2047, 2048, MAX_STREAM_LEN };
+
+int testTransmit() {
+  for(size_t len : streamLens) {
+    for(size_t i = 0; i < len; i++) {
+      data[i] = (uint8_t)rng();
+    }
+    hal->reset(NULL, len);
+    streamPos = 0;
+    RADIOLIB_TEST_ASSERT(radio.startTransmitStream(len, produce) == RADIOLIB_ERR_NONE, "start transmit");
+    RADIOLIB_TEST_ASSERT(service() == RADIOLIB_ERR_NONE, "transmit finished");
+    radio.standby();
+
+    // everything must be sent before the module goes to standby
+    RADIOLIB_TEST_ASSERT((hal->underflows == 0) && (hal->overflows == 0), "transmit FIFO");
+    RADIOLIB_TEST_ASSERT(hal->cutOff == 0, "transmit cut off");
+    RADIOLIB_TEST_ASSERT((hal->airPos == len) && (memcmp(hal->air, data, len) == 0), "transmit data");
+  }
+
+  printf("[Stream] Test:transmit passed\n");
+  return(0);
+}
+
+int testReceive() {
+  for(size_t len : streamLens) {
+    for(size_t i = 0; i < len; i++) {
+      data[i] = (uint8_t)rng();
+    }
+    hal->reset(data, len);
+    streamPos = 0;
+    RADIOLIB_TEST_ASSERT(radio.startReceiveStream(len, consume) == RADIOLIB_ERR_NONE, "start receive");
+    RADIOLIB_TEST_ASSERT(service() == RADIOLIB_ERR_NONE, "receive finished");
+    radio.standby();
+
+    RADIOLIB_TEST_ASSERT((hal->underflows == 0) && (hal->overflows == 0), "receive FIFO");
+    RADIOLIB_TEST_ASSERT((streamPos == len) && (memcmp(received, data, len) == 0), "receive data");
+  }
+
+  printf("[Stream] Test:receive passed\n");
+  return(0);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+
+  hal->regs[RADIOLIB_SX127X_REG_VERSION] = 0x12;
+  RADIOLIB_TEST_ASSERT(radio.beginFSK(434.0, BIT_RATE_KBPS, 50.0, 125.0) == RADIOLIB_ERR_NONE, "begin");
+
+  if(testTransmit() || testReceive()) {
+    return(1);
+  }
+
+  return(0);
+}
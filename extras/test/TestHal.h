@@ -0,0 +1,39 @@
+#if !defined(_RADIOLIB_TEST_HAL_H)
+#define _RADIOLIB_TEST_HAL_H
+
+// common parts of the host tests
+// each test defines RADIOLIB_TEST_NAME before including this header
+
+#include <RadioLib/RadioLib.h>
+#include <stdio.h>
+
+#if !defined(RADIOLIB_TEST_NAME)
+  #error "RADIOLIB_TEST_NAME must be defined before including TestHal.h"
+#endif
+
+// fail the current test function when a condition does not hold
+#define RADIOLIB_TEST_ASSERT(COND, MSG) { if(!(COND)) { printf("[" RADIOLIB_TEST_NAME "] Test:%s failed!\n", MSG); return(1); } }
+
+// HAL that does nothing, tests only override the parts they emulate (registers, time, storage etc.)
+class TestHal : public RadioLibHal {
+  public:
+    TestHal() : RadioLibHal(0, 1, 0, 1, 1, 2) {}
+
+    void pinMode(uint32_t pin, uint32_t mode) override { (void)pin; (void)mode; }
+    void digitalWrite(uint32_t pin, uint32_t value) override { (void)pin; (void)value; }
+    uint32_t digitalRead(uint32_t pin) override { (void)pin; return(0); }
+    void attachInterrupt(uint32_t interruptNum, void (*interruptCb)(void), uint32_t mode) override { (void)interruptNum; (void)interruptCb; (void)mode; }
+    void detachInterrupt(uint32_t interruptNum) override { (void)interruptNum; }
+    void delay(unsigned long ms) override { (void)ms; }
+    void delayMicroseconds(unsigned long us) override { (void)us; }
+    unsigned long millis() override { return(0); }
+    unsigned long micros() override { return(0); }
+    long pulseIn(uint32_t pin, uint32_t state, unsigned long timeout) override { (void)pin; (void)state; (void)timeout; return(0); }
+    void spiBegin() override {}
+    void spiBeginTransaction() override {}
+    void spiTransfer(uint8_t* out, size_t len, uint8_t* in) override { (void)out; (void)len; (void)in; }
+    void spiEndTransaction() override {}
+    void spiEnd() override {}
+};
+
+#endif
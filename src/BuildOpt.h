@@ -48,6 +48,7 @@
   #define RADIOLIB_DEFAULT_SPI_SETTINGS               SPISettings(2000000, MSBFIRST, SPI_MODE0)
   #define RADIOLIB_NONVOLATILE                        PROGMEM
   #define RADIOLIB_NONVOLATILE_READ_BYTE(addr)        pgm_read_byte(addr)
+  #define RADIOLIB_NONVOLATILE_READ_WORD(addr)        pgm_read_word(addr)
   #define RADIOLIB_NONVOLATILE_READ_DWORD(addr)       pgm_read_dword(addr)
   #define RADIOLIB_TYPE_ALIAS(type, alias)            using alias = type;
 
@@ -282,6 +283,10 @@
     #define RADIOLIB_NONVOLATILE_READ_BYTE(addr)        pgm_read_byte(addr)
   #endif
 
+  #if !defined(RADIOLIB_NONVOLATILE_READ_WORD)
+    #define RADIOLIB_NONVOLATILE_READ_WORD(addr)        pgm_read_word(addr)
+  #endif
+
   #if !defined(RADIOLIB_NONVOLATILE_READ_DWORD)
     #define RADIOLIB_NONVOLATILE_READ_DWORD(addr)       pgm_read_dword(addr)
   #endif
@@ -309,6 +314,7 @@
   #define RADIOLIB_NC                                 (0xFF)
   #define RADIOLIB_NONVOLATILE
   #define RADIOLIB_NONVOLATILE_READ_BYTE(addr)        (*((uint8_t *)(void *)(addr)))
+  #define RADIOLIB_NONVOLATILE_READ_WORD(addr)        (*((uint16_t *)(void *)(addr)))
   #define RADIOLIB_NONVOLATILE_READ_DWORD(addr)       (*((uint32_t *)(void *)(addr)))
   #define RADIOLIB_TYPE_ALIAS(type, alias)            using alias = type;
 
@@ -422,6 +428,74 @@
   #define RADIOLIB_STATIC_ARRAY_SIZE   (256)
 #endif
 
+/*
+ * Number of 256-entry lookup tables used by the software CRC engine.
+ * 1 will process the input byte-by-byte and needs 1 kB of RAM for the tables,
+ * 4 or 8 will enable slice-by-4/slice-by-8 processing, at the cost of 4 or 8 kB of RAM.
+ */
+#if !defined(RADIOLIB_CRC_TABLE_SLICES)
+  #define RADIOLIB_CRC_TABLE_SLICES   (1)
+#endif
+
+/*
+ * Number of different CRC configurations the software CRC engine keeps lookup tables for.
+ * Instances with the same size, polynomial and input reflection share one table. When all of them
+ * are taken, further configurations are calculated bit-by-bit. In static-only mode, the tables
+ * are always reserved, otherwise they are only allocated while used.
+ */
+#if !defined(RADIOLIB_CRC_MAX_TABLES)
+  #define RADIOLIB_CRC_MAX_TABLES     (1)
+#endif
+
+/*
+ * Uncomment to enable 32-bit T-table implementation of AES-128 (used by LoRaWAN).
+ * This is significantly faster on 32-bit platforms, but needs 2 kB of RAM for the lookup tables
+ * and 176 bytes for decryption round keys. Note that the table lookups are not constant-time.
+ * Note: Disabled by default.
+ */
+#if !defined(RADIOLIB_AES128_T_TABLES)
+  //#define RADIOLIB_AES128_T_TABLES
+#endif
+
+/*
+ * Size of the stack buffers used for SPI transactions, two of these are used for every transaction.
+ * Transactions that fit (command, address and data) are sent as a single SPI transfer.
+ * Longer ones are sent directly from/to the caller's buffer, which takes more than one transfer.
+ */
+#if !defined(RADIOLIB_SPI_BUFF_SIZE)
+  #define RADIOLIB_SPI_BUFF_SIZE   (64)
+#endif
+
+/*
+ * Uncomment to enable batching of register writes. Writes between Module::SPIbeginBatch and Module::SPIendBatch
+ * are then queued and writes to adjacent registers are sent as a single burst, which speeds up configuration.
+ * The queue takes 6 bytes of RAM per entry in every Module instance.
+ * Note: Disabled by default.
+ */
+#if !defined(RADIOLIB_SPI_BATCH)
+  //#define RADIOLIB_SPI_BATCH
+#endif
+
+// maximum number of register writes queued between Module::SPIbeginBatch and Module::SPIendBatch
+#if !defined(RADIOLIB_SPI_BATCH_SIZE)
+  #define RADIOLIB_SPI_BATCH_SIZE   (16)
+#endif
+
+/*
+ * Uncomment to enable shadow cache of module registers. Registers that were already read or written
+ * are then served from the cache, so that read-modify-write cycles only take a single write.
+ * Ranges of registers that can be changed by the module itself (FIFO, IRQ flags, RSSI etc.) are declared by each driver.
+ * Only registers below RADIOLIB_SPI_REG_CACHE_SIZE are cached, each one takes 1 byte of RAM for the value and 1 bit for validity.
+ * Note: Disabled by default.
+ */
+#if !defined(RADIOLIB_SPI_REG_CACHE)
+  //#define RADIOLIB_SPI_REG_CACHE
+#endif
+
+#if !defined(RADIOLIB_SPI_REG_CACHE_SIZE)
+  #define RADIOLIB_SPI_REG_CACHE_SIZE   (128)
+#endif
+
 // the base address for persistent storage
 // some protocols (e.g. LoRaWAN) require a method
 // to store some data persistently
@@ -432,9 +506,22 @@
   #define RADIOLIB_HAL_PERSISTENT_STORAGE_BASE            (0)
 #endif
 
+// the amount of space allocated to the journal of frequently updated counters (e.g. LoRaWAN frame counter)
+// the counters are appended to the journal instead of being overwritten in place, so the larger
+// the journal, the more evenly the writes are spread over the persistent storage
+#if !defined(RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE)
+  #define RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE            (0x100)
+#endif
+
+// number of LoRaWAN uplink frame counter values reserved by a single write to persistent storage
+// after reset, the counter continues after the reserved block, so some values may be skipped
+#if !defined(RADIOLIB_LORAWAN_FCNT_UP_RESERVATION)
+  #define RADIOLIB_LORAWAN_FCNT_UP_RESERVATION            (16)
+#endif
+
 // the amount of space allocated to the persistent storage
 #if !defined(RADIOLIB_HAL_PERSISTENT_STORAGE_SIZE)
-  #define RADIOLIB_HAL_PERSISTENT_STORAGE_SIZE            (0x60)
+  #define RADIOLIB_HAL_PERSISTENT_STORAGE_SIZE            (0x50 + RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE)
 #endif
 
 // This only compiles on STM32 boards with SUBGHZ module, but also
@@ -7,6 +7,8 @@
 #include "BuildOpt.h"
 
 // list of persistent parameters
+// DevNonce and uplink frame counter are deprecated, these are now kept in the journal
+// and the old values are only read once to migrate them
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID    (0)
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_ADDR_ID     (1)
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID      (2)
@@ -15,17 +17,19 @@
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_FNWK_SINT_KEY_ID (5)
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_SNWK_SINT_KEY_ID (6)
 #define RADIOLIB_PERSISTENT_PARAM_LORAWAN_NWK_SENC_KEY_ID (7)
+#define RADIOLIB_PERSISTENT_PARAM_JOURNAL_ID              (8)
 
 static const uint32_t RadioLibPersistentParamTable[] = {
-  0x00,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID
+  0x00,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID (deprecated)
   0x04,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_ADDR_ID
-  0x08,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID
+  0x08,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID (deprecated)
   0x0C,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_MAGIC_ID
   0x10,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_APP_S_KEY_ID
   0x20,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_FNWK_SINT_KEY_ID
   0x30,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_SNWK_SINT_KEY_ID
   0x40,   // RADIOLIB_PERSISTENT_PARAM_LORAWAN_NWK_SENC_KEY_ID
-  0x50,   // end
+  0x50,   // RADIOLIB_PERSISTENT_PARAM_JOURNAL_ID
+  0x50 + RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE,   // end
 };
 
 /*!
@@ -171,6 +175,8 @@ class RadioLibHal {
 
     /*!
       \brief Method to transfer buffer over SPI.
+      This may be called multiple times within a single transaction (while chip select is held low),
+      and the input and output buffers may be the same.
       \param out Buffer to send.
       \param len Number of data to send or receive.
       \param in Buffer to save received data into.
@@ -10,6 +10,10 @@
 #include <stdarg.h>
 #endif
 
+#if RADIOLIB_SPI_BUFF_SIZE < 8
+  #error "RADIOLIB_SPI_BUFF_SIZE is too small to hold SPI command headers"
+#endif
+
 #if defined(RADIOLIB_BUILD_ARDUINO)
 #include "ArduinoHal.h"
 
@@ -48,6 +52,7 @@ void Module::init() {
   RADIOLIB_DEBUG_PRINTLN("Version:  %d.%d.%d.%d", RADIOLIB_VERSION_MAJOR, RADIOLIB_VERSION_MINOR, RADIOLIB_VERSION_PATCH, RADIOLIB_VERSION_EXTRA);
   RADIOLIB_DEBUG_PRINTLN("Platform: " RADIOLIB_PLATFORM);
   RADIOLIB_DEBUG_PRINTLN("Compiled: " __DATE__ " " __TIME__ "\n");
+  this->SPIcacheInvalidate();
 }
 
 void Module::term() {
@@ -73,6 +78,15 @@ int16_t Module::SPIsetRegValue(uint16_t reg, uint8_t value, uint8_t msb, uint8_t
   uint8_t currentValue = SPIreadRegister(reg);
   uint8_t mask = ~((0b11111111 << (msb + 1)) | (0b11111111 >> (8 - lsb)));
   uint8_t newValue = (currentValue & ~mask) | (value & mask);
+
+  #if defined(RADIOLIB_SPI_BATCH)
+  // when batching, the write (and its verification) is postponed until the batch is sent
+  if(this->batchDepth > 0) {
+    this->SPIqueueWrite(reg, newValue, checkMask, checkInterval);
+    return(RADIOLIB_ERR_NONE);
+  }
+  #endif
+
   SPIwriteRegister(reg, newValue);
 
   #if defined(RADIOLIB_SPI_PARANOID)
@@ -81,7 +95,7 @@ int16_t Module::SPIsetRegValue(uint16_t reg, uint8_t value, uint8_t msb, uint8_t
     uint32_t start = this->hal->micros();
     uint8_t readValue = 0x00;
     while(this->hal->micros() - start < (checkInterval * 1000)) {
-      readValue = SPIreadRegister(reg);
+      readValue = SPIreadRegisterDirect(reg);
       if((readValue & checkMask) == (newValue & checkMask)) {
         // check passed, we can stop the loop
         return(RADIOLIB_ERR_NONE);
@@ -105,15 +119,45 @@ int16_t Module::SPIsetRegValue(uint16_t reg, uint8_t value, uint8_t msb, uint8_t
 }
 
 void Module::SPIreadRegisterBurst(uint16_t reg, size_t numBytes, uint8_t* inBytes) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  if(this->batchLen > 0) {
+    this->SPIflushBatch();
+  }
+  #endif
+
   if(!SPIstreamType) {
     SPItransfer(SPIreadCommand, reg, NULL, inBytes, numBytes);
   } else {
     uint8_t cmd[] = { SPIreadCommand, (uint8_t)((reg >> 8) & 0xFF), (uint8_t)(reg & 0xFF) };
     SPItransferStream(cmd, 3, false, NULL, inBytes, numBytes, true, RADIOLIB_MODULE_SPI_TIMEOUT);
   }
+
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  this->SPIcacheUpdate(reg & ~this->SPIburstFlag, inBytes, numBytes);
+  #endif
 }
 
 uint8_t Module::SPIreadRegister(uint16_t reg) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  // queued value takes precedence
+  for(size_t i = this->batchLen; i > 0; i--) {
+    if(this->batch[i - 1].reg == reg) {
+      return(this->batch[i - 1].value);
+    }
+  }
+  #endif
+
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  if(this->SPIcacheable(reg) && (this->regCacheValid[reg / 8] & (1 << (reg % 8)))) {
+    this->SPIcacheSaved++;
+    return(this->regCache[reg]);
+  }
+  #endif
+
+  return(this->SPIreadRegisterDirect(reg));
+}
+
+uint8_t Module::SPIreadRegisterDirect(uint16_t reg) {
   uint8_t resp = 0;
   if(!SPIstreamType) {
     SPItransfer(SPIreadCommand, reg, NULL, &resp, 1);
@@ -121,86 +165,295 @@ uint8_t Module::SPIreadRegister(uint16_t reg) {
     uint8_t cmd[] = { SPIreadCommand, (uint8_t)((reg >> 8) & 0xFF), (uint8_t)(reg & 0xFF) };
     SPItransferStream(cmd, 3, false, NULL, &resp, 1, true, RADIOLIB_MODULE_SPI_TIMEOUT);
   }
+
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  this->SPIcacheUpdate(reg, &resp, 1);
+  #endif
   return(resp);
 }
 
 void Module::SPIwriteRegisterBurst(uint16_t reg, uint8_t* data, size_t numBytes) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  if(this->batchLen > 0) {
+    this->SPIflushBatch();
+  }
+  #endif
+
   if(!SPIstreamType) {
     SPItransfer(SPIwriteCommand, reg, data, NULL, numBytes);
   } else {
     uint8_t cmd[] = { SPIwriteCommand, (uint8_t)((reg >> 8) & 0xFF), (uint8_t)(reg & 0xFF) };
     SPItransferStream(cmd, 3, true, data, NULL, numBytes, true, RADIOLIB_MODULE_SPI_TIMEOUT);
   }
+
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  this->SPIcacheUpdate(reg & ~this->SPIburstFlag, data, numBytes);
+  #endif
 }
 
 void Module::SPIwriteRegister(uint16_t reg, uint8_t data) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  if(this->batchDepth > 0) {
+    this->SPIqueueWrite(reg, data, 0x00, 0);
+    return;
+  }
+  #endif
+
   if(!SPIstreamType) {
     SPItransfer(SPIwriteCommand, reg, &data, NULL, 1);
   } else {
     uint8_t cmd[] = { SPIwriteCommand, (uint8_t)((reg >> 8) & 0xFF), (uint8_t)(reg & 0xFF) };
     SPItransferStream(cmd, 3, true, &data, NULL, 1, true, RADIOLIB_MODULE_SPI_TIMEOUT);
   }
+
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  this->SPIcacheUpdate(reg, &data, 1);
+  #endif
 }
 
-void Module::SPItransfer(uint8_t cmd, uint16_t reg, uint8_t* dataOut, uint8_t* dataIn, size_t numBytes) {
-  // prepare the buffers
-  size_t buffLen = this->SPIaddrWidth/8 + numBytes;
-  #if defined(RADIOLIB_STATIC_ONLY)
-    uint8_t buffOut[RADIOLIB_STATIC_ARRAY_SIZE];
-    uint8_t buffIn[RADIOLIB_STATIC_ARRAY_SIZE];
+void Module::SPIcacheInvalidate() {
+  #if defined(RADIOLIB_SPI_REG_CACHE)
+  memset(this->regCacheValid, 0x00, sizeof(this->regCacheValid));
+  #endif
+}
+
+#if defined(RADIOLIB_SPI_REG_CACHE)
+bool Module::SPIcacheable(uint16_t reg) {
+  // stream-type modules are configured by commands, which can change registers as well
+  if(this->SPIstreamType || (reg >= RADIOLIB_SPI_REG_CACHE_SIZE)) {
+    return(false);
+  }
+
+  for(size_t i = 0; i < this->SPIvolatileRegsNum; i++) {
+    if((reg >= this->SPIvolatileRegs[i].first) && (reg <= this->SPIvolatileRegs[i].last)) {
+      return(false);
+    }
+  }
+  return(true);
+}
+
+void Module::SPIcacheUpdate(uint16_t reg, const uint8_t* data, size_t numBytes) {
+  // burst access to a volatile register (e.g. FIFO) does not increment the address
+  if(!this->SPIcacheable(reg)) {
+    return;
+  }
+
+  // without auto-increment, burst access targets a single multi-byte register, so just forget it
+  if((numBytes > 1) && !this->SPIburstAutoIncrement) {
+    this->regCacheValid[reg / 8] &= ~(1 << (reg % 8));
+    return;
+  }
+
+  for(size_t i = 0; i < numBytes; i++) {
+    uint16_t addr = reg + i;
+    if(this->SPIcacheable(addr)) {
+      this->regCache[addr] = data[i];
+      this->regCacheValid[addr / 8] |= (1 << (addr % 8));
+    }
+  }
+}
+#endif
+
+void Module::SPIbeginBatch() {
+  #if defined(RADIOLIB_SPI_BATCH)
+  if(this->batchDepth == 0) {
+    this->batchState = RADIOLIB_ERR_NONE;
+  }
+  this->batchDepth++;
+  #endif
+}
+
+int16_t Module::SPIendBatch() {
+  #if !defined(RADIOLIB_SPI_BATCH)
+  // writes were not queued, so there is nothing to send
+  return(RADIOLIB_ERR_NONE);
   #else
-    uint8_t* buffOut = new uint8_t[buffLen];
-    uint8_t* buffIn = new uint8_t[buffLen];
+  if(this->batchDepth == 0) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  // only the outermost batch actually sends anything
+  this->batchDepth--;
+  if(this->batchDepth > 0) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  this->SPIflushBatch();
+  return(this->batchState);
   #endif
-  uint8_t* buffOutPtr = buffOut;
+}
 
-  // copy the command
-  if(this->SPIaddrWidth <= 8) {
-    *(buffOutPtr++) = reg | cmd;
-  } else {
-    *(buffOutPtr++) = (reg >> 8) | cmd;
-    *(buffOutPtr++) = reg & 0xFF;
+#if defined(RADIOLIB_SPI_BATCH)
+void Module::SPIqueueWrite(uint16_t reg, uint8_t value, uint8_t checkMask, uint8_t checkInterval) {
+  // repeated writes to the same register are all kept, as some registers need intermediate values (e.g. mode changes)
+  if(this->batchLen == RADIOLIB_SPI_BATCH_SIZE) {
+    this->SPIflushBatch();
   }
 
-  // copy the data
-  if(cmd == SPIwriteCommand) {
-    memcpy(buffOutPtr, dataOut, numBytes);
+  SPIbatchEntry_t* entry = &this->batch[this->batchLen++];
+  entry->reg = reg;
+  entry->value = value;
+  entry->checkMask = checkMask;
+  entry->checkInterval = checkInterval;
+}
+
+void Module::SPIflushBatch() {
+  // send the writes directly from now on
+  size_t len = this->batchLen;
+  uint8_t depth = this->batchDepth;
+  this->batchLen = 0;
+  this->batchDepth = 0;
+
+  int16_t state = RADIOLIB_ERR_NONE;
+  uint8_t data[RADIOLIB_SPI_BATCH_SIZE];
+  for(size_t i = 0; i < len;) {
+    // find the run of adjacent registers, keeping the original order of writes
+    SPIbatchEntry_t* first = &this->batch[i];
+    size_t runLen = 1;
+    data[0] = first->value;
+    uint8_t checkInterval = first->checkInterval;
+    bool check = (first->checkMask != 0x00);
+    while(this->SPIburstAutoIncrement && (i + runLen < len) && (this->batch[i + runLen].reg == first->reg + runLen)) {
+      SPIbatchEntry_t* entry = &this->batch[i + runLen];
+      data[runLen++] = entry->value;
+      check |= (entry->checkMask != 0x00);
+      if(entry->checkInterval > checkInterval) {
+        checkInterval = entry->checkInterval;
+      }
+    }
+
+    if(runLen == 1) {
+      this->SPIwriteRegister(first->reg, data[0]);
+    } else {
+      this->SPIwriteRegisterBurst(first->reg | this->SPIburstFlag, data, runLen);
+    }
+
+    #if defined(RADIOLIB_SPI_PARANOID)
+    // read the whole run back until it matches or the longest check interval elapses
+    if(check) {
+      uint8_t readback[RADIOLIB_SPI_BATCH_SIZE];
+      bool match = false;
+      uint32_t start = this->hal->micros();
+      do {
+        if(runLen == 1) {
+          readback[0] = this->SPIreadRegisterDirect(first->reg);
+        } else {
+          this->SPIreadRegisterBurst(first->reg | this->SPIburstFlag, runLen, readback);
+        }
+        match = true;
+        for(size_t j = 0; j < runLen; j++) {
+          uint8_t checkMask = this->batch[i + j].checkMask;
+          if((readback[j] & checkMask) != (data[j] & checkMask)) {
+            match = false;
+            break;
+          }
+        }
+      } while(!match && (this->hal->micros() - start < (uint32_t)checkInterval * 1000));
+
+      if(!match) {
+        RADIOLIB_DEBUG_PRINTLN("batched write to 0x%X (%lu bytes) failed verification", first->reg, (unsigned long)runLen);
+        state = RADIOLIB_ERR_SPI_WRITE_FAILED;
+      }
+    }
+    #else
+    (void)check;
+    (void)checkInterval;
+    #endif
+
+    i += runLen;
+  }
+
+  // keep the first error until the batch is finished
+  this->batchDepth = depth;
+  if(this->batchState == RADIOLIB_ERR_NONE) {
+    this->batchState = state;
+  }
+}
+#endif
+
+void Module::SPItransfer(uint8_t cmd, uint16_t reg, uint8_t* dataOut, uint8_t* dataIn, size_t numBytes) {
+  // prepare the buffers
+  uint8_t buffOut[RADIOLIB_SPI_BUFF_SIZE];
+  uint8_t buffIn[RADIOLIB_SPI_BUFF_SIZE];
+  size_t hdrLen = this->SPIaddrWidth/8;
+
+  // copy the command
+  if(this->SPIaddrWidth <= 8) {
+    buffOut[0] = reg | cmd;
   } else {
-    memset(buffOutPtr, this->SPInopCommand, numBytes);
+    buffOut[0] = (reg >> 8) | cmd;
+    buffOut[1] = reg & 0xFF;
   }
 
   // do the transfer
   this->hal->spiBeginTransaction();
   this->hal->digitalWrite(this->csPin, this->hal->GpioLevelLow);
-  this->hal->spiTransfer(buffOut, buffLen, buffIn);
+  this->SPItransferFrame(buffOut, buffIn, hdrLen, (cmd == SPIwriteCommand) ? dataOut : NULL, (cmd == SPIreadCommand) ? dataIn : NULL, numBytes);
   this->hal->digitalWrite(this->csPin, this->hal->GpioLevelHigh);
   this->hal->spiEndTransaction();
-  
-  // copy the data
-  if(cmd == SPIreadCommand) {
-    memcpy(dataIn, &buffIn[this->SPIaddrWidth/8], numBytes);
-  }
 
   // print debug information
   #if defined(RADIOLIB_VERBOSE)
     uint8_t* debugBuffPtr = NULL;
     if(cmd == SPIwriteCommand) {
       RADIOLIB_VERBOSE_PRINT("W\t%X\t", reg);
-      debugBuffPtr = &buffOut[this->SPIaddrWidth/8];
+      debugBuffPtr = dataOut;
     } else if(cmd == SPIreadCommand) {
       RADIOLIB_VERBOSE_PRINT("R\t%X\t", reg);
-      debugBuffPtr = &buffIn[this->SPIaddrWidth/8];
+      debugBuffPtr = dataIn;
     }
-    for(size_t n = 0; n < numBytes; n++) {
+    for(size_t n = 0; (debugBuffPtr != NULL) && (n < numBytes); n++) {
       RADIOLIB_VERBOSE_PRINT("%X\t", debugBuffPtr[n]);
     }
     RADIOLIB_VERBOSE_PRINTLN();
   #endif
+}
 
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    delete[] buffOut;
-    delete[] buffIn;
-  #endif
+uint8_t Module::SPItransferFrame(uint8_t* buffOut, uint8_t* buffIn, size_t hdrLen, uint8_t* dataOut, uint8_t* dataIn, size_t numBytes) {
+  // short transaction, send everything at once
+  if(hdrLen + numBytes <= RADIOLIB_SPI_BUFF_SIZE) {
+    if(dataOut) {
+      memcpy(&buffOut[hdrLen], dataOut, numBytes);
+    } else {
+      memset(&buffOut[hdrLen], this->SPInopCommand, numBytes);
+    }
+    this->hal->spiTransfer(buffOut, hdrLen + numBytes, buffIn);
+    if(dataIn) {
+      memcpy(dataIn, &buffIn[hdrLen], numBytes);
+    }
+    return((numBytes > 0) ? buffIn[hdrLen] : 0);
+  }
+
+  // long transaction, send the header first and then transfer the payload without copying it
+  this->hal->spiTransfer(buffOut, hdrLen, buffIn);
+  if(dataIn) {
+    // receive directly into the caller buffer, which also provides the NOPs to send when there is nothing else
+    if(!dataOut) {
+      memset(dataIn, this->SPInopCommand, numBytes);
+      dataOut = dataIn;
+    }
+    this->hal->spiTransfer(dataOut, numBytes, dataIn);
+    return(dataIn[0]);
+  }
+
+  // nothing to receive, discard it in the stack buffer
+  uint8_t first = 0;
+  for(size_t i = 0; i < numBytes; i += RADIOLIB_SPI_BUFF_SIZE) {
+    size_t chunkLen = numBytes - i;
+    if(chunkLen > RADIOLIB_SPI_BUFF_SIZE) {
+      chunkLen = RADIOLIB_SPI_BUFF_SIZE;
+    }
+    if(dataOut) {
+      this->hal->spiTransfer(&dataOut[i], chunkLen, buffIn);
+    } else {
+      memset(buffOut, this->SPInopCommand, chunkLen);
+      this->hal->spiTransfer(buffOut, chunkLen, buffIn);
+    }
+    if(i == 0) {
+      first = buffIn[0];
+    }
+  }
+  return(first);
 }
 
 int16_t Module::SPIreadStream(uint8_t cmd, uint8_t* data, size_t numBytes, bool waitForGpio, bool verify) {
@@ -208,6 +461,13 @@ int16_t Module::SPIreadStream(uint8_t cmd, uint8_t* data, size_t numBytes, bool
 }
 
 int16_t Module::SPIreadStream(uint8_t* cmd, uint8_t cmdLen, uint8_t* data, size_t numBytes, bool waitForGpio, bool verify) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  // commands must not overtake queued register writes
+  if(this->batchLen > 0) {
+    this->SPIflushBatch();
+  }
+  #endif
+
   // send the command
   int16_t state = this->SPItransferStream(cmd, cmdLen, false, NULL, data, numBytes, waitForGpio, RADIOLIB_MODULE_SPI_TIMEOUT);
   RADIOLIB_ASSERT(state);
@@ -225,6 +485,13 @@ int16_t Module::SPIwriteStream(uint8_t cmd, uint8_t* data, size_t numBytes, bool
 }
 
 int16_t Module::SPIwriteStream(uint8_t* cmd, uint8_t cmdLen, uint8_t* data, size_t numBytes, bool waitForGpio, bool verify) {
+  #if defined(RADIOLIB_SPI_BATCH)
+  // commands must not overtake queued register writes
+  if(this->batchLen > 0) {
+    this->SPIflushBatch();
+  }
+  #endif
+
   // send the command
   int16_t state = this->SPItransferStream(cmd, cmdLen, true, data, NULL, numBytes, waitForGpio, RADIOLIB_MODULE_SPI_TIMEOUT);
   RADIOLIB_ASSERT(state);
@@ -258,29 +525,15 @@ int16_t Module::SPIcheckStream() {
 
 int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint8_t* dataOut, uint8_t* dataIn, size_t numBytes, bool waitForGpio, uint32_t timeout) {
   // prepare the buffers
-  size_t buffLen = cmdLen + numBytes;
-  if(!write) {
-    buffLen++;
-  }
-  #if defined(RADIOLIB_STATIC_ONLY)
-    uint8_t buffOut[RADIOLIB_STATIC_ARRAY_SIZE];
-    uint8_t buffIn[RADIOLIB_STATIC_ARRAY_SIZE];
-  #else
-    uint8_t* buffOut = new uint8_t[buffLen];
-    uint8_t* buffIn = new uint8_t[buffLen];
-  #endif
-  uint8_t* buffOutPtr = buffOut;
+  uint8_t buffOut[RADIOLIB_SPI_BUFF_SIZE];
+  uint8_t buffIn[RADIOLIB_SPI_BUFF_SIZE];
 
   // copy the command
-  for(uint8_t n = 0; n < cmdLen; n++) {
-    *(buffOutPtr++) = cmd[n];
-  }
-
-  // copy the data
-  if(write) {
-    memcpy(buffOutPtr, dataOut, numBytes);
-  } else {
-    memset(buffOutPtr, this->SPInopCommand, numBytes + 1);
+  // read-type commands have an extra status byte before the data
+  size_t hdrLen = cmdLen;
+  memcpy(buffOut, cmd, cmdLen);
+  if(!write) {
+    buffOut[hdrLen++] = this->SPInopCommand;
   }
 
   // ensure GPIO is low
@@ -292,10 +545,6 @@ int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint
       this->hal->yield();
       if(this->hal->millis() - start >= timeout) {
         RADIOLIB_DEBUG_PRINTLN("GPIO pre-transfer timeout, is it connected?");
-        #if !defined(RADIOLIB_STATIC_ONLY)
-          delete[] buffOut;
-          delete[] buffIn;
-        #endif
         return(RADIOLIB_ERR_SPI_CMD_TIMEOUT);
       }
     }
@@ -304,9 +553,12 @@ int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint
   // do the transfer
   this->hal->spiBeginTransaction();
   this->hal->digitalWrite(this->csPin, this->hal->GpioLevelLow);
-  this->hal->spiTransfer(buffOut, buffLen, buffIn);
+  uint8_t spiStatus = this->SPItransferFrame(buffOut, buffIn, hdrLen, write ? dataOut : NULL, write ? NULL : dataIn, numBytes);
   this->hal->digitalWrite(this->csPin, this->hal->GpioLevelHigh);
   this->hal->spiEndTransaction();
+  if(!write) {
+    spiStatus = buffIn[cmdLen];
+  }
 
   // wait for GPIO to go high and then low
   if(waitForGpio) {
@@ -319,10 +571,6 @@ int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint
         this->hal->yield();
         if(this->hal->millis() - start >= timeout) {
           RADIOLIB_DEBUG_PRINTLN("GPIO post-transfer timeout, is it connected?");
-          #if !defined(RADIOLIB_STATIC_ONLY)
-            delete[] buffOut;
-            delete[] buffIn;
-          #endif
           return(RADIOLIB_ERR_SPI_CMD_TIMEOUT);
         }
       }
@@ -332,13 +580,7 @@ int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint
   // parse status
   int16_t state = RADIOLIB_ERR_NONE;
   if((this->SPIparseStatusCb != nullptr) && (numBytes > 0)) {
-    state = this->SPIparseStatusCb(buffIn[cmdLen]);
-  }
-  
-  // copy the data
-  if(!write) {
-    // skip the first byte for read-type commands (status-only)
-    memcpy(dataIn, &buffIn[cmdLen + 1], numBytes);
+    state = this->SPIparseStatusCb(spiStatus);
   }
 
   // print debug information
@@ -350,30 +592,26 @@ int16_t Module::SPItransferStream(uint8_t* cmd, uint8_t cmdLen, bool write, uint
     } else {
       RADIOLIB_VERBOSE_PRINT("R\t");
     }
-    size_t n = 0;
-    for(; n < cmdLen; n++) {
+    for(size_t n = 0; n < cmdLen; n++) {
       RADIOLIB_VERBOSE_PRINT("%X\t", cmd[n]);
     }
     RADIOLIB_VERBOSE_PRINTLN();
 
     // print data bytes
-    RADIOLIB_VERBOSE_PRINT("SI\t");
-    for(; n < buffLen; n++) {
-      RADIOLIB_VERBOSE_PRINT("%X\t", buffOut[n]);
-    }
-    RADIOLIB_VERBOSE_PRINTLN();
-    RADIOLIB_VERBOSE_PRINT("SO\t");
-    for(n = cmdLen; n < buffLen; n++) {
-      RADIOLIB_VERBOSE_PRINT("%X\t", buffIn[n]);
+    if(write) {
+      RADIOLIB_VERBOSE_PRINT("SI\t");
+      for(size_t n = 0; n < numBytes; n++) {
+        RADIOLIB_VERBOSE_PRINT("%X\t", dataOut[n]);
+      }
+    } else {
+      RADIOLIB_VERBOSE_PRINT("SO\t%X\t", spiStatus);
+      for(size_t n = 0; n < numBytes; n++) {
+        RADIOLIB_VERBOSE_PRINT("%X\t", dataIn[n]);
+      }
     }
     RADIOLIB_VERBOSE_PRINTLN();
   #endif
 
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    delete[] buffOut;
-    delete[] buffIn;
-  #endif
-
   return(state);
 }
 
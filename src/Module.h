@@ -152,6 +152,45 @@ class Module {
     */
     bool SPIstreamType = false;
 
+    /*!
+      \brief Whether burst register access auto-increments the address.
+      When set, batched writes to adjacent registers are merged into a single burst. Defaults to false.
+    */
+    bool SPIburstAutoIncrement = false;
+
+    /*!
+      \brief Address bits that must be set for burst register access (e.g. CC1101). Defaults to 0x00.
+    */
+    uint16_t SPIburstFlag = 0x00;
+
+    /*!
+      \brief Range of registers, used to declare registers that must not be cached.
+    */
+    struct SPIregRange_t {
+      /*! \brief First register of the range. */
+      uint16_t first;
+
+      /*! \brief Last register of the range (inclusive). */
+      uint16_t last;
+    };
+
+    /*!
+      \brief Registers that can be changed by the module itself (FIFO, IRQ flags, RSSI etc.).
+      These are never cached when RADIOLIB_SPI_REG_CACHE is enabled. Set by the module driver.
+    */
+    const SPIregRange_t* SPIvolatileRegs = nullptr;
+
+    /*!
+      \brief Number of ranges in SPIvolatileRegs.
+    */
+    size_t SPIvolatileRegsNum = 0;
+
+    /*!
+      \brief Number of SPI transactions saved by the register cache (reads served from the cache).
+      Always 0 when RADIOLIB_SPI_REG_CACHE is disabled.
+    */
+    uint32_t SPIcacheSaved = 0;
+
     /*!
       \brief The last recorded SPI stream error.
     */
@@ -252,6 +291,30 @@ class Module {
     */
     void SPIwriteRegister(uint16_t reg, uint8_t data);
 
+    /*!
+      \brief Drop all cached register values. Must be called by the driver whenever the module
+      may have changed its configuration on its own, e.g. after reset or sleep that does not retain configuration.
+      Does nothing when RADIOLIB_SPI_REG_CACHE is disabled.
+    */
+    void SPIcacheInvalidate();
+
+    /*!
+      \brief Start queueing register writes. Until the matching call to SPIendBatch, register writes
+      (including those from SPIsetRegValue) are only recorded, and reading a queued register returns the queued value.
+      Reads of other registers are performed immediately and are not ordered with respect to the queued writes,
+      so batches should only wrap independent configuration registers. Batches may be nested.
+      Does nothing unless RADIOLIB_SPI_BATCH is enabled.
+    */
+    void SPIbeginBatch();
+
+    /*!
+      \brief Finish queueing register writes and send them, merging adjacent registers into bursts where possible.
+      With RADIOLIB_SPI_PARANOID, each burst is verified by reading it back.
+      Without RADIOLIB_SPI_BATCH, the writes were already sent and this always returns RADIOLIB_ERR_NONE.
+      \returns \ref status_codes
+    */
+    int16_t SPIendBatch();
+
     /*!
       \brief SPI single transfer method.
       \param cmd SPI access command (read/write/burst/...).
@@ -503,6 +566,39 @@ class Module {
     #if defined(RADIOLIB_INTERRUPT_TIMING)
     uint32_t prevTimingLen = 0;
     #endif
+
+    #if defined(RADIOLIB_SPI_REG_CACHE)
+    // shadow copy of module registers
+    uint8_t regCache[RADIOLIB_SPI_REG_CACHE_SIZE];
+    uint8_t regCacheValid[(RADIOLIB_SPI_REG_CACHE_SIZE + 7) / 8] = { 0 };
+
+    bool SPIcacheable(uint16_t reg);
+    void SPIcacheUpdate(uint16_t reg, const uint8_t* data, size_t numBytes);
+    #endif
+
+    // read a register from the module, bypassing the cache and queued writes
+    uint8_t SPIreadRegisterDirect(uint16_t reg);
+
+    #if defined(RADIOLIB_SPI_BATCH)
+    // queued register writes
+    struct SPIbatchEntry_t {
+      uint16_t reg;
+      uint8_t value;
+      uint8_t checkMask;
+      uint8_t checkInterval;
+    };
+    SPIbatchEntry_t batch[RADIOLIB_SPI_BATCH_SIZE];
+    size_t batchLen = 0;
+    uint8_t batchDepth = 0;
+    int16_t batchState = RADIOLIB_ERR_NONE;
+
+    void SPIqueueWrite(uint16_t reg, uint8_t value, uint8_t checkMask, uint8_t checkInterval);
+    void SPIflushBatch();
+    #endif
+
+    // transfer header (already in buffOut) and payload while chip select is low
+    // returns the first byte received after the header
+    uint8_t SPItransferFrame(uint8_t* buffOut, uint8_t* buffIn, size_t hdrLen, uint8_t* dataOut, uint8_t* dataIn, size_t numBytes);
 };
 
 #endif
@@ -102,6 +102,7 @@
 // utilities
 #include "utils/CRC.h"
 #include "utils/Cryptography.h"
+#include "utils/PacketRing.h"
 
 // only create Radio class when using RadioShield
 #if defined(RADIOLIB_RADIOSHIELD)
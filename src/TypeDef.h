@@ -250,6 +250,16 @@
 */
 #define RADIOLIB_ERR_NULL_POINTER                              (-28)
 
+/*!
+  \brief There is no free slot in the packet ring. The packet remains in the radio and can be read later.
+*/
+#define RADIOLIB_ERR_PACKET_RING_FULL                          (-29)
+
+/*!
+  \brief Stream transfer is still in progress, serviceStream has to be called again.
+*/
+#define RADIOLIB_STREAM_IN_PROGRESS                            (-30)
+
 // RF69-specific status codes
 
 /*!
@@ -464,6 +474,11 @@
 */
 #define RADIOLIB_ERR_RANGING_TIMEOUT                           (-901)
 
+/*!
+  \brief The supplied number of ranging addresses is invalid.
+*/
+#define RADIOLIB_ERR_INVALID_NUM_RANGING_ADDRS                 (-902)
+
 // Pager-specific status codes
 
 /*!
@@ -481,6 +496,11 @@
 */
 #define RADIOLIB_ERR_INVALID_FUNCTION                           (-1003)
 
+/*!
+  \brief The received code word contains more bit errors than the forward error correction is able to correct.
+*/
+#define RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD                    (-1004)
+
 // LoRaWAN-specific status codes
 
 /*!
@@ -519,10 +539,35 @@
 #define RADIOLIB_ERR_INVALID_CID                                (-1107)
 
 /*!
-  \brief User requested to start uplink while still inside RX window.
+  \brief User requested to start uplink while still inside RX window, or before the duty cycle limit allows it.
 */
 #define RADIOLIB_ERR_UPLINK_UNAVAILABLE                         (-1108)
 
+/*!
+  \brief MAC command queue is full, the command can only be added after the next uplink.
+*/
+#define RADIOLIB_ERR_COMMAND_QUEUE_FULL                         (-1109)
+
+/*!
+  \brief The network server has not answered the requested MAC command yet.
+*/
+#define RADIOLIB_ERR_NO_MAC_ANSWER                              (-1110)
+
+/*!
+  \brief Downlink frame counter is lower than expected (replayed frame), or too far ahead of the expected value.
+*/
+#define RADIOLIB_ERR_DOWNLINK_FCNT_INVALID                      (-1111)
+
+/*!
+  \brief No class B beacon was received yet.
+*/
+#define RADIOLIB_ERR_NO_BEACON                                  (-1112)
+
+/*!
+  \brief Invalid class B ping slot periodicity.
+*/
+#define RADIOLIB_ERR_INVALID_PING_PERIODICITY                   (-1113)
+
 /*!
   \}
 */
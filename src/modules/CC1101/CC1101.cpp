@@ -2,6 +2,14 @@
 #include <math.h>
 #if !defined(RADIOLIB_EXCLUDE_CC1101)
 
+// registers that are updated by the module itself (FIFO, IRQ flags, RSSI etc.) and must not be cached
+// frequency synthesizer calibration is also updated automatically
+static const Module::SPIregRange_t CC1101VolatileRegs[] = {
+  { RADIOLIB_CC1101_REG_FSCAL3, RADIOLIB_CC1101_REG_FSCAL0 },
+  { RADIOLIB_CC1101_REG_PARTNUM, RADIOLIB_CC1101_REG_FIFO },
+  { RADIOLIB_CC1101_REG_PARTNUM | RADIOLIB_CC1101_CMD_ACCESS_STATUS_REG, RADIOLIB_CC1101_REG_FIFO | RADIOLIB_CC1101_CMD_ACCESS_STATUS_REG },
+};
+
 CC1101::CC1101(Module* module) : PhysicalLayer(RADIOLIB_CC1101_FREQUENCY_STEP_SIZE, RADIOLIB_CC1101_MAX_PACKET_LENGTH) {
   this->mod = module;
 }
@@ -14,6 +22,10 @@ int16_t CC1101::begin(float freq, float br, float freqDev, float rxBw, int8_t pw
   // set module properties
   this->mod->SPIreadCommand = RADIOLIB_CC1101_CMD_READ;
   this->mod->SPIwriteCommand = RADIOLIB_CC1101_CMD_WRITE;
+  this->mod->SPIburstAutoIncrement = true;
+  this->mod->SPIburstFlag = RADIOLIB_CC1101_CMD_BURST;
+  this->mod->SPIvolatileRegs = CC1101VolatileRegs;
+  this->mod->SPIvolatileRegsNum = sizeof(CC1101VolatileRegs) / sizeof(CC1101VolatileRegs[0]);
   this->mod->init();
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
 
@@ -100,6 +112,7 @@ void CC1101::reset() {
   this->mod->hal->digitalWrite(this->mod->getCs(), this->mod->hal->GpioLevelLow);
   this->mod->hal->delay(10);
   SPIsendCommand(RADIOLIB_CC1101_CMD_RESET);
+  this->mod->SPIcacheInvalidate();
 }
 
 int16_t CC1101::transmit(uint8_t* data, size_t len, uint8_t addr) {
@@ -197,9 +210,8 @@ int16_t CC1101::transmitDirect(bool sync, uint32_t frf) {
 
   // user requested to start transmitting immediately (required for RTTY)
   if(frf != 0) {
-    SPIwriteRegister(RADIOLIB_CC1101_REG_FREQ2, (frf & 0xFF0000) >> 16);
-    SPIwriteRegister(RADIOLIB_CC1101_REG_FREQ1, (frf & 0x00FF00) >> 8);
-    SPIwriteRegister(RADIOLIB_CC1101_REG_FREQ0, frf & 0x0000FF);
+    uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+    SPIwriteRegisterBurst(RADIOLIB_CC1101_REG_FREQ2, data, 3);
 
     SPIsendCommand(RADIOLIB_CC1101_CMD_TX);
   }
@@ -210,9 +222,25 @@ int16_t CC1101::transmitDirect(bool sync, uint32_t frf) {
 
   // start transmitting
   SPIsendCommand(RADIOLIB_CC1101_CMD_TX);
+  this->directTx = true;
   return(state);
 }
 
+int16_t CC1101::retuneDirect(uint32_t frf) {
+  if(!this->directTx || (frf == 0)) {
+    return(transmitDirect(frf));
+  }
+
+  // direct mode and RF switch are already set, FREQ registers are consecutive
+  // the frequency synthesizer only calibrates on the way from IDLE to TX, so go through IDLE
+  uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+  SPIsendCommand(RADIOLIB_CC1101_CMD_IDLE);
+  SPIwriteRegisterBurst(RADIOLIB_CC1101_REG_FREQ2, data, 3);
+  SPIsendCommand(RADIOLIB_CC1101_CMD_TX);
+  this->directTx = true;
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t CC1101::receiveDirect() {
   return receiveDirect(true);
 }
@@ -330,6 +358,113 @@ int16_t CC1101::finishTransmit() {
   return(state);
 }
 
+int16_t CC1101::startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  standby();
+
+  // flush Tx FIFO
+  SPIsendCommand(RADIOLIB_CC1101_CMD_FLUSH_TX);
+
+  // set packet length and FIFO threshold
+  int16_t state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // set GDO2 mapping
+  state = SPIsetRegValue(RADIOLIB_CC1101_REG_IOCFG2, RADIOLIB_CC1101_GDOX_SYNC_WORD_SENT_OR_PKT_RECEIVED, 5, 0);
+  RADIOLIB_ASSERT(state);
+
+  // fill the whole FIFO
+  startStream(len, cb, NULL);
+  uint8_t buff[RADIOLIB_CC1101_FIFO_LENGTH];
+  size_t chunkLen = produceStream(buff, RADIOLIB_CC1101_FIFO_LENGTH);
+  if(chunkLen > 0) {
+    SPIwriteRegisterBurst(RADIOLIB_CC1101_REG_FIFO, buff, chunkLen);
+  }
+  updateStreamMode(this->streamLen - this->streamPos + chunkLen);
+
+  // set RF switch (if present)
+  this->mod->setRfSwitchState(Module::MODE_TX);
+
+  // set mode to transmit
+  SPIsendCommand(RADIOLIB_CC1101_CMD_TX);
+
+  return(state);
+}
+
+int16_t CC1101::startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = standby();
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // the rest is the same as for any other packet
+  startStream(len, NULL, cb);
+  return(startReceive());
+}
+
+int16_t CC1101::serviceStream() {
+  // check there is a stream in progress
+  if((this->streamProducer == NULL) && (this->streamConsumer == NULL)) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  uint8_t buff[RADIOLIB_CC1101_FIFO_LENGTH];
+  if(this->streamProducer != NULL) {
+    // top up the FIFO
+    uint8_t inFifo = getFifoBytes(RADIOLIB_CC1101_REG_TXBYTES);
+    updateStreamMode(this->streamLen - this->streamPos + inFifo);
+    size_t chunkLen = produceStream(buff, RADIOLIB_CC1101_FIFO_LENGTH - inFifo);
+    if(chunkLen > 0) {
+      SPIwriteRegisterBurst(RADIOLIB_CC1101_REG_FIFO, buff, chunkLen);
+    }
+
+    // wait until the last byte is sent
+    if(this->streamPos < this->streamLen) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+    uint8_t marcState = SPIgetRegValue(RADIOLIB_CC1101_REG_MARCSTATE, 4, 0);
+    if((marcState == RADIOLIB_CC1101_MARC_STATE_TX) || (marcState == RADIOLIB_CC1101_MARC_STATE_TX_END)) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+  } else {
+    // the last byte in FIFO must not be read until the whole packet is received
+    uint8_t inFifo = getFifoBytes(RADIOLIB_CC1101_REG_RXBYTES);
+    size_t chunkLen = this->streamLen - this->streamPos;
+    if(inFifo < chunkLen) {
+      updateStreamMode(chunkLen - inFifo);
+      chunkLen = (inFifo > 0) ? inFifo - 1 : 0;
+    }
+    if(chunkLen > 0) {
+      SPIreadRegisterBurst(RADIOLIB_CC1101_REG_FIFO, chunkLen, buff);
+      consumeStream(buff, chunkLen);
+    }
+    if(this->streamPos < this->streamLen) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+    // status bytes with CRC result are appended once the whole packet is received
+    if(SPIgetRegValue(RADIOLIB_CC1101_REG_PKTCTRL1, 2, 2) == RADIOLIB_CC1101_APPEND_STATUS_ON) {
+      if(getFifoBytes(RADIOLIB_CC1101_REG_RXBYTES) < 2) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      this->rawRSSI = SPIgetRegValue(RADIOLIB_CC1101_REG_FIFO);
+      uint8_t val = SPIgetRegValue(RADIOLIB_CC1101_REG_FIFO);
+      this->rawLQI = val & 0x7F;
+      if(this->crcOn && (val & RADIOLIB_CC1101_CRC_OK) == RADIOLIB_CC1101_CRC_ERROR) {
+        finishStream();
+        return(RADIOLIB_ERR_CRC_MISMATCH);
+      }
+    }
+  }
+
+  finishStream();
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t CC1101::startReceive() {
   // set mode to standby
   int16_t state = standby();
@@ -955,20 +1090,23 @@ int16_t CC1101::config() {
 
   standby();
 
+  // queue the configuration, adjacent registers are then written in a single burst
+  this->mod->SPIbeginBatch();
+
   // enable automatic frequency synthesizer calibration and disable pin control
   int16_t state = SPIsetRegValue(RADIOLIB_CC1101_REG_MCSM0, RADIOLIB_CC1101_FS_AUTOCAL_IDLE_TO_RXTX, 5, 4);
   state |= SPIsetRegValue(RADIOLIB_CC1101_REG_MCSM0, RADIOLIB_CC1101_PIN_CTRL_OFF, 1, 1);
-  RADIOLIB_ASSERT(state);
 
   // set GDOs to Hi-Z so that it doesn't output clock on startup (might confuse GDO0 action)
-  state = SPIsetRegValue(RADIOLIB_CC1101_REG_IOCFG0, RADIOLIB_CC1101_GDOX_HIGH_Z, 5, 0);
+  state |= SPIsetRegValue(RADIOLIB_CC1101_REG_IOCFG0, RADIOLIB_CC1101_GDOX_HIGH_Z, 5, 0);
   state |= SPIsetRegValue(RADIOLIB_CC1101_REG_IOCFG2, RADIOLIB_CC1101_GDOX_HIGH_Z, 5, 0);
-  RADIOLIB_ASSERT(state);
 
   // set packet mode
-  state = packetMode();
+  state |= packetMode();
 
-  return(state);
+  int16_t batchState = this->mod->SPIendBatch();
+  RADIOLIB_ASSERT(state);
+  return(batchState);
 }
 
 int16_t CC1101::directMode(bool sync) {
@@ -1042,6 +1180,49 @@ int16_t CC1101::setPacketMode(uint8_t mode, uint16_t len) {
   return(state);
 }
 
+int16_t CC1101::setStreamMode(size_t len) {
+  // save the packet length, the stream will overwrite it
+  this->streamPacketLen = SPIgetRegValue(RADIOLIB_CC1101_REG_PKTLEN);
+
+  // packet length is 8-bit, longer streams have to start in infinite mode
+  this->streamInfinite = (len > 0xFF);
+  uint8_t lenConfig = RADIOLIB_CC1101_LENGTH_CONFIG_FIXED;
+  if(this->streamInfinite) {
+    lenConfig = RADIOLIB_CC1101_LENGTH_CONFIG_INFINITE;
+  }
+  int16_t state = SPIsetRegValue(RADIOLIB_CC1101_REG_PKTCTRL0, lenConfig, 1, 0);
+  state |= SPIsetRegValue(RADIOLIB_CC1101_REG_PKTLEN, len & 0xFF);
+  state |= SPIsetRegValue(RADIOLIB_CC1101_REG_FIFOTHR, RADIOLIB_CC1101_FIFO_THR_TX_33_RX_32, 3, 0);
+  return(state);
+}
+
+void CC1101::updateStreamMode(size_t remLen) {
+  // packet counter runs modulo 256, so the switch to fixed length has to be done
+  // once less than 256 bytes are left to be sent or received
+  if(this->streamInfinite && (remLen <= 0xFF)) {
+    SPIsetRegValue(RADIOLIB_CC1101_REG_PKTCTRL0, RADIOLIB_CC1101_LENGTH_CONFIG_FIXED, 1, 0);
+    this->streamInfinite = false;
+  }
+}
+
+void CC1101::finishStream() {
+  // restore packet length configuration
+  SPIsetRegValue(RADIOLIB_CC1101_REG_PKTCTRL0, this->packetLengthConfig, 1, 0);
+  SPIsetRegValue(RADIOLIB_CC1101_REG_PKTLEN, this->streamPacketLen);
+  startStream(0, NULL, NULL);
+}
+
+uint8_t CC1101::getFifoBytes(uint8_t reg) {
+  // the number of bytes may be wrong if it changes during the read, so it has to be read twice (errata)
+  uint8_t prev = 0;
+  uint8_t count = SPIgetRegValue(reg, 6, 0);
+  do {
+    prev = count;
+    count = SPIgetRegValue(reg, 6, 0);
+  } while(count != prev);
+  return(count);
+}
+
 int16_t CC1101::SPIgetRegValue(uint8_t reg, uint8_t msb, uint8_t lsb) {
   // status registers require special command
   if((reg > RADIOLIB_CC1101_REG_TEST0) && (reg < RADIOLIB_CC1101_REG_PATABLE)) {
@@ -1087,6 +1268,9 @@ void CC1101::SPIwriteRegisterBurst(uint8_t reg, uint8_t* data, size_t len) {
 }
 
 void CC1101::SPIsendCommand(uint8_t cmd) {
+  // all mode changes are done by command strobes
+  this->directTx = false;
+
   // pull NSS low
   this->mod->hal->digitalWrite(this->mod->getCs(), this->mod->hal->GpioLevelLow);
 
@@ -9,6 +9,7 @@
 // CC1101 physical layer properties
 #define RADIOLIB_CC1101_FREQUENCY_STEP_SIZE                     396.7285156
 #define RADIOLIB_CC1101_MAX_PACKET_LENGTH                       63
+#define RADIOLIB_CC1101_FIFO_LENGTH                             64
 #define RADIOLIB_CC1101_CRYSTAL_FREQ                            26.0
 #define RADIOLIB_CC1101_DIV_EXPONENT                            16
 
@@ -607,6 +608,15 @@ class CC1101: public PhysicalLayer {
     */
     int16_t transmitDirect(uint32_t frf = 0) override;
 
+    /*!
+      \brief Changes frequency of direct transmission already started by transmitDirect.
+      The module briefly goes to idle, so that the frequency synthesizer is calibrated for the new frequency.
+      If the module is not transmitting in direct mode, this is the same as calling transmitDirect.
+      \param frf 24-bit raw frequency value to transmit at.
+      \returns \ref status_codes
+    */
+    int16_t retuneDirect(uint32_t frf) override;
+
     /*!
       \brief Starts direct mode reception.
       \returns \ref status_codes
@@ -696,6 +706,31 @@ class CC1101: public PhysicalLayer {
     */
     int16_t finishTransmit() override;
 
+    /*!
+      \brief Interrupt-driven stream transmit method. Streams longer than 255 bytes are started
+      in infinite packet length mode, which is switched to fixed length for the last 255 bytes.
+      \param len Total number of bytes to transmit.
+      \param cb Callback that provides the next chunk of data.
+      \returns \ref status_codes
+    */
+    int16_t startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Interrupt-driven stream receive method. Streams longer than 255 bytes are started
+      in infinite packet length mode, which is switched to fixed length for the last 255 bytes.
+      \param len Total number of bytes to receive.
+      \param cb Callback that gets the next chunk of received data.
+      \returns \ref status_codes
+    */
+    int16_t startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Moves data between FIFO and the stream callbacks. CC1101 reports the exact number of bytes in FIFO,
+      so it is always refilled (or emptied) completely.
+      \returns \ref status_codes
+    */
+    int16_t serviceStream() override;
+
     /*!
       \brief Interrupt-driven receive method. GDO0 will be activated when full packet is received.
       \returns \ref status_codes
@@ -975,6 +1010,9 @@ class CC1101: public PhysicalLayer {
     bool promiscuous = false;
     bool crcOn = true;
     bool directModeEnabled = true;
+    bool directTx = false; // transmitting in direct mode, cleared by any command strobe
+    bool streamInfinite = false; // stream is in infinite packet length mode
+    uint8_t streamPacketLen = 0; // packet length to restore once the stream is finished
 
     int8_t power = RADIOLIB_CC1101_DEFAULT_POWER;
 
@@ -984,6 +1022,10 @@ class CC1101: public PhysicalLayer {
     int16_t directMode(bool sync);
     static void getExpMant(float target, uint16_t mantOffset, uint8_t divExp, uint8_t expMax, uint8_t& exp, uint8_t& mant);
     int16_t setPacketMode(uint8_t mode, uint16_t len);
+    int16_t setStreamMode(size_t len);
+    void updateStreamMode(size_t remLen);
+    void finishStream();
+    uint8_t getFifoBytes(uint8_t reg);
 };
 
 #endif
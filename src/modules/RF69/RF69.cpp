@@ -2,6 +2,15 @@
 #include <math.h>
 #if !defined(RADIOLIB_EXCLUDE_RF69)
 
+// registers that are updated by the module itself (FIFO, IRQ flags, RSSI etc.) and must not be cached
+static const Module::SPIregRange_t RF69VolatileRegs[] = {
+  { RADIOLIB_RF69_REG_FIFO, RADIOLIB_RF69_REG_OP_MODE },
+  { RADIOLIB_RF69_REG_OSC_1, RADIOLIB_RF69_REG_OSC_1 },
+  { RADIOLIB_RF69_REG_AFC_FEI, RADIOLIB_RF69_REG_RSSI_VALUE },
+  { RADIOLIB_RF69_REG_IRQ_FLAGS_1, RADIOLIB_RF69_REG_IRQ_FLAGS_2 },
+  { RADIOLIB_RF69_REG_TEMP_1, RADIOLIB_RF69_REG_TEMP_2 },
+};
+
 RF69::RF69(Module* module) : PhysicalLayer(RADIOLIB_RF69_FREQUENCY_STEP_SIZE, RADIOLIB_RF69_MAX_PACKET_LENGTH)  {
   this->mod = module;
 }
@@ -13,6 +22,7 @@ Module* RF69::getMod() {
 int16_t RF69::begin(float freq, float br, float freqDev, float rxBw, int8_t pwr, uint8_t preambleLen) {
   // set module properties
   this->mod->init();
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
 
   // try to find the RF69 chip
@@ -100,6 +110,8 @@ void RF69::reset() {
   this->mod->hal->delay(1);
   this->mod->hal->digitalWrite(this->mod->getRst(), this->mod->hal->GpioLevelLow);
   this->mod->hal->delay(10);
+  this->mod->SPIcacheInvalidate();
+  this->directTx = false;
 }
 
 int16_t RF69::transmit(uint8_t* data, size_t len, uint8_t addr) {
@@ -174,20 +186,33 @@ int16_t RF69::transmitDirect(uint32_t frf) {
   this->mod->setRfSwitchState(Module::MODE_TX);
 
   // user requested to start transmitting immediately (required for RTTY)
+  int16_t state = RADIOLIB_ERR_NONE;
   if(frf != 0) {
-    this->mod->SPIwriteRegister(RADIOLIB_RF69_REG_FRF_MSB, (frf & 0xFF0000) >> 16);
-    this->mod->SPIwriteRegister(RADIOLIB_RF69_REG_FRF_MID, (frf & 0x00FF00) >> 8);
-    this->mod->SPIwriteRegister(RADIOLIB_RF69_REG_FRF_LSB, frf & 0x0000FF);
+    uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+    this->mod->SPIwriteRegisterBurst(RADIOLIB_RF69_REG_FRF_MSB, data, 3);
 
-    return(setMode(RADIOLIB_RF69_TX));
+  } else {
+    // activate direct mode
+    state = directMode();
+    RADIOLIB_ASSERT(state);
   }
 
-  // activate direct mode
-  int16_t state = directMode();
-  RADIOLIB_ASSERT(state);
-
   // start transmitting
-  return(setMode(RADIOLIB_RF69_TX));
+  state = setMode(RADIOLIB_RF69_TX);
+  this->directTx = (state == RADIOLIB_ERR_NONE);
+  return(state);
+}
+
+int16_t RF69::retuneDirect(uint32_t frf) {
+  if(!this->directTx || (frf == 0)) {
+    return(transmitDirect(frf));
+  }
+
+  // RF switch and mode are already set, FRF registers are consecutive
+  // the new frequency is applied once the last one is written
+  uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+  this->mod->SPIwriteRegisterBurst(RADIOLIB_RF69_REG_FRF_MSB, data, 3);
+  return(RADIOLIB_ERR_NONE);
 }
 
 int16_t RF69::receiveDirect() {
@@ -384,6 +409,127 @@ bool RF69::fifoGet(volatile uint8_t* data, int totalLen, volatile int* rcvLen) {
   return(false);
 }
 
+int16_t RF69::startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = setMode(RADIOLIB_RF69_STANDBY);
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // clear interrupt flags
+  clearIRQFlags();
+
+  // set DIO mapping
+  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DIO_MAPPING_1, RADIOLIB_RF69_DIO0_PACK_PACKET_SENT | RADIOLIB_RF69_DIO1_PACK_FIFO_LEVEL, 7, 4);
+  RADIOLIB_ASSERT(state);
+
+  // fill the whole FIFO, transmission will start as soon as there is at least one byte
+  startStream(len, cb, NULL);
+  uint8_t buff[RADIOLIB_RF69_MAX_PACKET_LENGTH];
+  size_t chunkLen = produceStream(buff, RADIOLIB_RF69_MAX_PACKET_LENGTH);
+  if(chunkLen > 0) {
+    this->mod->SPIwriteRegisterBurst(RADIOLIB_RF69_REG_FIFO, buff, chunkLen);
+  }
+
+  // enable +20 dBm operation
+  if(this->power > 17) {
+    state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OCP, RADIOLIB_RF69_OCP_OFF | 0x0F);
+    state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_TEST_PA1, RADIOLIB_RF69_PA1_20_DBM);
+    state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_TEST_PA2, RADIOLIB_RF69_PA2_20_DBM);
+    RADIOLIB_ASSERT(state);
+  }
+
+  // set RF switch (if present)
+  this->mod->setRfSwitchState(Module::MODE_TX);
+
+  // set mode to transmit
+  return(setMode(RADIOLIB_RF69_TX));
+}
+
+int16_t RF69::startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = setMode(RADIOLIB_RF69_STANDBY);
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // the rest is the same as for any other packet
+  startStream(len, NULL, cb);
+  return(startReceive());
+}
+
+int16_t RF69::serviceStream() {
+  // check there is a stream in progress
+  if((this->streamProducer == NULL) && (this->streamConsumer == NULL)) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  uint8_t buff[RADIOLIB_RF69_MAX_PACKET_LENGTH];
+  uint8_t flags = this->mod->SPIreadRegister(RADIOLIB_RF69_REG_IRQ_FLAGS_2);
+  if(this->streamProducer != NULL) {
+    // while FIFO level is at or below the threshold, everything above it is free
+    while(!(flags & RADIOLIB_RF69_IRQ_FIFO_LEVEL) && (this->streamPos < this->streamLen)) {
+      size_t chunkLen = produceStream(buff, RADIOLIB_RF69_MAX_PACKET_LENGTH - RADIOLIB_RF69_FIFO_THRESH);
+      if(chunkLen == 0) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      this->mod->SPIwriteRegisterBurst(RADIOLIB_RF69_REG_FIFO, buff, chunkLen);
+      flags = this->mod->SPIreadRegister(RADIOLIB_RF69_REG_IRQ_FLAGS_2);
+    }
+
+    // fixed length packet is done once it is sent, there is no such event in unlimited length mode
+    if(this->streamPos < this->streamLen) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+    if(this->streamLen > 0xFF) {
+      if(flags & RADIOLIB_RF69_IRQ_FIFO_NOT_EMPTY) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+    } else if(!(flags & RADIOLIB_RF69_IRQ_PACKET_SENT)) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+  } else {
+    // FIFO level above the threshold means there is at least one byte more than the threshold,
+    // the last few bytes may never get there, so those are read one by one
+    // payload ready and CRC flags are cleared once FIFO is empty, so in fixed length mode
+    // the last byte is kept in FIFO until the whole packet is received
+    bool fixedLen = (this->streamLen <= 0xFF);
+    uint8_t lastFlags = flags;
+    while(this->streamPos < this->streamLen) {
+      size_t chunkLen = 1;
+      if(this->streamLen - this->streamPos > RADIOLIB_RF69_FIFO_THRESH) {
+        if(!(flags & RADIOLIB_RF69_IRQ_FIFO_LEVEL)) {
+          return(RADIOLIB_STREAM_IN_PROGRESS);
+        }
+        chunkLen = RADIOLIB_RF69_FIFO_THRESH + 1;
+      } else if(!(flags & RADIOLIB_RF69_IRQ_FIFO_NOT_EMPTY)) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      } else if(fixedLen && (this->streamLen - this->streamPos == 1) && !(flags & RADIOLIB_RF69_IRQ_PAYLOAD_READY)) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      lastFlags = flags;
+      this->mod->SPIreadRegisterBurst(RADIOLIB_RF69_REG_FIFO, chunkLen, buff);
+      consumeStream(buff, chunkLen);
+      flags = this->mod->SPIreadRegister(RADIOLIB_RF69_REG_IRQ_FLAGS_2);
+    }
+
+    // there is no CRC in unlimited length mode
+    bool crcOn = (this->mod->SPIgetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, 4, 4) == RADIOLIB_RF69_CRC_ON);
+    if(fixedLen && crcOn && !(lastFlags & RADIOLIB_RF69_IRQ_CRC_OK)) {
+      finishStream();
+      return(RADIOLIB_ERR_CRC_MISMATCH);
+    }
+  }
+
+  finishStream();
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t RF69::startTransmit(uint8_t* data, size_t len, uint8_t addr) {
   // set mode to standby
   int16_t state = setMode(RADIOLIB_RF69_STANDBY);
@@ -989,57 +1135,57 @@ int16_t RF69::getChipVersion() {
 int16_t RF69::config() {
   int16_t state = RADIOLIB_ERR_NONE;
 
+  // shared with SX1231
+  this->mod->SPIvolatileRegs = RF69VolatileRegs;
+  this->mod->SPIvolatileRegsNum = sizeof(RF69VolatileRegs) / sizeof(RF69VolatileRegs[0]);
+
   // set mode to STANDBY
   state = setMode(RADIOLIB_RF69_STANDBY);
   RADIOLIB_ASSERT(state);
 
+  // queue the configuration, adjacent registers are then written in a single burst
+  this->mod->SPIbeginBatch();
+
   // set operation modes
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OP_MODE, RADIOLIB_RF69_SEQUENCER_ON | RADIOLIB_RF69_LISTEN_OFF, 7, 6);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OP_MODE, RADIOLIB_RF69_SEQUENCER_ON | RADIOLIB_RF69_LISTEN_OFF, 7, 6);
 
   // enable over-current protection
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OCP, RADIOLIB_RF69_OCP_ON, 4, 4);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OCP, RADIOLIB_RF69_OCP_ON, 4, 4);
 
   // set data mode, modulation type and shaping
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DATA_MODUL, RADIOLIB_RF69_PACKET_MODE | RADIOLIB_RF69_FSK, 6, 3);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DATA_MODUL, RADIOLIB_RF69_PACKET_MODE | RADIOLIB_RF69_FSK, 6, 3);
   state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DATA_MODUL, RADIOLIB_RF69_FSK_GAUSSIAN_0_3, 1, 0);
-  RADIOLIB_ASSERT(state);
 
   // set RSSI threshold
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_RSSI_THRESH, RADIOLIB_RF69_RSSI_THRESHOLD, 7, 0);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_RSSI_THRESH, RADIOLIB_RF69_RSSI_THRESHOLD, 7, 0);
 
   // reset FIFO flag
   this->mod->SPIwriteRegister(RADIOLIB_RF69_REG_IRQ_FLAGS_2, RADIOLIB_RF69_IRQ_FIFO_OVERRUN);
 
   // disable ClkOut on DIO5
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DIO_MAPPING_2, RADIOLIB_RF69_CLK_OUT_OFF, 2, 0);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_DIO_MAPPING_2, RADIOLIB_RF69_CLK_OUT_OFF, 2, 0);
 
   // set packet configuration and disable encryption
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, RADIOLIB_RF69_PACKET_FORMAT_VARIABLE | RADIOLIB_RF69_DC_FREE_NONE | RADIOLIB_RF69_CRC_ON | RADIOLIB_RF69_CRC_AUTOCLEAR_ON | RADIOLIB_RF69_ADDRESS_FILTERING_OFF, 7, 1);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, RADIOLIB_RF69_PACKET_FORMAT_VARIABLE | RADIOLIB_RF69_DC_FREE_NONE | RADIOLIB_RF69_CRC_ON | RADIOLIB_RF69_CRC_AUTOCLEAR_ON | RADIOLIB_RF69_ADDRESS_FILTERING_OFF, 7, 1);
   state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_2, RADIOLIB_RF69_INTER_PACKET_RX_DELAY, 7, 4);
   state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_2, RADIOLIB_RF69_AUTO_RX_RESTART_ON | RADIOLIB_RF69_AES_OFF, 1, 0);
-  RADIOLIB_ASSERT(state);
 
   // set payload length
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PAYLOAD_LENGTH, RADIOLIB_RF69_PAYLOAD_LENGTH, 7, 0);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PAYLOAD_LENGTH, RADIOLIB_RF69_PAYLOAD_LENGTH, 7, 0);
 
   // set FIFO threshold
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_FIFO_THRESH, RADIOLIB_RF69_TX_START_CONDITION_FIFO_NOT_EMPTY | RADIOLIB_RF69_FIFO_THRESH, 7, 0);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_FIFO_THRESH, RADIOLIB_RF69_TX_START_CONDITION_FIFO_NOT_EMPTY | RADIOLIB_RF69_FIFO_THRESH, 7, 0);
 
   // set Rx timeouts
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_RX_TIMEOUT_1, RADIOLIB_RF69_TIMEOUT_RX_START, 7, 0);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_RX_TIMEOUT_1, RADIOLIB_RF69_TIMEOUT_RX_START, 7, 0);
   state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_RX_TIMEOUT_2, RADIOLIB_RF69_TIMEOUT_RSSI_THRESH, 7, 0);
-  RADIOLIB_ASSERT(state);
 
   // enable improved fading margin
-  state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_TEST_DAGC, RADIOLIB_RF69_CONTINUOUS_DAGC_LOW_BETA_OFF, 7, 0);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_TEST_DAGC, RADIOLIB_RF69_CONTINUOUS_DAGC_LOW_BETA_OFF, 7, 0);
 
-  return(state);
+  int16_t batchState = this->mod->SPIendBatch();
+  RADIOLIB_ASSERT(state);
+  return(batchState);
 }
 
 int16_t RF69::setPacketMode(uint8_t mode, uint8_t len) {
@@ -1062,6 +1208,7 @@ int16_t RF69::setPacketMode(uint8_t mode, uint8_t len) {
 }
 
 int16_t RF69::setMode(uint8_t mode) {
+  this->directTx = false;
   return(this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_OP_MODE, mode, 4, 2));
 }
 
@@ -1070,6 +1217,31 @@ void RF69::clearIRQFlags() {
   this->mod->SPIwriteRegister(RADIOLIB_RF69_REG_IRQ_FLAGS_2, 0b11111111);
 }
 
+int16_t RF69::setStreamMode(size_t len) {
+  // save the payload length, the stream will overwrite it
+  this->streamPayloadLen = this->mod->SPIreadRegister(RADIOLIB_RF69_REG_PAYLOAD_LENGTH);
+
+  // fixed packet length is 8-bit, zero length means unlimited
+  if(len > 0xFF) {
+    len = 0;
+  }
+  int16_t state = this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, RADIOLIB_RF69_PACKET_FORMAT_FIXED, 7, 7);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PAYLOAD_LENGTH, len);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_FIFO_THRESH, RADIOLIB_RF69_TX_START_CONDITION_FIFO_NOT_EMPTY | RADIOLIB_RF69_FIFO_THRESH, 7, 0);
+
+  // payload ready must be issued even on CRC mismatch, otherwise a failed stream would never finish
+  state |= this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, RADIOLIB_RF69_CRC_AUTOCLEAR_OFF, 3, 3);
+  return(state);
+}
+
+void RF69::finishStream() {
+  // restore packet length and CRC configuration
+  this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, this->packetLengthConfig, 7, 7);
+  this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PACKET_CONFIG_1, RADIOLIB_RF69_CRC_AUTOCLEAR_ON, 3, 3);
+  this->mod->SPIsetRegValue(RADIOLIB_RF69_REG_PAYLOAD_LENGTH, this->streamPayloadLen);
+  startStream(0, NULL, NULL);
+}
+
 void RF69::clearFIFO(size_t count) {
   while(count) {
     this->mod->SPIreadRegister(RADIOLIB_RF69_REG_FIFO);
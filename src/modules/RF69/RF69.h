@@ -562,6 +562,14 @@ class RF69: public PhysicalLayer {
     */
     int16_t transmitDirect(uint32_t frf = 0) override;
 
+    /*!
+      \brief Changes frequency of direct transmission already started by transmitDirect in a single SPI transaction.
+      If the module is not transmitting in direct mode, this is the same as calling transmitDirect.
+      \param frf 24-bit raw frequency value to transmit at.
+      \returns \ref status_codes
+    */
+    int16_t retuneDirect(uint32_t frf) override;
+
     /*!
       \brief Starts direct mode reception.
       \returns \ref status_codes
@@ -679,6 +687,31 @@ class RF69: public PhysicalLayer {
     */
     bool fifoGet(volatile uint8_t* data, int totalLen, volatile int* rcvLen);
 
+    /*!
+      \brief Interrupt-driven stream transmit method. Streams up to 255 bytes long are sent as fixed length packets,
+      longer ones use unlimited packet length, in which case CRC is not supported.
+      \param len Total number of bytes to transmit.
+      \param cb Callback that provides the next chunk of data.
+      \returns \ref status_codes
+    */
+    int16_t startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Interrupt-driven stream receive method. Streams up to 255 bytes long are received as fixed length packets,
+      longer ones use unlimited packet length, in which case CRC is not supported.
+      \param len Total number of bytes to receive.
+      \param cb Callback that gets the next chunk of received data.
+      \returns \ref status_codes
+    */
+    int16_t startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Moves data between FIFO and the stream callbacks. FIFO is refilled (or emptied) in chunks
+      as soon as its level crosses the FIFO threshold.
+      \returns \ref status_codes
+    */
+    int16_t serviceStream() override;
+
     /*!
       \brief Interrupt-driven binary transmit method.
       Overloads for string-based transmissions are implemented in PhysicalLayer.
@@ -1028,9 +1061,14 @@ class RF69: public PhysicalLayer {
 #if !defined(RADIOLIB_GODMODE)
   private:
 #endif
+    bool directTx = false; // transmitting in direct mode, cleared by any mode change or reset
+    uint8_t streamPayloadLen = 0; // payload length to restore once the stream is finished
+
     int16_t setMode(uint8_t mode);
     void clearIRQFlags();
     void clearFIFO(size_t count);
+    int16_t setStreamMode(size_t len);
+    void finishStream();
 };
 
 #endif
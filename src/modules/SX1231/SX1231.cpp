@@ -8,6 +8,7 @@ SX1231::SX1231(Module* mod) : RF69(mod) {
 int16_t SX1231::begin(float freq, float br, float freqDev, float rxBw, int8_t power, uint8_t preambleLen) {
   // set module properties
   this->mod->init();
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
   this->mod->hal->pinMode(this->mod->getRst(), this->mod->hal->GpioModeOutput);
 
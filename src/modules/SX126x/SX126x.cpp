@@ -22,6 +22,7 @@ int16_t SX126x::begin(uint8_t cr, uint8_t syncWord, uint16_t preambleLength, flo
   this->mod->SPInopCommand = RADIOLIB_SX126X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX126X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   
   // try to find the SX126x chip
@@ -107,6 +108,7 @@ int16_t SX126x::beginFSK(float br, float freqDev, float rxBw, uint16_t preambleL
   this->mod->SPInopCommand = RADIOLIB_SX126X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX126X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   
   // try to find the SX126x chip
@@ -738,6 +740,54 @@ int16_t SX126x::readData(uint8_t* data, size_t len) {
   return(state);
 }
 
+int16_t SX126x::readPacket(RadioLibPacket_t* pkt) {
+  if(pkt == NULL) {
+    return(RADIOLIB_ERR_NULL_POINTER);
+  }
+  pkt->timestamp = this->mod->hal->micros();
+
+  // check integrity CRC
+  uint16_t irq = getIrqStatus();
+  pkt->state = RADIOLIB_ERR_NONE;
+  if((irq & RADIOLIB_SX126X_IRQ_CRC_ERR) || (irq & RADIOLIB_SX126X_IRQ_HEADER_ERR)) {
+    pkt->state = RADIOLIB_ERR_CRC_MISMATCH;
+  }
+
+  // get packet length and its position in the buffer
+  uint8_t modem = getPacketType();
+  uint8_t rxBufStatus[2] = {0, 0};
+  int16_t state = this->mod->SPIreadStream(RADIOLIB_SX126X_CMD_GET_RX_BUFFER_STATUS, rxBufStatus, 2);
+  RADIOLIB_ASSERT(state);
+  size_t length = rxBufStatus[0];
+  if((modem == RADIOLIB_SX126X_PACKET_TYPE_LORA) && (this->headerType == RADIOLIB_SX126X_LORA_HEADER_IMPLICIT)) {
+    length = this->implicitLen;
+  }
+  if(length > RADIOLIB_PACKET_RING_MAX_LEN) {
+    length = RADIOLIB_PACKET_RING_MAX_LEN;
+  }
+
+  // read packet data from where it was actually received, so the base address does not have to be reset
+  state = readBuffer(pkt->data, length, rxBufStatus[1]);
+  RADIOLIB_ASSERT(state);
+  pkt->len = length;
+
+  // get RSSI and SNR from a single packet status
+  uint8_t packetStatus[3] = {0, 0, 0};
+  state = this->mod->SPIreadStream(RADIOLIB_SX126X_CMD_GET_PACKET_STATUS, packetStatus, 3);
+  RADIOLIB_ASSERT(state);
+  pkt->rssi = -1.0 * packetStatus[2]/2.0;
+  pkt->snr = 0;
+  if(modem == RADIOLIB_SX126X_PACKET_TYPE_LORA) {
+    pkt->snr = (int8_t)packetStatus[1]/4.0;
+  }
+
+  // clear interrupt flags
+  state = clearIrqStatus();
+  RADIOLIB_ASSERT(state);
+
+  return(pkt->state);
+}
+
 int16_t SX126x::startChannelScan() {
   return(this->startChannelScan(RADIOLIB_SX126X_CAD_PARAM_DEFAULT, RADIOLIB_SX126X_CAD_PARAM_DEFAULT, RADIOLIB_SX126X_CAD_PARAM_DEFAULT));
 }
@@ -1931,6 +1981,10 @@ int16_t SX126x::setFrequencyRaw(float freq) {
   return(setRfFrequency(frf));
 }
 
+int16_t SX126x::setFrequencyRaw(uint32_t frf) {
+  return(setRfFrequency(frf));
+}
+
 int16_t SX126x::fixSensitivity() {
   // fix receiver sensitivity for 500 kHz LoRa
   // see SX1262/SX1268 datasheet, chapter 15 Known Limitations, section 15.1 for details
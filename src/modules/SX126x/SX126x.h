@@ -696,6 +696,15 @@ class SX126x: public PhysicalLayer {
       \returns \ref status_codes
     */
     int16_t readData(uint8_t* data, size_t len) override;
+
+    /*!
+      \brief Reads packet received after calling startReceive method, including its metadata.
+      Unlike readData, length, RSSI and SNR are all read at once, and the payload is read from its actual
+      position in the buffer directly into the packet structure.
+      \param pkt Packet structure to save the packet in.
+      \returns \ref status_codes
+    */
+    int16_t readPacket(RadioLibPacket_t* pkt) override;
     
     /*!
       \brief Interrupt-driven channel activity detection method. DIO1 will be activated
@@ -778,6 +787,14 @@ class SX126x: public PhysicalLayer {
     */
     int16_t setFrequencyDeviation(float freqDev) override;
 
+    /*!
+      \brief Sets carrier frequency as raw value sent by SetRfFrequency command. No range checking or image calibration is done,
+      the new frequency should be in the same band as the last one set by setFrequency.
+      \param frf Carrier frequency in multiples of synthesizer frequency step.
+      \returns \ref status_codes
+    */
+    int16_t setFrequencyRaw(uint32_t frf) override;
+
     /*!
       \brief Sets FSK bit rate. Allowed values range from 0.6 to 300.0 kbps.
       \param br FSK bit rate to be set in kbps.
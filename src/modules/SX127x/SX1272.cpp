@@ -77,6 +77,8 @@ void SX1272::reset() {
   this->mod->hal->delay(1);
   this->mod->hal->digitalWrite(this->mod->getRst(), this->mod->hal->GpioLevelLow);
   this->mod->hal->delay(5);
+  this->mod->SPIcacheInvalidate();
+  this->directTx = false;
 }
 
 int16_t SX1272::setFrequency(float freq) {
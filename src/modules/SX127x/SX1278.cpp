@@ -77,6 +77,8 @@ void SX1278::reset() {
   this->mod->hal->delay(1);
   this->mod->hal->digitalWrite(this->mod->getRst(), this->mod->hal->GpioLevelHigh);
   this->mod->hal->delay(5);
+  this->mod->SPIcacheInvalidate();
+  this->directTx = false;
 }
 
 int16_t SX1278::setFrequency(float freq) {
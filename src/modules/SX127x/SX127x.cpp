@@ -2,6 +2,27 @@
 #include <math.h>
 #if !defined(RADIOLIB_EXCLUDE_SX127X)
 
+// registers that are updated by the module itself (FIFO, IRQ flags, RSSI etc.) and must not be cached
+// the register map depends on the active modem
+static const Module::SPIregRange_t SX127xVolatileRegsLoRa[] = {
+  { RADIOLIB_SX127X_REG_FIFO, RADIOLIB_SX127X_REG_OP_MODE },
+  { RADIOLIB_SX127X_REG_FIFO_ADDR_PTR, RADIOLIB_SX127X_REG_FIFO_ADDR_PTR },
+  { RADIOLIB_SX127X_REG_FIFO_RX_CURRENT_ADDR, RADIOLIB_SX127X_REG_HOP_CHANNEL },
+  { RADIOLIB_SX127X_REG_FIFO_RX_BYTE_ADDR, RADIOLIB_SX127X_REG_FIFO_RX_BYTE_ADDR },
+  { RADIOLIB_SX127X_REG_FEI_MSB, RADIOLIB_SX127X_REG_RSSI_WIDEBAND },
+  { RADIOLIB_SX127X_REG_IMAGE_CAL, RADIOLIB_SX127X_REG_TEMP }, // accessed in FSK mode by getTempRaw
+};
+
+static const Module::SPIregRange_t SX127xVolatileRegsFSK[] = {
+  { RADIOLIB_SX127X_REG_FIFO, RADIOLIB_SX127X_REG_OP_MODE },
+  { RADIOLIB_SX127X_REG_RX_CONFIG, RADIOLIB_SX127X_REG_RX_CONFIG },
+  { RADIOLIB_SX127X_REG_RSSI_VALUE_FSK, RADIOLIB_SX127X_REG_RSSI_VALUE_FSK },
+  { RADIOLIB_SX127X_REG_AFC_FEI, RADIOLIB_SX127X_REG_FEI_LSB_FSK },
+  { RADIOLIB_SX127X_REG_OSC, RADIOLIB_SX127X_REG_OSC },
+  { RADIOLIB_SX127X_REG_IMAGE_CAL, RADIOLIB_SX127X_REG_TEMP },
+  { RADIOLIB_SX127X_REG_IRQ_FLAGS_1, RADIOLIB_SX127X_REG_IRQ_FLAGS_2 },
+};
+
 SX127x::SX127x(Module* mod) : PhysicalLayer(RADIOLIB_SX127X_FREQUENCY_STEP_SIZE, RADIOLIB_SX127X_MAX_PACKET_LENGTH) {
   this->mod = mod;
 }
@@ -13,6 +34,8 @@ Module* SX127x::getMod() {
 int16_t SX127x::begin(uint8_t chipVersion, uint8_t syncWord, uint16_t preambleLength) {
   // set module properties
   this->mod->init();
+  this->mod->SPIburstAutoIncrement = true;
+  setVolatileRegs(RADIOLIB_SX127X_LORA);
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
   this->mod->hal->pinMode(this->mod->getGpio(), this->mod->hal->GpioModeInput);
 
@@ -64,6 +87,8 @@ int16_t SX127x::begin(uint8_t chipVersion, uint8_t syncWord, uint16_t preambleLe
 int16_t SX127x::beginFSK(uint8_t chipVersion, float freqDev, float rxBw, uint16_t preambleLength, bool enableOOK) {
   // set module properties
   this->mod->init();
+  this->mod->SPIburstAutoIncrement = true;
+  setVolatileRegs(RADIOLIB_SX127X_FSK_OOK);
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
   this->mod->hal->pinMode(this->mod->getGpio(), this->mod->hal->GpioModeInput);
 
@@ -305,23 +330,36 @@ int16_t SX127x::transmitDirect(uint32_t frf) {
   this->mod->setRfSwitchState(Module::MODE_TX);
 
   // user requested to start transmitting immediately (required for RTTY)
+  int16_t state = RADIOLIB_ERR_NONE;
   if(frf != 0) {
-    this->mod->SPIwriteRegister(RADIOLIB_SX127X_REG_FRF_MSB, (frf & 0xFF0000) >> 16);
-    this->mod->SPIwriteRegister(RADIOLIB_SX127X_REG_FRF_MID, (frf & 0x00FF00) >> 8);
-    this->mod->SPIwriteRegister(RADIOLIB_SX127X_REG_FRF_LSB, frf & 0x0000FF);
+    uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+    this->mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FRF_MSB, data, 3);
 
-    return(setMode(RADIOLIB_SX127X_TX));
+  } else {
+    // activate direct mode
+    state = directMode();
+    RADIOLIB_ASSERT(state);
+
+    // apply fixes to errata
+    RADIOLIB_ERRATA_SX127X(false);
   }
 
-  // activate direct mode
-  int16_t state = directMode();
-  RADIOLIB_ASSERT(state);
+  // start transmitting
+  state = setMode(RADIOLIB_SX127X_TX);
+  this->directTx = (state == RADIOLIB_ERR_NONE);
+  return(state);
+}
 
-  // apply fixes to errata
-  RADIOLIB_ERRATA_SX127X(false);
+int16_t SX127x::retuneDirect(uint32_t frf) {
+  if(!this->directTx || (frf == 0)) {
+    return(transmitDirect(frf));
+  }
 
-  // start transmitting
-  return(setMode(RADIOLIB_SX127X_TX));
+  // modem, RF switch and mode are already set, FRF registers are consecutive
+  // the new frequency is applied once the last one is written
+  uint8_t data[] = { (uint8_t)((frf & 0xFF0000) >> 16), (uint8_t)((frf & 0x00FF00) >> 8), (uint8_t)(frf & 0x0000FF) };
+  this->mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FRF_MSB, data, 3);
+  return(RADIOLIB_ERR_NONE);
 }
 
 int16_t SX127x::receiveDirect() {
@@ -548,6 +586,120 @@ bool SX127x::fifoGet(volatile uint8_t* data, int totalLen, volatile int* rcvLen)
   return(false);
 }
 
+int16_t SX127x::startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = setMode(RADIOLIB_SX127X_STANDBY);
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // clear interrupt flags
+  clearIRQFlags();
+
+  // set DIO mapping
+  state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_DIO_MAPPING_1, RADIOLIB_SX127X_DIO0_PACK_PACKET_SENT | RADIOLIB_SX127X_DIO1_PACK_FIFO_LEVEL, 7, 4);
+  RADIOLIB_ASSERT(state);
+
+  // fill the whole FIFO, transmission will start as soon as there is at least one byte
+  startStream(len, cb, NULL);
+  uint8_t buff[RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK];
+  size_t chunkLen = produceStream(buff, RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK);
+  if(chunkLen > 0) {
+    this->mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FIFO, buff, chunkLen);
+  }
+
+  // set RF switch (if present)
+  this->mod->setRfSwitchState(Module::MODE_TX);
+
+  // start transmission
+  return(setMode(RADIOLIB_SX127X_TX));
+}
+
+int16_t SX127x::startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = setMode(RADIOLIB_SX127X_STANDBY);
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // the rest is the same as for any other packet
+  startStream(len, NULL, cb);
+  return(startReceive());
+}
+
+int16_t SX127x::serviceStream() {
+  // check there is a stream in progress
+  if((this->streamProducer == NULL) && (this->streamConsumer == NULL)) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  uint8_t buff[RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK];
+  uint8_t flags = this->mod->SPIreadRegister(RADIOLIB_SX127X_REG_IRQ_FLAGS_2);
+  if(this->streamProducer != NULL) {
+    // while FIFO level is at or below the threshold, everything above it is free
+    while(!(flags & RADIOLIB_SX127X_FLAG_FIFO_LEVEL) && (this->streamPos < this->streamLen)) {
+      size_t chunkLen = produceStream(buff, RADIOLIB_SX127X_MAX_PACKET_LENGTH_FSK - RADIOLIB_SX127X_FIFO_THRESH);
+      if(chunkLen == 0) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      this->mod->SPIwriteRegisterBurst(RADIOLIB_SX127X_REG_FIFO, buff, chunkLen);
+      flags = this->mod->SPIreadRegister(RADIOLIB_SX127X_REG_IRQ_FLAGS_2);
+    }
+
+    // fixed length packet is done once it is sent, there is no such event in unlimited length mode
+    if(this->streamPos < this->streamLen) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+    if(this->streamLen > 0x7FF) {
+      // once FIFO is empty, the last byte is still in the shift register, so wait until it is sent as well
+      if(!(flags & RADIOLIB_SX127X_FLAG_FIFO_EMPTY)) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      this->mod->hal->delayMicroseconds((uint32_t)(8000.0 / this->bitRate) + 1);
+    } else if(!(flags & RADIOLIB_SX127X_FLAG_PACKET_SENT)) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+  } else {
+    // FIFO level above the threshold means there is at least one byte more than the threshold,
+    // the last few bytes may never get there, so those are read one by one
+    // payload ready and CRC flags are cleared once FIFO is empty, so in fixed length mode
+    // the last byte is kept in FIFO until the whole packet is received
+    bool fixedLen = (this->streamLen <= 0x7FF);
+    uint8_t lastFlags = flags;
+    while(this->streamPos < this->streamLen) {
+      size_t chunkLen = 1;
+      if(this->streamLen - this->streamPos > RADIOLIB_SX127X_FIFO_THRESH) {
+        if(!(flags & RADIOLIB_SX127X_FLAG_FIFO_LEVEL)) {
+          return(RADIOLIB_STREAM_IN_PROGRESS);
+        }
+        chunkLen = RADIOLIB_SX127X_FIFO_THRESH + 1;
+      } else if(flags & RADIOLIB_SX127X_FLAG_FIFO_EMPTY) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      } else if(fixedLen && (this->streamLen - this->streamPos == 1) && !(flags & RADIOLIB_SX127X_FLAG_PAYLOAD_READY)) {
+        return(RADIOLIB_STREAM_IN_PROGRESS);
+      }
+      lastFlags = flags;
+      this->mod->SPIreadRegisterBurst(RADIOLIB_SX127X_REG_FIFO, chunkLen, buff);
+      consumeStream(buff, chunkLen);
+      flags = this->mod->SPIreadRegister(RADIOLIB_SX127X_REG_IRQ_FLAGS_2);
+    }
+
+    // there is no CRC in unlimited length mode
+    if(fixedLen && this->crcOn && !(lastFlags & RADIOLIB_SX127X_FLAG_CRC_OK)) {
+      finishStream();
+      return(RADIOLIB_ERR_CRC_MISMATCH);
+    }
+  }
+
+  finishStream();
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t SX127x::startTransmit(uint8_t* data, size_t len, uint8_t addr) {
   // set mode to standby
   int16_t state = setMode(RADIOLIB_SX127X_STANDBY);
@@ -1138,6 +1290,12 @@ int16_t SX127x::setOOK(bool enableOOK) {
 }
 
 int16_t SX127x::setFrequencyRaw(float newFreq) {
+  // calculate register values
+  uint32_t FRF = (newFreq * (uint32_t(1) << RADIOLIB_SX127X_DIV_EXPONENT)) / RADIOLIB_SX127X_CRYSTAL_FREQ;
+  return(setFrequencyRaw(FRF));
+}
+
+int16_t SX127x::setFrequencyRaw(uint32_t frf) {
   int16_t state = RADIOLIB_ERR_NONE;
 
   // set mode to standby if not FHSS
@@ -1145,13 +1303,14 @@ int16_t SX127x::setFrequencyRaw(float newFreq) {
     state = setMode(RADIOLIB_SX127X_STANDBY);
   }
 
-  // calculate register values
-  uint32_t FRF = (newFreq * (uint32_t(1) << RADIOLIB_SX127X_DIV_EXPONENT)) / RADIOLIB_SX127X_CRYSTAL_FREQ;
-
   // write registers
-  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_MSB, (FRF & 0xFF0000) >> 16);
-  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_MID, (FRF & 0x00FF00) >> 8);
-  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_LSB, FRF & 0x0000FF);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_MSB, (frf & 0xFF0000) >> 16);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_MID, (frf & 0x00FF00) >> 8);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FRF_LSB, frf & 0x0000FF);
+  if(state == RADIOLIB_ERR_NONE) {
+    // band-dependent settings still need the frequency in MHz
+    this->frequency = ((float)frf * RADIOLIB_SX127X_CRYSTAL_FREQ) / (uint32_t(1) << RADIOLIB_SX127X_DIV_EXPONENT);
+  }
   return(state);
 }
 
@@ -1416,37 +1575,38 @@ int16_t SX127x::config() {
 }
 
 int16_t SX127x::configFSK() {
+  // queue the configuration, adjacent registers are then written in a single burst
+  // no write is actually performed until the batch ends, so errors are collected at the end
+  this->mod->SPIbeginBatch();
+
   // set RSSI threshold
   int16_t state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_RSSI_THRESH, RADIOLIB_SX127X_RSSI_THRESHOLD);
-  RADIOLIB_ASSERT(state);
 
   // reset FIFO flag
   this->mod->SPIwriteRegister(RADIOLIB_SX127X_REG_IRQ_FLAGS_2, RADIOLIB_SX127X_FLAG_FIFO_OVERRUN);
 
   // set packet configuration
-  state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, RADIOLIB_SX127X_PACKET_VARIABLE | RADIOLIB_SX127X_DC_FREE_NONE | RADIOLIB_SX127X_CRC_ON | RADIOLIB_SX127X_CRC_AUTOCLEAR_ON | RADIOLIB_SX127X_ADDRESS_FILTERING_OFF | RADIOLIB_SX127X_CRC_WHITENING_TYPE_CCITT, 7, 0);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, RADIOLIB_SX127X_PACKET_VARIABLE | RADIOLIB_SX127X_DC_FREE_NONE | RADIOLIB_SX127X_CRC_ON | RADIOLIB_SX127X_CRC_AUTOCLEAR_ON | RADIOLIB_SX127X_ADDRESS_FILTERING_OFF | RADIOLIB_SX127X_CRC_WHITENING_TYPE_CCITT, 7, 0);
   state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_2, RADIOLIB_SX127X_DATA_MODE_PACKET | RADIOLIB_SX127X_IO_HOME_OFF, 6, 5);
-  RADIOLIB_ASSERT(state);
 
   // set preamble polarity
-  state =this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_SYNC_CONFIG, RADIOLIB_SX127X_PREAMBLE_POLARITY_55, 5, 5);
-  RADIOLIB_ASSERT(state);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_SYNC_CONFIG, RADIOLIB_SX127X_PREAMBLE_POLARITY_55, 5, 5);
 
   // set FIFO threshold
-  state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FIFO_THRESH, RADIOLIB_SX127X_TX_START_FIFO_NOT_EMPTY, 7, 7);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FIFO_THRESH, RADIOLIB_SX127X_TX_START_FIFO_NOT_EMPTY, 7, 7);
   state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FIFO_THRESH, RADIOLIB_SX127X_FIFO_THRESH, 5, 0);
-  RADIOLIB_ASSERT(state);
+
+  // enable preamble detector
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PREAMBLE_DETECT, RADIOLIB_SX127X_PREAMBLE_DETECTOR_ON | RADIOLIB_SX127X_PREAMBLE_DETECTOR_2_BYTE | RADIOLIB_SX127X_PREAMBLE_DETECTOR_TOL);
 
   // disable Rx timeouts
-  state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_RX_TIMEOUT_1, RADIOLIB_SX127X_TIMEOUT_RX_RSSI_OFF);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_RX_TIMEOUT_1, RADIOLIB_SX127X_TIMEOUT_RX_RSSI_OFF);
   state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_RX_TIMEOUT_2, RADIOLIB_SX127X_TIMEOUT_RX_PREAMBLE_OFF);
   state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_RX_TIMEOUT_3, RADIOLIB_SX127X_TIMEOUT_SIGNAL_SYNC_OFF);
-  RADIOLIB_ASSERT(state);
 
-  // enable preamble detector
-  state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PREAMBLE_DETECT, RADIOLIB_SX127X_PREAMBLE_DETECTOR_ON | RADIOLIB_SX127X_PREAMBLE_DETECTOR_2_BYTE | RADIOLIB_SX127X_PREAMBLE_DETECTOR_TOL);
-
-  return(state);
+  int16_t batchState = this->mod->SPIendBatch();
+  RADIOLIB_ASSERT(state);
+  return(batchState);
 }
 
 int16_t SX127x::setPacketMode(uint8_t mode, uint8_t len) {
@@ -1473,6 +1633,38 @@ int16_t SX127x::setPacketMode(uint8_t mode, uint8_t len) {
   return(state);
 }
 
+int16_t SX127x::setStreamMode(size_t len) {
+  // streaming is only possible with FSK packet engine
+  if(getActiveModem() != RADIOLIB_SX127X_FSK_OOK) {
+    return(RADIOLIB_ERR_WRONG_MODEM);
+  }
+
+  // save the payload length, the stream will overwrite it
+  this->streamPayloadLen = this->mod->SPIreadRegister(RADIOLIB_SX127X_REG_PAYLOAD_LENGTH_FSK);
+
+  // fixed packet length is 11-bit, zero length means unlimited
+  if(len > 0x7FF) {
+    len = 0;
+  }
+  int16_t state = this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, RADIOLIB_SX127X_PACKET_FIXED, 7, 7);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_2, (len >> 8) & 0x07, 2, 0);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PAYLOAD_LENGTH_FSK, len & 0xFF);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_FIFO_THRESH, RADIOLIB_SX127X_TX_START_FIFO_NOT_EMPTY | RADIOLIB_SX127X_FIFO_THRESH, 7, 0);
+
+  // payload ready must be issued even on CRC mismatch, otherwise a failed stream would never finish
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, RADIOLIB_SX127X_CRC_AUTOCLEAR_OFF, 3, 3);
+  return(state);
+}
+
+void SX127x::finishStream() {
+  // restore packet length and CRC configuration
+  this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, this->packetLengthConfig, 7, 7);
+  this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_1, RADIOLIB_SX127X_CRC_AUTOCLEAR_ON, 3, 3);
+  this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PACKET_CONFIG_2, 0x00, 2, 0);
+  this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_PAYLOAD_LENGTH_FSK, this->streamPayloadLen);
+  startStream(0, NULL, NULL);
+}
+
 bool SX127x::findChip(uint8_t ver) {
   uint8_t i = 0;
   bool flagFound = false;
@@ -1495,6 +1687,7 @@ bool SX127x::findChip(uint8_t ver) {
 }
 
 int16_t SX127x::setMode(uint8_t mode) {
+  this->directTx = false;
   uint8_t checkMask = 0xFF;
   if((getActiveModem() == RADIOLIB_SX127X_FSK_OOK) && (mode == RADIOLIB_SX127X_RX)) {
     // disable checking of RX bit in FSK RX mode, as it sometimes seem to fail (#276)
@@ -1514,11 +1707,25 @@ int16_t SX127x::setActiveModem(uint8_t modem) {
   // set modem
   state |= this->mod->SPIsetRegValue(RADIOLIB_SX127X_REG_OP_MODE, modem, 7, 7, 5);
 
+  // the register map has changed
+  setVolatileRegs(modem);
+  this->mod->SPIcacheInvalidate();
+
   // set mode to STANDBY
   state |= setMode(RADIOLIB_SX127X_STANDBY);
   return(state);
 }
 
+void SX127x::setVolatileRegs(uint8_t modem) {
+  if(modem == RADIOLIB_SX127X_LORA) {
+    this->mod->SPIvolatileRegs = SX127xVolatileRegsLoRa;
+    this->mod->SPIvolatileRegsNum = sizeof(SX127xVolatileRegsLoRa) / sizeof(SX127xVolatileRegsLoRa[0]);
+  } else {
+    this->mod->SPIvolatileRegs = SX127xVolatileRegsFSK;
+    this->mod->SPIvolatileRegsNum = sizeof(SX127xVolatileRegsFSK) / sizeof(SX127xVolatileRegsFSK[0]);
+  }
+}
+
 void SX127x::clearIRQFlags() {
   int16_t modem = getActiveModem();
   if(modem == RADIOLIB_SX127X_LORA) {
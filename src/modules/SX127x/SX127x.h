@@ -677,6 +677,14 @@ class SX127x: public PhysicalLayer {
     */
     int16_t transmitDirect(uint32_t frf = 0) override;
 
+    /*!
+      \brief Changes frequency of direct transmission already started by transmitDirect in a single SPI transaction.
+      If the module is not transmitting in direct mode, this is the same as calling transmitDirect.
+      \param frf 24-bit raw frequency value to transmit at.
+      \returns \ref status_codes
+    */
+    int16_t retuneDirect(uint32_t frf) override;
+
     /*!
       \brief Enables direct reception mode on pins DIO1 (clock) and DIO2 (data).
       While in direct mode, the module will not be able to transmit or receive packets. Can only be activated in FSK mode.
@@ -789,6 +797,32 @@ class SX127x: public PhysicalLayer {
     */
     bool fifoGet(volatile uint8_t* data, int totalLen, volatile int* rcvLen);
 
+    /*!
+      \brief Interrupt-driven stream transmit method, FSK modem only. Streams up to 2047 bytes long are sent
+      as fixed length packets, longer ones use unlimited packet length, in which case CRC is not supported.
+      \param len Total number of bytes to transmit.
+      \param cb Callback that provides the next chunk of data.
+      \returns \ref status_codes
+    */
+    int16_t startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Interrupt-driven stream receive method, FSK modem only. Streams up to 2047 bytes long are received
+      as fixed length packets, longer ones use unlimited packet length, in which case CRC is not supported.
+      \param len Total number of bytes to receive.
+      \param cb Callback that gets the next chunk of received data.
+      \returns \ref status_codes
+    */
+    int16_t startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Moves data between FIFO and the stream callbacks. FIFO is refilled (or emptied) in chunks
+      as soon as its level crosses the FIFO threshold. In unlimited length mode, the last call blocks
+      for one byte time, until the last byte leaves the shift register.
+      \returns \ref status_codes
+    */
+    int16_t serviceStream() override;
+
     /*!
       \brief Interrupt-driven binary transmit method. Will start transmitting arbitrary binary data up to 255 bytes long using %LoRa or up to 63 bytes using FSK modem.
       \param data Binary data that will be transmitted.
@@ -908,6 +942,14 @@ class SX127x: public PhysicalLayer {
     */
     int16_t setFrequencyDeviation(float freqDev) override;
 
+    /*!
+      \brief Sets carrier frequency as raw value of FRF registers. No range checking is done,
+      the new frequency should be in the same band as the last one set by setFrequency.
+      \param frf Carrier frequency in multiples of synthesizer frequency step.
+      \returns \ref status_codes
+    */
+    int16_t setFrequencyRaw(uint32_t frf) override;
+
     /*!
       \brief Sets FSK receiver bandwidth. Allowed values range from 2.6 to 250 kHz. Only available in FSK mode.
       \param rxBw Receiver bandwidth to be set (in kHz).
@@ -1195,6 +1237,7 @@ class SX127x: public PhysicalLayer {
     bool crcEnabled = false;
     bool crcOn = true; // default value used in FSK mode
     size_t packetLength = 0;
+    bool directTx = false; // transmitting in direct mode, cleared by any mode change or reset
 
     int16_t setFrequencyRaw(float newFreq);
     int16_t setBitRateCommon(float br, uint8_t fracRegAddr);
@@ -1210,12 +1253,16 @@ class SX127x: public PhysicalLayer {
     float dataRate = 0;
     bool packetLengthQueried = false; // FSK packet length is the first byte in FIFO, length can only be queried once
     uint8_t packetLengthConfig = RADIOLIB_SX127X_PACKET_VARIABLE;
+    uint8_t streamPayloadLen = 0; // FSK payload length to restore once the stream is finished
 
     bool findChip(uint8_t ver);
     int16_t setMode(uint8_t mode);
     int16_t setActiveModem(uint8_t modem);
+    void setVolatileRegs(uint8_t modem);
     void clearIRQFlags();
     void clearFIFO(size_t count); // used mostly to clear remaining bytes in FIFO after a packet read
+    int16_t setStreamMode(size_t len);
+    void finishStream();
 
     /*!
       \brief Calculate exponent and mantissa values for receiver bandwidth and AFC
@@ -33,6 +33,238 @@ int16_t SX1280::range(bool master, uint32_t addr, uint16_t calTable[3][6]) {
 }
 
 int16_t SX1280::startRanging(bool master, uint32_t addr, uint16_t calTable[3][6]) {
+  // configure ranging engine
+  int16_t state = setupRanging(master, addr, calTable);
+  RADIOLIB_ASSERT(state);
+
+  // set role and start ranging
+  if(master) {
+    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_MASTER);
+    RADIOLIB_ASSERT(state);
+
+    state = setTx(RADIOLIB_SX128X_TX_TIMEOUT_NONE);
+    RADIOLIB_ASSERT(state);
+
+  } else {
+    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_SLAVE);
+    RADIOLIB_ASSERT(state);
+
+    state = setRx(RADIOLIB_SX128X_RX_TIMEOUT_INF);
+    RADIOLIB_ASSERT(state);
+
+  }
+
+  return(state);
+}
+
+float SX1280::getRangingResult() {
+  // set mode to standby XOSC
+  int16_t state = standby(RADIOLIB_SX128X_STANDBY_XOSC);
+  RADIOLIB_ASSERT(state);
+
+  // enable clock
+  uint8_t data[4];
+  state = readRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, data, 1);
+  RADIOLIB_ASSERT(state);
+
+  data[0] |= (1 << 1);
+  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, data, 1);
+  RADIOLIB_ASSERT(state);
+
+  // set result type to filtered
+  state = readRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, data, 1);
+  RADIOLIB_ASSERT(state);
+
+  data[0] &= 0xCF;
+  data[0] |= (1 << 4);
+  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, data, 1);
+  RADIOLIB_ASSERT(state);
+
+  // read the register values, MSB, MID and LSB are consecutive
+  state = readRegister(RADIOLIB_SX128X_REG_RANGING_RESULT_MSB, data, 3);
+  RADIOLIB_ASSERT(state);
+
+  // set mode to standby RC
+  state = standby();
+  RADIOLIB_ASSERT(state);
+
+  // calculate the real result
+  uint32_t raw = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+  return(rangingToMeters(raw));
+}
+
+int16_t SX1280::startRangingSession(bool master, uint32_t* addrs, size_t numAddrs, SX1280RangingStats_t* stats, float* samples, uint8_t exchanges, float* freqs, size_t numFreqs, uint16_t timeout, uint16_t calTable[3][6]) {
+  // check parameters
+  if((addrs == NULL) || (stats == NULL) || (master && (samples == NULL))) {
+    return(RADIOLIB_ERR_NULL_POINTER);
+  }
+  if((numAddrs == 0) || (!master && (numAddrs > 1))) {
+    return(RADIOLIB_ERR_INVALID_NUM_RANGING_ADDRS);
+  }
+  if(exchanges == 0) {
+    return(RADIOLIB_ERR_INVALID_NUM_SAMPLES);
+  }
+  if((freqs == NULL) || (numFreqs == 0)) {
+    freqs = NULL;
+    numFreqs = 0;
+  }
+
+  // master hops after every exchange, even when the request was lost, so the slave has to hop after a timeout as well
+  if(master) {
+    timeout = RADIOLIB_SX128X_RX_TIMEOUT_INF;
+  } else if(freqs && (timeout == RADIOLIB_SX128X_RX_TIMEOUT_INF)) {
+    return(RADIOLIB_ERR_INVALID_RX_PERIOD);
+  }
+
+  // the session starts on the first channel
+  int16_t state = RADIOLIB_ERR_NONE;
+  if(freqs) {
+    state = setFrequency(freqs[0]);
+    RADIOLIB_ASSERT(state);
+  }
+
+  // configure ranging engine
+  state = setupRanging(master, addrs[0], calTable);
+  RADIOLIB_ASSERT(state);
+
+  // both the valid result and the failure have to raise DIO1, otherwise the session would stall
+  uint16_t irqMask = RADIOLIB_SX128X_IRQ_RANGING_SLAVE_RESP_DONE | RADIOLIB_SX128X_IRQ_RANGING_SLAVE_REQ_DISCARD;
+  if(master) {
+    irqMask = RADIOLIB_SX128X_IRQ_RANGING_MASTER_RES_VALID | RADIOLIB_SX128X_IRQ_RANGING_MASTER_TIMEOUT;
+  } else if(timeout != RADIOLIB_SX128X_RX_TIMEOUT_INF) {
+    irqMask |= RADIOLIB_SX128X_IRQ_RX_TX_TIMEOUT;
+  }
+  state = setDioIrqParams(irqMask, irqMask);
+  RADIOLIB_ASSERT(state);
+
+  if(master) {
+    // result type is retained for the whole session, so it is only set once
+    // filtered result would average exchanges across slaves and channels, so every exchange is read raw
+    uint8_t data = 0;
+    state = readRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, &data, 1);
+    RADIOLIB_ASSERT(state);
+    data &= 0xCF;
+    state = writeRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, &data, 1);
+    RADIOLIB_ASSERT(state);
+
+    // cache the clock enable register, it is written after every exchange
+    state = readRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, &this->rangingClockEnable, 1);
+    RADIOLIB_ASSERT(state);
+    this->rangingClockEnable |= (1 << 1);
+  }
+
+  // reset statistics
+  for(size_t i = 0; i < numAddrs; i++) {
+    memset(&stats[i], 0, sizeof(SX1280RangingStats_t));
+    stats[i].addr = addrs[i];
+  }
+
+  // save session parameters
+  this->rangingMaster = master;
+  this->rangingAddrs = addrs;
+  this->rangingNumAddrs = numAddrs;
+  this->rangingAddrIndex = 0;
+  this->rangingStats = stats;
+  this->rangingExchanges = exchanges;
+  this->rangingExchange = 0;
+  this->rangingFreqs = freqs;
+  this->rangingNumFreqs = numFreqs;
+  this->rangingHop = 0;
+  this->rangingTimeout = timeout;
+  this->rangingSamples = samples;
+
+  // set role and start the first exchange
+  if(master) {
+    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_MASTER);
+    RADIOLIB_ASSERT(state);
+    state = setTx(RADIOLIB_SX128X_TX_TIMEOUT_NONE);
+  } else {
+    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_SLAVE);
+    RADIOLIB_ASSERT(state);
+    state = setRx(timeout);
+  }
+  if(state != RADIOLIB_ERR_NONE) {
+    this->rangingAddrs = NULL;
+  }
+
+  return(state);
+}
+
+bool SX1280::serviceRanging() {
+  // check there is a session running
+  if(this->rangingAddrs == NULL) {
+    return(true);
+  }
+
+  // check which exchange event occurred
+  SX1280RangingStats_t* stats = &this->rangingStats[this->rangingAddrIndex];
+  uint16_t irq = getIrqStatus();
+  if(this->rangingMaster) {
+    if(irq & RADIOLIB_SX128X_IRQ_RANGING_MASTER_RES_VALID) {
+      float distance = 0;
+      float rssi = 0;
+      if(readRangingResult(&distance, &rssi) == RADIOLIB_ERR_NONE) {
+        addRangingSample(distance, rssi);
+      } else {
+        stats->timeouts++;
+      }
+    } else if(irq & RADIOLIB_SX128X_IRQ_RANGING_MASTER_TIMEOUT) {
+      stats->timeouts++;
+    } else {
+      return(false);
+    }
+
+  } else {
+    if(irq & RADIOLIB_SX128X_IRQ_RANGING_SLAVE_RESP_DONE) {
+      stats->valid++;
+    } else if(irq & (RADIOLIB_SX128X_IRQ_RANGING_SLAVE_REQ_DISCARD | RADIOLIB_SX128X_IRQ_RX_TX_TIMEOUT)) {
+      // request for another slave, or a lost one, the master moves to the next channel in both cases
+      stats->timeouts++;
+      clearIrqStatus();
+      this->rangingHop++;
+      if(startRangingExchange(false) != RADIOLIB_ERR_NONE) {
+        this->rangingAddrs = NULL;
+        standby();
+        return(true);
+      }
+      return(false);
+    } else {
+      return(false);
+    }
+
+  }
+  clearIrqStatus();
+
+  // move on to the next slave once all exchanges with this one are done
+  bool newAddr = false;
+  this->rangingExchange++;
+  if(this->rangingExchange >= this->rangingExchanges) {
+    finishRangingStats();
+    this->rangingExchange = 0;
+    this->rangingAddrIndex++;
+    if(this->rangingAddrIndex >= this->rangingNumAddrs) {
+      this->rangingAddrs = NULL;
+      standby();
+      return(true);
+    }
+    newAddr = true;
+  }
+
+  // start the next exchange
+  this->rangingHop++;
+  if(startRangingExchange(newAddr) != RADIOLIB_ERR_NONE) {
+    this->rangingAddrs = NULL;
+    standby();
+    return(true);
+  }
+  return(false);
+}
+
+void SX1280::setRangingCorrection(RangingCorrectionCb_t cb) {
+  this->rangingCorrection = cb;
+}
+
+int16_t SX1280::setupRanging(bool master, uint32_t addr, uint16_t calTable[3][6]) {
   // check active modem
   uint8_t modem = getPacketType();
   if(!((modem == RADIOLIB_SX128X_PACKET_TYPE_LORA) || (modem == RADIOLIB_SX128X_PACKET_TYPE_RANGING))) {
@@ -116,66 +348,92 @@ int16_t SX1280::startRanging(bool master, uint32_t addr, uint16_t calTable[3][6]
       return(RADIOLIB_ERR_INVALID_BANDWIDTH);
   }
   uint8_t calBuff[] = { (uint8_t)((val >> 8) & 0xFF), (uint8_t)(val & 0xFF) };
-  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_CALIBRATION_MSB, calBuff, 2);
+  return(writeRegister(RADIOLIB_SX128X_REG_RANGING_CALIBRATION_MSB, calBuff, 2));
+}
+
+int16_t SX1280::readRangingResult(float* distance, float* rssi) {
+  // result is only readable in standby XOSC with the clock enabled
+  int16_t state = standby(RADIOLIB_SX128X_STANDBY_XOSC);
+  RADIOLIB_ASSERT(state);
+  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, &this->rangingClockEnable, 1);
   RADIOLIB_ASSERT(state);
 
-  // set role and start ranging
-  if(master) {
-    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_MASTER);
-    RADIOLIB_ASSERT(state);
+  // result MSB, MID, LSB and RSSI are consecutive, so read all of them at once
+  uint8_t data[4];
+  state = readRegister(RADIOLIB_SX128X_REG_RANGING_RESULT_MSB, data, 4);
+  RADIOLIB_ASSERT(state);
 
-    state = setTx(RADIOLIB_SX128X_TX_TIMEOUT_NONE);
-    RADIOLIB_ASSERT(state);
+  uint32_t raw = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+  *distance = rangingToMeters(raw);
+  *rssi = -1.0 * data[3]/2.0;
+  return(state);
+}
 
-  } else {
-    state = setRangingRole(RADIOLIB_SX128X_RANGING_ROLE_SLAVE);
-    RADIOLIB_ASSERT(state);
+int16_t SX1280::startRangingExchange(bool newAddr) {
+  int16_t state = RADIOLIB_ERR_NONE;
 
-    state = setRx(RADIOLIB_SX128X_RX_TIMEOUT_INF);
+  // switch channel, it only depends on the number of exchanges so far, so master and slaves stay in sync
+  if(this->rangingFreqs) {
+    state = standby();
+    RADIOLIB_ASSERT(state);
+    state = setFrequency(this->rangingFreqs[this->rangingHop % this->rangingNumFreqs]);
     RADIOLIB_ASSERT(state);
-
   }
 
-  return(state);
-}
-
-float SX1280::getRangingResult() {
-  // set mode to standby XOSC
-  int16_t state = standby(RADIOLIB_SX128X_STANDBY_XOSC);
-  RADIOLIB_ASSERT(state);
+  // slave only answers requests
+  if(!this->rangingMaster) {
+    return(setRx(this->rangingTimeout));
+  }
 
-  // enable clock
-  uint8_t data[4];
-  state = readRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, data, 1);
-  RADIOLIB_ASSERT(state);
+  // set address of the next slave
+  if(newAddr) {
+    uint32_t addr = this->rangingAddrs[this->rangingAddrIndex];
+    uint8_t addrBuff[] = { (uint8_t)((addr >> 24) & 0xFF), (uint8_t)((addr >> 16) & 0xFF), (uint8_t)((addr >> 8) & 0xFF), (uint8_t)(addr & 0xFF) };
+    state = writeRegister(RADIOLIB_SX128X_REG_MASTER_RANGING_ADDRESS_BYTE_3, addrBuff, 4);
+    RADIOLIB_ASSERT(state);
+  }
 
-  data[0] |= (1 << 1);
-  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_LORA_CLOCK_ENABLE, data, 1);
-  RADIOLIB_ASSERT(state);
+  return(setTx(RADIOLIB_SX128X_TX_TIMEOUT_NONE));
+}
 
-  // set result type to filtered
-  state = readRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, data, 1);
-  RADIOLIB_ASSERT(state);
+void SX1280::addRangingSample(float distance, float rssi) {
+  if(this->rangingCorrection) {
+    distance = this->rangingCorrection(distance, rssi);
+  }
 
-  data[0] &= 0xCF;
-  data[0] |= (1 << 4);
-  state = writeRegister(RADIOLIB_SX128X_REG_RANGING_TYPE, data, 1);
-  RADIOLIB_ASSERT(state);
+  // running mean and sum of squared differences (Welford), variance is finished later
+  SX1280RangingStats_t* stats = &this->rangingStats[this->rangingAddrIndex];
+  stats->valid++;
+  float delta = distance - stats->mean;
+  stats->mean += delta / stats->valid;
+  stats->variance += delta * (distance - stats->mean);
+  stats->rssi += (rssi - stats->rssi) / stats->valid;
+
+  // insert the sample so that the array stays sorted
+  uint8_t i = stats->valid - 1;
+  while((i > 0) && (this->rangingSamples[i - 1] > distance)) {
+    this->rangingSamples[i] = this->rangingSamples[i - 1];
+    i--;
+  }
+  this->rangingSamples[i] = distance;
+}
 
-  // read the register values
-  state = readRegister(RADIOLIB_SX128X_REG_RANGING_RESULT_MSB, &data[0], 1);
-  RADIOLIB_ASSERT(state);
-  state = readRegister(RADIOLIB_SX128X_REG_RANGING_RESULT_MID, &data[1], 1);
-  RADIOLIB_ASSERT(state);
-  state = readRegister(RADIOLIB_SX128X_REG_RANGING_RESULT_LSB, &data[2], 1);
-  RADIOLIB_ASSERT(state);
+void SX1280::finishRangingStats() {
+  SX1280RangingStats_t* stats = &this->rangingStats[this->rangingAddrIndex];
+  if(!this->rangingMaster || (stats->valid == 0)) {
+    return;
+  }
 
-  // set mode to standby RC
-  state = standby();
-  RADIOLIB_ASSERT(state);
+  uint8_t mid = stats->valid / 2;
+  if(stats->valid % 2) {
+    stats->median = this->rangingSamples[mid];
+  } else {
+    stats->median = (this->rangingSamples[mid - 1] + this->rangingSamples[mid]) / 2.0;
+  }
+  stats->variance /= stats->valid;
+}
 
-  // calculate the real result
-  uint32_t raw = ((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2];
+float SX1280::rangingToMeters(uint32_t raw) {
   return((float)raw * 150.0 / (4.096 * this->bandwidthKhz));
 }
 
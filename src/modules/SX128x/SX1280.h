@@ -9,6 +9,33 @@
 #include "SX128x.h"
 #include "SX1281.h"
 
+/*!
+  \struct SX1280RangingStats_t
+  \brief Statistics of ranging exchanges with a single slave, collected by a ranging session.
+*/
+struct SX1280RangingStats_t {
+  /*! \brief Ranging address of the slave */
+  uint32_t addr;
+
+  /*! \brief Number of successful exchanges (master) or sent responses (slave) */
+  uint8_t valid;
+
+  /*! \brief Number of exchanges that timed out (master), or discarded requests and receive timeouts (slave) */
+  uint8_t timeouts;
+
+  /*! \brief Median distance in meters (master only) */
+  float median;
+
+  /*! \brief Mean distance in meters (master only) */
+  float mean;
+
+  /*! \brief Variance of the distance in square meters (master only) */
+  float variance;
+
+  /*! \brief Mean ranging RSSI in dBm (master only) */
+  float rssi;
+};
+
 /*!
   \class SX1280
   \brief Derived class for %SX1280 modules.
@@ -45,9 +72,79 @@ class SX1280: public SX1281 {
     */
     float getRangingResult();
 
+    /*!
+      \brief Type of the callback function used to correct the distance of a single ranging exchange.
+      Called with the distance in meters and ranging RSSI in dBm, returns the corrected distance in meters.
+    */
+    typedef float (*RangingCorrectionCb_t)(float distance, float rssi);
+
+    /*!
+      \brief Starts non-blocking ranging session. In master mode, the specified number of exchanges is executed
+      with each of the slaves in turn, and statistics of the results are saved for each slave.
+      In slave mode, the specified number of requests is answered, only a single address is allowed.
+      After this method, serviceRanging must be called whenever DIO1 interrupt occurs.
+      \param master Whether to execute ranging in master mode (true) or slave mode (false).
+      \param addrs Ranging addresses of the slaves. Must remain valid until the session is finished.
+      \param numAddrs Number of ranging addresses.
+      \param stats Array of numAddrs structures that will be filled with the session results.
+      Must remain valid until the session is finished.
+      \param samples Buffer of at least exchanges values, used to find the median distance of each slave.
+      Only required in master mode, must remain valid until the session is finished.
+      \param exchanges Number of exchanges per slave.
+      \param freqs Channel frequencies in MHz. Set to NULL to stay on the current frequency.
+      The channel is changed after each exchange of the session, regardless of its result or the slave,
+      so master and slaves have to use the same channel list. Must remain valid until the session is finished.
+      \param numFreqs Number of channel frequencies.
+      \param timeout Slave only, raw timeout expressed as multiples of 15.625 us. When no request arrives
+      in this time, the slave assumes the exchange was lost and moves to the next channel along with the master.
+      Should be slightly longer than the interval between exchanges of the master. Required when hopping,
+      defaults to RADIOLIB_SX128X_RX_TIMEOUT_INF (no timeout).
+      \param calTable Ranging calibration table - set to NULL to use the default.
+      \returns \ref status_codes
+    */
+    int16_t startRangingSession(bool master, uint32_t* addrs, size_t numAddrs, SX1280RangingStats_t* stats, float* samples, uint8_t exchanges, float* freqs = NULL, size_t numFreqs = 0, uint16_t timeout = RADIOLIB_SX128X_RX_TIMEOUT_INF, uint16_t calTable[3][6] = NULL);
+
+    /*!
+      \brief Processes the finished exchange of a ranging session and starts the next one.
+      Should be called after DIO1 interrupt, calling it at any other time has no effect.
+      \returns Whether the session is finished (or not running).
+    */
+    bool serviceRanging();
+
+    /*!
+      \brief Sets callback used to correct the distance of each exchange in ranging session,
+      e.g. to compensate RSSI-dependent bias. Set to NULL to disable the correction.
+      \param cb Correction callback.
+    */
+    void setRangingCorrection(RangingCorrectionCb_t cb);
+
 #if !defined(RADIOLIB_GODMODE)
   private:
 #endif
+    // ranging session state
+    bool rangingMaster = false;
+    uint32_t* rangingAddrs = NULL;
+    size_t rangingNumAddrs = 0;
+    size_t rangingAddrIndex = 0;
+    SX1280RangingStats_t* rangingStats = NULL;
+    uint8_t rangingExchanges = 0;
+    uint8_t rangingExchange = 0;
+    float* rangingFreqs = NULL;
+    size_t rangingNumFreqs = 0;
+    uint32_t rangingHop = 0; // number of exchanges in the whole session, selects the channel
+    uint16_t rangingTimeout = RADIOLIB_SX128X_RX_TIMEOUT_INF;
+    uint8_t rangingClockEnable = 0;
+    RangingCorrectionCb_t rangingCorrection = NULL;
+
+    // distances of the current slave, kept sorted for the median
+    float* rangingSamples = NULL;
+
+    int16_t setupRanging(bool master, uint32_t addr, uint16_t calTable[3][6]);
+    int16_t readRangingResult(float* distance, float* rssi);
+    int16_t startRangingExchange(bool newAddr);
+    void addRangingSample(float distance, float rssi);
+    void finishRangingStats();
+    float rangingToMeters(uint32_t raw);
 
 };
 
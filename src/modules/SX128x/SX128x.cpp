@@ -20,6 +20,7 @@ int16_t SX128x::begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t sync
   this->mod->SPInopCommand = RADIOLIB_SX128X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX128X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   RADIOLIB_DEBUG_PRINTLN("M\tSX128x");
 
@@ -81,6 +82,7 @@ int16_t SX128x::beginGFSK(float freq, uint16_t br, float freqDev, int8_t pwr, ui
   this->mod->SPInopCommand = RADIOLIB_SX128X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX128X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   RADIOLIB_DEBUG_PRINTLN("M\tSX128x");
 
@@ -150,6 +152,7 @@ int16_t SX128x::beginBLE(float freq, uint16_t br, float freqDev, int8_t pwr, uin
   this->mod->SPInopCommand = RADIOLIB_SX128X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX128X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   RADIOLIB_DEBUG_PRINTLN("M\tSX128x");
 
@@ -205,6 +208,7 @@ int16_t SX128x::beginFLRC(float freq, uint16_t br, uint8_t cr, int8_t pwr, uint1
   this->mod->SPInopCommand = RADIOLIB_SX128X_CMD_NOP;
   this->mod->SPIstatusCommand = RADIOLIB_SX128X_CMD_GET_STATUS;
   this->mod->SPIstreamType = true;
+  this->mod->SPIburstAutoIncrement = true;
   this->mod->SPIparseStatusCb = SPIparseStatus;
   RADIOLIB_DEBUG_PRINTLN("M\tSX128x");
 
@@ -658,6 +662,68 @@ int16_t SX128x::readData(uint8_t* data, size_t len) {
   return(state);
 }
 
+int16_t SX128x::readPacket(RadioLibPacket_t* pkt) {
+  if(pkt == NULL) {
+    return(RADIOLIB_ERR_NULL_POINTER);
+  }
+  pkt->timestamp = this->mod->hal->micros();
+
+  // check active modem
+  uint8_t modem = getPacketType();
+  if(modem == RADIOLIB_SX128X_PACKET_TYPE_RANGING) {
+    return(RADIOLIB_ERR_WRONG_MODEM);
+  }
+
+  // set mode to standby
+  int16_t state = standby();
+  RADIOLIB_ASSERT(state);
+
+  // check integrity CRC
+  uint16_t irq = getIrqStatus();
+  pkt->state = RADIOLIB_ERR_NONE;
+  if((irq & RADIOLIB_SX128X_IRQ_CRC_ERROR) || (irq & RADIOLIB_SX128X_IRQ_HEADER_ERROR)) {
+    pkt->state = RADIOLIB_ERR_CRC_MISMATCH;
+  }
+
+  // get packet length and its position in the buffer
+  uint8_t rxBufStatus[2] = {0, 0};
+  state = this->mod->SPIreadStream(RADIOLIB_SX128X_CMD_GET_RX_BUFFER_STATUS, rxBufStatus, 2);
+  RADIOLIB_ASSERT(state);
+  size_t length = rxBufStatus[0];
+  if((modem == RADIOLIB_SX128X_PACKET_TYPE_LORA) && (this->headerType == RADIOLIB_SX128X_LORA_HEADER_IMPLICIT)) {
+    length = this->payloadLen;
+  }
+  if(length > RADIOLIB_PACKET_RING_MAX_LEN) {
+    length = RADIOLIB_PACKET_RING_MAX_LEN;
+  }
+
+  // read packet data directly into the packet structure
+  state = readBuffer(pkt->data, length, rxBufStatus[1]);
+  RADIOLIB_ASSERT(state);
+  pkt->len = length;
+
+  // get RSSI and SNR from a single packet status
+  uint8_t packetStatus[5];
+  state = this->mod->SPIreadStream(RADIOLIB_SX128X_CMD_GET_PACKET_STATUS, packetStatus, 5);
+  RADIOLIB_ASSERT(state);
+  if(modem == RADIOLIB_SX128X_PACKET_TYPE_LORA) {
+    pkt->snr = (int8_t)packetStatus[1]/4.0;
+    pkt->rssi = -1.0 * packetStatus[0]/2.0;
+    if(pkt->snr <= 0.0) {
+      pkt->rssi -= pkt->snr;
+    }
+  } else {
+    pkt->snr = 0;
+    pkt->rssi = -1.0 * packetStatus[1]/2.0;
+  }
+
+  // clear interrupt flags
+  state = clearIrqStatus();
+  RADIOLIB_ASSERT(state);
+
+  return(pkt->state);
+}
+
 int16_t SX128x::setFrequency(float freq) {
   RADIOLIB_CHECK_RANGE(freq, 2400.0, 2500.0, RADIOLIB_ERR_INVALID_FREQUENCY);
 
@@ -666,6 +732,10 @@ int16_t SX128x::setFrequency(float freq) {
   return(setRfFrequency(frf));
 }
 
+int16_t SX128x::setFrequencyRaw(uint32_t frf) {
+  return(setRfFrequency(frf));
+}
+
 int16_t SX128x::setBandwidth(float bw) {
   // check active modem
   uint8_t modem = getPacketType();
@@ -1372,8 +1442,8 @@ int16_t SX128x::writeBuffer(uint8_t* data, uint8_t numBytes, uint8_t offset) {
   return(this->mod->SPIwriteStream(cmd, 2, data, numBytes));
 }
 
-int16_t SX128x::readBuffer(uint8_t* data, uint8_t numBytes) {
-  uint8_t cmd[] = { RADIOLIB_SX128X_CMD_READ_BUFFER, RADIOLIB_SX128X_CMD_NOP };
+int16_t SX128x::readBuffer(uint8_t* data, uint8_t numBytes, uint8_t offset) {
+  uint8_t cmd[] = { RADIOLIB_SX128X_CMD_READ_BUFFER, offset };
   return(this->mod->SPIreadStream(cmd, 2, data, numBytes));
 }
 
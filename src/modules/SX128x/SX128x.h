@@ -571,6 +571,15 @@ class SX128x: public PhysicalLayer {
     */
     int16_t readData(uint8_t* data, size_t len) override;
 
+    /*!
+      \brief Reads packet received after calling startReceive method, including its metadata.
+      Unlike readData, length, RSSI and SNR are all read at once, and the payload is read from its actual
+      position in the buffer directly into the packet structure.
+      \param pkt Packet structure to save the packet in.
+      \returns \ref status_codes
+    */
+    int16_t readPacket(RadioLibPacket_t* pkt) override;
+
     // configuration methods
 
     /*!
@@ -580,6 +589,13 @@ class SX128x: public PhysicalLayer {
     */
     int16_t setFrequency(float freq);
 
+    /*!
+      \brief Sets carrier frequency as raw value sent by SetRfFrequency command. No range checking is done.
+      \param frf Carrier frequency in multiples of synthesizer frequency step.
+      \returns \ref status_codes
+    */
+    int16_t setFrequencyRaw(uint32_t frf) override;
+
     /*!
       \brief Sets LoRa bandwidth. Allowed values are 203.125, 406.25, 812.5 and 1625.0 kHz.
       \param bw LoRa bandwidth to be set in kHz.
@@ -798,7 +814,7 @@ class SX128x: public PhysicalLayer {
     int16_t writeRegister(uint16_t addr, uint8_t* data, uint8_t numBytes);
     int16_t readRegister(uint16_t addr, uint8_t* data, uint8_t numBytes);
     int16_t writeBuffer(uint8_t* data, uint8_t numBytes, uint8_t offset = 0x00);
-    int16_t readBuffer(uint8_t* data, uint8_t numBytes);
+    int16_t readBuffer(uint8_t* data, uint8_t numBytes, uint8_t offset = 0x00);
     int16_t setTx(uint16_t periodBaseCount = RADIOLIB_SX128X_TX_TIMEOUT_NONE, uint8_t periodBase = RADIOLIB_SX128X_PERIOD_BASE_15_625_US);
     int16_t setRx(uint16_t periodBaseCount, uint8_t periodBase = RADIOLIB_SX128X_PERIOD_BASE_15_625_US);
     int16_t setCad();
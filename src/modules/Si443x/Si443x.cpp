@@ -2,6 +2,20 @@
 #include <math.h>
 #if !defined(RADIOLIB_EXCLUDE_SI443X)
 
+// registers that are updated by the module itself (FIFO, IRQ flags, RSSI etc.) and must not be cached
+static const Module::SPIregRange_t Si443xVolatileRegs[] = {
+  { RADIOLIB_SI443X_REG_DEVICE_STATUS, RADIOLIB_SI443X_REG_INTERRUPT_STATUS_2 },
+  { RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_1, RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_1 },
+  { RADIOLIB_SI443X_REG_ADC_CONFIG, RADIOLIB_SI443X_REG_ADC_VALUE },
+  { RADIOLIB_SI443X_REG_WAKEUP_TIMER_VALUE_1, RADIOLIB_SI443X_REG_WAKEUP_TIMER_VALUE_2 },
+  { RADIOLIB_SI443X_REG_BATT_VOLTAGE_LEVEL, RADIOLIB_SI443X_REG_BATT_VOLTAGE_LEVEL },
+  { RADIOLIB_SI443X_REG_RSSI, RADIOLIB_SI443X_REG_RSSI },
+  { RADIOLIB_SI443X_REG_AFC_CORRECTION, RADIOLIB_SI443X_REG_AFC_CORRECTION },
+  { RADIOLIB_SI443X_REG_EZMAC_STATUS, RADIOLIB_SI443X_REG_EZMAC_STATUS },
+  { RADIOLIB_SI443X_REG_RECEIVED_HEADER_3, RADIOLIB_SI443X_REG_RECEIVED_PACKET_LENGTH },
+  { RADIOLIB_SI443X_REG_FIFO_ACCESS, RADIOLIB_SI443X_REG_FIFO_ACCESS },
+};
+
 Si443x::Si443x(Module* mod) : PhysicalLayer(RADIOLIB_SI443X_FREQUENCY_STEP_SIZE, RADIOLIB_SI443X_MAX_PACKET_LENGTH) {
   this->mod = mod;
 }
@@ -13,6 +27,9 @@ Module* Si443x::getMod() {
 int16_t Si443x::begin(float br, float freqDev, float rxBw, uint8_t preambleLen) {
   // set module properties
   this->mod->init();
+  this->mod->SPIburstAutoIncrement = true;
+  this->mod->SPIvolatileRegs = Si443xVolatileRegs;
+  this->mod->SPIvolatileRegsNum = sizeof(Si443xVolatileRegs) / sizeof(Si443xVolatileRegs[0]);
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
   this->mod->hal->pinMode(this->mod->getRst(), this->mod->hal->GpioModeOutput);
   this->mod->hal->digitalWrite(this->mod->getRst(), this->mod->hal->GpioLevelLow);
@@ -28,6 +45,7 @@ int16_t Si443x::begin(float br, float freqDev, float rxBw, uint8_t preambleLen)
 
   // reset the device
   this->mod->SPIwriteRegister(RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_1, RADIOLIB_SI443X_SOFTWARE_RESET);
+  this->mod->SPIcacheInvalidate();
 
   // clear POR interrupt
   clearIRQFlags();
@@ -73,6 +91,7 @@ void Si443x::reset() {
   this->mod->hal->delay(1);
   this->mod->hal->digitalWrite(this->mod->getRst(), this->mod->hal->GpioLevelLow);
   this->mod->hal->delay(100);
+  this->mod->SPIcacheInvalidate();
 }
 
 int16_t Si443x::transmit(uint8_t* data, size_t len, uint8_t addr) {
@@ -279,6 +298,133 @@ int16_t Si443x::finishTransmit() {
   return(standby());
 }
 
+int16_t Si443x::startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = standby();
+  RADIOLIB_ASSERT(state);
+
+  // clear Tx FIFO
+  this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_2, RADIOLIB_SI443X_TX_FIFO_RESET, 0, 0);
+  this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_2, RADIOLIB_SI443X_TX_FIFO_CLEAR, 0, 0);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // clear interrupt flags
+  clearIRQFlags();
+
+  // fill the whole FIFO
+  startStream(len, cb, NULL);
+  uint8_t buff[RADIOLIB_SI443X_MAX_PACKET_LENGTH];
+  size_t chunkLen = produceStream(buff, RADIOLIB_SI443X_MAX_PACKET_LENGTH);
+  if(chunkLen > 0) {
+    this->mod->SPIwriteRegisterBurst(RADIOLIB_SI443X_REG_FIFO_ACCESS, buff, chunkLen);
+  }
+  this->streamFifoBytes = RADIOLIB_SI443X_MAX_PACKET_LENGTH - chunkLen;
+
+  // set RF switch (if present)
+  this->mod->setRfSwitchState(Module::MODE_TX);
+
+  // set interrupt mapping
+  this->mod->SPIwriteRegister(RADIOLIB_SI443X_REG_INTERRUPT_ENABLE_1, RADIOLIB_SI443X_PACKET_SENT_ENABLED | RADIOLIB_SI443X_TX_FIFO_ALMOST_EMPTY_ENABLED);
+  this->mod->SPIwriteRegister(RADIOLIB_SI443X_REG_INTERRUPT_ENABLE_2, 0x00);
+
+  // set mode to transmit
+  this->mod->SPIwriteRegister(RADIOLIB_SI443X_REG_OP_FUNC_CONTROL_1, RADIOLIB_SI443X_TX_ON | RADIOLIB_SI443X_XTAL_ON);
+
+  return(state);
+}
+
+int16_t Si443x::startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) {
+  // set mode to standby
+  int16_t state = standby();
+  RADIOLIB_ASSERT(state);
+
+  // set packet length and FIFO threshold
+  state = setStreamMode(len);
+  RADIOLIB_ASSERT(state);
+
+  // start receiving as usual
+  startStream(len, NULL, cb);
+  state = startReceive();
+  RADIOLIB_ASSERT(state);
+
+  // enable FIFO almost full interrupt as well
+  this->mod->SPIwriteRegister(RADIOLIB_SI443X_REG_INTERRUPT_ENABLE_1, RADIOLIB_SI443X_VALID_PACKET_RECEIVED_ENABLED | RADIOLIB_SI443X_CRC_ERROR_ENABLED | RADIOLIB_SI443X_RX_FIFO_ALMOST_FULL_ENABLED);
+
+  return(state);
+}
+
+int16_t Si443x::serviceStream() {
+  // check there is a stream in progress
+  if((this->streamProducer == NULL) && (this->streamConsumer == NULL)) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  // reading interrupt status also clears it
+  uint8_t buff[RADIOLIB_SI443X_MAX_PACKET_LENGTH];
+  uint8_t flags = this->mod->SPIreadRegister(RADIOLIB_SI443X_REG_INTERRUPT_STATUS_1);
+  if(this->streamProducer != NULL) {
+    // once FIFO drops to the threshold, everything above it is free
+    if(flags & RADIOLIB_SI443X_TX_FIFO_ALMOST_EMPTY_INTERRUPT) {
+      this->streamFifoBytes = RADIOLIB_SI443X_MAX_PACKET_LENGTH - RADIOLIB_SI443X_FIFO_THRESH_STREAM;
+    }
+    size_t chunkLen = produceStream(buff, this->streamFifoBytes);
+    if(chunkLen > 0) {
+      this->mod->SPIwriteRegisterBurst(RADIOLIB_SI443X_REG_FIFO_ACCESS, buff, chunkLen);
+      this->streamFifoBytes -= chunkLen;
+    }
+
+    // wait until the whole packet is sent
+    if((this->streamPos < this->streamLen) || !(flags & RADIOLIB_SI443X_PACKET_SENT_INTERRUPT)) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+  } else {
+    // flags are cleared on read, so CRC result has to be kept until the whole stream is read
+    this->streamIrqFlags |= flags & (RADIOLIB_SI443X_VALID_PACKET_RECEIVED_INTERRUPT | RADIOLIB_SI443X_CRC_ERROR_INTERRUPT);
+
+    // once FIFO gets to the threshold, read all of it
+    if(flags & RADIOLIB_SI443X_RX_FIFO_ALMOST_FULL_INTERRUPT) {
+      this->streamFifoBytes = RADIOLIB_SI443X_FIFO_THRESH_STREAM;
+    }
+    size_t chunkLen = this->streamLen - this->streamPos;
+    if(chunkLen > this->streamFifoBytes) {
+      chunkLen = this->streamFifoBytes;
+    }
+    if(chunkLen > 0) {
+      this->mod->SPIreadRegisterBurst(RADIOLIB_SI443X_REG_FIFO_ACCESS, chunkLen, buff);
+      consumeStream(buff, chunkLen);
+      this->streamFifoBytes -= chunkLen;
+    }
+
+    // the last few bytes may never get to the threshold, so those are read one by one
+    while((this->streamPos < this->streamLen) && (this->streamLen - this->streamPos < RADIOLIB_SI443X_FIFO_THRESH_STREAM)) {
+      if(this->mod->SPIreadRegister(RADIOLIB_SI443X_REG_DEVICE_STATUS) & RADIOLIB_SI443X_RX_FIFO_EMPTY) {
+        break;
+      }
+      buff[0] = this->mod->SPIreadRegister(RADIOLIB_SI443X_REG_FIFO_ACCESS);
+      consumeStream(buff, 1);
+    }
+    if(this->streamPos < this->streamLen) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+
+    // wait until the packet is validated
+    if(!this->streamIrqFlags) {
+      return(RADIOLIB_STREAM_IN_PROGRESS);
+    }
+    if(this->streamIrqFlags & RADIOLIB_SI443X_CRC_ERROR_INTERRUPT) {
+      finishStream();
+      return(RADIOLIB_ERR_CRC_MISMATCH);
+    }
+  }
+
+  finishStream();
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t Si443x::startReceive() {
   // set mode to standby
   int16_t state = standby();
@@ -714,6 +860,32 @@ void Si443x::clearIRQFlags() {
   this->mod->SPIreadRegisterBurst(RADIOLIB_SI443X_REG_INTERRUPT_STATUS_1, 2, buff);
 }
 
+int16_t Si443x::setStreamMode(size_t len) {
+  // check packet length
+  if(len > 0xFF) {
+    return(RADIOLIB_ERR_PACKET_TOO_LONG);
+  }
+
+  // save the packet length, the stream will overwrite it
+  this->streamPacketLen = this->mod->SPIreadRegister(RADIOLIB_SI443X_REG_TRANSMIT_PACKET_LENGTH);
+  this->streamFifoBytes = 0;
+  this->streamIrqFlags = 0;
+
+  // this is used as packet length for transmission, and for reception in fixed length mode
+  int16_t state = this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_TRANSMIT_PACKET_LENGTH, len);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_TX_FIFO_CONTROL_2, RADIOLIB_SI443X_FIFO_THRESH_STREAM, 5, 0);
+  state |= this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_RX_FIFO_CONTROL, RADIOLIB_SI443X_FIFO_THRESH_STREAM, 5, 0);
+  return(state);
+}
+
+void Si443x::finishStream() {
+  // restore packet length and FIFO thresholds
+  this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_TRANSMIT_PACKET_LENGTH, this->streamPacketLen);
+  this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_TX_FIFO_CONTROL_2, RADIOLIB_SI443X_TX_FIFO_ALMOST_EMPTY_THRESHOLD, 5, 0);
+  this->mod->SPIsetRegValue(RADIOLIB_SI443X_REG_RX_FIFO_CONTROL, RADIOLIB_SI443X_RX_FIFO_ALMOST_FULL_THRESHOLD, 5, 0);
+  startStream(0, NULL, NULL);
+}
+
 void Si443x::clearFIFO(size_t count) {
   while(count) {
     this->mod->SPIreadRegister(RADIOLIB_SI443X_REG_FIFO_ACCESS);
@@ -545,6 +545,9 @@
 // RADIOLIB_SI443X_REG_RX_FIFO_CONTROL
 #define RADIOLIB_SI443X_RX_FIFO_ALMOST_FULL_THRESHOLD           0x37        //  5     0  Rx FIFO almost full threshold
 
+// FIFO threshold used for both Tx and Rx streams
+#define RADIOLIB_SI443X_FIFO_THRESH_STREAM                      0x20        //  5     0  Tx FIFO almost empty and Rx FIFO almost full threshold
+
 /*!
   \class Si443x
   \brief Base class for Si443x series. All derived classes for Si443x (e.g. Si4431 or Si4432) inherit from this base class.
@@ -693,6 +696,29 @@ class Si443x: public PhysicalLayer {
     */
     int16_t finishTransmit() override;
 
+    /*!
+      \brief Interrupt-driven stream transmit method. Packet length is 8-bit, so the stream can be at most 255 bytes long.
+      \param len Total number of bytes to transmit.
+      \param cb Callback that provides the next chunk of data.
+      \returns \ref status_codes
+    */
+    int16_t startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Interrupt-driven stream receive method. Packet length is 8-bit, so the stream can be at most 255 bytes long.
+      \param len Total number of bytes to receive.
+      \param cb Callback that gets the next chunk of received data.
+      \returns \ref status_codes
+    */
+    int16_t startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) override;
+
+    /*!
+      \brief Moves data between FIFO and the stream callbacks. FIFO is refilled (or emptied) in chunks
+      each time the FIFO almost empty (or almost full) interrupt is raised.
+      \returns \ref status_codes
+    */
+    int16_t serviceStream() override;
+
     /*!
       \brief Interrupt-driven receive method. IRQ will be activated when full valid packet is received.
       \returns \ref status_codes
@@ -848,9 +874,15 @@ class Si443x: public PhysicalLayer {
 #if !defined(RADIOLIB_GODMODE)
   private:
 #endif
+    uint8_t streamPacketLen = 0; // packet length to restore once the stream is finished
+    uint8_t streamFifoBytes = 0; // number of bytes that can be moved through FIFO without waiting for interrupt
+    uint8_t streamIrqFlags = 0; // packet valid and CRC error flags received during the stream
+
     bool findChip();
     void clearIRQFlags();
     void clearFIFO(size_t count);
+    int16_t setStreamMode(size_t len);
+    void finishStream();
     int16_t config();
     int16_t updateClockRecovery();
     int16_t directMode();
@@ -2,6 +2,12 @@
 #include <string.h>
 #if !defined(RADIOLIB_EXCLUDE_NRF24)
 
+// registers that are updated by the module itself (FIFO, IRQ flags, RSSI etc.) and must not be cached
+static const Module::SPIregRange_t nRF24VolatileRegs[] = {
+  { RADIOLIB_NRF24_REG_STATUS, RADIOLIB_NRF24_REG_RPD },
+  { RADIOLIB_NRF24_REG_FIFO_STATUS, RADIOLIB_NRF24_REG_FIFO_STATUS },
+};
+
 nRF24::nRF24(Module* mod) : PhysicalLayer(RADIOLIB_NRF24_FREQUENCY_STEP_SIZE, RADIOLIB_NRF24_MAX_PACKET_LENGTH) {
   this->mod = mod;
 }
@@ -14,6 +20,8 @@ int16_t nRF24::begin(int16_t freq, int16_t dr, int8_t pwr, uint8_t addrWidth) {
   // set module properties
   this->mod->SPIreadCommand = RADIOLIB_NRF24_CMD_READ;
   this->mod->SPIwriteCommand = RADIOLIB_NRF24_CMD_WRITE;
+  this->mod->SPIvolatileRegs = nRF24VolatileRegs;
+  this->mod->SPIvolatileRegsNum = sizeof(nRF24VolatileRegs) / sizeof(nRF24VolatileRegs[0]);
   this->mod->init();
   this->mod->hal->pinMode(this->mod->getIrq(), this->mod->hal->GpioModeInput);
 
@@ -27,15 +27,16 @@ int16_t FSK4Client::begin(float base, uint32_t shift, uint16_t rate) {
   // calculate carrier shift
   shiftFreq = getRawShift(shift);
 
+  // calculate 24-bit frequency
+  baseFreq = (base * 1000000.0) / phyLayer->getFreqStep();
+
   // Write resultant tones into arrays for quick lookup when modulating.
+  // These already include the base frequency, so they can be sent as they are.
   for(uint8_t i = 0; i < 4; i++) {
-    tones[i] = shiftFreq*i;
-    tonesHz[i] = shiftFreqHz*i;
+    tones[i] = baseFreq + shiftFreq*i;
+    tonesHz[i] = baseFreqHz + shiftFreqHz*i;
   }
 
-  // calculate 24-bit frequency
-  baseFreq = (base * 1000000.0) / phyLayer->getFreqStep();
-
   // configure for direct mode
   return(phyLayer->startDirect());
 }
@@ -82,7 +83,7 @@ size_t FSK4Client::write(uint8_t b) {
 void FSK4Client::tone(uint8_t i) {
   Module* mod = phyLayer->getMod();
   uint32_t start = mod->hal->micros();
-  transmitDirect(baseFreq + tones[i], baseFreqHz + tonesHz[i]);
+  transmitDirect(tones[i], tonesHz[i]);
   mod->waitForMicroseconds(start, bitDuration);
 }
 
@@ -92,7 +93,7 @@ int16_t FSK4Client::transmitDirect(uint32_t freq, uint32_t freqHz) {
     return(audioClient->tone(freqHz));
   }
   #endif
-  return(phyLayer->transmitDirect(freq));
+  return(phyLayer->retuneDirect(freq));
 }
 
 int16_t FSK4Client::standby() {
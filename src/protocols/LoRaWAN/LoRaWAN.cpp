@@ -4,32 +4,43 @@
 
 #if !defined(RADIOLIB_EXCLUDE_LORAWAN)
 
-// flag to indicate whether we have received a downlink
-static volatile bool downlinkReceived = false;
-
-// interrupt service routine to handle downlinks automatically
-#if defined(ESP8266) || defined(ESP32)
-  IRAM_ATTR
-#endif
-static void LoRaWANNodeOnDownlink(void) {
-  downlinkReceived = true;
-}
-
-// flag to indicate whether channel scan operation is complete
-static volatile bool scanFlag = false;
-
-// interrupt service routine to handle downlinks automatically
-#if defined(ESP8266) || defined(ESP32)
-  IRAM_ATTR
-#endif
-static void LoRaWANNodeOnChannelScan(void) {
-  scanFlag = true;
-}
+// payload lengths of all MAC commands, indexed by command ID
+// the length is needed to skip commands the node does not handle, and to pack the answers
+static const LoRaWANMacSpec_t LoRaWANMacSpecs[] = {
+  { RADIOLIB_LORAWAN_MAC_LEN_NONE, RADIOLIB_LORAWAN_MAC_LEN_NONE, false },  // 0x00 unused
+  { 1, 1, false },                                                          // ResetInd/ResetConf
+  { 2, 0, false },                                                          // LinkCheckReq/LinkCheckAns
+  { 4, 1, false },                                                          // LinkADRReq/LinkADRAns
+  { 1, 0, false },                                                          // DutyCycleReq/DutyCycleAns
+  { 4, 1, true },                                                           // RXParamSetupReq/RXParamSetupAns
+  { 0, 2, false },                                                          // DevStatusReq/DevStatusAns
+  { 5, 1, false },                                                          // NewChannelReq/NewChannelAns
+  { 1, 0, true },                                                           // RXTimingSetupReq/RXTimingSetupAns
+  { 1, 0, false },                                                          // TxParamSetupReq/TxParamSetupAns
+  { 4, 1, true },                                                           // DlChannelReq/DlChannelAns
+  { 1, 1, false },                                                          // RekeyInd/RekeyConf
+  { 1, 0, false },                                                          // ADRParamSetupReq/ADRParamSetupAns
+  { 5, 0, false },                                                          // DeviceTimeReq/DeviceTimeAns
+  { 2, RADIOLIB_LORAWAN_MAC_LEN_NONE, false },                              // ForceRejoinReq
+  { 1, 1, false },                                                          // RejoinParamSetupReq/RejoinParamSetupAns
+  { 0, 1, false },                                                          // PingSlotInfoReq/PingSlotInfoAns
+  { 4, 1, true },                                                           // PingSlotChannelReq/PingSlotChannelAns
+  { 3, 0, false },                                                          // BeaconTimingReq/BeaconTimingAns
+  { 3, 1, false },                                                          // BeaconFreqReq/BeaconFreqAns
+};
 
 LoRaWANNode::LoRaWANNode(PhysicalLayer* phy, const LoRaWANBand_t* band) {
   this->phyLayer = phy;
   this->band = band;
   this->FSK = false;
+  this->buildSpanTables();
+}
+
+LoRaWANNode::~LoRaWANNode() {
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  delete[] this->uplinkBuff;
+  delete[] this->rxBuff;
+  #endif
 }
 
 void LoRaWANNode::wipe() {
@@ -50,10 +61,14 @@ int16_t LoRaWANNode::begin() {
 
   // pull all needed information from persistent storage
   this->devAddr = mod->hal->getPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_ADDR_ID);
-  mod->hal->readPersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_APP_S_KEY_ID), this->appSKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->readPersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FNWK_SINT_KEY_ID), this->fNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->readPersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_SNWK_SINT_KEY_ID), this->sNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->readPersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_NWK_SENC_KEY_ID), this->nwkSEncKey, RADIOLIB_AES128_BLOCK_SIZE);
+  uint8_t keys[4*RADIOLIB_AES128_KEY_SIZE];
+  mod->hal->readPersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_APP_S_KEY_ID), keys, sizeof(keys));
+  memcpy(this->appSKey, &keys[0*RADIOLIB_AES128_KEY_SIZE], RADIOLIB_AES128_KEY_SIZE);
+  memcpy(this->fNwkSIntKey, &keys[1*RADIOLIB_AES128_KEY_SIZE], RADIOLIB_AES128_KEY_SIZE);
+  memcpy(this->sNwkSIntKey, &keys[2*RADIOLIB_AES128_KEY_SIZE], RADIOLIB_AES128_KEY_SIZE);
+  memcpy(this->nwkSEncKey, &keys[3*RADIOLIB_AES128_KEY_SIZE], RADIOLIB_AES128_KEY_SIZE);
+  this->expandSessionKeys();
+  this->loadCounters();
   return(RADIOLIB_ERR_NONE);
 }
 
@@ -65,13 +80,39 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
     return(this->begin());
   }
 
+  // send the join request
+  int16_t state = this->startJoin(joinEUI, devEUI, nwkKey, appKey);
+  RADIOLIB_ASSERT(state);
+
+  // run the state machine until the procedure is finished
+  while(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+    mod->hal->yield();
+    this->poll();
+  }
+
+  return(this->result);
+}
+
+int16_t LoRaWANNode::startJoin(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey) {
+  // check the state machine is not busy
+  if(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+    return(RADIOLIB_ERR_UPLINK_UNAVAILABLE);
+  }
+  this->stopContinuousRx();
+  this->stopClassBRx();
+
   // set the physical layer configuration
   int16_t state = this->setPhyProperties();
   RADIOLIB_ASSERT(state);
 
+  state = this->selectChannel(true);
+  RADIOLIB_ASSERT(state);
+
   // get dev nonce from persistent storage and increment it
-  uint16_t devNonce = mod->hal->getPersistentParameter<uint16_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID);
-  mod->hal->setPersistentParameter<uint16_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID, devNonce + 1);
+  this->loadCounters();
+  uint32_t devNonceCnt = this->journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE);
+  this->journal.write(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE, devNonceCnt + 1);
+  uint16_t devNonce = (uint16_t)devNonceCnt;
 
   // build the join-request message
   uint8_t joinRequestMsg[RADIOLIB_LORAWAN_JOIN_REQUEST_LEN];
@@ -83,48 +124,26 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   LoRaWANNode::hton<uint16_t>(&joinRequestMsg[RADIOLIB_LORAWAN_JOIN_REQUEST_DEV_NONCE_POS], devNonce);
 
   // add the authentication code
-  uint32_t mic = this->generateMIC(joinRequestMsg, RADIOLIB_LORAWAN_JOIN_REQUEST_LEN - sizeof(uint32_t), nwkKey);
+  RadioLibAES128Key_t nwkKeyCtx;
+  RadioLibAES128::initKey(&nwkKeyCtx, nwkKey);
+  uint32_t mic = this->generateMIC(joinRequestMsg, RADIOLIB_LORAWAN_JOIN_REQUEST_LEN - sizeof(uint32_t), &nwkKeyCtx);
   LoRaWANNode::hton<uint32_t>(&joinRequestMsg[RADIOLIB_LORAWAN_JOIN_REQUEST_LEN - sizeof(uint32_t)], mic);
 
   // send it
-  state = this->phyLayer->transmit(joinRequestMsg, RADIOLIB_LORAWAN_JOIN_REQUEST_LEN);
-  RADIOLIB_ASSERT(state);
-  
-  // set the function that will be called when the reply is received
-  this->phyLayer->setPacketReceivedAction(LoRaWANNodeOnDownlink);
-
-  // downlink messages are sent with inverted IQ
-  // TODO use downlink() for this
-  if(!this->FSK) {
-    state = this->phyLayer->invertIQ(true);
-    RADIOLIB_ASSERT(state);
-  }
-  
-  // start receiving
-  uint32_t start = mod->hal->millis();
-  downlinkReceived = false;
-  state = this->phyLayer->startReceive();
+  state = this->startTransaction(joinRequestMsg, RADIOLIB_LORAWAN_JOIN_REQUEST_LEN);
   RADIOLIB_ASSERT(state);
 
-  // wait for the reply or timeout
-  while(!downlinkReceived) {
-    if(mod->hal->millis() - start >= RADIOLIB_LORAWAN_JOIN_ACCEPT_DELAY_2_MS + 2000) {
-      downlinkReceived = false;
-      if(!this->FSK) {
-        this->phyLayer->invertIQ(false);
-      }
-      return(RADIOLIB_ERR_RX_TIMEOUT);
-    }
-  }
-
-  // we have a message, reset the IQ inversion
-  downlinkReceived = false;
-  this->phyLayer->clearPacketReceivedAction();
-  if(!this->FSK) {
-    state = this->phyLayer->invertIQ(false);
-    RADIOLIB_ASSERT(state);
-  }
+  // save everything that will be needed to process the join accept
+  this->joining = true;
+  this->joinEUI = joinEUI;
+  this->devEUI = devEUI;
+  this->devNonce = devNonce;
+  this->nwkKey = nwkKey;
+  this->appKey = appKey;
+  return(RADIOLIB_ERR_NONE);
+}
 
+int16_t LoRaWANNode::processJoinAccept() {
   // build the buffer for the reply data
   uint8_t joinAcceptMsgEnc[RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN];
 
@@ -136,7 +155,7 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   }
 
   // read the packet
-  state = this->phyLayer->readData(joinAcceptMsgEnc, lenRx);
+  int16_t state = this->phyLayer->readData(joinAcceptMsgEnc, lenRx);
   // downlink frames are sent without CRC, which will raise error on SX127x
   // we can ignore that error
   if(state != RADIOLIB_ERR_LORA_HEADER_DAMAGED) {
@@ -154,8 +173,12 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   // the first byte is the MAC header which is not encrypted
   uint8_t joinAcceptMsg[RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN];
   joinAcceptMsg[0] = joinAcceptMsgEnc[0];
-  RadioLibAES128Instance.init(nwkKey);
-  RadioLibAES128Instance.encryptECB(&joinAcceptMsgEnc[1], RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN - 1, &joinAcceptMsg[1]);
+  RadioLibAES128Key_t nwkKeyCtx;
+  RadioLibAES128::initKey(&nwkKeyCtx, this->nwkKey);
+  RadioLibAES128::encryptECB(&nwkKeyCtx, &joinAcceptMsgEnc[1], RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN - 1, &joinAcceptMsg[1]);
+
+  // JSIntKey or AppKey, each of them is only used for a single step below
+  RadioLibAES128Key_t keyCtx;
 
   //Module::hexdump(joinAcceptMsg, lenRx);
 
@@ -165,26 +188,23 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
     // 1.1 version, first we need to derive the join accept integrity key
     uint8_t keyDerivationBuff[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_JS_INT_KEY;
-    LoRaWANNode::hton<uint64_t>(&keyDerivationBuff[1], devEUI);
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->jSIntKey);
-
-    // prepare the buffer for MIC calculation
-    uint8_t micBuff[3*RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
-    micBuff[0] = RADIOLIB_LORAWAN_JOIN_REQUEST_TYPE;
-    LoRaWANNode::hton<uint64_t>(&micBuff[1], joinEUI);
-    LoRaWANNode::hton<uint16_t>(&micBuff[9], devNonce);
-    memcpy(&micBuff[11], joinAcceptMsg, lenRx);
-
-    //Module::hexdump(micBuff, lenRx + 11);
-    
-    if(!verifyMIC(micBuff, lenRx + 11, this->jSIntKey)) {
+    LoRaWANNode::hton<uint64_t>(&keyDerivationBuff[1], this->devEUI);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->jSIntKey);
+    RadioLibAES128::initKey(&keyCtx, this->jSIntKey);
+
+    // the MIC is calculated over the join request type, join EUI and dev nonce, followed by the message itself
+    uint8_t micMsg[11 + RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN];
+    micMsg[0] = RADIOLIB_LORAWAN_JOIN_REQUEST_TYPE;
+    LoRaWANNode::hton<uint64_t>(&micMsg[1], this->joinEUI);
+    LoRaWANNode::hton<uint16_t>(&micMsg[9], this->devNonce);
+    memcpy(&micMsg[11], joinAcceptMsg, lenRx);
+    if(!verifyMIC(micMsg, 11 + lenRx, &keyCtx)) {
       return(RADIOLIB_ERR_CRC_MISMATCH);
     }
   
   } else {
     // 1.0 version
-    if(!verifyMIC(joinAcceptMsg, lenRx, nwkKey)) {
+    if(!verifyMIC(joinAcceptMsg, lenRx, &nwkKeyCtx)) {
       return(RADIOLIB_ERR_CRC_MISMATCH);
     }
 
@@ -200,6 +220,21 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   }
   this->rxDelays[1] = this->rxDelays[0] + 1000;
 
+  // settings changed by MAC commands in the previous session are not valid anymore
+  this->macQueueLen = 0;
+  this->rx1DrOffset = 0;
+  this->rx2Frf = 0;
+  this->rx2DataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED;
+  this->rx2Span = NULL;
+  this->maxDutyCycle = 0;
+  this->adrAckLimit = RADIOLIB_LORAWAN_ADR_ACK_LIMIT;
+  this->adrAckDelay = RADIOLIB_LORAWAN_ADR_ACK_DELAY;
+  this->beaconFrf = 0;
+  this->pingPeriodicity = RADIOLIB_LORAWAN_PING_PERIODICITY_MAX;
+  this->pingFrf = 0;
+  this->pingDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED;
+  this->pingSpan = NULL;
+
   // process CFlist if present
   if(lenRx == RADIOLIB_LORAWAN_JOIN_ACCEPT_MAX_LEN) {
     if(this->band->cfListType == RADIOLIB_LORAWAN_CFLIST_TYPE_FREQUENCIES) {
@@ -207,6 +242,7 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
       for(uint8_t i = 0; i < 5; i++) {
         uint32_t freq = LoRaWANNode::ntoh<uint32_t>(&joinAcceptMsg[RADIOLIB_LORAWAN_JOIN_ACCEPT_CFLIST_POS + 3*i], 3);
         availableChannelsFreq[i] = (float)freq/10000.0;
+        availableChannelsFrf[i] = this->getFrf(availableChannelsFreq[i]);
         RADIOLIB_DEBUG_PRINTLN("Channel %d frequency = %f MHz", i, availableChannelsFreq[i]);
       }
 
@@ -219,6 +255,9 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   
   }
 
+  // new channels may have been added
+  this->resetChannelMask();
+
   // prepare buffer for key derivation
   uint8_t keyDerivationBuff[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
   LoRaWANNode::hton<uint32_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_JOIN_NONCE_POS], joinNonce, 3);
@@ -226,72 +265,145 @@ int16_t LoRaWANNode::beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKe
   // check protocol version (1.0 vs 1.1)
   if(dlSettings & RADIOLIB_LORAWAN_JOIN_ACCEPT_R_1_1) {
     // 1.1 version, derive the keys
-    LoRaWANNode::hton<uint64_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_JOIN_EUI_POS], joinEUI);
-    LoRaWANNode::hton<uint16_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_DEV_NONCE_POS], devNonce);
+    LoRaWANNode::hton<uint64_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_JOIN_EUI_POS], this->joinEUI);
+    LoRaWANNode::hton<uint16_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_DEV_NONCE_POS], this->devNonce);
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_APP_S_KEY;
     //Module::hexdump(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE);
 
-    RadioLibAES128Instance.init(appKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->appSKey);
+    RadioLibAES128::initKey(&keyCtx, this->appKey);
+    RadioLibAES128::encryptECB(&keyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->appSKey);
     //Module::hexdump(this->appSKey, RADIOLIB_AES128_BLOCK_SIZE);
 
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_F_NWK_S_INT_KEY;
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->fNwkSIntKey);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->fNwkSIntKey);
     //Module::hexdump(this->fNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
 
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_S_NWK_S_INT_KEY;
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->sNwkSIntKey);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->sNwkSIntKey);
     //Module::hexdump(this->sNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
 
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_NWK_S_ENC_KEY;
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->nwkSEncKey);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->nwkSEncKey);
     //Module::hexdump(this->nwkSEncKey, RADIOLIB_AES128_BLOCK_SIZE);
 
-    // send the RekeyInd MAC command
+    // the session keys are needed for the RekeyInd uplink already
     this->rev = 1;
-    uint8_t serverRev = 0xFF;
-    state = sendMacCommand(RADIOLIB_LORAWAN_MAC_CMD_REKEY_IND, &this->rev, sizeof(uint8_t), &serverRev, sizeof(uint8_t));
-    RADIOLIB_ASSERT(state);
-
-    // check the supported server version
-    if(serverRev != this->rev) {
-      return(RADIOLIB_ERR_INVALID_REVISION);
-    }
+    this->expandSessionKeys();
   
   } else {
     // 1.0 version, just derive the keys
     this->rev = 0;
     LoRaWANNode::hton<uint32_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_HOME_NET_ID_POS], homeNetId, 3);
-    LoRaWANNode::hton<uint16_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_DEV_ADDR_POS], devNonce);
+    LoRaWANNode::hton<uint16_t>(&keyDerivationBuff[RADIOLIB_LORAWAN_JOIN_ACCEPT_DEV_ADDR_POS], this->devNonce);
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_APP_S_KEY;
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->appSKey);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->appSKey);
 
     keyDerivationBuff[0] = RADIOLIB_LORAWAN_JOIN_ACCEPT_F_NWK_S_INT_KEY;
-    RadioLibAES128Instance.init(nwkKey);
-    RadioLibAES128Instance.encryptECB(keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->fNwkSIntKey);
+    RadioLibAES128::encryptECB(&nwkKeyCtx, keyDerivationBuff, RADIOLIB_AES128_BLOCK_SIZE, this->fNwkSIntKey);
 
     memcpy(this->sNwkSIntKey, this->fNwkSIntKey, RADIOLIB_AES128_KEY_SIZE);
     memcpy(this->nwkSEncKey, this->fNwkSIntKey, RADIOLIB_AES128_KEY_SIZE);
+    this->expandSessionKeys();
   
   }
 
+  // new session was established, reset device counters
+  this->journal.reset(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP);
+  this->journal.reset(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN);
+  this->journal.reset(RADIOLIB_JOURNAL_ID_LORAWAN_A_FCNT_DOWN);
+  this->fcntUp = 0;
+  this->fcntUpReserved = 0;
+  this->nFCntDown = 0;
+  this->aFCntDown = 0;
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::startRekey() {
+  // the join accept was received, the rest of the exchange is a regular uplink
+  this->joining = false;
+  this->rekeying = true;
+  this->rekeyConfRev = RADIOLIB_LORAWAN_MAC_LEN_NONE;
+
+  // send the RekeyInd MAC command, the reply is checked once the downlink arrives
+  uint8_t macReqBuff[2] = { RADIOLIB_LORAWAN_MAC_CMD_REKEY_IND, this->rev };
+  int16_t state = this->startUplink(macReqBuff, sizeof(macReqBuff), RADIOLIB_LORAWAN_FPORT_MAC_COMMAND);
+  if(state == RADIOLIB_ERR_UPLINK_UNAVAILABLE) {
+    // all channels are blocked by duty cycle limit, try again later
+    Module* mod = this->phyLayer->getMod();
+    this->retransmitAt = mod->hal->millis();
+    this->state = RADIOLIB_LORAWAN_STATE_TX_WAIT;
+    return(RADIOLIB_ERR_NONE);
+  } else if(state != RADIOLIB_ERR_NONE) {
+    this->rekeying = false;
+  }
+  return(state);
+}
+
+void LoRaWANNode::loadCounters() {
+  Module* mod = this->phyLayer->getMod();
+  this->journal.begin(mod->hal, RADIOLIB_HAL_PERSISTENT_STORAGE_BASE + mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_JOURNAL_ID), RADIOLIB_HAL_PERSISTENT_JOURNAL_SIZE);
+  this->migrateCounter(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP, RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID, sizeof(uint32_t));
+  this->migrateCounter(RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE, RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_NONCE_ID, sizeof(uint16_t));
+
+  // all values up to the saved one may have been used before
+  this->fcntUp = this->journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP);
+  this->fcntUpReserved = this->fcntUp;
+
+  // downlink counters are saved after every valid downlink, so these are the next expected values
+  this->nFCntDown = this->journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN);
+  this->aFCntDown = this->journal.read(RADIOLIB_JOURNAL_ID_LORAWAN_A_FCNT_DOWN);
+}
+
+void LoRaWANNode::migrateCounter(uint8_t id, uint32_t paramId, size_t len) {
+  // older versions saved the counter in native byte order
+  Module* mod = this->phyLayer->getMod();
+  uint32_t addr = RADIOLIB_HAL_PERSISTENT_STORAGE_BASE + mod->hal->getPersistentAddr(paramId);
+  uint8_t buff[sizeof(uint32_t)] = { 0 };
+  mod->hal->readPersistentStorage(addr, buff, len);
+
+  // nothing to migrate if the storage is wiped (all 0x00) or was never written (all 0xFF)
+  bool wiped = true;
+  bool erased = true;
+  for(size_t i = 0; i < len; i++) {
+    wiped &= (buff[i] == 0x00);
+    erased &= (buff[i] == 0xFF);
+  }
+  if(wiped || erased) {
+    return;
+  }
+
+  uint32_t value = 0;
+  if(len == sizeof(uint16_t)) {
+    uint16_t val16 = 0;
+    memcpy(&val16, buff, sizeof(uint16_t));
+    value = val16;
+  } else {
+    memcpy(&value, buff, sizeof(uint32_t));
+  }
+  if(value > this->journal.read(id)) {
+    this->journal.write(id, value);
+  }
+
+  // clear the old value, otherwise it would be picked up again after the counter is reset
+  memset(buff, 0x00, sizeof(buff));
+  mod->hal->writePersistentStorage(addr, buff, len);
+}
+
+void LoRaWANNode::saveSession() {
   // save the device address
+  Module* mod = this->phyLayer->getMod();
   mod->hal->setPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_DEV_ADDR_ID, this->devAddr);
 
-  // update the keys
-  mod->hal->writePersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_APP_S_KEY_ID), this->appSKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->writePersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FNWK_SINT_KEY_ID), this->fNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->writePersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_SNWK_SINT_KEY_ID), this->sNwkSIntKey, RADIOLIB_AES128_BLOCK_SIZE);
-  mod->hal->writePersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_NWK_SENC_KEY_ID), this->nwkSEncKey, RADIOLIB_AES128_BLOCK_SIZE);
+  // update the keys - these are stored next to each other, so they are written at once
+  uint8_t keys[4*RADIOLIB_AES128_KEY_SIZE];
+  memcpy(&keys[0*RADIOLIB_AES128_KEY_SIZE], this->appSKey, RADIOLIB_AES128_KEY_SIZE);
+  memcpy(&keys[1*RADIOLIB_AES128_KEY_SIZE], this->fNwkSIntKey, RADIOLIB_AES128_KEY_SIZE);
+  memcpy(&keys[2*RADIOLIB_AES128_KEY_SIZE], this->sNwkSIntKey, RADIOLIB_AES128_KEY_SIZE);
+  memcpy(&keys[3*RADIOLIB_AES128_KEY_SIZE], this->nwkSEncKey, RADIOLIB_AES128_KEY_SIZE);
+  mod->hal->writePersistentStorage(mod->hal->getPersistentAddr(RADIOLIB_PERSISTENT_PARAM_LORAWAN_APP_S_KEY_ID), keys, sizeof(keys));
 
-  // all complete, reset device counters and set the magic number
-  mod->hal->setPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID, 0);
+  // all complete, set the magic number
   mod->hal->setPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_MAGIC_ID, RADIOLIB_LORAWAN_MAGIC);
-  return(RADIOLIB_ERR_NONE);
 }
 
 int16_t LoRaWANNode::beginAPB(uint32_t addr, uint8_t* nwkSKey, uint8_t* appSKey, uint8_t* fNwkSIntKey, uint8_t* sNwkSIntKey) {
@@ -306,7 +418,12 @@ int16_t LoRaWANNode::beginAPB(uint32_t addr, uint8_t* nwkSKey, uint8_t* appSKey,
   }
   if(sNwkSIntKey) {
     memcpy(this->sNwkSIntKey, sNwkSIntKey, RADIOLIB_AES128_KEY_SIZE);
+  } else {
+    // LoRaWAN 1.0 uses the same key for all network session operations
+    memcpy(this->sNwkSIntKey, nwkSKey, RADIOLIB_AES128_KEY_SIZE);
   }
+  this->expandSessionKeys();
+  this->loadCounters();
 
   // set the physical layer configuration
   int16_t state = this->setPhyProperties();
@@ -314,25 +431,96 @@ int16_t LoRaWANNode::beginAPB(uint32_t addr, uint8_t* nwkSKey, uint8_t* appSKey,
 }
 
 #if defined(RADIOLIB_BUILD_ARDUINO)
-int16_t LoRaWANNode::uplink(String& str, uint8_t port) {
-  return(this->uplink(str.c_str(), port));
+int16_t LoRaWANNode::uplink(String& str, uint8_t port, bool isConfirmed) {
+  return(this->uplink(str.c_str(), port, isConfirmed));
 }
 #endif
 
-int16_t LoRaWANNode::uplink(const char* str, uint8_t port) {
-  return(this->uplink((uint8_t*)str, strlen(str), port));
+int16_t LoRaWANNode::uplink(const char* str, uint8_t port, bool isConfirmed) {
+  return(this->uplink((uint8_t*)str, strlen(str), port, isConfirmed));
+}
+
+int16_t LoRaWANNode::uplink(uint8_t* data, size_t len, uint8_t port, bool isConfirmed) {
+  int16_t state = this->startUplink(data, len, port, isConfirmed);
+  RADIOLIB_ASSERT(state);
+
+  // wait for the transmission to finish, Rx windows are handled later by downlink() or poll()
+  Module* mod = this->phyLayer->getMod();
+  while(this->state == RADIOLIB_LORAWAN_STATE_TX) {
+    mod->hal->yield();
+    state = this->poll();
+  }
+
+  // confirmed uplink is only done once acknowledged, or all retransmissions were used up
+  if(isConfirmed && (state == RADIOLIB_ERR_NONE)) {
+    while(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+      mod->hal->yield();
+      this->poll();
+    }
+    state = this->result;
+  }
+
+  return(state);
 }
 
-int16_t LoRaWANNode::uplink(uint8_t* data, size_t len, uint8_t port) {
+int16_t LoRaWANNode::startUplink(uint8_t* data, size_t len, uint8_t port, bool isConfirmed) {
   // check destination port
   if(port > 0xDF) {
     return(RADIOLIB_ERR_INVALID_PORT);
   }
 
-  // check if there is a MAC command to piggyback
+  // check the previous uplink is finished
+  // the transaction is advanced first, in case the application stopped polling it
+  // when called from an event callback, poll() is already doing that
+  if(!this->stepping) {
+    Module* mod = this->phyLayer->getMod();
+    this->stepTransaction(mod->hal->millis(), mod->hal->digitalRead(mod->getIrq()));
+  }
+  if(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+    // we may still be in an RX window
+    return(RADIOLIB_ERR_UPLINK_UNAVAILABLE);
+  }
+  this->uplinkLen = 0;
+
+  // class C reception and class B windows are paused for the uplink, poll() resumes them once the transaction is finished
+  this->stopContinuousRx();
+  this->stopClassBRx();
+
+  // pick the channel for this uplink
+  int16_t state = this->selectChannel(false);
+  RADIOLIB_ASSERT(state);
+
+  // set the frame control field
+  uint8_t fctrl = 0x00;
+  if(this->ackPending) {
+    // acknowledge the last confirmed downlink
+    fctrl |= RADIOLIB_LORAWAN_FCTRL_ACK;
+  }
+  if(this->beaconState == RADIOLIB_LORAWAN_BEACON_STATE_LOCKED) {
+    // the network server may use ping slots
+    fctrl |= RADIOLIB_LORAWAN_FCTRL_CLASS_B;
+  }
+  if(this->adrEnabled) {
+    fctrl |= RADIOLIB_LORAWAN_FCTRL_ADR_ENABLED;
+
+    // no downlink for too long, ask the network server to respond
+    if(this->adrAckCnt >= this->adrAckLimit) {
+      fctrl |= RADIOLIB_LORAWAN_FCTRL_ADR_ACK_REQ;
+    }
+
+    // still nothing, step back every ADR_ACK_DELAY uplinks
+    if((this->adrAckCnt >= this->adrAckLimit + this->adrAckDelay) && 
+       (((this->adrAckCnt - this->adrAckLimit) % this->adrAckDelay) == 0)) {
+      state = this->adrBackoff();
+      RADIOLIB_ASSERT(state);
+    }
+  }
+
+  // piggyback all queued MAC commands
+  // FOpts must be empty when the payload itself carries MAC commands, so the queue waits for the next uplink
   uint8_t foptsLen = 0;
-  if(this->command) {
-    foptsLen = 1 + this->command->len;
+  if(port != RADIOLIB_LORAWAN_FPORT_MAC_COMMAND) {
+    foptsLen = this->macQueueLen;
   }
 
   // check maximum payload len as defined in phy
@@ -340,103 +528,96 @@ int16_t LoRaWANNode::uplink(uint8_t* data, size_t len, uint8_t port) {
     return(RADIOLIB_ERR_PACKET_TOO_LONG);
   }
 
-  // check if sufficient time has elapsed since the last uplink
-  Module* mod = this->phyLayer->getMod();
-  if(mod->hal->millis() - this->rxDelayStart < rxDelays[1]) {
-    // not enough time elapsed since the last uplink, we may still be in an RX window
-    return(RADIOLIB_ERR_UPLINK_UNAVAILABLE);
-  }
-
   // build the uplink message
   // the first 16 bytes are reserved for MIC calculation blocks
   size_t uplinkMsgLen = RADIOLIB_LORAWAN_FRAME_LEN(len, foptsLen);
-  #if defined(RADIOLIB_STATIC_ONLY)
-  uint8_t uplinkMsg[RADIOLIB_STATIC_ARRAY_SIZE];
-  #else
-  uint8_t* uplinkMsg = new uint8_t[uplinkMsgLen];
+  if(uplinkMsgLen > RADIOLIB_LORAWAN_FRAME_MAX_LEN) {
+    return(RADIOLIB_ERR_PACKET_TOO_LONG);
+  }
+
+  // the frame is kept until the next uplink, since it may have to be retransmitted
+  // the buffer is allocated for the longest frame on first use and reused from then on
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  if(!this->uplinkBuff) {
+    this->uplinkBuff = new uint8_t[RADIOLIB_LORAWAN_FRAME_MAX_LEN];
+  }
   #endif
+  uint8_t* uplinkMsg = this->uplinkBuff;
   
   // set the packet fields
-  uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS] = RADIOLIB_LORAWAN_MHDR_MTYPE_UNCONF_DATA_UP | RADIOLIB_LORAWAN_MHDR_MAJOR_R1;
+  uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS] = RADIOLIB_LORAWAN_MHDR_MAJOR_R1;
+  if(isConfirmed) {
+    uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS] |= RADIOLIB_LORAWAN_MHDR_MTYPE_CONF_DATA_UP;
+  } else {
+    uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS] |= RADIOLIB_LORAWAN_MHDR_MTYPE_UNCONF_DATA_UP;
+  }
   LoRaWANNode::hton<uint32_t>(&uplinkMsg[RADIOLIB_LORAWAN_FHDR_DEV_ADDR_POS], this->devAddr);
 
-  // TODO implement adaptive data rate
-  uplinkMsg[RADIOLIB_LORAWAN_FHDR_FCTRL_POS] = 0x00 | foptsLen;
+  uplinkMsg[RADIOLIB_LORAWAN_FHDR_FCTRL_POS] = fctrl | foptsLen;
 
-  // get frame counter from persistent storage
-  uint32_t fcnt = mod->hal->getPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID) + 1;
-  mod->hal->setPersistentParameter<uint32_t>(RADIOLIB_PERSISTENT_PARAM_LORAWAN_FCNT_UP_ID, fcnt);
+  // get the next frame counter, persistent storage is only updated once per reserved block of values
+  uint32_t fcnt = ++this->fcntUp;
+  if(fcnt > this->fcntUpReserved) {
+    this->fcntUpReserved = fcnt + RADIOLIB_LORAWAN_FCNT_UP_RESERVATION - 1;
+    this->journal.write(RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP, this->fcntUpReserved);
+  }
   LoRaWANNode::hton<uint16_t>(&uplinkMsg[RADIOLIB_LORAWAN_FHDR_FCNT_POS], (uint16_t)fcnt);
 
+  // count uplinks since the last downlink
+  if(this->adrAckCnt < 0xFFFF) {
+    this->adrAckCnt++;
+  }
+
   // check if there is something in FOpts
-  if(this->command) {
-    // append MAC command
-    uint8_t foptsBuff[RADIOLIB_AES128_BLOCK_SIZE];
-    foptsBuff[0] = this->command->cid;
-    for(size_t i = 1; i < this->command->len; i++) {
-      foptsBuff[i] = this->command->payload[i];
+  if(foptsLen > 0) {
+    // FOpts are only encrypted since LoRaWAN 1.1
+    if(this->rev == 1) {
+      processAES(this->macQueue, foptsLen, &this->nwkSEncKeyCtx, &uplinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK, 0x00, false);
+    } else {
+      memcpy(&uplinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], this->macQueue, foptsLen);
     }
-
-    // encrypt it
-    processAES(foptsBuff, foptsLen, this->nwkSEncKey, &uplinkMsg[RADIOLIB_LORAWAN_FRAME_PAYLOAD_POS(0)], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK, 0x00, false);
   }
 
   // set the port
   uplinkMsg[RADIOLIB_LORAWAN_FHDR_FPORT_POS(foptsLen)] = port;
 
   // select encryption key based on the target port
-  uint8_t* encKey = this->appSKey;
+  const RadioLibAES128Key_t* encKey = &this->appSKeyCtx;
   if(port == RADIOLIB_LORAWAN_FPORT_MAC_COMMAND) {
-    encKey = this->nwkSEncKey;
+    encKey = &this->nwkSEncKeyCtx;
   }
 
   // encrypt the frame payload
   processAES(data, len, encKey, &uplinkMsg[RADIOLIB_LORAWAN_FRAME_PAYLOAD_POS(foptsLen)], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK, 0x00, true);
 
-  // create blocks for MIC calculation
-  uint8_t block0[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
-  block0[RADIOLIB_LORAWAN_BLOCK_MAGIC_POS] = RADIOLIB_LORAWAN_MIC_BLOCK_MAGIC;
-  block0[RADIOLIB_LORAWAN_BLOCK_DIR_POS] = RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK;
-  LoRaWANNode::hton<uint32_t>(&block0[RADIOLIB_LORAWAN_BLOCK_DEV_ADDR_POS], this->devAddr);
-  LoRaWANNode::hton<uint32_t>(&block0[RADIOLIB_LORAWAN_BLOCK_FCNT_POS], fcnt);
-  block0[RADIOLIB_LORAWAN_MIC_BLOCK_LEN_POS] = uplinkMsgLen - RADIOLIB_AES128_BLOCK_SIZE - sizeof(uint32_t);
-
-  uint8_t block1[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
-  memcpy(block1, block0, RADIOLIB_AES128_BLOCK_SIZE);
-  // TODO implement confirmed frames 
-  block1[RADIOLIB_LORAWAN_MIC_DATA_RATE_POS] = this->dataRate;
-  block1[RADIOLIB_LORAWAN_MIC_CH_INDEX_POS] = this->chIndex;
-
-  //Module::hexdump(uplinkMsg, uplinkMsgLen);
-
-  // calculate authentication codes
-  memcpy(uplinkMsg, block1, RADIOLIB_AES128_BLOCK_SIZE);
-  uint32_t micS = this->generateMIC(uplinkMsg, uplinkMsgLen - sizeof(uint32_t), this->sNwkSIntKey);
-  memcpy(uplinkMsg, block0, RADIOLIB_AES128_BLOCK_SIZE);
-  uint32_t micF = this->generateMIC(uplinkMsg, uplinkMsgLen - sizeof(uint32_t), this->fNwkSIntKey);
-
-  // check LoRaWAN revision
-  if(this->rev == 1) {
-    uint32_t mic = ((uint32_t)(micF & 0x0000FF00) << 16) | ((uint32_t)(micF & 0x0000000FF) << 16) | ((uint32_t)(micS & 0x0000FF00) >> 0) | ((uint32_t)(micS & 0x0000000FF) >> 0);
-    LoRaWANNode::hton<uint32_t>(&uplinkMsg[uplinkMsgLen - sizeof(uint32_t)], mic);
-  } else {
-    LoRaWANNode::hton<uint32_t>(&uplinkMsg[uplinkMsgLen - sizeof(uint32_t)], micF);
-  }
+  // create block for MIC calculation
+  memset(uplinkMsg, 0x00, RADIOLIB_AES128_BLOCK_SIZE);
+  uplinkMsg[RADIOLIB_LORAWAN_BLOCK_MAGIC_POS] = RADIOLIB_LORAWAN_MIC_BLOCK_MAGIC;
+  uplinkMsg[RADIOLIB_LORAWAN_BLOCK_DIR_POS] = RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK;
+  LoRaWANNode::hton<uint32_t>(&uplinkMsg[RADIOLIB_LORAWAN_BLOCK_DEV_ADDR_POS], this->devAddr);
+  LoRaWANNode::hton<uint32_t>(&uplinkMsg[RADIOLIB_LORAWAN_BLOCK_FCNT_POS], fcnt);
+  uplinkMsg[RADIOLIB_LORAWAN_MIC_BLOCK_LEN_POS] = uplinkMsgLen - RADIOLIB_AES128_BLOCK_SIZE - sizeof(uint32_t);
 
   //Module::hexdump(uplinkMsg, uplinkMsgLen);
 
-  // send it (without the MIC calculation blocks)
-  uint32_t txStart = mod->hal->millis();
-  uint32_t timeOnAir = this->phyLayer->getTimeOnAir(uplinkMsgLen - RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS) / 1000;
-  int16_t state = this->phyLayer->transmit(&uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS], uplinkMsgLen - RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS);
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  delete[] uplinkMsg;
-  #endif
+  // calculate the first authentication code, the rest is done for each transmission
+  this->uplinkMicF = this->generateMIC(uplinkMsg, uplinkMsgLen - sizeof(uint32_t), &this->fNwkSIntKeyCtx);
+  this->uplinkLen = uplinkMsgLen;
+
+  // retransmissions reuse this frame, including its frame counter
+  this->uplinkResult.fcnt = fcnt;
+  this->uplinkResult.confirmed = isConfirmed;
+  this->uplinkResult.acked = false;
+  this->uplinkResult.retries = 0;
+  this->uplinkResult.airtime = 0;
+  state = this->transmitUplink();
   RADIOLIB_ASSERT(state);
 
-  // set the timestamp so that we can measure when to start receiving
-  this->command = NULL;
-  this->rxDelayStart = txStart + timeOnAir;
+  // sticky answers stay in the queue until the network server sends a downlink
+  if(foptsLen > 0) {
+    this->clearMacCommands(false);
+  }
+  this->ackPending = false;
   return(RADIOLIB_ERR_NONE);
 }
 
@@ -465,230 +646,1694 @@ int16_t LoRaWANNode::downlink(String& str) {
 
 int16_t LoRaWANNode::downlink(uint8_t* data, size_t* len) {
   // check if there are any upcoming Rx windows
-  Module* mod = this->phyLayer->getMod();
-  const uint32_t scanGuard = 500;
-  if(mod->hal->millis() - this->rxDelayStart > (this->rxDelays[1] + scanGuard)) {
-    // time since last Tx is greater than RX2 delay + some guard period
+  if((this->state == RADIOLIB_LORAWAN_STATE_IDLE) && !this->rxPending) {
     // we have nothing to downlink
     return(RADIOLIB_ERR_NO_RX_WINDOW);
   }
 
-  // downlink messages are sent with inverted IQ
-  int16_t state = RADIOLIB_ERR_UNKNOWN;
-  if(!this->FSK) {
-    state = this->phyLayer->invertIQ(true);
-    RADIOLIB_ASSERT(state);
+  // run the state machine until both Rx windows are finished
+  Module* mod = this->phyLayer->getMod();
+  while(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+    mod->hal->yield();
+    this->poll();
+  }
+  RADIOLIB_ASSERT(this->result);
+
+  return(this->readDownlink(data, len));
+}
+
+int16_t LoRaWANNode::readDownlink(uint8_t* data, size_t* len) {
+  if(!this->rxPending) {
+    return(RADIOLIB_ERR_NO_RX_WINDOW);
   }
 
-  // calculate the channel scanning timeout
-  // according to the spec, this must be at least enough time to effectively detect a preamble
-  uint32_t scanTimeout = this->phyLayer->getTimeOnAir(0)/1000;
+  memcpy(data, &this->rxBuff[this->rxPayloadPos], this->rxPayloadLen);
+  *len = this->rxPayloadLen;
+  this->rxPending = false;
+  return(RADIOLIB_ERR_NONE);
+}
 
-  // set up everything for channel scan
-  downlinkReceived = false;
-  scanFlag = false;
-  bool packetDetected = false;
-  this->phyLayer->setChannelScanAction(LoRaWANNodeOnChannelScan);
+int16_t LoRaWANNode::poll() {
+  Module* mod = this->phyLayer->getMod();
+  uint32_t now = mod->hal->millis();
+  bool irq = mod->hal->digitalRead(mod->getIrq());
+  int16_t state = RADIOLIB_ERR_NONE;
 
-  // perform listening in the two Rx windows
-  for(uint8_t i = 0; i < 2; i++) {
-    // wait for the start of the Rx window
-    // the waiting duration is shortened a bit to cover any possible timing errors
-    uint32_t waitLen = this->rxDelays[i] - (mod->hal->millis() - this->rxDelayStart);
-    if(waitLen > scanGuard) {
-      waitLen -= scanGuard;
+  // class C downlink, this may happen in any state except when the radio is used for something else
+  if(this->rxContinuous && irq) {
+    this->stopContinuousRx();
+    state = this->processDownlink();
+    if(state != RADIOLIB_ERR_NONE) {
+      // most likely a frame for some other device, reception is resumed below
+      RADIOLIB_DEBUG_PRINTLN("Class C downlink dropped, code %d", state);
+    } else if(this->state == RADIOLIB_LORAWAN_STATE_IDLE) {
+      // downlink outside of any transaction
+      this->rxPending = true;
+      this->notify(RADIOLIB_LORAWAN_EVENT_DOWNLINK);
+    } else {
+      // reply to the last uplink, received either in RX2 or while waiting for retransmission
+      this->rxPending = true;
+      this->finishTransaction(RADIOLIB_ERR_NONE, RADIOLIB_LORAWAN_EVENT_DOWNLINK);
     }
-    mod->hal->delay(waitLen);
 
-    // wait until we get a preamble
-    uint32_t scanStart = mod->hal->millis();
-    while((mod->hal->millis() - scanStart) < (scanTimeout + scanGuard)) {
-      // check channel detection timeout
-      state = this->phyLayer->startChannelScan();
-      RADIOLIB_ASSERT(state);
+    // the interrupt belonged to this frame, not to a transaction the event callback may have started
+    irq = false;
+  }
 
-      // wait with some timeout, though it should not be hit
-      uint32_t cadStart = mod->hal->millis();
-      while(!scanFlag) {
-        mod->hal->yield();
-        if(mod->hal->millis() - cadStart >= 3000) {
-          // timed out, stop waiting
-          break;
+  // events raised by the transaction may start another one from the callback, which must not step it again
+  this->stepping = true;
+  state = this->stepTransaction(now, irq);
+  this->stepping = false;
+  RADIOLIB_ASSERT(state);
+
+  // class C device listens whenever the radio is free, i.e. after RX1 until the next uplink
+  bool rxFree = (this->state == RADIOLIB_LORAWAN_STATE_IDLE) || (this->state == RADIOLIB_LORAWAN_STATE_TX_WAIT) || ((this->state == RADIOLIB_LORAWAN_STATE_RX_WAIT) && (this->rxWindow == 1));
+  if(!this->rxContinuous && rxFree && this->isClassC()) {
+    int16_t res = this->startContinuousRx();
+    RADIOLIB_ASSERT(res);
+  }
+
+  // class B beacon and ping slots only fit between transactions
+  if((this->state == RADIOLIB_LORAWAN_STATE_IDLE) && (this->beaconState != RADIOLIB_LORAWAN_BEACON_STATE_NONE)) {
+    int16_t res = this->pollClassB(now, irq);
+    RADIOLIB_ASSERT(res);
+  }
+
+  return(state);
+}
+
+int16_t LoRaWANNode::stepTransaction(uint32_t now, bool irq) {
+  int16_t state = RADIOLIB_ERR_NONE;
+
+  switch(this->state) {
+    case(RADIOLIB_LORAWAN_STATE_TX):
+      if(!irq) {
+        // still transmitting, check the timeout
+        if(now - this->stateStart > this->stateTimeout) {
+          this->phyLayer->finishTransmit();
+          return(this->finishTransaction(RADIOLIB_ERR_TX_TIMEOUT, RADIOLIB_LORAWAN_EVENT_ERROR));
+        }
+        break;
+      }
+
+      state = this->phyLayer->finishTransmit();
+      if(state != RADIOLIB_ERR_NONE) {
+        return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+      }
+
+      // Rx delays are measured from the end of uplink, which is known from its time-on-air
+      // the interrupt may be noticed late when poll() is not called often enough, but it cannot come sooner
+      this->rxDelayStart = this->txStart + this->txDuration;
+      if((int32_t)(now - this->rxDelayStart) < 0) {
+        this->rxDelayStart = now;
+      }
+      this->rxWindow = 0;
+      this->rxOpened = 0;
+      this->state = RADIOLIB_LORAWAN_STATE_RX_WAIT;
+      this->notify(RADIOLIB_LORAWAN_EVENT_TX_DONE);
+      break;
+
+    case(RADIOLIB_LORAWAN_STATE_TX_WAIT):
+      // RekeyInd or retransmission is waiting for timeout and duty cycle limit
+      if(((int32_t)(now - this->retransmitAt) < 0) || (this->dutyCycleWaitTime() > 0)) {
+        break;
+      }
+
+      this->stopContinuousRx();
+      if(this->uplinkLen == 0) {
+        this->state = RADIOLIB_LORAWAN_STATE_IDLE;
+        state = this->startRekey();
+      } else {
+        // retransmissions may use any channel, just like a new uplink
+        this->uplinkResult.retries++;
+        state = this->selectChannel(false);
+        if(state == RADIOLIB_ERR_NONE) {
+          state = this->transmitUplink();
         }
       }
+      if(state != RADIOLIB_ERR_NONE) {
+        return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+      }
+      break;
+
+    case(RADIOLIB_LORAWAN_STATE_RX_SCAN): {
+      if(!irq && (now - this->stateStart < RADIOLIB_LORAWAN_CAD_TIMEOUT_MS)) {
+        // still scanning, the timeout should not be hit
+        break;
+      }
 
       // check the scan result
-      scanFlag = false;
       state = this->phyLayer->getChannelScanResult();
       if((state == RADIOLIB_PREAMBLE_DETECTED) || (state == RADIOLIB_LORA_DETECTED)) {
-        packetDetected = true;
+        // got a preamble, start receiving with timeout long enough for the longest frame
+        state = this->phyLayer->startReceive();
+        if(state != RADIOLIB_ERR_NONE) {
+          return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+        }
+        this->stateStart = now;
+        this->stateTimeout = this->phyLayer->getTimeOnAir(RADIOLIB_LORAWAN_FRAME_MAX_LEN - RADIOLIB_AES128_BLOCK_SIZE)/1000 + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS;
+        this->state = RADIOLIB_LORAWAN_STATE_RX;
         break;
       }
-    
-    }
 
-    // check if we have a packet
-    if(packetDetected) {
-      break;
+      // nothing yet, scan again until the window is over
+      // according to the spec, this must be at least enough time to effectively detect a preamble
+      uint32_t scanTimeout = this->phyLayer->getTimeOnAir(0)/1000;
+      if(now - this->windowStart < scanTimeout + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS) {
+        state = this->phyLayer->startChannelScan();
+        if(state != RADIOLIB_ERR_NONE) {
+          return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+        }
+        this->stateStart = now;
+        break;
+      }
 
-    } else if(i == 0) {
-      // nothing in the first window, configure for the second
-      state = this->phyLayer->setFrequency(this->band->backupChannel.freqStart);
+      state = this->nextRxWindow();
       RADIOLIB_ASSERT(state);
+    } break;
 
-      DataRate_t datr;
-      findDataRate(RADIOLIB_LORAWAN_DATA_RATE_UNUSED, &datr, &this->band->backupChannel);
-      state = this->phyLayer->setDataRate(datr);
-      RADIOLIB_ASSERT(state);
-    
-    }
-    
+    case(RADIOLIB_LORAWAN_STATE_RX):
+      if(!irq) {
+        if(now - this->stateStart > this->stateTimeout) {
+          return(this->finishTransaction(RADIOLIB_ERR_RX_TIMEOUT, RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK));
+        }
+        break;
+      }
+
+      // we have a message
+      this->phyLayer->standby();
+      if(this->joining) {
+        state = this->processJoinAccept();
+      } else {
+        state = this->processDownlink();
+      }
+      if(state != RADIOLIB_ERR_NONE) {
+        return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+      }
+
+      if(this->joining && (this->rev == 1)) {
+        // LoRaWAN 1.1 join has to be confirmed by RekeyInd
+        this->finishTransaction(RADIOLIB_ERR_NONE, 0);
+        state = this->startRekey();
+        if(state != RADIOLIB_ERR_NONE) {
+          return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+        }
+
+      } else if(this->joining) {
+        this->saveSession();
+        return(this->finishTransaction(RADIOLIB_ERR_NONE, RADIOLIB_LORAWAN_EVENT_JOINED));
+
+      } else if(this->rekeying) {
+        // check the RekeyConf reply, which may come along with other MAC commands
+        if(this->rekeyConfRev == RADIOLIB_LORAWAN_MAC_LEN_NONE) {
+          state = RADIOLIB_ERR_INVALID_CID;
+        } else if(this->rekeyConfRev != this->rev) {
+          // the server does not support the same version
+          state = RADIOLIB_ERR_INVALID_REVISION;
+        }
+        if(state != RADIOLIB_ERR_NONE) {
+          return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+        }
+        this->saveSession();
+        return(this->finishTransaction(RADIOLIB_ERR_NONE, RADIOLIB_LORAWAN_EVENT_JOINED));
+
+      } else {
+        this->rxPending = true;
+        return(this->finishTransaction(RADIOLIB_ERR_NONE, RADIOLIB_LORAWAN_EVENT_DOWNLINK));
+
+      }
+      break;
+
+    default:
+      break;
   }
 
-  // check if we received a packet at all
-  if(!packetDetected) {
-    this->phyLayer->standby();
-    if(!this->FSK) {
-      this->phyLayer->invertIQ(false);
+  // waiting for Rx window is checked last, so that it is handled within the same call as the transition into it
+  while(this->state == RADIOLIB_LORAWAN_STATE_RX_WAIT) {
+    uint32_t rxDelay = this->rxDelays[this->rxWindow];
+    if(this->joining) {
+      rxDelay = (this->rxWindow == 0) ? RADIOLIB_LORAWAN_JOIN_ACCEPT_DELAY_1_MS : RADIOLIB_LORAWAN_JOIN_ACCEPT_DELAY_2_MS;
     }
 
-    // restore the original uplink channel
-    this->configureChannel(0, this->dataRate);
+    uint32_t elapsed = now - this->rxDelayStart;
+    uint32_t scanTimeout = this->phyLayer->getTimeOnAir(0)/1000;
+    if(elapsed > rxDelay + scanTimeout + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS) {
+      // the window is already over, e.g. because poll() was not called in time
+      state = this->nextRxWindow();
+      RADIOLIB_ASSERT(state);
+      continue;
+    }
+
+    // the window is opened a bit sooner to cover any possible timing errors
+    // class C device is already receiving with RX2 parameters, so only the end of RX2 is needed
+    if((elapsed + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS < rxDelay) || ((this->rxWindow == 1) && this->isClassC())) {
+      break;
+    }
 
-    return(RADIOLIB_ERR_RX_TIMEOUT);
+    state = this->openRxWindow();
+    if(state != RADIOLIB_ERR_NONE) {
+      return(this->finishTransaction(state, RADIOLIB_LORAWAN_EVENT_ERROR));
+    }
   }
 
-  // channel scan is finished, swap the actions
-  this->phyLayer->clearChannelScanAction();
-  downlinkReceived = false;
-  this->phyLayer->setPacketReceivedAction(LoRaWANNodeOnDownlink);
+  return(state);
+}
 
-  // start receiving
-  state = this->phyLayer->startReceive();
-  RADIOLIB_ASSERT(state);
+void LoRaWANNode::onEvent(EventCb_t func) {
+  this->eventCb = func;
+}
 
-  // wait for reception with some timeout
-  uint32_t rxStart = mod->hal->millis();
-  while(!downlinkReceived) {
-    mod->hal->yield();
-    // let's hope 30 seconds is long enough timeout
-    if(mod->hal->millis() - rxStart >= 30000) {
-      // timed out
-      this->phyLayer->standby();
-      if(!this->FSK) {
-        this->phyLayer->invertIQ(false);
-      }
-      return(RADIOLIB_ERR_RX_TIMEOUT);
-    }
+void LoRaWANNode::notify(uint8_t event) {
+  if(this->eventCb && event) {
+    this->eventCb(this, event);
   }
+}
 
-  // we have a message, clear actions, go to standby and reset the IQ inversion
-  downlinkReceived = false;
-  this->phyLayer->standby();
-  this->phyLayer->clearPacketReceivedAction();
+int16_t LoRaWANNode::startTransaction(uint8_t* frame, size_t len) {
+  Module* mod = this->phyLayer->getMod();
+  uint32_t timeOnAir = this->phyLayer->getTimeOnAir(len) / 1000;
+  int16_t state = this->phyLayer->startTransmit(frame, len);
+  RADIOLIB_ASSERT(state);
+  this->txStart = mod->hal->millis();
+  this->txDuration = timeOnAir;
+
+  // the sub-band may not be used again until the off-time required by its duty cycle limit passes
+  float freq = this->band->fskFreq;
   if(!this->FSK) {
-    state = this->phyLayer->invertIQ(false);
-    RADIOLIB_ASSERT(state);
+    this->getChannel(this->chIndex, &freq);
+  }
+  int8_t subBand = this->findSubBand(freq);
+  if(subBand >= 0) {
+    this->subBandTxAllowed[subBand] = this->txStart + timeOnAir*this->band->subBands[subBand].dutyCycle;
+    this->subBandsBlocked |= (1 << subBand);
   }
 
-  // get the packet length
-  size_t downlinkMsgLen = this->phyLayer->getPacketLength();
-
-  // check the minimum required frame length
-  // an extra byte is subtracted because downlink frames may not have a port
-  if(downlinkMsgLen < RADIOLIB_LORAWAN_FRAME_LEN(0, 0) - 1 - RADIOLIB_AES128_BLOCK_SIZE) {
-    RADIOLIB_DEBUG_PRINTLN("Downlink message too short (%lu bytes)", downlinkMsgLen);
-    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+  // the network server may also limit the aggregated duty cycle of all channels
+  if(this->maxDutyCycle > 0) {
+    this->aggregatedTxAllowed = this->txStart + timeOnAir*((uint32_t)1 << this->maxDutyCycle);
   }
 
-  // build the buffer for the downlink message
-  // the first 16 bytes are reserved for MIC calculation block
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    uint8_t* downlinkMsg = new uint8_t[RADIOLIB_AES128_BLOCK_SIZE + downlinkMsgLen];
-  #else
-    uint8_t downlinkMsg[RADIOLIB_STATIC_ARRAY_SIZE];
-  #endif
+  // the previous downlink is overwritten by the next one, and there may be none
+  this->rxPending = false;
 
-  // set the MIC calculation block
-  // TODO implement confirmed frames
-  memset(downlinkMsg, 0x00, RADIOLIB_AES128_BLOCK_SIZE);
-  downlinkMsg[RADIOLIB_LORAWAN_BLOCK_MAGIC_POS] = RADIOLIB_LORAWAN_MIC_BLOCK_MAGIC;
-  LoRaWANNode::hton<uint32_t>(&downlinkMsg[RADIOLIB_LORAWAN_BLOCK_DEV_ADDR_POS], this->devAddr);
-  downlinkMsg[RADIOLIB_LORAWAN_BLOCK_DIR_POS] = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK;
-  downlinkMsg[RADIOLIB_LORAWAN_MIC_BLOCK_LEN_POS] = downlinkMsgLen - sizeof(uint32_t);
+  // the timeout should not be hit, unless something went wrong with the radio
+  this->stateStart = mod->hal->millis();
+  this->stateTimeout = 2*timeOnAir + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS;
+  this->state = RADIOLIB_LORAWAN_STATE_TX;
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::transmitUplink() {
+  uint8_t* uplinkMsg = this->uplinkBuff;
+  size_t uplinkMsgLen = this->uplinkLen;
+
+  // check LoRaWAN revision, only 1.1 needs the second code
+  // it depends on the channel and data rate, so it has to be updated for every transmission
+  if(this->rev == 1) {
+    uint16_t confFCnt = 0;
+    if(uplinkMsg[RADIOLIB_LORAWAN_FHDR_FCTRL_POS] & RADIOLIB_LORAWAN_FCTRL_ACK) {
+      confFCnt = this->ackFCnt;
+    }
+    LoRaWANNode::hton<uint16_t>(&uplinkMsg[RADIOLIB_LORAWAN_MIC_CONF_FCNT_POS], confFCnt);
+    uplinkMsg[RADIOLIB_LORAWAN_MIC_DATA_RATE_POS] = this->dataRate;
+    uplinkMsg[RADIOLIB_LORAWAN_MIC_CH_INDEX_POS] = this->chIndex;
+    uint32_t micF = this->uplinkMicF;
+    uint32_t micS = this->generateMIC(uplinkMsg, uplinkMsgLen - sizeof(uint32_t), &this->sNwkSIntKeyCtx);
+    uint32_t mic = ((uint32_t)(micF & 0x0000FF00) << 16) | ((uint32_t)(micF & 0x0000000FF) << 16) | ((uint32_t)(micS & 0x0000FF00) >> 0) | ((uint32_t)(micS & 0x0000000FF) >> 0);
+    LoRaWANNode::hton<uint32_t>(&uplinkMsg[uplinkMsgLen - sizeof(uint32_t)], mic);
+  } else {
+    LoRaWANNode::hton<uint32_t>(&uplinkMsg[uplinkMsgLen - sizeof(uint32_t)], this->uplinkMicF);
+  }
+
+  //Module::hexdump(uplinkMsg, uplinkMsgLen);
+
+  // send it (without the MIC calculation blocks)
+  int16_t state = this->startTransaction(&uplinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS], uplinkMsgLen - RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS);
+  RADIOLIB_ASSERT(state);
+
+  this->uplinkResult.airtime += this->txDuration;
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::openRxWindow() {
+  // the first window uses the uplink channel, the second one the backup channel
+  // unless the network server changed that
+  int16_t state = RADIOLIB_ERR_NONE;
+  if(this->rxWindow == 1) {
+    state = this->configureRx2();
+    RADIOLIB_ASSERT(state);
+
+  } else if((this->rxWindow == 0) && (this->rx1DrOffset > 0) && !this->FSK) {
+    // the first window may use lower data rate than the uplink
+    float freq = 0;
+    const LoRaWANChannelSpan_t* span = this->getChannel(this->chIndex, &freq);
+    int8_t dr = (int8_t)this->dataRate - (int8_t)this->rx1DrOffset;
+    if(dr < (int8_t)this->band->downlinkDataRateMin) {
+      dr = this->band->downlinkDataRateMin;
+    }
+    DataRate_t datr;
+    findDataRate(dr, &datr, span);
+    state = this->phyLayer->setDataRate(datr);
+    RADIOLIB_ASSERT(state);
+
+  }
+  this->rxOpened |= (1 << this->rxWindow);
+
+  // downlink messages are sent with inverted IQ
+  if(!this->FSK) {
+    state = this->phyLayer->invertIQ(true);
+    RADIOLIB_ASSERT(state);
+  }
+
+  // wait until we get a preamble
+  state = this->phyLayer->startChannelScan();
+  RADIOLIB_ASSERT(state);
+
+  Module* mod = this->phyLayer->getMod();
+  this->windowStart = mod->hal->millis();
+  this->stateStart = this->windowStart;
+  this->state = RADIOLIB_LORAWAN_STATE_RX_SCAN;
+  this->notify((this->rxWindow == 0) ? RADIOLIB_LORAWAN_EVENT_RX1_OPEN : RADIOLIB_LORAWAN_EVENT_RX2_OPEN);
+  return(state);
+}
+
+int16_t LoRaWANNode::configureRx2() {
+  // FSK downlinks use the same frequency and data rate
+  if(this->FSK) {
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  int16_t state = this->phyLayer->setFrequencyRaw((this->rx2Frf != 0) ? this->rx2Frf : this->getSpanFrf(&this->band->backupChannel, 0));
+  RADIOLIB_ASSERT(state);
+
+  DataRate_t datr;
+  if(this->rx2Span) {
+    findDataRate(this->rx2DataRate, &datr, this->rx2Span);
+  } else {
+    findDataRate(RADIOLIB_LORAWAN_DATA_RATE_UNUSED, &datr, &this->band->backupChannel);
+  }
+  return(this->phyLayer->setDataRate(datr));
+}
+
+bool LoRaWANNode::isClassC() {
+  return((this->devClass == RADIOLIB_LORAWAN_CLASS_C) && !this->joining && !this->rekeying);
+}
+
+int16_t LoRaWANNode::startContinuousRx() {
+  this->phyLayer->standby();
+  int16_t state = this->configureRx2();
+  RADIOLIB_ASSERT(state);
+  if(!this->FSK) {
+    state = this->phyLayer->invertIQ(true);
+    RADIOLIB_ASSERT(state);
+  }
+  state = this->phyLayer->startReceive();
+  RADIOLIB_ASSERT(state);
+  this->rxContinuous = true;
+
+  // continuous reception replaces the RX2 window
+  if(this->state == RADIOLIB_LORAWAN_STATE_RX_WAIT) {
+    this->notify(RADIOLIB_LORAWAN_EVENT_RX2_OPEN);
+  }
+  return(RADIOLIB_ERR_NONE);
+}
+
+void LoRaWANNode::stopContinuousRx() {
+  if(!this->rxContinuous) {
+    return;
+  }
+
+  // the channel is configured again before the next uplink, only IQ inversion has to be reset
+  this->phyLayer->standby();
+  if(!this->FSK) {
+    this->phyLayer->invertIQ(false);
+  }
+  this->rxContinuous = false;
+}
+
+int16_t LoRaWANNode::pollClassB(uint32_t now, bool irq) {
+  int16_t state = RADIOLIB_ERR_NONE;
+
+  // beacon has priority, ping slot reception that overlaps its window is cut short
+  bool beaconDue = (int32_t)(now - (this->beaconAt - this->beaconGuard)) >= 0;
+  if(beaconDue && (this->classBRx != RADIOLIB_LORAWAN_CLASS_B_RX_NONE) && (this->classBRx != RADIOLIB_LORAWAN_CLASS_B_RX_BEACON)) {
+    this->stopClassBRx();
+  }
+
+  switch(this->classBRx) {
+    case(RADIOLIB_LORAWAN_CLASS_B_RX_BEACON):
+      if(irq) {
+        state = this->processBeacon(now);
+        if(state == RADIOLIB_ERR_NONE) {
+          this->stopClassBRx();
+          this->notify(RADIOLIB_LORAWAN_EVENT_BEACON);
+          return(state);
+        }
+
+        // damaged beacon, or some other frame on the same channel
+        RADIOLIB_DEBUG_PRINTLN("Beacon dropped, code %d", state);
+        state = this->phyLayer->startReceive();
+        RADIOLIB_ASSERT(state);
+      }
+
+      // the window closes once even the latest possible beacon would have been received
+      if((int32_t)(now - (this->beaconAt + this->beaconGuard + this->beaconTimeOnAir)) > 0) {
+        this->stopClassBRx();
+        this->skipBeacon(true);
+      }
+      return(RADIOLIB_ERR_NONE);
+
+    case(RADIOLIB_LORAWAN_CLASS_B_RX_PING_SCAN): {
+      if(!irq && (now - this->stateStart < RADIOLIB_LORAWAN_CAD_TIMEOUT_MS)) {
+        return(RADIOLIB_ERR_NONE);
+      }
+
+      // got a preamble, start receiving with timeout long enough for the longest frame
+      state = this->phyLayer->getChannelScanResult();
+      if((state == RADIOLIB_PREAMBLE_DETECTED) || (state == RADIOLIB_LORA_DETECTED)) {
+        state = this->phyLayer->startReceive();
+        if(state != RADIOLIB_ERR_NONE) {
+          this->stopClassBRx();
+          return(state);
+        }
+        this->stateStart = now;
+        this->stateTimeout = this->phyLayer->getTimeOnAir(RADIOLIB_LORAWAN_FRAME_MAX_LEN - RADIOLIB_AES128_BLOCK_SIZE)/1000 + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS;
+        this->classBRx = RADIOLIB_LORAWAN_CLASS_B_RX_PING;
+        return(RADIOLIB_ERR_NONE);
+      }
+
+      // nothing yet, keep scanning until the slot start plus the timing uncertainty is covered
+      uint32_t scanTimeout = this->phyLayer->getTimeOnAir(0)/1000;
+      if(now - this->windowStart < scanTimeout + 2*this->beaconGuard) {
+        state = this->phyLayer->startChannelScan();
+        if(state != RADIOLIB_ERR_NONE) {
+          this->stopClassBRx();
+          return(state);
+        }
+        this->stateStart = now;
+        return(RADIOLIB_ERR_NONE);
+      }
+      this->stopClassBRx();
+      this->pingSlot++;
+    } break;
+
+    case(RADIOLIB_LORAWAN_CLASS_B_RX_PING):
+      if(!irq) {
+        if(now - this->stateStart > this->stateTimeout) {
+          this->stopClassBRx();
+          this->pingSlot++;
+        }
+        return(RADIOLIB_ERR_NONE);
+      }
+
+      // we have a message
+      this->phyLayer->standby();
+      state = this->processDownlink();
+      this->stopClassBRx();
+      this->pingSlot++;
+      if(state != RADIOLIB_ERR_NONE) {
+        // most likely a frame for some other device in the same slot
+        RADIOLIB_DEBUG_PRINTLN("Ping slot downlink dropped, code %d", state);
+        return(state);
+      }
+      this->rxPending = true;
+      this->notify(RADIOLIB_LORAWAN_EVENT_DOWNLINK);
+      return(RADIOLIB_ERR_NONE);
+
+    default:
+      break;
+  }
+
+  // the radio is free, open the next window that is due
+  if(beaconDue) {
+    if((int32_t)(now - (this->beaconAt + this->beaconGuard)) > 0) {
+      // the beacon window was taken by a transaction
+      this->skipBeacon(false);
+      return(RADIOLIB_ERR_NONE);
+    }
+    state = this->openBeaconWindow();
+    if(state != RADIOLIB_ERR_NONE) {
+      this->stopClassBRx();
+    }
+    return(state);
+  }
+
+  // ping slots are only known once the beacon was found
+  if(this->beaconState != RADIOLIB_LORAWAN_BEACON_STATE_LOCKED) {
+    return(RADIOLIB_ERR_NONE);
+  }
+  uint16_t pingNb = (uint16_t)1 << (RADIOLIB_LORAWAN_PING_PERIODICITY_MAX - this->pingPeriodicity);
+  uint32_t pingPeriod = (uint32_t)1 << (5 + this->pingPeriodicity);
+  while(this->pingSlot < pingNb) {
+    uint32_t slotAt = this->beaconAt - RADIOLIB_LORAWAN_BEACON_PERIOD_MS + RADIOLIB_LORAWAN_BEACON_RESERVED_MS + (this->pingOffset + this->pingSlot*pingPeriod)*RADIOLIB_LORAWAN_PING_SLOT_LEN_MS;
+    if((int32_t)(now - (slotAt - this->beaconGuard)) < 0) {
+      break;
+    }
+
+    // slots that passed during a transaction are skipped
+    if((int32_t)(now - (slotAt + this->beaconGuard)) > 0) {
+      this->pingSlot++;
+      continue;
+    }
+
+    state = this->openPingSlot();
+    if(state != RADIOLIB_ERR_NONE) {
+      this->stopClassBRx();
+    }
+    return(state);
+  }
+
+  return(RADIOLIB_ERR_NONE);
+}
+
+void LoRaWANNode::startBeaconAcquisition() {
+  this->stopClassBRx();
+  this->beaconState = RADIOLIB_LORAWAN_BEACON_STATE_ACQUIRE;
+  this->beaconsMissed = 0;
+
+  Module* mod = this->phyLayer->getMod();
+  uint32_t now = mod->hal->millis();
+  if(this->deviceTimeValid) {
+    // beacons are sent when GPS time is a multiple of the beacon period
+    uint32_t periodPos = (this->deviceTimeGpsEpoch % RADIOLIB_LORAWAN_BEACON_PERIOD_S)*1000 + ((uint32_t)this->deviceTimeFraction*1000)/256 + (now - this->deviceTimeAt);
+    uint32_t periods = periodPos / RADIOLIB_LORAWAN_BEACON_PERIOD_MS + 1;
+    this->beaconAt = now + periods*RADIOLIB_LORAWAN_BEACON_PERIOD_MS - periodPos;
+    this->beaconTime = this->deviceTimeGpsEpoch - (this->deviceTimeGpsEpoch % RADIOLIB_LORAWAN_BEACON_PERIOD_S) + periods*RADIOLIB_LORAWAN_BEACON_PERIOD_S;
+    this->beaconGuard = RADIOLIB_LORAWAN_BEACON_ACQUIRE_GUARD_MS;
+    this->beaconSearch = false;
+    return;
+  }
+
+  // without device time, the receiver stays on the first beacon channel until a beacon is sent there
+  uint32_t numChannels = (this->beaconFrf != 0) ? 1 : this->band->beaconChannel.numChannels;
+  uint32_t searchLen = numChannels*RADIOLIB_LORAWAN_BEACON_PERIOD_MS + RADIOLIB_LORAWAN_BEACON_RESERVED_MS;
+  this->beaconAt = now + searchLen/2;
+  this->beaconGuard = searchLen/2;
+  this->beaconSearch = true;
+}
+
+int16_t LoRaWANNode::openBeaconWindow() {
+  // beacon hops over the channels every period, the search stays on the first one
+  const LoRaWANChannelSpan_t* span = &this->band->beaconChannel;
+  uint32_t frf = this->beaconFrf;
+  if(frf == 0) {
+    uint8_t chan = this->beaconSearch ? 0 : (this->beaconTime / RADIOLIB_LORAWAN_BEACON_PERIOD_S) % span->numChannels;
+    frf = this->getSpanFrf(span, chan);
+  }
+  this->classBRx = RADIOLIB_LORAWAN_CLASS_B_RX_BEACON;
+  int16_t state = this->phyLayer->setFrequencyRaw(frf);
+  RADIOLIB_ASSERT(state);
+
+  DataRate_t datr;
+  findDataRate(RADIOLIB_LORAWAN_DATA_RATE_UNUSED, &datr, span);
+  state = this->phyLayer->setDataRate(datr);
+  RADIOLIB_ASSERT(state);
+
+  // beacon has no header and is protected by its own CRCs
+  uint8_t len = LoRaWANNode::getBeaconLen(this->band);
+  state = this->phyLayer->implicitHeader(len);
+  RADIOLIB_ASSERT(state);
+  this->beaconTimeOnAir = this->phyLayer->getTimeOnAir(len)/1000;
+
+  return(this->phyLayer->startReceive());
+}
+
+int16_t LoRaWANNode::processBeacon(uint32_t now) {
+  uint8_t beacon[RADIOLIB_LORAWAN_BEACON_MAX_LEN];
+  uint8_t len = LoRaWANNode::getBeaconLen(this->band);
+  int16_t state = this->phyLayer->readData(beacon, len);
+  // beacon is sent without PHY CRC, which may be reported as an error
+  if((state == RADIOLIB_ERR_CRC_MISMATCH) || (state == RADIOLIB_ERR_LORA_HEADER_DAMAGED)) {
+    state = RADIOLIB_ERR_NONE;
+  }
+  RADIOLIB_ASSERT(state);
+
+  // the common part carries the time, so it has to be intact
+  size_t crcPos = this->band->beaconRfuLen[0] + RADIOLIB_LORAWAN_BEACON_TIME_LEN;
+  if(RadioLibLoRaWANBeaconCRC::checksum(beacon, crcPos) != LoRaWANNode::ntoh<uint16_t>(&beacon[crcPos])) {
+    return(RADIOLIB_ERR_CRC_MISMATCH);
+  }
+  this->beaconLastTime = LoRaWANNode::ntoh<uint32_t>(&beacon[this->band->beaconRfuLen[0]]);
+
+  // the gateway-specific part is only informative
+  size_t gwPos = crcPos + RADIOLIB_LORAWAN_BEACON_CRC_LEN;
+  size_t gwCrcPos = gwPos + RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN + this->band->beaconRfuLen[1];
+  if(RadioLibLoRaWANBeaconCRC::checksum(&beacon[gwPos], gwCrcPos - gwPos) == LoRaWANNode::ntoh<uint16_t>(&beacon[gwCrcPos])) {
+    memcpy(this->beaconGwSpecific, &beacon[gwPos], RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN);
+  } else {
+    memset(this->beaconGwSpecific, 0x00, RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN);
+  }
+  this->beaconValid = true;
+
+  // beacon is sent at the start of the period, the reception ends one time-on-air later
+  this->beaconAt = now - this->beaconTimeOnAir + RADIOLIB_LORAWAN_BEACON_PERIOD_MS;
+  this->beaconTime = this->beaconLastTime + RADIOLIB_LORAWAN_BEACON_PERIOD_S;
+  this->beaconGuard = RADIOLIB_LORAWAN_BEACON_GUARD_MS;
+  this->beaconSearch = false;
+  this->beaconsMissed = 0;
+  this->beaconState = RADIOLIB_LORAWAN_BEACON_STATE_LOCKED;
+  this->schedulePingSlots();
+  return(RADIOLIB_ERR_NONE);
+}
+
+void LoRaWANNode::skipBeacon(bool listened) {
+  if(this->beaconState == RADIOLIB_LORAWAN_BEACON_STATE_ACQUIRE) {
+    // the search only fails if the radio was actually listening
+    if(listened) {
+      this->loseBeacon();
+    } else {
+      this->startBeaconAcquisition();
+    }
+    return;
+  }
+
+  // ping slots keep the expected timing for a while, the windows widen until the beacon is found again
+  if(++this->beaconsMissed > RADIOLIB_LORAWAN_BEACON_LESS_MAX_PERIODS) {
+    this->loseBeacon();
+    return;
+  }
+  RADIOLIB_DEBUG_PRINTLN("Beacon missed (%d)", this->beaconsMissed);
+  this->beaconAt += RADIOLIB_LORAWAN_BEACON_PERIOD_MS;
+  this->beaconTime += RADIOLIB_LORAWAN_BEACON_PERIOD_S;
+  this->beaconGuard += RADIOLIB_LORAWAN_BEACON_GUARD_MS;
+  this->schedulePingSlots();
+}
+
+void LoRaWANNode::loseBeacon() {
+  this->stopClassBRx();
+  this->beaconState = RADIOLIB_LORAWAN_BEACON_STATE_NONE;
+  this->devClass = RADIOLIB_LORAWAN_CLASS_A;
+  this->notify(RADIOLIB_LORAWAN_EVENT_BEACON_LOST);
+}
+
+void LoRaWANNode::schedulePingSlots() {
+  // the offset is the AES of the current period's beacon time and device address with all-zero key
+  uint8_t block[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
+  uint8_t key[RADIOLIB_AES128_KEY_SIZE] = { 0 };
+  LoRaWANNode::hton<uint32_t>(&block[0], this->beaconTime - RADIOLIB_LORAWAN_BEACON_PERIOD_S);
+  LoRaWANNode::hton<uint32_t>(&block[4], this->devAddr);
+  RadioLibAES128Key_t keyCtx;
+  RadioLibAES128::initKey(&keyCtx, key);
+
+  // encryptECB clears the output buffer first, so it cannot work in place
+  uint8_t rand[RADIOLIB_AES128_BLOCK_SIZE];
+  RadioLibAES128::encryptECB(&keyCtx, block, RADIOLIB_AES128_BLOCK_SIZE, rand);
+
+  uint32_t pingPeriod = (uint32_t)1 << (5 + this->pingPeriodicity);
+  this->pingOffset = ((uint32_t)rand[0] + (uint32_t)rand[1]*256) % pingPeriod;
+  this->pingSlot = 0;
+}
+
+int16_t LoRaWANNode::openPingSlot() {
+  // default channel hops every period, based on the device address
+  uint32_t frf = this->pingFrf;
+  if(frf == 0) {
+    const LoRaWANChannelSpan_t* span = &this->band->beaconChannel;
+    uint8_t chan = (this->devAddr + (this->beaconTime - RADIOLIB_LORAWAN_BEACON_PERIOD_S) / RADIOLIB_LORAWAN_BEACON_PERIOD_S) % span->numChannels;
+    frf = this->getSpanFrf(span, chan);
+  }
+  this->classBRx = RADIOLIB_LORAWAN_CLASS_B_RX_PING_SCAN;
+  int16_t state = this->phyLayer->setFrequencyRaw(frf);
+  RADIOLIB_ASSERT(state);
+
+  DataRate_t datr;
+  findDataRate(this->pingDataRate, &datr, this->pingSpan ? this->pingSpan : &this->band->beaconChannel);
+  state = this->phyLayer->setDataRate(datr);
+  RADIOLIB_ASSERT(state);
+
+  // ping slot downlinks are sent with inverted IQ, just like in class A windows
+  state = this->phyLayer->invertIQ(true);
+  RADIOLIB_ASSERT(state);
+
+  state = this->phyLayer->startChannelScan();
+  RADIOLIB_ASSERT(state);
+
+  Module* mod = this->phyLayer->getMod();
+  this->windowStart = mod->hal->millis();
+  this->stateStart = this->windowStart;
+  return(RADIOLIB_ERR_NONE);
+}
+
+void LoRaWANNode::stopClassBRx() {
+  if(this->classBRx == RADIOLIB_LORAWAN_CLASS_B_RX_NONE) {
+    return;
+  }
+
+  // the channel is configured again before the next uplink, only header mode and IQ inversion have to be reset
+  this->phyLayer->standby();
+  if(this->classBRx == RADIOLIB_LORAWAN_CLASS_B_RX_BEACON) {
+    this->phyLayer->explicitHeader();
+  } else {
+    this->phyLayer->invertIQ(false);
+  }
+  this->classBRx = RADIOLIB_LORAWAN_CLASS_B_RX_NONE;
+}
+
+int16_t LoRaWANNode::nextRxWindow() {
+  if(this->rxWindow == 0) {
+    this->rxWindow = 1;
+    this->state = RADIOLIB_LORAWAN_STATE_RX_WAIT;
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  // nothing in either window
+  int16_t res = RADIOLIB_ERR_NO_RX_WINDOW;
+  if(this->rxOpened || this->rxContinuous) {
+    res = RADIOLIB_ERR_RX_TIMEOUT;
+  }
+  return(this->finishTransaction(res, RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK));
+}
+
+int16_t LoRaWANNode::finishTransaction(int16_t res, uint8_t event) {
+  // class C reception is restarted by poll(), possibly with new RX2 parameters
+  this->stopContinuousRx();
+  if(this->rxOpened) {
+    // stop receiving and reset the IQ inversion
+    this->phyLayer->standby();
+    if(!this->FSK) {
+      this->phyLayer->invertIQ(false);
+    }
+
+    // restore the original uplink channel
+    if(((this->rxOpened & (1 << 1)) || (this->rx1DrOffset > 0)) && !this->FSK) {
+      this->configureChannel(this->chIndex, this->dataRate);
+    }
+    this->rxOpened = 0;
+  }
+
+  // no answer to the uplink, send it again if the network server requested more transmissions
+  // a confirmed uplink only needs the acknowledgement, so it waits a bit longer to avoid repeated collisions
+  if((event == RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK) && (this->uplinkLen > 0) && (this->uplinkResult.retries + 1 < this->nbTrans)) {
+    Module* mod = this->phyLayer->getMod();
+    this->retransmitAt = mod->hal->millis();
+    if(this->uplinkResult.confirmed) {
+      this->retransmitAt += RADIOLIB_LORAWAN_RETRANSMIT_TIMEOUT_MIN_MS + this->nextRandom() % (RADIOLIB_LORAWAN_RETRANSMIT_TIMEOUT_MAX_MS - RADIOLIB_LORAWAN_RETRANSMIT_TIMEOUT_MIN_MS + 1);
+    }
+    this->state = RADIOLIB_LORAWAN_STATE_TX_WAIT;
+    return(RADIOLIB_ERR_NONE);
+  }
+
+  this->state = RADIOLIB_LORAWAN_STATE_IDLE;
+  this->uplinkLen = 0;
+  this->result = res;
+  if(event != 0) {
+    // transaction is fully finished (i.e. not just a step of the join procedure)
+    this->joining = false;
+    this->rekeying = false;
+  }
+  this->notify(event);
+  return(res);
+}
+
+int16_t LoRaWANNode::processDownlink() {
+  // get the packet length
+  size_t downlinkMsgLen = this->phyLayer->getPacketLength();
+
+  // check the minimum required frame length
+  // an extra byte is subtracted because downlink frames may not have a port
+  if(downlinkMsgLen < RADIOLIB_LORAWAN_FRAME_LEN(0, 0) - 1 - RADIOLIB_AES128_BLOCK_SIZE) {
+    RADIOLIB_DEBUG_PRINTLN("Downlink message too short (%lu bytes)", downlinkMsgLen);
+    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+  }
+  if(downlinkMsgLen > RADIOLIB_LORAWAN_FRAME_MAX_LEN - RADIOLIB_AES128_BLOCK_SIZE) {
+    RADIOLIB_DEBUG_PRINTLN("Downlink message too long (%lu bytes)", downlinkMsgLen);
+    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+  }
+
+  // the frame is kept until the application reads it, in the same way as the uplink buffer
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  if(!this->rxBuff) {
+    this->rxBuff = new uint8_t[RADIOLIB_LORAWAN_FRAME_MAX_LEN];
+  }
+  #endif
+
+  // set the MIC calculation block
+  uint8_t* downlinkMsg = this->rxBuff;
+  memset(downlinkMsg, 0x00, RADIOLIB_AES128_BLOCK_SIZE);
+  downlinkMsg[RADIOLIB_LORAWAN_BLOCK_MAGIC_POS] = RADIOLIB_LORAWAN_MIC_BLOCK_MAGIC;
+  LoRaWANNode::hton<uint32_t>(&downlinkMsg[RADIOLIB_LORAWAN_BLOCK_DEV_ADDR_POS], this->devAddr);
+  downlinkMsg[RADIOLIB_LORAWAN_BLOCK_DIR_POS] = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK;
+  downlinkMsg[RADIOLIB_LORAWAN_MIC_BLOCK_LEN_POS] = downlinkMsgLen - sizeof(uint32_t);
 
   // read the data
-  state = this->phyLayer->readData(&downlinkMsg[RADIOLIB_AES128_BLOCK_SIZE], downlinkMsgLen);
+  int16_t state = this->phyLayer->readData(&downlinkMsg[RADIOLIB_AES128_BLOCK_SIZE], downlinkMsgLen);
   // downlink frames are sent without CRC, which will raise error on SX127x
   // we can ignore that error
   if(state == RADIOLIB_ERR_LORA_HEADER_DAMAGED) {
     state = RADIOLIB_ERR_NONE;
   }
 
-  //Module::hexdump(downlinkMsg, RADIOLIB_AES128_BLOCK_SIZE + downlinkMsgLen);
-  
-  if(state != RADIOLIB_ERR_NONE) {
-    #if !defined(RADIOLIB_STATIC_ONLY)
-      delete[] downlinkMsg;
-    #endif
-    return(state);
+  //Module::hexdump(downlinkMsg, RADIOLIB_AES128_BLOCK_SIZE + downlinkMsgLen);
+  
+  RADIOLIB_ASSERT(state);
+
+  // cheap checks first, so that frames for other devices, replays and malformed frames never reach AES
+  // check the address
+  uint32_t addr = LoRaWANNode::ntoh<uint32_t>(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_DEV_ADDR_POS]);
+  if(addr != this->devAddr) {
+    RADIOLIB_DEBUG_PRINTLN("Device address mismatch, expected 0x%08X, got 0x%08X", this->devAddr, addr);
+    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+  }
+
+  // check fopts len
+  uint8_t fctrl = downlinkMsg[RADIOLIB_LORAWAN_FHDR_FCTRL_POS];
+  uint8_t foptsLen = fctrl & RADIOLIB_LORAWAN_FHDR_FOPTS_LEN_MASK;
+  size_t headerLen = RADIOLIB_LORAWAN_FRAME_LEN(0, foptsLen) - 1 - RADIOLIB_AES128_BLOCK_SIZE;
+  if(downlinkMsgLen < headerLen) {
+    RADIOLIB_DEBUG_PRINTLN("Downlink message too short for %d bytes of FOpts", foptsLen);
+    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+  }
+
+  // LoRaWAN 1.1 has separate counters for application payload and for MAC-only frames
+  uint8_t fcntId = RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN;
+  uint32_t* fcntDown = &this->nFCntDown;
+  if((this->rev == 1) && (downlinkMsgLen > headerLen) && (downlinkMsg[RADIOLIB_LORAWAN_FHDR_FPORT_POS(foptsLen)] != RADIOLIB_LORAWAN_FPORT_MAC_COMMAND)) {
+    fcntId = RADIOLIB_JOURNAL_ID_LORAWAN_A_FCNT_DOWN;
+    fcntDown = &this->aFCntDown;
+  }
+
+  // only the lower 16 bits of the counter are sent, the upper ones are the closest to the expected value
+  uint16_t fcnt16 = LoRaWANNode::ntoh<uint16_t>(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FCNT_POS]);
+  uint32_t fcnt = (*fcntDown & 0xFFFF0000) | fcnt16;
+  if(fcnt < *fcntDown) {
+    fcnt += (uint32_t)1 << 16;
+  }
+
+  // anything below the expected value is a replay
+  if((fcnt - *fcntDown >= RADIOLIB_LORAWAN_MAX_FCNT_GAP) || (fcnt == 0xFFFFFFFF)) {
+    RADIOLIB_DEBUG_PRINTLN("Invalid downlink frame counter %d, expected at least %lu", fcnt16, *fcntDown);
+    return(RADIOLIB_ERR_DOWNLINK_FCNT_INVALID);
+  }
+  LoRaWANNode::hton<uint32_t>(&downlinkMsg[RADIOLIB_LORAWAN_BLOCK_FCNT_POS], fcnt);
+
+  // LoRaWAN 1.1 acknowledgement also includes frame counter of the confirmed uplink
+  if((this->rev == 1) && (fctrl & RADIOLIB_LORAWAN_FCTRL_ACK)) {
+    LoRaWANNode::hton<uint16_t>(&downlinkMsg[RADIOLIB_LORAWAN_MIC_CONF_FCNT_POS], (uint16_t)this->uplinkResult.fcnt);
+  }
+
+  // check the MIC
+  if(!verifyMIC(downlinkMsg, RADIOLIB_AES128_BLOCK_SIZE + downlinkMsgLen, &this->sNwkSIntKeyCtx)) {
+    return(RADIOLIB_ERR_CRC_MISMATCH);
+  }
+
+  // the frame is authentic, so it may not be received again
+  *fcntDown = fcnt + 1;
+  this->journal.write(fcntId, *fcntDown);
+
+  // valid downlink, the link is alive - save its quality and restart ADR backoff
+  this->snrHistory[this->historyPos] = this->phyLayer->getSNR();
+  this->rssiHistory[this->historyPos] = this->phyLayer->getRSSI();
+  this->historyPos = (this->historyPos + 1) % RADIOLIB_LORAWAN_LINK_HISTORY_LEN;
+  if(this->historyLen < RADIOLIB_LORAWAN_LINK_HISTORY_LEN) {
+    this->historyLen++;
+  }
+  this->adrAckCnt = 0;
+
+  // the downlink ADR bit is not needed: when the network server is not able to manage data rate,
+  // the device may keep ADR enabled and rely on the backoff in startUplink(), which is what it does anyway
+
+  // check if this is the acknowledgement, and whether the network server expects one
+  if((fctrl & RADIOLIB_LORAWAN_FCTRL_ACK) && this->uplinkResult.confirmed) {
+    this->uplinkResult.acked = true;
+  }
+  this->ackPending = false;
+  if((downlinkMsg[RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS] & RADIOLIB_LORAWAN_MHDR_MTYPE_MASK) == RADIOLIB_LORAWAN_MHDR_MTYPE_CONF_DATA_DOWN) {
+    this->ackPending = true;
+    this->ackFCnt = fcnt16;
+  }
+
+  // the network server got the last uplink, sticky answers are not needed anymore
+  this->clearMacCommands(true);
+
+  if(foptsLen > 0) {
+    // FOpts are only encrypted since LoRaWAN 1.1
+    // according to the specification, the last two arguments should be 0x00 and false,
+    // but that will fail even for LoRaWAN 1.1.0 server
+    if(this->rev == 1) {
+      processAES(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], foptsLen, &this->nwkSEncKeyCtx, &downlinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK, 0x01, true);
+    }
+    this->processMacCommands(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], foptsLen);
+  }
+
+  // payload following the port (if there is any)
+  this->rxPayloadPos = RADIOLIB_LORAWAN_FRAME_PAYLOAD_POS(foptsLen);
+  this->rxPayloadLen = 0;
+  if(downlinkMsgLen == headerLen) {
+    return(state);
+  }
+  this->rxPayloadLen = downlinkMsgLen - headerLen - 1;
+
+  // MAC commands in the payload are encrypted with the network session key
+  if(downlinkMsg[RADIOLIB_LORAWAN_FHDR_FPORT_POS(foptsLen)] == RADIOLIB_LORAWAN_FPORT_MAC_COMMAND) {
+    processAES(&downlinkMsg[this->rxPayloadPos], this->rxPayloadLen, &this->nwkSEncKeyCtx, &downlinkMsg[this->rxPayloadPos], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK, 0x00, true);
+    this->processMacCommands(&downlinkMsg[this->rxPayloadPos], this->rxPayloadLen);
+
+    // nothing for the application
+    this->rxPayloadLen = 0;
+  } else {
+    processAES(&downlinkMsg[this->rxPayloadPos], this->rxPayloadLen, &this->appSKeyCtx, &downlinkMsg[this->rxPayloadPos], fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK, 0x00, true);
+  }
+
+  return(state);
+}
+
+void LoRaWANNode::processMacCommands(uint8_t* cmds, size_t len) {
+  size_t i = 0;
+  while(i < len) {
+    // check the command is known, otherwise there is no way to find the next one
+    uint8_t cid = cmds[i];
+    if((cid >= sizeof(LoRaWANMacSpecs) / sizeof(LoRaWANMacSpecs[0])) || (LoRaWANMacSpecs[cid].lenDn == RADIOLIB_LORAWAN_MAC_LEN_NONE) || (i + 1 + LoRaWANMacSpecs[cid].lenDn > len)) {
+      RADIOLIB_DEBUG_PRINTLN("Unable to parse MAC command 0x%02x", cid);
+      return;
+    }
+    size_t cmdLen = 1 + LoRaWANMacSpecs[cid].lenDn;
+
+    // consecutive LinkADRReq commands form a single block, which is applied as a whole
+    uint8_t numReqs = 1;
+    if(cid == RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ) {
+      while((i + (numReqs + 1)*cmdLen <= len) && (cmds[i + numReqs*cmdLen] == cid)) {
+        numReqs++;
+      }
+    }
+
+    this->execMacCommand(&cmds[i], numReqs);
+    i += numReqs*cmdLen;
+  }
+}
+
+void LoRaWANNode::execMacCommand(uint8_t* cmd, uint8_t numReqs) {
+  uint8_t cid = cmd[0];
+  uint8_t* payload = &cmd[1];
+  uint8_t ans[2] = { 0, 0 };
+  switch(cid) {
+    case(RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_ANS): {
+      this->linkCheckMargin = payload[0];
+      this->linkCheckGwCnt = payload[1];
+      this->linkCheckValid = true;
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ): {
+      // every request in the block gets the same answer
+      ans[0] = this->processLinkAdrReq(cmd, numReqs);
+      for(uint8_t i = 0; i < numReqs; i++) {
+        this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_ANS, ans);
+      }
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_DUTY_CYCLE_REQ): {
+      this->maxDutyCycle = payload[0] & 0x0F;
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_DUTY_CYCLE_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_RX_PARAM_SETUP_REQ): {
+      uint8_t rx1DrOffset = (payload[0] >> 4) & 0x07;
+      uint8_t rx2DataRate = payload[0] & 0x0F;
+      float freq = (float)LoRaWANNode::ntoh<uint32_t>(&payload[1], 3)/10000.0;
+
+      // RX1 data rate offset is only supported in bands where uplink and downlink data rates are the same
+      if((rx1DrOffset == 0) || ((this->band->downlinkDataRateBase == 0) && (rx1DrOffset <= RADIOLIB_LORAWAN_RX1_DR_OFFSET_MAX))) {
+        ans[0] |= RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX1_DR_OFFSET_ACK;
+      }
+
+      // RX2 data rate has to be defined for downlink
+      const LoRaWANChannelSpan_t* rx2Span = NULL;
+      for(uint8_t span = 0; span < this->band->numChannelSpans; span++) {
+        const LoRaWANChannelSpan_t* chSpan = &this->band->defaultChannels[span];
+        if((chSpan->direction != RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK) && (chSpan->dataRates[rx2DataRate] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+          rx2Span = chSpan;
+          ans[0] |= RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX2_DATA_RATE_ACK;
+          break;
+        }
+      }
+
+      if(this->isFrequencyInBand(freq)) {
+        ans[0] |= RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_CHANNEL_ACK;
+      }
+
+      // the new settings are applied only if all of them are acceptable
+      if(ans[0] == (RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_CHANNEL_ACK | RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX2_DATA_RATE_ACK | RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX1_DR_OFFSET_ACK)) {
+        this->rx1DrOffset = rx1DrOffset;
+        this->rx2DataRate = rx2DataRate;
+        this->rx2Span = rx2Span;
+        this->rx2Frf = this->getFrf(freq);
+      }
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_RX_PARAM_SETUP_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_REQ): {
+      // margin is the SNR of this downlink as 6-bit signed integer
+      int16_t margin = (int16_t)this->phyLayer->getSNR();
+      if(margin < RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MIN) {
+        margin = RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MIN;
+      } else if(margin > RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MAX) {
+        margin = RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MAX;
+      }
+      ans[0] = this->battLevel;
+      ans[1] = (uint8_t)margin & 0x3F;
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_NEW_CHANNEL_REQ): {
+      // only the channels that could be added by CFList can be changed
+      uint8_t chan = payload[0];
+      float freq = (float)LoRaWANNode::ntoh<uint32_t>(&payload[1], 3)/10000.0;
+      uint8_t drMin = payload[4] & 0x0F;
+      uint8_t drMax = payload[4] >> 4;
+      uint8_t numChannels = this->getNumChannels();
+      uint8_t numAdded = sizeof(this->availableChannelsFreq) / sizeof(this->availableChannelsFreq[0]);
+      if((this->band->cfListType == RADIOLIB_LORAWAN_CFLIST_TYPE_FREQUENCIES) && (chan >= numChannels - numAdded) && (chan < numChannels)) {
+        if((freq == 0) || this->isFrequencyInBand(freq)) {
+          ans[0] |= RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_FREQ_ACK;
+        }
+
+        // added channels share the data rates of the first span, so the range must fit in it
+        const LoRaWANChannelSpan_t* span = &this->band->defaultChannels[0];
+        if((freq == 0) || ((drMin <= drMax) && (span->dataRates[drMin] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED) && (span->dataRates[drMax] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED))) {
+          ans[0] |= RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_DATA_RATE_ACK;
+        }
+      }
+
+      // frequency of 0 disables the channel
+      if(ans[0] == (RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_FREQ_ACK | RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_DATA_RATE_ACK)) {
+        this->availableChannelsFreq[chan - (numChannels - numAdded)] = freq;
+        this->availableChannelsFrf[chan - (numChannels - numAdded)] = this->getFrf(freq);
+        if(freq == 0) {
+          this->availableChannelsMask[chan / 16] &= ~(1 << (chan % 16));
+        } else {
+          this->availableChannelsMask[chan / 16] |= (1 << (chan % 16));
+        }
+      }
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_NEW_CHANNEL_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_RX_TIMING_SETUP_REQ): {
+      uint8_t delay = payload[0] & 0x0F;
+      if(delay == 0) {
+        delay = 1;
+      }
+      this->rxDelays[0] = delay*1000;
+      this->rxDelays[1] = this->rxDelays[0] + 1000;
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_RX_TIMING_SETUP_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_DL_CHANNEL_REQ): {
+      // separate RX1 frequency is not supported, only report whether the uplink channel exists
+      float freq = 0;
+      if(this->getChannel(payload[0], &freq)) {
+        ans[0] |= RADIOLIB_LORAWAN_DL_CHANNEL_ANS_UPLINK_FREQ_EXISTS;
+      }
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_DI_CHANNEL_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_REKEY_CONF): {
+      this->rekeyConfRev = payload[0];
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_ADR_PARAM_SETUP_REQ): {
+      this->adrAckLimit = (uint16_t)1 << (payload[0] >> 4);
+      this->adrAckDelay = (uint16_t)1 << (payload[0] & 0x0F);
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_ADR_PARAM_SETUP_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_ANS): {
+      this->deviceTimeGpsEpoch = LoRaWANNode::ntoh<uint32_t>(&payload[0]);
+      this->deviceTimeFraction = payload[4];
+      this->deviceTimeValid = true;
+
+      // the time is valid at the end of the uplink
+      this->deviceTimeAt = this->rxDelayStart;
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_REJOIN_PARAM_SETUP_REQ): {
+      // rejoin requests are never sent, so the time limit is not accepted
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_REJOIN_PARAM_SETUP_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_INFO_ANS): {
+      // the network server accepted the periodicity, use it from the next slot on
+      this->pingPeriodicity = this->pingPeriodicityReq;
+      if(this->beaconState == RADIOLIB_LORAWAN_BEACON_STATE_LOCKED) {
+        this->schedulePingSlots();
+      }
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_CHANNEL_REQ): {
+      float freq = (float)LoRaWANNode::ntoh<uint32_t>(&payload[0], 3)/10000.0;
+      uint8_t dr = payload[3] & 0x0F;
+
+      // frequency of 0 restores the default channel
+      if((freq == 0) || this->isFrequencyInBand(freq)) {
+        ans[0] |= RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_FREQ_ACK;
+      }
+
+      // data rate has to be defined for downlink
+      const LoRaWANChannelSpan_t* pingSpan = NULL;
+      if(this->band->beaconChannel.dataRates[dr] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED) {
+        pingSpan = &this->band->beaconChannel;
+      }
+      for(uint8_t span = 0; (span < this->band->numChannelSpans) && !pingSpan; span++) {
+        const LoRaWANChannelSpan_t* chSpan = &this->band->defaultChannels[span];
+        if((chSpan->direction != RADIOLIB_LORAWAN_CHANNEL_DIR_UPLINK) && (chSpan->dataRates[dr] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+          pingSpan = chSpan;
+        }
+      }
+      if(pingSpan) {
+        ans[0] |= RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_DATA_RATE_ACK;
+      }
+
+      if(ans[0] == (RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_FREQ_ACK | RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_DATA_RATE_ACK)) {
+        this->pingFrf = this->getFrf(freq);
+        this->pingDataRate = dr;
+        this->pingSpan = pingSpan;
+      }
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_CHANNEL_ANS, ans);
+    } break;
+
+    case(RADIOLIB_LORAWAN_MAC_CMD_BEACON_FREQ_REQ): {
+      // frequency of 0 restores the default channel
+      float freq = (float)LoRaWANNode::ntoh<uint32_t>(&payload[0], 3)/10000.0;
+      if((freq == 0) || this->isFrequencyInBand(freq)) {
+        ans[0] |= RADIOLIB_LORAWAN_BEACON_FREQ_ANS_FREQ_ACK;
+        this->beaconFrf = this->getFrf(freq);
+      }
+      this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_BEACON_FREQ_ANS, ans);
+    } break;
+
+    default:
+      // ResetConf is only informative, TxParamSetupReq and ForceRejoinReq are not supported
+      // BeaconTimingAns is deprecated, beacon timing is derived from DeviceTimeAns instead
+      RADIOLIB_DEBUG_PRINTLN("Skipped MAC command 0x%02x", cid);
+      break;
+  }
+}
+
+int16_t LoRaWANNode::pushMacCommand(uint8_t cid, uint8_t* payload) {
+  uint8_t len = LoRaWANMacSpecs[cid].lenUp;
+
+  // the latest answer to a sticky command replaces the previous one
+  if(LoRaWANMacSpecs[cid].sticky) {
+    size_t i = 0;
+    while(i < this->macQueueLen) {
+      size_t cmdLen = 1 + LoRaWANMacSpecs[this->macQueue[i]].lenUp;
+      if(this->macQueue[i] == cid) {
+        memmove(&this->macQueue[i], &this->macQueue[i + cmdLen], this->macQueueLen - i - cmdLen);
+        this->macQueueLen -= cmdLen;
+        continue;
+      }
+      i += cmdLen;
+    }
+  }
+
+  if(this->macQueueLen + 1 + len > RADIOLIB_LORAWAN_MAC_QUEUE_LEN) {
+    RADIOLIB_DEBUG_PRINTLN("MAC command queue full, dropped 0x%02x", cid);
+    return(RADIOLIB_ERR_COMMAND_QUEUE_FULL);
   }
 
-  // check the MIC
-  if(!verifyMIC(downlinkMsg, RADIOLIB_AES128_BLOCK_SIZE + downlinkMsgLen, this->sNwkSIntKey)) {
-    return(RADIOLIB_ERR_CRC_MISMATCH);
+  this->macQueue[this->macQueueLen] = cid;
+  if(len > 0) {
+    memcpy(&this->macQueue[this->macQueueLen + 1], payload, len);
   }
+  this->macQueueLen += 1 + len;
+  return(RADIOLIB_ERR_NONE);
+}
 
-  // check the address
-  uint32_t addr = LoRaWANNode::ntoh<uint32_t>(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_DEV_ADDR_POS]);
-  if(addr != this->devAddr) {
-    RADIOLIB_DEBUG_PRINTLN("Device address mismatch, expected 0x%08X, got 0x%08X", this->devAddr, addr);
-    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
+void LoRaWANNode::clearMacCommands(bool sticky) {
+  size_t i = 0;
+  while(i < this->macQueueLen) {
+    size_t cmdLen = 1 + LoRaWANMacSpecs[this->macQueue[i]].lenUp;
+    if(LoRaWANMacSpecs[this->macQueue[i]].sticky == sticky) {
+      memmove(&this->macQueue[i], &this->macQueue[i + cmdLen], this->macQueueLen - i - cmdLen);
+      this->macQueueLen -= cmdLen;
+      continue;
+    }
+    i += cmdLen;
+  }
+}
+
+bool LoRaWANNode::isFrequencyInBand(float freq) {
+  // bands with duty cycle limits cover all usable frequencies by the sub-bands
+  if(this->band->numSubBands > 0) {
+    return(this->findSubBand(freq) >= 0);
   }
 
-  // TODO cache the ADR bit?
-  // TODO cache and check fcnt?
-  uint16_t fcnt = LoRaWANNode::ntoh<uint16_t>(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FCNT_POS]);
+  // otherwise it has to be between the lowest and the highest default channel
+  float freqMin = this->band->backupChannel.freqStart;
+  float freqMax = freqMin;
+  for(uint8_t span = 0; span < this->band->numChannelSpans; span++) {
+    const LoRaWANChannelSpan_t* chSpan = &this->band->defaultChannels[span];
+    float spanEnd = chSpan->freqStart + chSpan->freqStep*(float)(chSpan->numChannels - 1);
+    if(chSpan->freqStart < freqMin) {
+      freqMin = chSpan->freqStart;
+    }
+    if(spanEnd > freqMax) {
+      freqMax = spanEnd;
+    }
+  }
+  return((freq >= freqMin) && (freq <= freqMax));
+}
 
-  // check fopts len
-  uint8_t foptsLen = downlinkMsg[RADIOLIB_LORAWAN_FHDR_FCTRL_POS] & RADIOLIB_LORAWAN_FHDR_FOPTS_LEN_MASK;
-  if(foptsLen > 0) {
-    // there are some Fopts, decrypt them
-    *len = foptsLen;
+uint8_t LoRaWANNode::processLinkAdrReq(uint8_t* reqs, uint8_t numReqs) {
+  // build the new channel mask from all requests in the block
+  uint16_t mask[sizeof(this->availableChannelsMask) / sizeof(this->availableChannelsMask[0])];
+  memcpy(mask, this->availableChannelsMask, sizeof(mask));
+  uint8_t numChannels = this->getNumChannels();
+  bool chMaskAck = true;
+  for(uint8_t i = 0; i < numReqs; i++) {
+    uint8_t* req = &reqs[i*(1 + LoRaWANMacSpecs[RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ].lenDn) + 1];
+    uint16_t chMask = LoRaWANNode::ntoh<uint16_t>(&req[1]);
+    uint8_t chMaskCntl = (req[3] >> 4) & 0x07;
+    if(chMaskCntl == 6) {
+      // all channels enabled, on bands with more than 16 channels the mask applies to the last bank
+      for(uint8_t chan = 0; chan < numChannels; chan++) {
+        mask[chan / 16] |= (1 << (chan % 16));
+      }
+      if(numChannels > 16) {
+        mask[4] = chMask;
+      }
 
-    // according to the specification, the last two arguments should be 0x00 and false,
-    // but that will fail even for LoRaWAN 1.1.0 server
-    processAES(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], foptsLen, this->nwkSEncKey, data, fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK, 0x01, true);
+    } else if((chMaskCntl == 7) && (numChannels > 16)) {
+      // all channels disabled except the last bank
+      memset(mask, 0x00, sizeof(mask));
+      mask[4] = chMask;
+
+    } else if(chMaskCntl*16 < numChannels) {
+      // mask of a single bank
+      mask[chMaskCntl] = chMask;
+
+    } else {
+      chMaskAck = false;
+
+    }
+  }
+
+  // all enabled channels must be defined, and at least one must be enabled
+  bool anyEnabled = false;
+  for(uint8_t chan = 0; chan < 16*sizeof(mask) / sizeof(mask[0]); chan++) {
+    if(mask[chan / 16] & (1 << (chan % 16))) {
+      float freq = 0;
+      if(this->getChannel(chan, &freq)) {
+        anyEnabled = true;
+      } else {
+        chMaskAck = false;
+      }
+    }
+  }
+  chMaskAck &= anyEnabled;
+
+  // data rate, output power and number of transmissions are taken from the last request
+  uint8_t* req = &reqs[(numReqs - 1)*(1 + LoRaWANMacSpecs[RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ].lenDn) + 1];
+  uint8_t dr = req[0] >> 4;
+  uint8_t txPower = req[0] & 0x0F;
+  uint8_t nbTrans = req[3] & 0x0F;
+  if(dr == RADIOLIB_LORAWAN_LINK_ADR_KEEP) {
+    dr = this->dataRate;
+  }
+  if(txPower == RADIOLIB_LORAWAN_LINK_ADR_KEEP) {
+    txPower = this->txPowerStep;
+  }
+  bool drAck = this->isDataRateSupported(dr, mask);
+  bool txPowerAck = (txPower <= this->band->powerNumSteps);
+
+  uint8_t status = 0;
+  if(chMaskAck) {
+    status |= RADIOLIB_LORAWAN_LINK_ADR_ANS_CH_MASK_ACK;
+  }
+  if(drAck) {
+    status |= RADIOLIB_LORAWAN_LINK_ADR_ANS_DATA_RATE_ACK;
+  }
+  if(txPowerAck) {
+    status |= RADIOLIB_LORAWAN_LINK_ADR_ANS_POWER_ACK;
+  }
+  RADIOLIB_DEBUG_PRINTLN("LinkADRReq DR%d power %d mask %04x, status 0x%02x", dr, txPower, mask[0], status);
+
+  // the request is applied only if all of it is acceptable
+  if(!(chMaskAck && drAck && txPowerAck)) {
+    return(status);
+  }
+
+  memcpy(this->availableChannelsMask, mask, sizeof(mask));
+  this->nbTrans = (nbTrans == 0) ? 1 : nbTrans;
+  this->txPowerStep = txPower;
+  this->phyLayer->setOutputPower(this->band->powerMax + RADIOLIB_LORAWAN_POWER_STEP_SIZE_DBM*this->txPowerStep);
+  this->configureDataRate(dr);
+  return(status);
+}
+
+int16_t LoRaWANNode::adrBackoff() {
+  // first try the maximum output power
+  if(this->txPowerStep > 0) {
+    RADIOLIB_DEBUG_PRINTLN("ADR backoff: maximum output power");
+    this->txPowerStep = 0;
+    return(this->phyLayer->setOutputPower(this->band->powerMax));
+  }
+
+  // then go to lower data rate
+  for(int8_t dr = (int8_t)this->dataRate - 1; dr >= 0; dr--) {
+    if(this->isDataRateSupported(dr, this->availableChannelsMask)) {
+      RADIOLIB_DEBUG_PRINTLN("ADR backoff: DR%d", dr);
+      return(this->configureDataRate(dr));
+    }
+  }
+
+  // and finally, enable all default channels
+  this->resetChannelMask();
+  this->nbTrans = 1;
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::configureDataRate(uint8_t dr) {
+  // keep the current channel if possible, otherwise use the first enabled one that supports the data rate
+  uint8_t numChannels = this->getNumChannels();
+  uint8_t chan = this->chIndex;
+  for(uint8_t i = 0; i <= numChannels; i++) {
+    float freq = 0;
+    const LoRaWANChannelSpan_t* span = this->getChannel(chan, &freq);
+    if(span && (this->availableChannelsMask[chan / 16] & (1 << (chan % 16))) && (span->dataRates[dr] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+      return(this->configureChannel(chan, dr));
+    }
+    chan = i;
+  }
+
+  return(RADIOLIB_ERR_INVALID_CHANNEL);
+}
+
+void LoRaWANNode::setADR(bool enable) {
+  this->adrEnabled = enable;
+  this->adrAckCnt = 0;
+}
+
+uint8_t LoRaWANNode::getDataRate() {
+  return(this->dataRate);
+}
+
+float LoRaWANNode::getAverageSNR() {
+  float sum = 0;
+  for(uint8_t i = 0; i < this->historyLen; i++) {
+    sum += this->snrHistory[i];
+  }
+  return(this->historyLen ? sum / this->historyLen : 0);
+}
+
+float LoRaWANNode::getAverageRSSI() {
+  float sum = 0;
+  for(uint8_t i = 0; i < this->historyLen; i++) {
+    sum += this->rssiHistory[i];
+  }
+  return(this->historyLen ? sum / this->historyLen : 0);
+}
+
+float LoRaWANNode::getLinkMargin() {
+  if(this->historyLen == 0) {
+    return(0);
+  }
+
+  float snrMax = this->snrHistory[0];
+  for(uint8_t i = 1; i < this->historyLen; i++) {
+    if(this->snrHistory[i] > snrMax) {
+      snrMax = this->snrHistory[i];
+    }
+  }
+
+  // LoRa demodulation floor is -7.5 dB at SF7, and 2.5 dB lower for each spreading factor step
+  float freq = 0;
+  const LoRaWANChannelSpan_t* span = this->getChannel(this->chIndex, &freq);
+  if(!span || (span->dataRates[this->dataRate] == RADIOLIB_LORAWAN_DATA_RATE_UNUSED) || (span->dataRates[this->dataRate] & RADIOLIB_LORAWAN_DATA_RATE_FSK_50_K)) {
+    return(snrMax);
+  }
+  uint8_t sf = ((span->dataRates[this->dataRate] & 0x70) >> 4) + 6;
+  return(snrMax + 7.5 + 2.5*(float)(sf - 7));
+}
+
+void LoRaWANNode::setDutyCycle(bool enable) {
+  this->dutyCycleEnabled = enable;
+}
+
+uint32_t LoRaWANNode::timeUntilUplink() {
+  // the transaction in progress has to finish first, which is after the end of RX2 at the latest
+  Module* mod = this->phyLayer->getMod();
+  uint32_t wait = 0;
+  if(this->state != RADIOLIB_LORAWAN_STATE_IDLE) {
+    uint32_t rxDelay = this->joining ? RADIOLIB_LORAWAN_JOIN_ACCEPT_DELAY_2_MS : this->rxDelays[1];
+    uint32_t end = this->txStart + this->txDuration + rxDelay + this->phyLayer->getTimeOnAir(0)/1000 + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS;
+    if(this->state == RADIOLIB_LORAWAN_STATE_TX_WAIT) {
+      // retransmission is still to be sent, and its Rx windows after it
+      end = this->retransmitAt + this->txDuration + rxDelay + this->phyLayer->getTimeOnAir(0)/1000 + RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS;
+    }
+    int32_t remaining = (int32_t)(end - mod->hal->millis());
+    wait = (remaining > 0) ? remaining : 1;
+  }
+
+  // then the duty cycle limit
+  uint32_t dutyCycleWait = this->dutyCycleWaitTime();
+  return((dutyCycleWait > wait) ? dutyCycleWait : wait);
+}
+
+LoRaWANUplinkResult_t LoRaWANNode::getUplinkResult() {
+  return(this->uplinkResult);
+}
+
+int16_t LoRaWANNode::sendMacCommandReq(uint8_t cid) {
+  // only some of the commands are requested by the end device
+  if(cid == RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_REQ) {
+    this->linkCheckValid = false;
+  } else if(cid == RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_REQ) {
+    this->deviceTimeValid = false;
+  } else {
+    return(RADIOLIB_ERR_INVALID_CID);
+  }
+  return(this->pushMacCommand(cid, NULL));
+}
+
+int16_t LoRaWANNode::getMacLinkCheckAns(uint8_t* margin, uint8_t* gwCnt) {
+  if(!this->linkCheckValid) {
+    return(RADIOLIB_ERR_NO_MAC_ANSWER);
+  }
+  *margin = this->linkCheckMargin;
+  *gwCnt = this->linkCheckGwCnt;
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::getMacDeviceTimeAns(uint32_t* gpsEpoch, uint8_t* fraction) {
+  if(!this->deviceTimeValid) {
+    return(RADIOLIB_ERR_NO_MAC_ANSWER);
+  }
+  *gpsEpoch = this->deviceTimeGpsEpoch;
+  *fraction = this->deviceTimeFraction;
+  return(RADIOLIB_ERR_NONE);
+}
+
+void LoRaWANNode::setDeviceStatus(uint8_t battLevel) {
+  this->battLevel = battLevel;
+}
 
-    #if !defined(RADIOLIB_STATIC_ONLY)
-      delete[] downlinkMsg;
-    #endif
+int16_t LoRaWANNode::setClass(uint8_t cls) {
+  // class B relies on LoRa beacons
+  if((cls > RADIOLIB_LORAWAN_CLASS_C) || ((cls == RADIOLIB_LORAWAN_CLASS_B) && this->FSK)) {
+    return(RADIOLIB_ERR_UNSUPPORTED);
+  }
+  if(cls == this->devClass) {
     return(RADIOLIB_ERR_NONE);
   }
+  this->devClass = cls;
 
-  // no fopts, just payload
-  // TODO implement decoding piggybacked Fopts?
-  *len = downlinkMsgLen;
-  processAES(&downlinkMsg[RADIOLIB_LORAWAN_FHDR_FOPTS_POS], downlinkMsgLen, this->appSKey, data, fcnt, RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK, 0x00, true);
-  
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    delete[] downlinkMsg;
-  #endif
+  // class C reception is started by the next poll()
+  if(cls != RADIOLIB_LORAWAN_CLASS_C) {
+    this->stopContinuousRx();
+  }
 
-  return(state);
+  // class B windows are opened by poll() as well
+  if(cls == RADIOLIB_LORAWAN_CLASS_B) {
+    this->startBeaconAcquisition();
+  } else {
+    this->stopClassBRx();
+    this->beaconState = RADIOLIB_LORAWAN_BEACON_STATE_NONE;
+  }
+  return(RADIOLIB_ERR_NONE);
+}
+
+int16_t LoRaWANNode::setPingSlotPeriodicity(uint8_t periodicity) {
+  if(periodicity > RADIOLIB_LORAWAN_PING_PERIODICITY_MAX) {
+    return(RADIOLIB_ERR_INVALID_PING_PERIODICITY);
+  }
+  this->pingPeriodicityReq = periodicity;
+  return(this->pushMacCommand(RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_INFO_REQ, &periodicity));
+}
+
+int16_t LoRaWANNode::getBeacon(uint32_t* gpsTime, uint8_t* gwSpecific) {
+  if(!this->beaconValid) {
+    return(RADIOLIB_ERR_NO_BEACON);
+  }
+  *gpsTime = this->beaconLastTime;
+  if(gwSpecific) {
+    memcpy(gwSpecific, this->beaconGwSpecific, RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN);
+  }
+  return(RADIOLIB_ERR_NONE);
+}
+
+size_t LoRaWANNode::buildBeacon(const LoRaWANBand_t* band, uint32_t gpsTime, uint8_t* gwSpecific, uint8_t* buff) {
+  // the first part is common for the whole network
+  uint8_t rfu1 = band->beaconRfuLen[0];
+  uint8_t rfu2 = band->beaconRfuLen[1];
+  memset(buff, 0x00, LoRaWANNode::getBeaconLen(band));
+  LoRaWANNode::hton<uint32_t>(&buff[rfu1], gpsTime);
+  size_t pos = rfu1 + RADIOLIB_LORAWAN_BEACON_TIME_LEN;
+  LoRaWANNode::hton<uint16_t>(&buff[pos], RadioLibLoRaWANBeaconCRC::checksum(buff, pos));
+  pos += RADIOLIB_LORAWAN_BEACON_CRC_LEN;
+
+  // the second part is specific to the gateway
+  size_t gwPos = pos;
+  if(gwSpecific) {
+    memcpy(&buff[pos], gwSpecific, RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN);
+  }
+  pos += RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN + rfu2;
+  LoRaWANNode::hton<uint16_t>(&buff[pos], RadioLibLoRaWANBeaconCRC::checksum(&buff[gwPos], pos - gwPos));
+  return(pos + RADIOLIB_LORAWAN_BEACON_CRC_LEN);
+}
+
+uint8_t LoRaWANNode::getBeaconLen(const LoRaWANBand_t* band) {
+  return(band->beaconRfuLen[0] + RADIOLIB_LORAWAN_BEACON_TIME_LEN + RADIOLIB_LORAWAN_BEACON_CRC_LEN + RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN + band->beaconRfuLen[1] + RADIOLIB_LORAWAN_BEACON_CRC_LEN);
+}
+
+uint32_t LoRaWANNode::dutyCycleWaitTime() {
+  if(this->FSK) {
+    return(this->subBandWaitTime(this->findSubBand(this->band->fskFreq)));
+  }
+
+  // find the first channel that becomes available
+  uint32_t wait = 0xFFFFFFFF;
+  uint8_t numChannels = this->getNumChannels();
+  for(uint8_t chan = 0; chan < numChannels; chan++) {
+    float freq = 0;
+    const LoRaWANChannelSpan_t* span = this->getChannel(chan, &freq);
+    if(span && (this->availableChannelsMask[chan / 16] & (1 << (chan % 16))) && (span->dataRates[this->dataRate] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+      uint32_t chanWait = this->subBandWaitTime(this->findSubBand(freq));
+      if(chanWait < wait) {
+        wait = chanWait;
+      }
+    }
+  }
+
+  // no usable channel at all, that will be reported by the uplink
+  if(wait == 0xFFFFFFFF) {
+    wait = 0;
+  }
+  return(wait);
+}
+
+int8_t LoRaWANNode::findSubBand(float freq) {
+  for(uint8_t i = 0; i < this->band->numSubBands; i++) {
+    if((freq >= this->band->subBands[i].freqStart) && (freq <= this->band->subBands[i].freqEnd)) {
+      return(i);
+    }
+  }
+  return(-1);
+}
+
+uint32_t LoRaWANNode::subBandWaitTime(int8_t subBand) {
+  if(!this->dutyCycleEnabled) {
+    return(0);
+  }
+
+  // aggregated limit applies to all channels, even those without sub-band
+  // signed difference handles millis() overflow
+  Module* mod = this->phyLayer->getMod();
+  int32_t remaining = 0;
+  if(this->maxDutyCycle > 0) {
+    remaining = (int32_t)(this->aggregatedTxAllowed - mod->hal->millis());
+  }
+
+  if((subBand >= 0) && (this->subBandsBlocked & (1 << subBand))) {
+    int32_t subBandRemaining = (int32_t)(this->subBandTxAllowed[subBand] - mod->hal->millis());
+    if(subBandRemaining <= 0) {
+      this->subBandsBlocked &= ~(1 << subBand);
+    } else if(subBandRemaining > remaining) {
+      remaining = subBandRemaining;
+    }
+  }
+
+  return((remaining > 0) ? remaining : 0);
+}
+
+int16_t LoRaWANNode::selectChannel(bool join) {
+  // FSK has just a single channel
+  if(this->FSK) {
+    return((this->subBandWaitTime(this->findSubBand(this->band->fskFreq)) == 0) ? RADIOLIB_ERR_NONE : RADIOLIB_ERR_UPLINK_UNAVAILABLE);
+  }
+
+  // join requests may only use the default channels
+  uint8_t numChannels = this->getNumChannels();
+  if(join) {
+    numChannels = 0;
+    for(uint8_t span = 0; span < this->band->numChannelSpans; span++) {
+      if(this->band->defaultChannels[span].direction != RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK) {
+        numChannels += this->band->defaultChannels[span].numChannels;
+      }
+    }
+  }
+
+  // the channel is drawn from those that can be used right now
+  // first pass counts them, second one finds the drawn channel
+  uint8_t numUsable = 0;
+  int16_t pick = -1;
+  for(uint8_t pass = 0; pass < 2; pass++) {
+    for(uint8_t chan = 0; chan < numChannels; chan++) {
+      float freq = 0;
+      const LoRaWANChannelSpan_t* span = this->getChannel(chan, &freq);
+      if(!span || !(this->availableChannelsMask[chan / 16] & (1 << (chan % 16)))) {
+        continue;
+      }
+      if(!join && (span->dataRates[this->dataRate] == RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+        continue;
+      }
+      if(this->subBandWaitTime(this->findSubBand(freq)) > 0) {
+        continue;
+      }
+
+      if(pass == 0) {
+        numUsable++;
+      } else if(pick-- == 0) {
+        return(this->configureChannel(chan, join ? span->joinRequestDataRate : this->dataRate));
+      }
+    }
+
+    if(numUsable == 0) {
+      // all channels are blocked by the duty cycle limit, or there is no channel for the data rate at all
+      return((this->subBandsBlocked || this->maxDutyCycle) ? RADIOLIB_ERR_UPLINK_UNAVAILABLE : RADIOLIB_ERR_INVALID_CHANNEL);
+    }
+
+    pick = this->nextRandom() % numUsable;
+  }
+
+  return(RADIOLIB_ERR_INVALID_CHANNEL);
+}
+
+uint32_t LoRaWANNode::nextRandom() {
+  // xorshift generator, seeded from the radio
+  if(this->rngState == 0) {
+    Module* mod = this->phyLayer->getMod();
+    this->rngState = (uint32_t)this->phyLayer->random(0x7FFFFFFF) ^ mod->hal->micros();
+    if(this->rngState == 0) {
+      this->rngState = 1;
+    }
+  }
+  this->rngState ^= this->rngState << 13;
+  this->rngState ^= this->rngState >> 17;
+  this->rngState ^= this->rngState << 5;
+  return(this->rngState);
 }
 
-void LoRaWANNode::findDataRate(uint8_t dr, DataRate_t* datr, const LoRaWANChannelSpan_t* span) {
-  uint8_t dataRateBand = span->dataRates[dr];
-  this->dataRate = dr;
-  if(dr == RADIOLIB_LORAWAN_DATA_RATE_UNUSED) {
+uint8_t LoRaWANNode::findDataRate(uint8_t dr, DataRate_t* datr, const LoRaWANChannelSpan_t* span) {
+  uint8_t dataRateBand = RADIOLIB_LORAWAN_DATA_RATE_UNUSED;
+  if((dr >= RADIOLIB_LORAWAN_CHANNEL_NUM_DATARATES) || (span->dataRates[dr] == RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
     for(uint8_t i = 0; i < RADIOLIB_LORAWAN_CHANNEL_NUM_DATARATES; i++) {
       if(span->dataRates[i] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED) {
         dataRateBand = span->dataRates[i];
-        this->dataRate = i;
+        dr = i;
         break;
       }
     }
+  } else {
+    dataRateBand = span->dataRates[dr];
   }
 
   if(dataRateBand & RADIOLIB_LORAWAN_DATA_RATE_FSK_50_K) {
@@ -715,57 +2360,159 @@ void LoRaWANNode::findDataRate(uint8_t dr, DataRate_t* datr, const LoRaWANChanne
   
   }
 
+  return(dr);
 }
 
-int16_t LoRaWANNode::configureChannel(uint8_t chan, uint8_t dr) {
+uint8_t LoRaWANNode::getNumChannels() {
+  // downlink-only spans are not counted
+  uint8_t num = 0;
+  for(uint8_t span = 0; span < this->band->numChannelSpans; span++) {
+    if(this->band->defaultChannels[span].direction != RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK) {
+      num += this->band->defaultChannels[span].numChannels;
+    }
+  }
+
+  // CFList may add some frequencies after the default channels
+  if(this->band->cfListType == RADIOLIB_LORAWAN_CFLIST_TYPE_FREQUENCIES) {
+    num += sizeof(this->availableChannelsFreq) / sizeof(this->availableChannelsFreq[0]);
+  }
+  return(num);
+}
+
+const LoRaWANChannelSpan_t* LoRaWANNode::getChannel(uint8_t chan, float* freq, uint32_t* frf) {
   // find the span based on the channel ID
-  uint8_t span = 0;
-  uint8_t spanChannelId = 0;
-  bool found = false;
-  for(uint8_t chanCtr = 0; span < this->band->numChannelSpans; span++) {
-    for(; spanChannelId < this->band->defaultChannels[span].numChannels; spanChannelId++) {
-      if(chanCtr >= chan) {
-        found = true;
-        break;
+  uint8_t spanChannelId = chan;
+  for(uint8_t span = 0; span < this->band->numChannelSpans; span++) {
+    const LoRaWANChannelSpan_t* chSpan = &this->band->defaultChannels[span];
+    if(chSpan->direction == RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK) {
+      continue;
+    }
+    if(spanChannelId < chSpan->numChannels) {
+      if(freq) {
+        *freq = chSpan->freqStart + chSpan->freqStep * (float)spanChannelId;
       }
-      chanCtr++;
+      if(frf) {
+        *frf = this->getSpanFrf(chSpan, spanChannelId);
+      }
+      return(chSpan);
     }
-    if(found) {
-      break;
+    spanChannelId -= chSpan->numChannels;
+  }
+
+  // channels added by CFList share the data rates of the first span
+  if((this->band->cfListType == RADIOLIB_LORAWAN_CFLIST_TYPE_FREQUENCIES) && (spanChannelId < sizeof(this->availableChannelsFreq) / sizeof(this->availableChannelsFreq[0]))) {
+    if(this->availableChannelsFreq[spanChannelId] != 0) {
+      if(freq) {
+        *freq = this->availableChannelsFreq[spanChannelId];
+      }
+      if(frf) {
+        *frf = this->availableChannelsFrf[spanChannelId];
+      }
+      return(&this->band->defaultChannels[0]);
     }
   }
 
-  if(!found) {
+  return(NULL);
+}
+
+uint32_t LoRaWANNode::getFrf(float freq) {
+  return((uint32_t)((freq * 1000000.0) / this->phyLayer->getFreqStep() + 0.5));
+}
+
+void LoRaWANNode::buildSpanTables() {
+  // channel step is kept with some fractional bits, otherwise the rounding error would add up over the channels
+  for(uint8_t i = 0; i < RADIOLIB_LORAWAN_NUM_SPAN_TABLES; i++) {
+    const LoRaWANChannelSpan_t* span = &this->band->backupChannel;
+    if(i == RADIOLIB_LORAWAN_SPAN_TABLE_BEACON) {
+      span = &this->band->beaconChannel;
+    } else if(i != RADIOLIB_LORAWAN_SPAN_TABLE_BACKUP) {
+      span = &this->band->defaultChannels[i];
+    }
+    this->spanFrf[i] = this->getFrf(span->freqStart);
+    this->spanFrfStep[i] = (uint32_t)(((span->freqStep * 1000000.0) / this->phyLayer->getFreqStep()) * (float)((uint32_t)1 << RADIOLIB_LORAWAN_SPAN_TABLE_STEP_FRAC_BITS) + 0.5);
+  }
+}
+
+uint32_t LoRaWANNode::getSpanFrf(const LoRaWANChannelSpan_t* span, uint8_t chan) {
+  uint8_t i = span - this->band->defaultChannels;
+  if(span == &this->band->backupChannel) {
+    i = RADIOLIB_LORAWAN_SPAN_TABLE_BACKUP;
+  } else if(span == &this->band->beaconChannel) {
+    i = RADIOLIB_LORAWAN_SPAN_TABLE_BEACON;
+  }
+
+  // integer and fractional part of the step are multiplied separately, so that this does not overflow
+  uint32_t step = this->spanFrfStep[i];
+  uint32_t frac = (uint32_t)chan * (step & (((uint32_t)1 << RADIOLIB_LORAWAN_SPAN_TABLE_STEP_FRAC_BITS) - 1));
+  return(this->spanFrf[i] + (uint32_t)chan * (step >> RADIOLIB_LORAWAN_SPAN_TABLE_STEP_FRAC_BITS) + (frac >> RADIOLIB_LORAWAN_SPAN_TABLE_STEP_FRAC_BITS));
+}
+
+bool LoRaWANNode::isDataRateSupported(uint8_t dr, uint16_t* mask) {
+  if(dr >= RADIOLIB_LORAWAN_CHANNEL_NUM_DATARATES) {
+    return(false);
+  }
+
+  uint8_t numChannels = this->getNumChannels();
+  for(uint8_t chan = 0; chan < numChannels; chan++) {
+    float freq = 0;
+    const LoRaWANChannelSpan_t* span = this->getChannel(chan, &freq);
+    if(span && (mask[chan / 16] & (1 << (chan % 16))) && (span->dataRates[dr] != RADIOLIB_LORAWAN_DATA_RATE_UNUSED)) {
+      return(true);
+    }
+  }
+  return(false);
+}
+
+void LoRaWANNode::resetChannelMask() {
+  memset(this->availableChannelsMask, 0x00, sizeof(this->availableChannelsMask));
+  uint8_t numChannels = this->getNumChannels();
+  for(uint8_t chan = 0; chan < numChannels; chan++) {
+    float freq = 0;
+    if(this->getChannel(chan, &freq)) {
+      this->availableChannelsMask[chan / 16] |= (1 << (chan % 16));
+    }
+  }
+}
+
+int16_t LoRaWANNode::configureChannel(uint8_t chan, uint8_t dr) {
+  uint32_t frf = 0;
+  const LoRaWANChannelSpan_t* span = this->getChannel(chan, NULL, &frf);
+  if(!span) {
     return(RADIOLIB_ERR_INVALID_CHANNEL);
   }
 
   this->chIndex = chan;
 
   // set the frequency
-  float freq = this->band->defaultChannels[span].freqStart + this->band->defaultChannels[span].freqStep * (float)spanChannelId;
-  int state = this->phyLayer->setFrequency(freq);
+  int state = this->phyLayer->setFrequencyRaw(frf);
   RADIOLIB_ASSERT(state);
 
   // set the data rate
   DataRate_t datr;
-  findDataRate(dr, &datr, &this->band->defaultChannels[span]);
+  this->dataRate = findDataRate(dr, &datr, span);
   state = this->phyLayer->setDataRate(datr);
 
   return(state);
 }
 
-uint32_t LoRaWANNode::generateMIC(uint8_t* msg, size_t len, uint8_t* key) {
+void LoRaWANNode::expandSessionKeys() {
+  RadioLibAES128::initKey(&this->appSKeyCtx, this->appSKey);
+  RadioLibAES128::initKey(&this->fNwkSIntKeyCtx, this->fNwkSIntKey);
+  RadioLibAES128::initKey(&this->sNwkSIntKeyCtx, this->sNwkSIntKey);
+  RadioLibAES128::initKey(&this->nwkSEncKeyCtx, this->nwkSEncKey);
+}
+
+uint32_t LoRaWANNode::generateMIC(uint8_t* msg, size_t len, const RadioLibAES128Key_t* ctx) {
   if((msg == NULL) || (len == 0)) {
     return(0);
   }
 
-  RadioLibAES128Instance.init(key);
   uint8_t cmac[RADIOLIB_AES128_BLOCK_SIZE];
-  RadioLibAES128Instance.generateCMAC(msg, len, cmac);
+  RadioLibAES128::generateCMAC(ctx, msg, len, cmac);
   return(((uint32_t)cmac[0]) | ((uint32_t)cmac[1] << 8) | ((uint32_t)cmac[2] << 16) | ((uint32_t)cmac[3]) << 24);
 }
 
-bool LoRaWANNode::verifyMIC(uint8_t* msg, size_t len, uint8_t* key) {
+bool LoRaWANNode::verifyMIC(uint8_t* msg, size_t len, const RadioLibAES128Key_t* ctx) {
   if((msg == NULL) || (len < sizeof(uint32_t))) {
     return(0);
   }
@@ -774,7 +2521,7 @@ bool LoRaWANNode::verifyMIC(uint8_t* msg, size_t len, uint8_t* key) {
   uint32_t micReceived = LoRaWANNode::ntoh<uint32_t>(&msg[len - sizeof(uint32_t)]);
 
   // calculate the expected value and compare
-  uint32_t micCalculated = generateMIC(msg, len - sizeof(uint32_t), key);
+  uint32_t micCalculated = generateMIC(msg, len - sizeof(uint32_t), ctx);
   if(micCalculated != micReceived) {
     return(false);
   }
@@ -784,8 +2531,7 @@ bool LoRaWANNode::verifyMIC(uint8_t* msg, size_t len, uint8_t* key) {
 
 int16_t LoRaWANNode::setPhyProperties() {
   // set the physical layer configuration
-  // TODO select channel span based on channel ID
-  // TODO select channel randomly
+  // start from the first channel, the actual one is selected for each uplink
   uint8_t channelId = 0;
   int16_t state = RADIOLIB_ERR_NONE;
   if(this->FSK) {
@@ -800,10 +2546,18 @@ int16_t LoRaWANNode::setPhyProperties() {
     RADIOLIB_ASSERT(state);
     state = this->phyLayer->setEncoding(RADIOLIB_ENCODING_WHITENING);
   } else {
+    // the first frequency is set the slow way, so that the radio can check it and calibrate for the band
+    state = this->phyLayer->setFrequency(this->band->defaultChannels[0].freqStart);
+    RADIOLIB_ASSERT(state);
     state = this->configureChannel(channelId, this->band->defaultChannels[0].joinRequestDataRate);
   }
   RADIOLIB_ASSERT(state);
 
+  // start from the defaults, ADR will adjust them later
+  this->txPowerStep = 0;
+  this->nbTrans = 1;
+  this->adrAckCnt = 0;
+  this->resetChannelMask();
   state = this->phyLayer->setOutputPower(this->band->powerMax);
   RADIOLIB_ASSERT(state);
 
@@ -831,111 +2585,21 @@ int16_t LoRaWANNode::setPhyProperties() {
   return(state);
 }
 
-int16_t LoRaWANNode::sendMacCommand(uint8_t cid, uint8_t* payload, size_t payloadLen, uint8_t* reply, size_t replyLen) {
-  // build the command
-  size_t macReqLen = 1 + payloadLen;
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    uint8_t* macReqBuff = new uint8_t[macReqLen];
-  #else
-    uint8_t macReqBuff[RADIOLIB_STATIC_ARRAY_SIZE];
-  #endif
-  macReqBuff[0] = cid;
-  memcpy(&macReqBuff[1], payload, payloadLen);
-
-  // uplink it
-  int16_t state = this->uplink(macReqBuff, macReqLen, RADIOLIB_LORAWAN_FPORT_MAC_COMMAND);
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    delete[] macReqBuff;
-  #endif
-  RADIOLIB_ASSERT(state);
-
-  // build the reply buffer
-  size_t macRplLen = 1 + replyLen;
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    uint8_t* macRplBuff = new uint8_t[this->band->payloadLenMax[this->dataRate]];
-  #else
-    uint8_t macRplBuff[RADIOLIB_STATIC_ARRAY_SIZE];
-  #endif
-
-  // wait for reply from the server
-  size_t rxRplLen = 0;
-  state = this->downlink(macRplBuff, &rxRplLen);
-  if(state != RADIOLIB_ERR_NONE) {
-    #if !defined(RADIOLIB_STATIC_ONLY)
-      delete[] macRplBuff;
-    #endif
-    return(state);
-  }
-
-  //Module::hexdump(macRplBuff, rxRplLen);
-
-  // check the length - it may be longer than expected
-  // if the server decided to append more MAC commands, but never shorter
-  // TODO how to handle the additional command(s)?
-  if(rxRplLen < macRplLen) {
-    #if !defined(RADIOLIB_STATIC_ONLY)
-      delete[] macRplBuff;
-    #endif
-    return(RADIOLIB_ERR_DOWNLINK_MALFORMED);
-  }
-
-  // check the CID
-  if(macRplBuff[0] != cid) {
-    #if !defined(RADIOLIB_STATIC_ONLY)
-      delete[] macRplBuff;
-    #endif
-    return(RADIOLIB_ERR_INVALID_CID);
-  }
-
-  // copy the data
-  memcpy(reply, &macRplBuff[1], replyLen);
-  #if !defined(RADIOLIB_STATIC_ONLY)
-    delete[] macRplBuff;
-  #endif
-
-  return(state);
-}
-
-void LoRaWANNode::processAES(uint8_t* in, size_t len, uint8_t* key, uint8_t* out, uint32_t fcnt, uint8_t dir, uint8_t ctrId, bool counter) {
-  // figure out how many encryption blocks are there
-  size_t numBlocks = len/RADIOLIB_AES128_BLOCK_SIZE;
-  if(len % RADIOLIB_AES128_BLOCK_SIZE) {
-    numBlocks++;
-  }
-
-  // generate the encryption blocks
-  uint8_t encBuffer[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
+void LoRaWANNode::processAES(uint8_t* in, size_t len, const RadioLibAES128Key_t* ctx, uint8_t* out, uint32_t fcnt, uint8_t dir, uint8_t ctrId, bool counter) {
+  // build the initial counter block
   uint8_t encBlock[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
   encBlock[RADIOLIB_LORAWAN_BLOCK_MAGIC_POS] = RADIOLIB_LORAWAN_ENC_BLOCK_MAGIC;
   encBlock[RADIOLIB_LORAWAN_ENC_BLOCK_COUNTER_ID_POS] = ctrId;
   encBlock[RADIOLIB_LORAWAN_BLOCK_DIR_POS] = dir;
   LoRaWANNode::hton<uint32_t>(&encBlock[RADIOLIB_LORAWAN_BLOCK_DEV_ADDR_POS], this->devAddr);
   LoRaWANNode::hton<uint32_t>(&encBlock[RADIOLIB_LORAWAN_BLOCK_FCNT_POS], fcnt);
-
-  //Module::hexdump(uplinkMsg, uplinkMsgLen);
+  if(counter) {
+    encBlock[RADIOLIB_LORAWAN_ENC_BLOCK_COUNTER_POS] = 1;
+  }
 
   // now encrypt the input
   // on downlink frames, this has a decryption effect because server actually "decrypts" the plaintext
-  size_t remLen = len;
-  for(size_t i = 0; i < numBlocks; i++) {
-    if(counter) {
-      encBlock[RADIOLIB_LORAWAN_ENC_BLOCK_COUNTER_POS] = i + 1;
-    }
-
-    // encrypt the buffer
-    RadioLibAES128Instance.init(key);
-    RadioLibAES128Instance.encryptECB(encBlock, RADIOLIB_AES128_BLOCK_SIZE, encBuffer);
-
-    // now xor the buffer with the input
-    size_t xorLen = remLen;
-    if(xorLen > RADIOLIB_AES128_BLOCK_SIZE) {
-      xorLen = RADIOLIB_AES128_BLOCK_SIZE;
-    }
-    for(uint8_t j = 0; j < xorLen; j++) {
-      out[i*RADIOLIB_AES128_BLOCK_SIZE + j] = in[i*RADIOLIB_AES128_BLOCK_SIZE + j] ^ encBuffer[j];
-    }
-    remLen -= xorLen;
-  }
+  RadioLibAES128::encryptCTR(ctx, in, len, encBlock, out);
 }
 
 template<typename T>
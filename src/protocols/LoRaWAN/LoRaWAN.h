@@ -4,6 +4,8 @@
 #include "../../TypeDef.h"
 #include "../PhysicalLayer/PhysicalLayer.h"
 #include "../../utils/Cryptography.h"
+#include "../../utils/Journal.h"
+#include "../../utils/CRC.h"
 
 // preamble format
 #define RADIOLIB_LORAWAN_LORA_SYNC_WORD                         (0x34)
@@ -28,6 +30,7 @@
 #define RADIOLIB_LORAWAN_FCTRL_ADR_ACK_REQ                      (0x01 << 6) //  6     6     adaptive data rate ACK request
 #define RADIOLIB_LORAWAN_FCTRL_ACK                              (0x01 << 5) //  5     5     confirmed message acknowledge
 #define RADIOLIB_LORAWAN_FCTRL_FRAME_PENDING                    (0x01 << 4) //  4     4     downlink frame is pending
+#define RADIOLIB_LORAWAN_FCTRL_CLASS_B                          (0x01 << 4) //  4     4     uplink from class B device
 
 // port field
 #define RADIOLIB_LORAWAN_FPORT_MAC_COMMAND                      (0x00 << 0) //  7     0     payload contains MAC commands only
@@ -65,6 +68,12 @@
 #define RADIOLIB_LORAWAN_CFLIST_TYPE_MASK                       (1)
 #define RADIOLIB_LORAWAN_CHANNEL_NUM_DATARATES                  (16)
 
+// synthesizer value tables, one for each default channel span, backup and beacon channel
+#define RADIOLIB_LORAWAN_SPAN_TABLE_BACKUP                      (3)
+#define RADIOLIB_LORAWAN_SPAN_TABLE_BEACON                      (4)
+#define RADIOLIB_LORAWAN_NUM_SPAN_TABLES                        (5)
+#define RADIOLIB_LORAWAN_SPAN_TABLE_STEP_FRAC_BITS              (8)     // fractional bits of the channel step
+
 // recommended default settings
 #define RADIOLIB_LORAWAN_RECEIVE_DELAY_1_MS                     (1000)
 #define RADIOLIB_LORAWAN_RECEIVE_DELAY_2_MS                     ((RADIOLIB_LORAWAN_RECEIVE_DELAY_1_MS) + 1000)
@@ -79,6 +88,71 @@
 #define RADIOLIB_LORAWAN_RETRANSMIT_TIMEOUT_MAX_MS              (3000)
 #define RADIOLIB_LORAWAN_POWER_STEP_SIZE_DBM                    (-2)
 
+// adaptive data rate
+#define RADIOLIB_LORAWAN_LINK_HISTORY_LEN                       (8)     // number of downlinks kept for link margin estimation
+#define RADIOLIB_LORAWAN_LINK_ADR_ANS_CH_MASK_ACK               (0x01 << 0)
+#define RADIOLIB_LORAWAN_LINK_ADR_ANS_DATA_RATE_ACK             (0x01 << 1)
+#define RADIOLIB_LORAWAN_LINK_ADR_ANS_POWER_ACK                 (0x01 << 2)
+#define RADIOLIB_LORAWAN_LINK_ADR_KEEP                          (0x0F)  // data rate or power unchanged
+
+// duty cycle
+#define RADIOLIB_LORAWAN_MAX_SUB_BANDS                          (6)
+
+// device classes
+#define RADIOLIB_LORAWAN_CLASS_A                                (0x00)
+#define RADIOLIB_LORAWAN_CLASS_B                                (0x01)
+#define RADIOLIB_LORAWAN_CLASS_C                                (0x02)
+
+// MAC state machine states
+#define RADIOLIB_LORAWAN_STATE_IDLE                             (0x00)  // nothing in progress, uplink may be started
+#define RADIOLIB_LORAWAN_STATE_TX                               (0x01)  // uplink in progress
+#define RADIOLIB_LORAWAN_STATE_RX_WAIT                          (0x02)  // waiting for the start of RX1/RX2 window
+#define RADIOLIB_LORAWAN_STATE_RX_SCAN                          (0x03)  // Rx window open, scanning for preamble
+#define RADIOLIB_LORAWAN_STATE_RX                               (0x04)  // preamble detected, receiving downlink
+#define RADIOLIB_LORAWAN_STATE_TX_WAIT                          (0x05)  // next uplink of the procedure or retransmission is waiting for timeout or duty cycle limit
+
+// MAC state machine events, passed to the callback set by LoRaWANNode::onEvent
+#define RADIOLIB_LORAWAN_EVENT_TX_DONE                          (0x01)  // uplink transmitted, Rx delays start now
+#define RADIOLIB_LORAWAN_EVENT_RX1_OPEN                         (0x02)  // RX1 window opened
+#define RADIOLIB_LORAWAN_EVENT_RX2_OPEN                         (0x03)  // RX2 window opened
+#define RADIOLIB_LORAWAN_EVENT_DOWNLINK                         (0x04)  // valid downlink received (in Rx window, or any time in class C), can be read by LoRaWANNode::readDownlink
+#define RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK                      (0x05)  // both Rx windows passed without downlink
+#define RADIOLIB_LORAWAN_EVENT_JOINED                           (0x06)  // join procedure finished successfully
+#define RADIOLIB_LORAWAN_EVENT_ERROR                            (0x07)  // transaction failed, status code is returned by LoRaWANNode::poll
+#define RADIOLIB_LORAWAN_EVENT_BEACON                           (0x08)  // class B beacon received, can be read by LoRaWANNode::getBeacon
+#define RADIOLIB_LORAWAN_EVENT_BEACON_LOST                      (0x09)  // class B beacon not found or missed for too long, node reverted to class A
+
+// MAC state machine timing
+#define RADIOLIB_LORAWAN_RX_SCAN_GUARD_MS                       (500)
+#define RADIOLIB_LORAWAN_CAD_TIMEOUT_MS                         (3000)
+
+// class B timing
+#define RADIOLIB_LORAWAN_BEACON_PERIOD_MS                       (128000)
+#define RADIOLIB_LORAWAN_BEACON_PERIOD_S                        (128)
+#define RADIOLIB_LORAWAN_BEACON_RESERVED_MS                     (2120)  // start of the period reserved for the beacon, no ping slots there
+#define RADIOLIB_LORAWAN_PING_SLOT_LEN_MS                       (30)
+#define RADIOLIB_LORAWAN_PING_PERIODICITY_MAX                   (7)     // one ping slot per beacon period
+#define RADIOLIB_LORAWAN_BEACON_LESS_MAX_PERIODS                (56)    // ping slots are kept for 2 hours without beacon
+#define RADIOLIB_LORAWAN_BEACON_GUARD_MS                        (20)    // beacon window widening for each period since the last beacon
+#define RADIOLIB_LORAWAN_BEACON_ACQUIRE_GUARD_MS                (200)   // uncertainty of beacon timing derived from DeviceTimeAns
+
+// class B beacon layout
+#define RADIOLIB_LORAWAN_BEACON_MAX_LEN                         (23)
+#define RADIOLIB_LORAWAN_BEACON_TIME_LEN                        (4)
+#define RADIOLIB_LORAWAN_BEACON_CRC_LEN                         (2)
+#define RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN                 (7)
+
+// class B beacon tracking states
+#define RADIOLIB_LORAWAN_BEACON_STATE_NONE                      (0x00)  // class B not used
+#define RADIOLIB_LORAWAN_BEACON_STATE_ACQUIRE                   (0x01)  // searching for the first beacon
+#define RADIOLIB_LORAWAN_BEACON_STATE_LOCKED                    (0x02)  // beacon timing known, ping slots are open
+
+// class B reception, only used while the MAC state machine is idle
+#define RADIOLIB_LORAWAN_CLASS_B_RX_NONE                        (0x00)  // radio not used by class B
+#define RADIOLIB_LORAWAN_CLASS_B_RX_BEACON                      (0x01)  // beacon window open
+#define RADIOLIB_LORAWAN_CLASS_B_RX_PING_SCAN                   (0x02)  // ping slot open, scanning for preamble
+#define RADIOLIB_LORAWAN_CLASS_B_RX_PING                        (0x03)  // preamble detected in ping slot, receiving downlink
+
 // join request message layout
 #define RADIOLIB_LORAWAN_JOIN_REQUEST_LEN                       (23)
 #define RADIOLIB_LORAWAN_JOIN_REQUEST_JOIN_EUI_POS              (1)
@@ -123,6 +197,7 @@
 #define RADIOLIB_LORAWAN_FHDR_FPORT_POS(FOPTS)                  (RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS + 8 + (FOPTS))
 #define RADIOLIB_LORAWAN_FRAME_PAYLOAD_POS(FOPTS)               (RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS + 9 + (FOPTS))
 #define RADIOLIB_LORAWAN_FRAME_LEN(PAYLOAD, FOPTS)              (16 + 13 + (PAYLOAD) + (FOPTS))
+#define RADIOLIB_LORAWAN_FRAME_MAX_LEN                          (RADIOLIB_LORAWAN_FHDR_LEN_START_OFFS + 255)
 
 // payload encryption/MIC blocks common layout
 #define RADIOLIB_LORAWAN_BLOCK_MAGIC_POS                        (0)
@@ -138,6 +213,7 @@
 // payload MIC blocks layout
 #define RADIOLIB_LORAWAN_MIC_BLOCK_MAGIC                        (0x49)
 #define RADIOLIB_LORAWAN_MIC_BLOCK_LEN_POS                      (15)
+#define RADIOLIB_LORAWAN_MIC_CONF_FCNT_POS                      (1)
 #define RADIOLIB_LORAWAN_MIC_DATA_RATE_POS                      (3)
 #define RADIOLIB_LORAWAN_MIC_CH_INDEX_POS                       (4)
 
@@ -148,6 +224,7 @@
 #define RADIOLIB_LORAWAN_MAC_CMD_RESET_IND                      (0x01)
 #define RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_REQ                 (0x02)
 #define RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_ANS                   (0x03)
+#define RADIOLIB_LORAWAN_MAC_CMD_LINK_ADR_REQ                   (0x03)
 #define RADIOLIB_LORAWAN_MAC_CMD_DUTY_CYCLE_ANS                 (0x04)
 #define RADIOLIB_LORAWAN_MAC_CMD_RX_PARAM_SETUP_ANS             (0x05)
 #define RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_ANS                 (0x06)
@@ -159,6 +236,49 @@
 #define RADIOLIB_LORAWAN_MAC_CMD_ADR_PARAM_SETUP_ANS            (0x0C)
 #define RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_REQ                (0x0D)
 #define RADIOLIB_LORAWAN_MAC_CMD_REJOIN_PARAM_SETUP_ANS         (0x0F)
+#define RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_INFO_REQ             (0x10)
+#define RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_CHANNEL_ANS          (0x11)
+#define RADIOLIB_LORAWAN_MAC_CMD_BEACON_FREQ_ANS                (0x13)
+
+// MAC commands sent by the network server
+#define RADIOLIB_LORAWAN_MAC_CMD_RESET_CONF                     (0x01)
+#define RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_ANS                 (0x02)
+#define RADIOLIB_LORAWAN_MAC_CMD_DUTY_CYCLE_REQ                 (0x04)
+#define RADIOLIB_LORAWAN_MAC_CMD_RX_PARAM_SETUP_REQ             (0x05)
+#define RADIOLIB_LORAWAN_MAC_CMD_DEV_STATUS_REQ                 (0x06)
+#define RADIOLIB_LORAWAN_MAC_CMD_NEW_CHANNEL_REQ                (0x07)
+#define RADIOLIB_LORAWAN_MAC_CMD_RX_TIMING_SETUP_REQ            (0x08)
+#define RADIOLIB_LORAWAN_MAC_CMD_TX_PARAM_SETUP_REQ             (0x09)
+#define RADIOLIB_LORAWAN_MAC_CMD_DL_CHANNEL_REQ                 (0x0A)
+#define RADIOLIB_LORAWAN_MAC_CMD_REKEY_CONF                     (0x0B)
+#define RADIOLIB_LORAWAN_MAC_CMD_ADR_PARAM_SETUP_REQ            (0x0C)
+#define RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_ANS                (0x0D)
+#define RADIOLIB_LORAWAN_MAC_CMD_FORCE_REJOIN_REQ               (0x0E)
+#define RADIOLIB_LORAWAN_MAC_CMD_REJOIN_PARAM_SETUP_REQ         (0x0F)
+#define RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_INFO_ANS             (0x10)
+#define RADIOLIB_LORAWAN_MAC_CMD_PING_SLOT_CHANNEL_REQ          (0x11)
+#define RADIOLIB_LORAWAN_MAC_CMD_BEACON_TIMING_ANS              (0x12)
+#define RADIOLIB_LORAWAN_MAC_CMD_BEACON_FREQ_REQ                (0x13)
+
+// MAC command queue
+#define RADIOLIB_LORAWAN_MAC_QUEUE_LEN                          (15)    // answers are piggybacked in FOpts, which is at most 15 bytes long
+#define RADIOLIB_LORAWAN_MAC_LEN_NONE                           (0xFF)  // command is never sent in this direction
+
+// MAC command answer status bits
+#define RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_CHANNEL_ACK         (0x01 << 0)
+#define RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX2_DATA_RATE_ACK   (0x01 << 1)
+#define RADIOLIB_LORAWAN_RX_PARAM_SETUP_ANS_RX1_DR_OFFSET_ACK   (0x01 << 2)
+#define RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_FREQ_ACK               (0x01 << 0)
+#define RADIOLIB_LORAWAN_NEW_CHANNEL_ANS_DATA_RATE_ACK          (0x01 << 1)
+#define RADIOLIB_LORAWAN_DL_CHANNEL_ANS_FREQ_ACK                (0x01 << 0)
+#define RADIOLIB_LORAWAN_DL_CHANNEL_ANS_UPLINK_FREQ_EXISTS      (0x01 << 1)
+#define RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_FREQ_ACK         (0x01 << 0)
+#define RADIOLIB_LORAWAN_PING_SLOT_CHANNEL_ANS_DATA_RATE_ACK    (0x01 << 1)
+#define RADIOLIB_LORAWAN_BEACON_FREQ_ANS_FREQ_ACK               (0x01 << 0)
+#define RADIOLIB_LORAWAN_RX1_DR_OFFSET_MAX                      (5)
+#define RADIOLIB_LORAWAN_DEV_STATUS_BATTERY_UNKNOWN             (0xFF)
+#define RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MIN                  (-32)
+#define RADIOLIB_LORAWAN_DEV_STATUS_MARGIN_MAX                  (31)
 
 /*!
   \struct LoRaWANChannelSpan_t
@@ -185,9 +305,32 @@ struct LoRaWANChannelSpan_t {
   uint8_t dataRates[RADIOLIB_LORAWAN_CHANNEL_NUM_DATARATES];
 };
 
+/*!
+  \brief CRC-16 protecting both parts of class B beacon, transmitted little-endian.
+*/
+typedef RadioLibCRCDescriptor<16, RADIOLIB_CRC_CCITT_POLY, 0x0000, 0x0000, false, false> RadioLibLoRaWANBeaconCRC;
+
 // alias for unused channel span
 #define RADIOLIB_LORAWAN_CHANNEL_SPAN_NONE    { .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_NONE, .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED, .numChannels = 0, .freqStart = 0, .freqStep = 0, .dataRates = { 0 } }
 
+/*!
+  \struct LoRaWANSubBand_t
+  \brief Structure to save information about regulatory sub-bands, which share a single duty cycle limit.
+*/
+struct LoRaWANSubBand_t {
+  /*! \brief Lowest frequency of the sub-band */
+  float freqStart;
+
+  /*! \brief Highest frequency of the sub-band */
+  float freqEnd;
+
+  /*! \brief Inverse of the allowed duty cycle, e.g. 100 for 1 % */
+  uint16_t dutyCycle;
+};
+
+// alias for unused sub-band
+#define RADIOLIB_LORAWAN_SUB_BAND_NONE    { .freqStart = 0, .freqEnd = 0, .dutyCycle = 0 }
+
 /*!
   \struct LoRaWANBand_t
   \brief Structure to save information about LoRaWAN band
@@ -222,6 +365,18 @@ struct LoRaWANBand_t {
   
   /*! \brief Backup downlink (RX2) channel - just a single channel, but using the same structure for convenience */
   LoRaWANChannelSpan_t backupChannel;
+
+  /*! \brief Number of sub-bands with duty cycle limit in the band, 0 if there is no limit */
+  uint8_t numSubBands;
+
+  /*! \brief Sub-bands with duty cycle limit */
+  LoRaWANSubBand_t subBands[RADIOLIB_LORAWAN_MAX_SUB_BANDS];
+
+  /*! \brief Class B beacon channel, also used for ping slots by default. If there are more channels, the one used changes every beacon period */
+  LoRaWANChannelSpan_t beaconChannel;
+
+  /*! \brief Lengths of the reserved fields in the first and the second part of class B beacon */
+  uint8_t beaconRfuLen[2];
 };
 
 // supported bands
@@ -235,18 +390,54 @@ extern const LoRaWANBand_t AS923;
 extern const LoRaWANBand_t KR920;
 extern const LoRaWANBand_t IN865;
 
-struct LoRaWANMacCommand_t {
-  uint8_t cid;
-  size_t len;
-  uint8_t* payload;
+/*!
+  \struct LoRaWANMacSpec_t
+  \brief Structure to save information about a LoRaWAN MAC command.
+*/
+struct LoRaWANMacSpec_t {
+  /*! \brief Payload length of the command sent by the network server, RADIOLIB_LORAWAN_MAC_LEN_NONE if never sent */
+  uint8_t lenDn;
+
+  /*! \brief Payload length of the command sent by the end device, RADIOLIB_LORAWAN_MAC_LEN_NONE if never sent */
+  uint8_t lenUp;
+
+  /*! \brief Whether the answer has to be repeated in all uplinks until a downlink is received */
+  bool sticky;
+};
+
+/*!
+  \struct LoRaWANUplinkResult_t
+  \brief Outcome of the last uplink, including all of its retransmissions.
+*/
+struct LoRaWANUplinkResult_t {
+  /*! \brief Frame counter of the uplink, shared by all of its transmissions */
+  uint32_t fcnt;
+
+  /*! \brief Whether the uplink was sent as confirmed */
+  bool confirmed;
+
+  /*! \brief Whether the network server acknowledged the uplink (confirmed uplinks only) */
+  bool acked;
+
+  /*! \brief Number of retransmissions used */
+  uint8_t retries;
+
+  /*! \brief Total time-on-air of all transmissions in milliseconds */
+  uint32_t airtime;
 };
 
 /*!
   \class LoRaWANNode
-  \brief LoRaWAN-compatible node (class A device).
+  \brief LoRaWAN-compatible node (class A, B or C device).
 */
 class LoRaWANNode {
   public:
+    /*!
+      \brief Type of the callback function notified about MAC state machine events.
+      Called with the node that raised the event and one of RADIOLIB_LORAWAN_EVENT_* values.
+    */
+    typedef void (*EventCb_t)(LoRaWANNode* node, uint8_t event);
+
     /*! \brief Set to true to force the node to only use FSK channels. Set to false by default. */
     bool FSK;
 
@@ -257,6 +448,11 @@ class LoRaWANNode {
     */
     LoRaWANNode(PhysicalLayer* phy, const LoRaWANBand_t* band);
 
+    /*!
+      \brief Default destructor.
+    */
+    ~LoRaWANNode();
+
     /*!
       \brief Wipe internal persistent parameters.
       This will reset all counters and saved variables, so the device will have to rejoin the network.
@@ -281,6 +477,17 @@ class LoRaWANNode {
     */
     int16_t beginOTAA(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey, bool force = false);
 
+    /*!
+      \brief Start over-the-air activation without waiting for the join accept.
+      The rest of the procedure is handled by poll(), RADIOLIB_LORAWAN_EVENT_JOINED is raised once finished.
+      \param joinEUI 8-byte application identifier.
+      \param devEUI 8-byte device identifier.
+      \param nwkKey Pointer to the network AES-128 key. Must remain valid until the procedure finishes.
+      \param appKey Pointer to the application AES-128 key. Must remain valid until the procedure finishes.
+      \returns \ref status_codes
+    */
+    int16_t startJoin(uint64_t joinEUI, uint64_t devEUI, uint8_t* nwkKey, uint8_t* appKey);
+
     /*!
       \brief Join network by performing activation by personalization.
       In this procedure, all necessary configuration must be provided by the user.
@@ -298,27 +505,43 @@ class LoRaWANNode {
       \brief Send a message to the server.
       \param str Address of Arduino String that will be transmitted.
       \param port Port number to send the message to.
+      \param isConfirmed Whether the uplink must be acknowledged by the network server.
       \returns \ref status_codes
     */
-    int16_t uplink(String& str, uint8_t port);
+    int16_t uplink(String& str, uint8_t port, bool isConfirmed = false);
     #endif
 
     /*!
       \brief Send a message to the server.
       \param str C-string that will be transmitted.
       \param port Port number to send the message to.
+      \param isConfirmed Whether the uplink must be acknowledged by the network server.
       \returns \ref status_codes
     */
-    int16_t uplink(const char* str, uint8_t port);
+    int16_t uplink(const char* str, uint8_t port, bool isConfirmed = false);
 
     /*!
-      \brief Send a message to the server.
+      \brief Send a message to the server. Confirmed uplinks are retransmitted until acknowledged
+      or the number of transmissions set by the network server is used up, and this method only returns
+      once that is done. The downlink carrying the acknowledgement can then be read by readDownlink().
       \param data Data to send.
       \param len Length of the data.
       \param port Port number to send the message to.
+      \param isConfirmed Whether the uplink must be acknowledged by the network server.
       \returns \ref status_codes
     */
-    int16_t uplink(uint8_t* data, size_t len, uint8_t port);
+    int16_t uplink(uint8_t* data, size_t len, uint8_t port, bool isConfirmed = false);
+
+    /*!
+      \brief Start sending a message to the server without waiting for it to finish.
+      Transmission and the following Rx windows are handled by poll().
+      \param data Data to send.
+      \param len Length of the data.
+      \param port Port number to send the message to.
+      \param isConfirmed Whether the uplink must be acknowledged by the network server.
+      \returns \ref status_codes
+    */
+    int16_t startUplink(uint8_t* data, size_t len, uint8_t port, bool isConfirmed = false);
 
     #if defined(RADIOLIB_BUILD_ARDUINO)
     /*!
@@ -337,14 +560,166 @@ class LoRaWANNode {
     */
     int16_t downlink(uint8_t* data, size_t* len);
 
+    /*!
+      \brief Read downlink received by the MAC state machine, after RADIOLIB_LORAWAN_EVENT_DOWNLINK was raised.
+      \param data Buffer to save received data into.
+      \param len Pointer to variable that will be used to save the number of received bytes.
+      \returns \ref status_codes
+    */
+    int16_t readDownlink(uint8_t* data, size_t* len);
+
+    /*!
+      \brief Advance the MAC state machine. Never blocks, should be called periodically
+      (e.g. from the main loop) while an uplink or join procedure is in progress.
+      Events are timed from the radio interrupt pin and the HAL timestamps,
+      so a single loop can drive any number of nodes.
+      \returns \ref status_codes of the step, including failure of the current transaction.
+    */
+    int16_t poll();
+
+    /*!
+      \brief Set callback to be notified about MAC state machine events.
+      \param func Callback function, or NULL to disable notifications.
+    */
+    void onEvent(EventCb_t func);
+
+    /*!
+      \brief Enable or disable adaptive data rate. When enabled (default), the network server
+      controls data rate, output power and channel mask of the node, and the node falls back
+      to more robust settings when it stops receiving downlinks.
+      \param enable Whether to enable ADR.
+    */
+    void setADR(bool enable);
+
+    /*!
+      \brief Get the data rate currently used for uplinks.
+      \returns Data rate DR0 - DR15 (band-dependent!).
+    */
+    uint8_t getDataRate();
+
+    /*!
+      \brief Get average SNR of the last downlinks.
+      \returns Average SNR in dB, or 0 if no downlink was received yet.
+    */
+    float getAverageSNR();
+
+    /*!
+      \brief Get average RSSI of the last downlinks.
+      \returns Average RSSI in dBm, or 0 if no downlink was received yet.
+    */
+    float getAverageRSSI();
+
+    /*!
+      \brief Get link margin, i.e. the best SNR of the last downlinks above the demodulation floor
+      of the current data rate. This is the same estimate network servers use for ADR.
+      \returns Link margin in dB, or 0 if no downlink was received yet.
+    */
+    float getLinkMargin();
+
+    /*!
+      \brief Enable or disable duty cycle limits of the band. Enabled by default, since the limits
+      are set by regulations - disabling should only be done for testing.
+      \param enable Whether to enforce duty cycle limits.
+    */
+    void setDutyCycle(bool enable);
+
+    /*!
+      \brief Get time until the next uplink can be started. This accounts for both the transaction
+      in progress and duty cycle limits of all enabled channels. Starting an uplink sooner
+      will fail with RADIOLIB_ERR_UPLINK_UNAVAILABLE.
+      \returns Time in milliseconds, 0 if the uplink can be started right away.
+    */
+    uint32_t timeUntilUplink();
+
+    /*!
+      \brief Get the outcome of the last uplink. Only final once the uplink transaction is finished,
+      i.e. after RADIOLIB_LORAWAN_EVENT_DOWNLINK or RADIOLIB_LORAWAN_EVENT_NO_DOWNLINK was raised.
+      \returns Whether the uplink was acknowledged, number of retransmissions and total time-on-air.
+    */
+    LoRaWANUplinkResult_t getUplinkResult();
+
+    /*!
+      \brief Request information from the network server. The request is queued
+      and piggybacked on the next uplink, the answer arrives with the downlink after it.
+      \param cid ID of the MAC command, RADIOLIB_LORAWAN_MAC_CMD_LINK_CHECK_REQ or RADIOLIB_LORAWAN_MAC_CMD_DEVICE_TIME_REQ.
+      \returns \ref status_codes
+    */
+    int16_t sendMacCommandReq(uint8_t cid);
+
+    /*!
+      \brief Get the answer to the last LinkCheckReq.
+      \param margin Pointer to variable to save the link margin of the uplink in dB.
+      \param gwCnt Pointer to variable to save the number of gateways that received the uplink.
+      \returns \ref status_codes
+    */
+    int16_t getMacLinkCheckAns(uint8_t* margin, uint8_t* gwCnt);
+
+    /*!
+      \brief Get the answer to the last DeviceTimeReq.
+      \param gpsEpoch Pointer to variable to save the number of seconds since GPS epoch at the end of the uplink.
+      \param fraction Pointer to variable to save the fractional second, in 1/256 s steps.
+      \returns \ref status_codes
+    */
+    int16_t getMacDeviceTimeAns(uint32_t* gpsEpoch, uint8_t* fraction);
+
+    /*!
+      \brief Set battery level reported to the network server in answer to DevStatusReq.
+      \param battLevel 0 if powered by external source, 1 - 254 for battery level from empty to full,
+      255 if the level cannot be measured (default).
+    */
+    void setDeviceStatus(uint8_t battLevel);
+
+    /*!
+      \brief Set device class. Class C device keeps receiving on RX2 frequency and data rate whenever
+      it is not transmitting, including the RX2 window. Reception is paused for uplinks and resumed
+      by poll() afterwards, every downlink raises RADIOLIB_LORAWAN_EVENT_DOWNLINK.
+      Class B device first searches for the network beacon. If DeviceTimeAns was received,
+      only a short window around the next beacon is needed, otherwise the search may take more than one beacon period.
+      Once the beacon is found, RADIOLIB_LORAWAN_EVENT_BEACON is raised every beacon period,
+      and the node opens ping slots between uplinks. If the beacon is not found or missed for too long,
+      RADIOLIB_LORAWAN_EVENT_BEACON_LOST is raised and the node reverts to class A.
+      Class B windows are timed by poll(), so it has to be called at least every few milliseconds.
+      The node is always class A during join procedure, so this should be called after activation.
+      \param cls Device class, RADIOLIB_LORAWAN_CLASS_A (default), RADIOLIB_LORAWAN_CLASS_B or RADIOLIB_LORAWAN_CLASS_C.
+      \returns \ref status_codes
+    */
+    int16_t setClass(uint8_t cls);
+
+    /*!
+      \brief Request a different class B ping slot periodicity. The request is queued and piggybacked
+      on the next uplink, the new periodicity is used once the network server answers.
+      \param periodicity Ping slot every 2^periodicity seconds, 0 - 7. Default is 7, i.e. one slot per beacon period.
+      \returns \ref status_codes
+    */
+    int16_t setPingSlotPeriodicity(uint8_t periodicity);
+
+    /*!
+      \brief Get the contents of the last received class B beacon.
+      \param gpsTime Pointer to variable to save the number of seconds since GPS epoch at the start of the beacon.
+      \param gwSpecific Buffer to save the gateway-specific part of the beacon, RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN bytes.
+      Filled with zeros if the part was damaged. May be NULL if not needed.
+      \returns \ref status_codes
+    */
+    int16_t getBeacon(uint32_t* gpsTime, uint8_t* gwSpecific);
+
+    /*!
+      \brief Build class B beacon frame, e.g. to simulate the network beacon when testing class B devices.
+      The frame has to be transmitted with implicit header and without CRC,
+      on the beacon channel and data rate of the band, at the start of the beacon period.
+      \param band Pointer to the LoRaWAN band the beacon is for.
+      \param gpsTime Number of seconds since GPS epoch at the start of the beacon, should be a multiple of 128.
+      \param gwSpecific Gateway-specific part of the beacon, RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN bytes. May be NULL to leave it empty.
+      \param buff Buffer to save the frame into, at least RADIOLIB_LORAWAN_BEACON_MAX_LEN bytes long.
+      \returns Length of the beacon frame.
+    */
+    static size_t buildBeacon(const LoRaWANBand_t* band, uint32_t gpsTime, uint8_t* gwSpecific, uint8_t* buff);
+
 #if !defined(RADIOLIB_GODMODE)
   private:
 #endif
     PhysicalLayer* phyLayer = NULL;
     const LoRaWANBand_t* band = NULL;
 
-    LoRaWANMacCommand_t* command = NULL;
-
     // the following is either provided by the network server (OTAA)
     // or directly entered by the user (ABP)
     uint32_t devAddr = 0;
@@ -353,9 +728,22 @@ class LoRaWANNode {
     uint8_t sNwkSIntKey[RADIOLIB_AES128_KEY_SIZE] = { 0 };
     uint8_t nwkSEncKey[RADIOLIB_AES128_KEY_SIZE] = { 0 };
     uint8_t jSIntKey[RADIOLIB_AES128_KEY_SIZE] = { 0 };
+
+    // expanded session keys, so that the key schedule is not recalculated for every frame
+    // this costs sizeof(RadioLibAES128Key_t) per key (192 bytes), the join keys are only expanded while joining
+    RadioLibAES128Key_t appSKeyCtx;
+    RadioLibAES128Key_t fNwkSIntKeyCtx;
+    RadioLibAES128Key_t sNwkSIntKeyCtx;
+    RadioLibAES128Key_t nwkSEncKeyCtx;
     float availableChannelsFreq[5] = { 0 };
+    uint32_t availableChannelsFrf[5] = { 0 };
     uint16_t availableChannelsMask[6] = { 0 };
 
+    // synthesizer values of the first channel and the step between channels in each span of the band,
+    // calculated once, so that switching channels does not need any float math
+    uint32_t spanFrf[RADIOLIB_LORAWAN_NUM_SPAN_TABLES] = { 0 };
+    uint32_t spanFrfStep[RADIOLIB_LORAWAN_NUM_SPAN_TABLES] = { 0 };
+
     // LoRaWAN revision (1.0 vs 1.1)
     uint8_t rev = 0;
 
@@ -368,11 +756,243 @@ class LoRaWANNode {
     // timestamp to measure the RX1/2 delay (from uplink end)
     uint32_t rxDelayStart = 0;
 
+    // set while the transaction is being advanced, so that event callbacks do not advance it again
+    bool stepping = false;
+
     // delays between the uplink and RX1/2 windows
     uint32_t rxDelays[2] = { RADIOLIB_LORAWAN_RECEIVE_DELAY_1_MS, RADIOLIB_LORAWAN_RECEIVE_DELAY_2_MS };
 
-    // find the first usable data rate in a given channel span
-    void findDataRate(uint8_t dr, DataRate_t* datr, const LoRaWANChannelSpan_t* span);
+    // adaptive data rate
+    bool adrEnabled = true;
+
+    // number of uplinks since the last downlink, used for ADR backoff
+    uint16_t adrAckCnt = 0;
+    uint16_t adrAckLimit = RADIOLIB_LORAWAN_ADR_ACK_LIMIT;
+    uint16_t adrAckDelay = RADIOLIB_LORAWAN_ADR_ACK_DELAY;
+
+    // currently configured output power, as the number of steps below the band maximum
+    uint8_t txPowerStep = 0;
+
+    // number of transmissions of each uplink requested by the network server
+    uint8_t nbTrans = 1;
+
+    // SNR and RSSI of the last downlinks
+    float snrHistory[RADIOLIB_LORAWAN_LINK_HISTORY_LEN] = { 0 };
+    float rssiHistory[RADIOLIB_LORAWAN_LINK_HISTORY_LEN] = { 0 };
+    uint8_t historyLen = 0;
+    uint8_t historyPos = 0;
+
+    // journal of device counters in persistent storage
+    RadioLibJournal journal;
+
+    // last used uplink frame counter, and the highest value already saved in persistent storage
+    uint32_t fcntUp = 0;
+    uint32_t fcntUpReserved = 0;
+
+    // next expected downlink frame counters (network and application in LoRaWAN 1.1, only the first one in LoRaWAN 1.0)
+    uint32_t nFCntDown = 0;
+    uint32_t aFCntDown = 0;
+
+    // duty cycle limits
+    bool dutyCycleEnabled = true;
+
+    // time when each sub-band may be used again, only valid if the sub-band has its bit set in subBandsBlocked
+    uint32_t subBandTxAllowed[RADIOLIB_LORAWAN_MAX_SUB_BANDS] = { 0 };
+    uint8_t subBandsBlocked = 0;
+
+    // aggregated duty cycle limit requested by the network server as 1/2^maxDutyCycle, 0 for no limit
+    uint8_t maxDutyCycle = 0;
+    uint32_t aggregatedTxAllowed = 0;
+
+    // start and duration of the last uplink
+    uint32_t txStart = 0;
+    uint32_t txDuration = 0;
+
+    // RX1 data rate offset, RX2 synthesizer value and data rate (0 and RADIOLIB_LORAWAN_DATA_RATE_UNUSED for the band default)
+    uint8_t rx1DrOffset = 0;
+    uint32_t rx2Frf = 0;
+    uint8_t rx2DataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED;
+    const LoRaWANChannelSpan_t* rx2Span = NULL;
+
+    // state of the pseudo-random generator used for channel selection and retransmission timeout
+    uint32_t rngState = 0;
+
+    // the last uplink frame, kept for retransmissions
+    // the first 16 bytes are reserved for MIC calculation block
+    // without static-only, the buffer is allocated once for the longest frame
+    #if defined(RADIOLIB_STATIC_ONLY)
+    uint8_t uplinkBuff[RADIOLIB_LORAWAN_FRAME_MAX_LEN] = { 0 };
+    #else
+    uint8_t* uplinkBuff = NULL;
+    #endif
+    size_t uplinkLen = 0;
+    uint32_t uplinkMicF = 0;
+    LoRaWANUplinkResult_t uplinkResult = { 0, false, false, 0, 0 };
+
+    // time when the next retransmission may be sent
+    uint32_t retransmitAt = 0;
+
+    // confirmed downlink waiting to be acknowledged by the next uplink, and its frame counter
+    bool ackPending = false;
+    uint16_t ackFCnt = 0;
+
+    // MAC commands piggybacked on the next uplink, one after another in the same format as in FOpts
+    uint8_t macQueue[RADIOLIB_LORAWAN_MAC_QUEUE_LEN] = { 0 };
+    uint8_t macQueueLen = 0;
+
+    // battery level reported by DevStatusAns
+    uint8_t battLevel = RADIOLIB_LORAWAN_DEV_STATUS_BATTERY_UNKNOWN;
+
+    // answers to MAC commands requested by the user
+    bool linkCheckValid = false;
+    uint8_t linkCheckMargin = 0;
+    uint8_t linkCheckGwCnt = 0;
+    bool deviceTimeValid = false;
+    uint32_t deviceTimeGpsEpoch = 0;
+    uint8_t deviceTimeFraction = 0;
+
+    // local timestamp the DeviceTimeAns refers to, i.e. the end of the uplink that carried the request
+    uint32_t deviceTimeAt = 0;
+
+    // LoRaWAN revision in the RekeyConf reply, RADIOLIB_LORAWAN_MAC_LEN_NONE until it is received
+    uint8_t rekeyConfRev = RADIOLIB_LORAWAN_MAC_LEN_NONE;
+
+    // MAC state machine
+    uint8_t state = RADIOLIB_LORAWAN_STATE_IDLE;
+    uint8_t devClass = RADIOLIB_LORAWAN_CLASS_A;
+
+    // class C continuous reception is running
+    bool rxContinuous = false;
+    EventCb_t eventCb = NULL;
+
+    // class B beacon tracking and reception in progress
+    uint8_t beaconState = RADIOLIB_LORAWAN_BEACON_STATE_NONE;
+    uint8_t classBRx = RADIOLIB_LORAWAN_CLASS_B_RX_NONE;
+
+    // local timestamp and GPS time of the next beacon, the current beacon period started one period earlier
+    uint32_t beaconAt = 0;
+    uint32_t beaconTime = 0;
+
+    // beacon window extends this far around the expected beacon, the whole period (or more) when searching without device time
+    uint32_t beaconGuard = 0;
+    bool beaconSearch = false;
+    uint32_t beaconTimeOnAir = 0;
+    uint8_t beaconsMissed = 0;
+
+    // the last received beacon
+    bool beaconValid = false;
+    uint32_t beaconLastTime = 0;
+    uint8_t beaconGwSpecific[RADIOLIB_LORAWAN_BEACON_GW_SPECIFIC_LEN] = { 0 };
+
+    // synthesizer value of beacon frequency set by the network server, 0 for the band default
+    uint32_t beaconFrf = 0;
+
+    // ping slot periodicity in use and the one requested by the last PingSlotInfoReq
+    uint8_t pingPeriodicity = RADIOLIB_LORAWAN_PING_PERIODICITY_MAX;
+    uint8_t pingPeriodicityReq = RADIOLIB_LORAWAN_PING_PERIODICITY_MAX;
+
+    // ping slot synthesizer value and data rate set by the network server (0 and RADIOLIB_LORAWAN_DATA_RATE_UNUSED for the band default)
+    uint32_t pingFrf = 0;
+    uint8_t pingDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED;
+    const LoRaWANChannelSpan_t* pingSpan = NULL;
+
+    // pseudo-random offset of the ping slots in the current beacon period, and the next slot to open
+    uint16_t pingOffset = 0;
+    uint16_t pingSlot = 0;
+
+    // timestamp and timeout of the current state
+    uint32_t stateStart = 0;
+    uint32_t stateTimeout = 0;
+
+    // Rx window currently handled (0 for RX1, 1 for RX2), bit mask of windows opened so far
+    uint8_t rxWindow = 0;
+    uint8_t rxOpened = 0;
+    uint32_t windowStart = 0;
+
+    // result of the last finished transaction
+    int16_t result = RADIOLIB_ERR_NONE;
+
+    // join procedure in progress - either waiting for join accept or for RekeyConf (LoRaWAN 1.1)
+    bool joining = false;
+    bool rekeying = false;
+    uint64_t joinEUI = 0;
+    uint64_t devEUI = 0;
+    uint16_t devNonce = 0;
+    uint8_t* nwkKey = NULL;
+    uint8_t* appKey = NULL;
+
+    // the last received downlink, decrypted in place
+    // the first 16 bytes are reserved for MIC calculation block, allocated in the same way as uplinkBuff
+    #if defined(RADIOLIB_STATIC_ONLY)
+    uint8_t rxBuff[RADIOLIB_LORAWAN_FRAME_MAX_LEN] = { 0 };
+    #else
+    uint8_t* rxBuff = NULL;
+    #endif
+    size_t rxPayloadPos = 0;
+    size_t rxPayloadLen = 0;
+    bool rxPending = false;
+
+    // find the first usable data rate in a given channel span, returns the index of the found data rate
+    uint8_t findDataRate(uint8_t dr, DataRate_t* datr, const LoRaWANChannelSpan_t* span);
+
+    // get the total number of uplink channels, including those added by CFList
+    uint8_t getNumChannels();
+
+    // get the span and frequency of an uplink channel, returns NULL if the channel is not defined
+    // either the frequency in MHz or the synthesizer value may be NULL when not needed
+    const LoRaWANChannelSpan_t* getChannel(uint8_t chan, float* freq, uint32_t* frf = NULL);
+
+    // convert frequency in MHz to synthesizer value of the radio
+    uint32_t getFrf(float freq);
+
+    // fill the synthesizer value tables of the band channel spans
+    void buildSpanTables();
+
+    // get synthesizer value of a channel in one of the band spans
+    uint32_t getSpanFrf(const LoRaWANChannelSpan_t* span, uint8_t chan);
+
+    // check whether a data rate is supported by at least one channel enabled in the mask
+    bool isDataRateSupported(uint8_t dr, uint16_t* mask);
+
+    // enable all defined uplink channels
+    void resetChannelMask();
+
+    // handle all MAC commands received from the network server in FOpts or payload
+    void processMacCommands(uint8_t* cmds, size_t len);
+
+    // handle a single MAC command (or a block of LinkADRReq commands) and queue the answer
+    void execMacCommand(uint8_t* cmd, uint8_t numReqs);
+
+    // add command to the queue to be sent with the next uplink
+    int16_t pushMacCommand(uint8_t cid, uint8_t* payload);
+
+    // remove either sticky or non-sticky commands from the queue
+    void clearMacCommands(bool sticky);
+
+    // check whether a frequency can be used in the band
+    bool isFrequencyInBand(float freq);
+
+    // handle LinkADRReq block, returns LinkADRAns status
+    uint8_t processLinkAdrReq(uint8_t* reqs, uint8_t numReqs);
+
+    // step back to more robust settings after not receiving any downlink for too long
+    int16_t adrBackoff();
+
+    // switch to a data rate, changing to another enabled channel if the current one does not support it
+    int16_t configureDataRate(uint8_t dr);
+
+    // get index of the sub-band a frequency belongs to, -1 if there is no duty cycle limit for it
+    int8_t findSubBand(float freq);
+
+    // get time until a sub-band may be used again, 0 if it is available now
+    uint32_t subBandWaitTime(int8_t subBand);
+
+    // get time until at least one enabled channel may be used again
+    uint32_t dutyCycleWaitTime();
+
+    // pick a random enabled channel that supports the data rate and is not blocked by duty cycle limit
+    // only the default channels are used for join requests
+    int16_t selectChannel(bool join);
 
     /*!
       \brief Configure the radio to a given channel frequency and data rate.
@@ -382,21 +1002,101 @@ class LoRaWANNode {
     */
     int16_t configureChannel(uint8_t chan, uint8_t dr);
 
+    // expand all session keys into their AES contexts, must be called whenever the keys change
+    void expandSessionKeys();
+
     // method to generate message integrity code
-    uint32_t generateMIC(uint8_t* msg, size_t len, uint8_t* key);
+    uint32_t generateMIC(uint8_t* msg, size_t len, const RadioLibAES128Key_t* ctx);
 
     // method to verify message integrity code
     // it assumes that the MIC is the last 4 bytes of the message
-    bool verifyMIC(uint8_t* msg, size_t len, uint8_t* key);
+    bool verifyMIC(uint8_t* msg, size_t len, const RadioLibAES128Key_t* ctx);
 
     // configure the physical layer properties (frequency, sync word etc.)
     int16_t setPhyProperties();
 
-    // send a MAC command to the network server
-    int16_t sendMacCommand(uint8_t cid, uint8_t* payload, size_t payloadLen, uint8_t* reply, size_t replyLen);
+    // start transmitting a frame and switch the state machine to Tx
+    int16_t startTransaction(uint8_t* frame, size_t len);
+
+    // (re)transmit the frame in uplink buffer on the current channel
+    int16_t transmitUplink();
+
+    // get the next pseudo-random number
+    uint32_t nextRandom();
+
+    // configure the radio for the current Rx window and start scanning
+    int16_t openRxWindow();
+
+    // configure the radio to RX2 frequency and data rate
+    int16_t configureRx2();
+
+    // check whether class C reception may be used, i.e. the node is class C and not in join procedure
+    bool isClassC();
+
+    // start or stop class C continuous reception
+    int16_t startContinuousRx();
+    void stopContinuousRx();
+
+    // advance the current transaction (uplink, join or rekey) by a single step, must not be called recursively
+    int16_t stepTransaction(uint32_t now, bool irq);
+
+    // class B scheduler, opens beacon windows and ping slots while the MAC state machine is idle
+    int16_t pollClassB(uint32_t now, bool irq);
+
+    // start searching for the beacon, either around the time derived from DeviceTimeAns or for the whole period
+    void startBeaconAcquisition();
+
+    // configure the radio for the beacon and start receiving
+    int16_t openBeaconWindow();
+
+    // check the received beacon and synchronize the beacon period to it
+    int16_t processBeacon(uint32_t now);
+
+    // move on to the next beacon period after the beacon was not received
+    void skipBeacon(bool listened);
+
+    // leave class B after the beacon was lost
+    void loseBeacon();
+
+    // calculate the ping slot offset for the current beacon period
+    void schedulePingSlots();
+
+    // configure the radio for the ping slot and start scanning
+    int16_t openPingSlot();
+
+    // stop class B reception and restore the radio settings it changed
+    void stopClassBRx();
+
+    // length of the beacon frame in a given band
+    static uint8_t getBeaconLen(const LoRaWANBand_t* band);
+
+    // move on to RX2, or finish the transaction if that was RX2 already
+    int16_t nextRxWindow();
+
+    // restore the radio to the uplink configuration, go to idle and notify the application
+    int16_t finishTransaction(int16_t res, uint8_t event);
+
+    // send RekeyInd MAC command after LoRaWAN 1.1 join accept
+    int16_t startRekey();
+
+    // process the received join accept or data downlink
+    int16_t processJoinAccept();
+    int16_t processDownlink();
+
+    // load frame counter and DevNonce from the journal
+    void loadCounters();
+
+    // move a counter saved in place by older versions into the journal
+    void migrateCounter(uint8_t id, uint32_t paramId, size_t len);
+
+    // save the session after successful join
+    void saveSession();
+
+    // pass event to the application callback, if there is one
+    void notify(uint8_t event);
 
     // function to encrypt and decrypt payloads
-    void processAES(uint8_t* in, size_t len, uint8_t* key, uint8_t* out, uint32_t fcnt, uint8_t dir, uint8_t ctrId, bool counter);
+    void processAES(uint8_t* in, size_t len, const RadioLibAES128Key_t* ctx, uint8_t* out, uint32_t fcnt, uint8_t dir, uint8_t ctrId, bool counter);
 
     // network-to-host conversion method - takes data from network packet and converts it to the host endians
     template<typename T>
@@ -74,7 +74,42 @@ const LoRaWANBand_t EU868 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 6,
+  .subBands = {
+    { .freqStart = 863.0, .freqEnd = 865.0, .dutyCycle = 1000 },
+    { .freqStart = 865.0, .freqEnd = 868.0, .dutyCycle = 100 },
+    { .freqStart = 868.0, .freqEnd = 868.6, .dutyCycle = 100 },
+    { .freqStart = 868.7, .freqEnd = 869.2, .dutyCycle = 1000 },
+    { .freqStart = 869.4, .freqEnd = 869.65, .dutyCycle = 10 },
+    { .freqStart = 869.7, .freqEnd = 870.0, .dutyCycle = 100 }
+  },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 869.525,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_9 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 2, 0 }
 };
 
 const LoRaWANBand_t US915 = {
@@ -187,7 +222,35 @@ const LoRaWANBand_t US915 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 8,
+    .freqStart = 923.3,
+    .freqStep = 0.6,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_12 | RADIOLIB_LORAWAN_DATA_RATE_BW_500_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 5, 1 }
 };
 
 const LoRaWANBand_t CN780 = {
@@ -254,7 +317,37 @@ const LoRaWANBand_t CN780 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 1,
+  .subBands = {
+    { .freqStart = 779.0, .freqEnd = 787.0, .dutyCycle = 100 }
+  },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 785,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_9 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 2, 0 }
 };
 
 const LoRaWANBand_t EU433 = {
@@ -321,7 +414,37 @@ const LoRaWANBand_t EU433 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 1,
+  .subBands = {
+    { .freqStart = 433.05, .freqEnd = 434.79, .dutyCycle = 100 }
+  },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 434.665,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_9 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 2, 0 }
 };
 
 const LoRaWANBand_t AU915 = {
@@ -434,7 +557,35 @@ const LoRaWANBand_t AU915 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 8,
+    .freqStart = 923.3,
+    .freqStep = 0.6,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_12 | RADIOLIB_LORAWAN_DATA_RATE_BW_500_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 5, 1 }
 };
 
 const LoRaWANBand_t CN500 = {
@@ -524,7 +675,35 @@ const LoRaWANBand_t CN500 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 8,
+    .freqStart = 508.3,
+    .freqStep = 0.2,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_10 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 3, 1 }
 };
 
 const LoRaWANBand_t AS923 = {
@@ -591,7 +770,35 @@ const LoRaWANBand_t AS923 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 923.4,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_9 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 2, 0 }
 };
 
 const LoRaWANBand_t KR920 = {
@@ -658,7 +865,35 @@ const LoRaWANBand_t KR920 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 923.1,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_9 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 2, 0 }
 };
 
 const LoRaWANBand_t IN865 = {
@@ -725,7 +960,35 @@ const LoRaWANBand_t IN865 = {
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
       RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
     }
-  }
+  },
+  .numSubBands = 0,
+  .subBands = { RADIOLIB_LORAWAN_SUB_BAND_NONE },
+  .beaconChannel = {
+    .direction = RADIOLIB_LORAWAN_CHANNEL_DIR_DOWNLINK,
+    .joinRequestDataRate = RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    .numChannels = 1,
+    .freqStart = 866.55,
+    .freqStep = 0,
+    .dataRates = {
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_SF_8 | RADIOLIB_LORAWAN_DATA_RATE_BW_125_KHZ,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+      RADIOLIB_LORAWAN_DATA_RATE_UNUSED,
+    }
+  },
+  .beaconRfuLen = { 1, 3 }
 };
 
 #endif
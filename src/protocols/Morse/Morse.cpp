@@ -172,7 +172,7 @@ int16_t MorseClient::transmitDirect(uint32_t freq, uint32_t freqHz) {
     return(audioClient->tone(freqHz));
   }
   #endif
-  return(phyLayer->transmitDirect(freq));
+  return(phyLayer->retuneDirect(freq));
 }
 
 int16_t MorseClient::standby() {
@@ -43,7 +43,11 @@ int16_t PagerClient::begin(float base, uint16_t speed, bool invert, uint16_t shi
   shiftFreq = shiftFreqHz/step;
   inv = invert;
 
-  // initialize BCH encoder
+  // 0 is sent above base frequency and 1 below it, unless inverted
+  bitFreqRaw[0] = inv ? (baseFreqRaw - shiftFreq) : (baseFreqRaw + shiftFreq);
+  bitFreqRaw[1] = inv ? (baseFreqRaw + shiftFreq) : (baseFreqRaw - shiftFreq);
+
+  // initialize BCH encoder/decoder
   RadioLibBCHInstance.begin(RADIOLIB_PAGER_BCH_N, RADIOLIB_PAGER_BCH_K, RADIOLIB_PAGER_BCH_PRIMITIVE_POLY);
 
   // configure for direct mode
@@ -152,7 +156,7 @@ int16_t PagerClient::transmit(uint8_t* data, size_t len, uint32_t addr, uint8_t
   }
 
   // write address code word
-  msg[RADIOLIB_PAGER_PREAMBLE_LENGTH + 1 + framePos] = RadioLibBCHInstance.encode(frameAddr);
+  msg[RADIOLIB_PAGER_PREAMBLE_LENGTH + 1 + framePos] = frameAddr;
 
   // write the data as 20-bit code blocks
   if(len > 0) {
@@ -216,12 +220,13 @@ int16_t PagerClient::transmit(uint8_t* data, size_t len, uint32_t addr, uint8_t
 
       // save the number of overflown bits
       remBits = RADIOLIB_PAGER_FUNC_BITS_POS - symbolPos - symbolLength;
-
-      // do the FEC
-      msg[blockPos] = RadioLibBCHInstance.encode(msg[blockPos]);
     }
   }
 
+  // do the FEC on everything after preamble in one pass
+  // frame synchronization and idle code words are valid code words, so they will not be changed
+  RadioLibBCHInstance.encode(&msg[RADIOLIB_PAGER_PREAMBLE_LENGTH], &msg[RADIOLIB_PAGER_PREAMBLE_LENGTH], msgLen - RADIOLIB_PAGER_PREAMBLE_LENGTH);
+
   // transmit the message
   PagerClient::write(msg, msgLen);
 
@@ -241,6 +246,8 @@ int16_t PagerClient::startReceive(uint32_t pin, uint32_t addr, uint32_t mask) {
   readBitPin = pin;
   filterAddr = addr;
   filterMask = mask;
+  correctedCodeWords = 0;
+  uncorrectableCodeWords = 0;
 
   // set the carrier frequency
   int16_t state = phyLayer->setFrequency(baseFreq);
@@ -330,7 +337,8 @@ int16_t PagerClient::readData(uint8_t* data, size_t* len, uint32_t* addr) {
   uint8_t framePos = 0;
   uint8_t symbolLength = 0;
   while(!match && phyLayer->available()) {
-    uint32_t cw = read();
+    int16_t state = RADIOLIB_ERR_NONE;
+    uint32_t cw = read(&state);
     framePos++;
 
     // check if it's the idle code word
@@ -344,6 +352,11 @@ int16_t PagerClient::readData(uint8_t* data, size_t* len, uint32_t* addr) {
       continue;
     }
 
+    // do not try to match address in code words that could not be corrected
+    if(state == RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD) {
+      continue;
+    }
+
     // not an idle code word, check if it's an address word
     if(cw & (RADIOLIB_PAGER_MESSAGE_CODE_WORD << (RADIOLIB_PAGER_CODE_WORD_LEN - 1))) {
       // this is pretty weird, it seems to be a message code word without address
@@ -454,6 +467,14 @@ int16_t PagerClient::readData(uint8_t* data, size_t* len, uint32_t* addr) {
   *len = decodedBytes;
   return(RADIOLIB_ERR_NONE);
 }
+
+uint32_t PagerClient::getCorrectedCodeWords() {
+  return(correctedCodeWords);
+}
+
+uint32_t PagerClient::getUncorrectableCodeWords() {
+  return(uncorrectableCodeWords);
+}
 #endif
 
 void PagerClient::write(uint32_t* data, size_t len) {
@@ -467,24 +488,10 @@ void PagerClient::write(uint32_t codeWord) {
   // write single code word
   Module* mod = phyLayer->getMod();
   for(int8_t i = 31; i >= 0; i--) {
-    uint32_t mask = (uint32_t)0x01 << i;
     uint32_t start = mod->hal->micros();
 
-    // figure out the shift direction - start by assuming the bit is 0
-    int16_t change = shiftFreq;
-
-    // now check if it's actually 1
-    if(codeWord & mask) {
-      change = -shiftFreq;
-    }
-
-    // finally, check if inversion is enabled
-    if(inv) {
-      change = -change;
-    }
-
-    // now transmit the shifted frequency
-    phyLayer->transmitDirect(baseFreqRaw + change);
+    // transmit the shifted frequency for this bit
+    phyLayer->retuneDirect(bitFreqRaw[(codeWord >> i) & 0x01]);
 
     // this is pretty silly, while(mod->hal->micros() ... ) would be enough
     // but for some reason, MegaCore throws a linker error on it
@@ -497,7 +504,7 @@ void PagerClient::write(uint32_t codeWord) {
 }
 
 #if !defined(RADIOLIB_EXCLUDE_DIRECT_RECEIVE)
-uint32_t PagerClient::read() {
+uint32_t PagerClient::read(int16_t* state) {
   uint32_t codeWord = 0;
   codeWord |= (uint32_t)phyLayer->read() << 24;
   codeWord |= (uint32_t)phyLayer->read() << 16;
@@ -512,7 +519,18 @@ uint32_t PagerClient::read() {
   }
 
   RADIOLIB_VERBOSE_PRINTLN("R\t%lX", codeWord);
-  // TODO BCH error correction here
+
+  // correct bit errors, uncorrectable code words are returned as-is
+  int16_t res = RadioLibBCHInstance.decode(&codeWord);
+  if(res == RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD) {
+    uncorrectableCodeWords++;
+  } else if(res > 0) {
+    correctedCodeWords++;
+  }
+
+  if(state) {
+    *state = res;
+  }
   return(codeWord);
 }
 #endif
@@ -160,6 +160,18 @@ class PagerClient {
       \returns \ref status_codes
     */
     int16_t readData(uint8_t* data, size_t* len, uint32_t* addr = NULL);
+
+    /*!
+      \brief Get the number of received code words in which bit errors were corrected since the last call to startReceive.
+      \returns Number of corrected code words.
+    */
+    uint32_t getCorrectedCodeWords();
+
+    /*!
+      \brief Get the number of received code words with too many bit errors to be corrected since the last call to startReceive.
+      \returns Number of uncorrectable code words.
+    */
+    uint32_t getUncorrectableCodeWords();
 #endif
 
 #if !defined(RADIOLIB_GODMODE)
@@ -170,18 +182,21 @@ class PagerClient {
     float baseFreq;
     float dataRate;
     uint32_t baseFreqRaw;
+    uint32_t bitFreqRaw[2]; // raw frequency of 0 and 1 bits, including inversion
     uint16_t shiftFreq;
     uint16_t shiftFreqHz;
     uint16_t bitDuration;
     uint32_t filterAddr;
     uint32_t filterMask;
     bool inv = false;
+    uint32_t correctedCodeWords = 0;
+    uint32_t uncorrectableCodeWords = 0;
 
     void write(uint32_t* data, size_t len);
     void write(uint32_t codeWord);
 
 #if !defined(RADIOLIB_EXCLUDE_DIRECT_RECEIVE)
-    uint32_t read();
+    uint32_t read(int16_t* state = NULL);
 #endif
 
     uint8_t encodeBCD(char c);
@@ -4,6 +4,10 @@
 PhysicalLayer::PhysicalLayer(float step, size_t maxLen) {
   this->freqStep = step;
   this->maxPacketLength = maxLen;
+  this->streamLen = 0;
+  this->streamPos = 0;
+  this->streamProducer = NULL;
+  this->streamConsumer = NULL;
   #if !defined(RADIOLIB_EXCLUDE_DIRECT_RECEIVE)
   this->bufferBitPos = 0;
   this->bufferWritePos = 0;
@@ -212,11 +216,51 @@ int16_t PhysicalLayer::readData(uint8_t* data, size_t len) {
   return(RADIOLIB_ERR_UNSUPPORTED);
 }
 
+int16_t PhysicalLayer::readData(RadioLibPacketRing& ring) {
+  // the packet stays in the radio when there is no space for it
+  RadioLibPacket_t* pkt = ring.reserve();
+  if(pkt == NULL) {
+    return(RADIOLIB_ERR_PACKET_RING_FULL);
+  }
+
+  // damaged packets are passed on too, the consumer can check the slot state
+  int16_t state = readPacket(pkt);
+  if((state == RADIOLIB_ERR_NONE) || (state == RADIOLIB_ERR_CRC_MISMATCH)) {
+    ring.commit();
+  }
+  return(state);
+}
+
+int16_t PhysicalLayer::readPacket(RadioLibPacket_t* pkt) {
+  (void)pkt;
+  return(RADIOLIB_ERR_UNSUPPORTED);
+}
+
+int16_t PhysicalLayer::startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len)) {
+  (void)len;
+  (void)cb;
+  return(RADIOLIB_ERR_UNSUPPORTED);
+}
+
+int16_t PhysicalLayer::startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len)) {
+  (void)len;
+  (void)cb;
+  return(RADIOLIB_ERR_UNSUPPORTED);
+}
+
+int16_t PhysicalLayer::serviceStream() {
+  return(RADIOLIB_ERR_NONE);
+}
+
 int16_t PhysicalLayer::transmitDirect(uint32_t frf) {
   (void)frf;
   return(RADIOLIB_ERR_UNSUPPORTED);
 }
 
+int16_t PhysicalLayer::retuneDirect(uint32_t frf) {
+  return(this->transmitDirect(frf));
+}
+
 int16_t PhysicalLayer::receiveDirect() {
   return(RADIOLIB_ERR_UNSUPPORTED);
 }
@@ -226,6 +270,10 @@ int16_t PhysicalLayer::setFrequency(float freq) {
   return(RADIOLIB_ERR_UNSUPPORTED);
 }
 
+int16_t PhysicalLayer::setFrequencyRaw(uint32_t frf) {
+  return(this->setFrequency(((float)frf * this->freqStep) / 1000000.0));
+}
+
 int16_t PhysicalLayer::setBitRate(float br) {
   (void)br;
   return(RADIOLIB_ERR_UNSUPPORTED);
@@ -267,6 +315,15 @@ int16_t PhysicalLayer::setPreambleLength(size_t len) {
   return(RADIOLIB_ERR_UNSUPPORTED);
 }
 
+int16_t PhysicalLayer::implicitHeader(size_t len) {
+  (void)len;
+  return(RADIOLIB_ERR_UNSUPPORTED);
+}
+
+int16_t PhysicalLayer::explicitHeader() {
+  return(RADIOLIB_ERR_UNSUPPORTED);
+}
+
 int16_t PhysicalLayer::setDataRate(DataRate_t dr) {
   (void)dr;
   return(RADIOLIB_ERR_UNSUPPORTED);
@@ -473,3 +530,35 @@ void PhysicalLayer::setTimerFlag() {
   mod->TimerFlag = true;
 }
 #endif
+
+void PhysicalLayer::startStream(size_t len, size_t (*producer)(uint8_t*, size_t), void (*consumer)(uint8_t*, size_t)) {
+  this->streamLen = len;
+  this->streamPos = 0;
+  this->streamProducer = producer;
+  this->streamConsumer = consumer;
+}
+
+size_t PhysicalLayer::produceStream(uint8_t* data, size_t len) {
+  // never ask for more than what is left in the stream
+  if(len > this->streamLen - this->streamPos) {
+    len = this->streamLen - this->streamPos;
+  }
+  if((len == 0) || (this->streamProducer == NULL)) {
+    return(0);
+  }
+
+  // the producer may not have all the data ready yet
+  size_t produced = this->streamProducer(data, len);
+  if(produced > len) {
+    produced = len;
+  }
+  this->streamPos += produced;
+  return(produced);
+}
+
+void PhysicalLayer::consumeStream(uint8_t* data, size_t len) {
+  this->streamPos += len;
+  if(this->streamConsumer != NULL) {
+    this->streamConsumer(data, len);
+  }
+}
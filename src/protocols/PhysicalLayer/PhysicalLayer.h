@@ -3,6 +3,7 @@
 
 #include "../../TypeDef.h"
 #include "../../Module.h"
+#include "../../utils/PacketRing.h"
 
 // data rate structure interpretation in case LoRa is used
 struct LoRaRate_t {
@@ -188,6 +189,51 @@ class PhysicalLayer {
     */
     virtual int16_t readData(uint8_t* data, size_t len);
 
+    /*!
+      \brief Reads packet that was received after calling startReceive method directly into the next free slot
+      of packet ring, together with its length, RSSI, SNR and timestamp. Packets with CRC error are stored as well,
+      with the error saved in the slot state.
+      \param ring Packet ring to save the packet in.
+      \returns \ref status_codes
+    */
+    int16_t readData(RadioLibPacketRing& ring);
+
+    /*!
+      \brief Reads packet that was received after calling startReceive method, including its metadata.
+      Packets longer than RADIOLIB_PACKET_RING_MAX_LEN are truncated.
+      \param pkt Packet structure to save the packet in.
+      \returns \ref status_codes
+    */
+    virtual int16_t readPacket(RadioLibPacket_t* pkt);
+
+    /*!
+      \brief Interrupt-driven stream transmit method. Unlike startTransmit, the payload does not have to fit into FIFO.
+      Instead, it is requested from the callback in chunks sized to the FIFO threshold, each time serviceStream is called.
+      \param len Total number of bytes to transmit.
+      \param cb Callback that gets a buffer and the maximum number of bytes to put in it,
+      and returns the number of bytes it actually provided.
+      \returns \ref status_codes
+    */
+    virtual int16_t startTransmitStream(size_t len, size_t (*cb)(uint8_t* data, size_t len));
+
+    /*!
+      \brief Interrupt-driven stream receive method. Unlike startReceive, the payload does not have to fit into FIFO.
+      Instead, it is passed to the callback in chunks sized to the FIFO threshold, each time serviceStream is called.
+      \param len Total number of bytes to receive.
+      \param cb Callback that gets a buffer with the next chunk of received data and its length.
+      \returns \ref status_codes
+    */
+    virtual int16_t startReceiveStream(size_t len, void (*cb)(uint8_t* data, size_t len));
+
+    /*!
+      \brief Moves data between FIFO and the stream callbacks. Must be called often enough to refill (or empty)
+      the FIFO before it runs out, e.g. from the main loop, or when the FIFO interrupt fires.
+      Once the stream is finished, call finishTransmit or standby.
+      \returns \ref status_codes - RADIOLIB_ERR_NONE once the whole stream was transferred,
+      RADIOLIB_STREAM_IN_PROGRESS while it is not, or RADIOLIB_ERR_CRC_MISMATCH when received stream failed CRC check.
+    */
+    virtual int16_t serviceStream();
+
     /*!
       \brief Enables direct transmission mode on pins DIO1 (clock) and DIO2 (data). Must be implemented in module class.
       While in direct mode, the module will not be able to transmit or receive packets. Can only be activated in FSK mode.
@@ -196,6 +242,15 @@ class PhysicalLayer {
     */
     virtual int16_t transmitDirect(uint32_t frf = 0);
 
+    /*!
+      \brief Changes frequency of direct transmission already started by transmitDirect, e.g. for each symbol of RTTY or SSTV.
+      Modules that implement this skip the mode and RF switch setup that was already done, which reduces timing jitter
+      at high symbol rates. The default implementation simply calls transmitDirect.
+      \param frf 24-bit raw frequency value to transmit at.
+      \returns \ref status_codes
+    */
+    virtual int16_t retuneDirect(uint32_t frf);
+
     /*!
       \brief Enables direct reception mode on pins DIO1 (clock) and DIO2 (data). Must be implemented in module class.
       While in direct mode, the module will not be able to transmit or receive packets. Can only be activated in FSK mode.
@@ -212,6 +267,15 @@ class PhysicalLayer {
     */
     virtual int16_t setFrequency(float freq);
 
+    /*!
+      \brief Sets carrier frequency as raw synthesizer value, without float math, range checks or calibration.
+      The new frequency should be in the same band as the last one set by setFrequency. Modules that do not implement this
+      will convert the value back to MHz and call setFrequency.
+      \param frf Carrier frequency in multiples of synthesizer frequency step, see getFreqStep.
+      \returns \ref status_codes
+    */
+    virtual int16_t setFrequencyRaw(uint32_t frf);
+
     /*!
       \brief Sets FSK bit rate. Only available in FSK mode. Must be implemented in module class.
       \param br Bit rate to be set (in kbps).
@@ -269,6 +333,19 @@ class PhysicalLayer {
       \returns \ref status_codes
     */
     virtual int16_t setPreambleLength(size_t len);
+
+    /*!
+      \brief Set implicit header mode for future reception/transmission. Must be implemented in module class if the module supports it.
+      \param len Payload length in bytes.
+      \returns \ref status_codes
+    */
+    virtual int16_t implicitHeader(size_t len);
+
+    /*!
+      \brief Set explicit header mode for future reception/transmission. Must be implemented in module class if the module supports it.
+      \returns \ref status_codes
+    */
+    virtual int16_t explicitHeader();
     
     /*!
       \brief Set data. Must be implemented in module class if the module supports it.
@@ -458,11 +535,21 @@ class PhysicalLayer {
 
     #endif
 
-#if !defined(RADIOLIB_EXCLUDE_DIRECT_RECEIVE)
   protected:
+#if !defined(RADIOLIB_EXCLUDE_DIRECT_RECEIVE)
     void updateDirectBuffer(uint8_t bit);
 #endif
 
+    // FIFO stream state, only used by modules that implement streaming
+    size_t streamLen;
+    size_t streamPos;
+    size_t (*streamProducer)(uint8_t* data, size_t len);
+    void (*streamConsumer)(uint8_t* data, size_t len);
+
+    void startStream(size_t len, size_t (*producer)(uint8_t*, size_t), void (*consumer)(uint8_t*, size_t));
+    size_t produceStream(uint8_t* data, size_t len);
+    void consumeStream(uint8_t* data, size_t len);
+
 #if !defined(RADIOLIB_GODMODE)
   private:
 #endif
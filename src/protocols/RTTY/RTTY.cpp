@@ -109,7 +109,7 @@ int16_t RTTYClient::transmitDirect(uint32_t freq, uint32_t freqHz) {
     return(audioClient->tone(freqHz));
   }
   #endif
-  return(phyLayer->transmitDirect(freq));
+  return(phyLayer->retuneDirect(freq));
 }
 
 int16_t RTTYClient::standby() {
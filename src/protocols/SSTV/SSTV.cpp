@@ -186,6 +186,20 @@ int16_t SSTVClient::begin(float base, const SSTVMode_t& mode) {
   // calculate 24-bit frequency
   baseFreq = (base * 1000000.0) / phyLayer->getFreqStep();
 
+  // precompute all tones, so that there is no float math while sending the picture
+  // audio tones are sent in Hz, the others as offset from base frequency
+  float step = phyLayer->getFreqStep();
+  #if !defined(RADIOLIB_EXCLUDE_AFSK)
+  if(audioClient != nullptr) {
+    step = 1;
+  }
+  #endif
+  toneScale = ((float)((uint32_t)1 << RADIOLIB_SSTV_TONE_SCALE_BITS) / step) + 0.5;
+  for(uint16_t i = 0; i < RADIOLIB_SSTV_NUM_PIXEL_TONES; i++) {
+    float freq = RADIOLIB_SSTV_TONE_BRIGHTNESS_MIN + ((float)i * (RADIOLIB_SSTV_TONE_BRIGHTNESS_MAX - RADIOLIB_SSTV_TONE_BRIGHTNESS_MIN)) / (RADIOLIB_SSTV_NUM_PIXEL_TONES - 1);
+    pixelTones[i] = (freq / step) + 0.5;
+  }
+
   // configure for direct mode
   return(phyLayer->startDirect());
 }
@@ -279,7 +293,7 @@ void SSTVClient::sendLine(uint32_t* imgLine) {
           case(tone_t::GENERIC):
             break;
         }
-        this->tone(RADIOLIB_SSTV_TONE_BRIGHTNESS_MIN + ((float)color * 3.1372549), txMode.scanPixelLen);
+        this->toneRaw(pixelTones[color], txMode.scanPixelLen);
       }
     }
   }
@@ -289,17 +303,21 @@ uint16_t SSTVClient::getPictureHeight() const {
   return(txMode.height);
 }
 
-void SSTVClient::tone(float freq, uint32_t len) {
+void SSTVClient::tone(uint16_t freq, uint32_t len) {
+  toneRaw(((uint32_t)freq * toneScale) >> RADIOLIB_SSTV_TONE_SCALE_BITS, len);
+}
+
+void SSTVClient::toneRaw(uint16_t tone, uint32_t len) {
   Module* mod = phyLayer->getMod();
   uint32_t start = mod->hal->micros();
   #if !defined(RADIOLIB_EXCLUDE_AFSK)
   if(audioClient != nullptr) {
-    audioClient->tone(freq, false);
+    audioClient->tone(tone, false);
   } else {
-    phyLayer->transmitDirect(baseFreq + (freq / phyLayer->getFreqStep()));
+    phyLayer->retuneDirect(baseFreq + tone);
   }
   #else
-  phyLayer->transmitDirect(baseFreq + (freq / phyLayer->getFreqStep()));
+  phyLayer->retuneDirect(baseFreq + tone);
   #endif
   mod->waitForMicroseconds(start, len);
 }
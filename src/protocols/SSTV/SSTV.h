@@ -30,6 +30,10 @@
 #define RADIOLIB_SSTV_TONE_BRIGHTNESS_MIN                       1500
 #define RADIOLIB_SSTV_TONE_BRIGHTNESS_MAX                       2300
 
+// precomputed tones
+#define RADIOLIB_SSTV_NUM_PIXEL_TONES                           256
+#define RADIOLIB_SSTV_TONE_SCALE_BITS                           16
+
 // calibration header timing in us
 #define RADIOLIB_SSTV_HEADER_LEADER_LENGTH                      300000
 #define RADIOLIB_SSTV_HEADER_BREAK_LENGTH                       10000
@@ -194,7 +198,14 @@ class SSTVClient {
     SSTVMode_t txMode = Scottie1;
     bool firstLine = true;
 
-    void tone(float freq, uint32_t len = 0);
+    // tone for each pixel brightness, either as raw frequency offset from base, or as audio frequency in Hz
+    uint16_t pixelTones[RADIOLIB_SSTV_NUM_PIXEL_TONES] = { 0 };
+
+    // conversion of tone frequency in Hz to the same units as pixelTones, with RADIOLIB_SSTV_TONE_SCALE_BITS fractional bits
+    uint32_t toneScale = 0;
+
+    void tone(uint16_t freq, uint32_t len = 0);
+    void toneRaw(uint16_t tone, uint32_t len);
 };
 
 #endif
@@ -1,35 +1,209 @@
 #include "CRC.h"
 
+RadioLibCRC::Table RadioLibCRC::tables[RADIOLIB_CRC_MAX_TABLES];
+
 RadioLibCRC::RadioLibCRC() {
 
 }
 
+RadioLibCRC::RadioLibCRC(uint8_t size, uint32_t poly, uint32_t init, uint32_t out, bool refIn, bool refOut)
+  : size(size), poly(poly), init(init), out(out), refIn(refIn), refOut(refOut) {
+
+}
+
+RadioLibCRC::~RadioLibCRC() {
+  this->releaseTable();
+}
+
 uint32_t RadioLibCRC::checksum(uint8_t* buff, size_t len) {
-  uint32_t crc = this->init;
-  size_t pos = 0;
-  for(size_t i = 0; i < 8*len; i++) {
-    if(i % 8 == 0) {
-      uint32_t in = buff[pos++];
-      if(this->refIn) {
-        in = Module::reflect(in, 8);
+  this->reset();
+  this->update(buff, len);
+  return(this->finalize());
+}
+
+void RadioLibCRC::reset() {
+  // switch to other tables if the configuration changed since the last time
+  if(this->tableIndex != RADIOLIB_CRC_TABLE_NONE) {
+    Table* table = &RadioLibCRC::tables[this->tableIndex];
+    if((this->size != table->size) || (this->poly != table->poly) || (this->refIn != table->refIn)) {
+      this->releaseTable();
+    }
+  }
+  if(this->tableIndex == RADIOLIB_CRC_TABLE_NONE) {
+    this->acquireTable();
+  }
+
+  // reflected CRC is processed LSB-first, normal one is aligned to the MSB of the register
+  if(this->refIn) {
+    this->crc = Module::reflect(this->init, this->size);
+  } else {
+    this->crc = this->init << (32 - this->size);
+  }
+}
+
+void RadioLibCRC::update(const uint8_t* buff, size_t len) {
+  uint32_t crc = this->crc;
+
+  // all tables are taken by other configurations, so calculate bit-by-bit
+  if(this->tableIndex == RADIOLIB_CRC_TABLE_NONE) {
+    if(this->refIn) {
+      uint32_t poly = Module::reflect(this->poly, this->size);
+      for(size_t i = 0; i < len; i++) {
+        crc ^= buff[i];
+        for(uint8_t j = 0; j < 8; j++) {
+          crc = (crc & 1) ? ((crc >> 1) ^ poly) : (crc >> 1);
+        }
+      }
+    } else {
+      uint32_t poly = this->poly << (32 - this->size);
+      for(size_t i = 0; i < len; i++) {
+        crc ^= (uint32_t)buff[i] << 24;
+        for(uint8_t j = 0; j < 8; j++) {
+          crc = (crc & ((uint32_t)1 << 31)) ? ((crc << 1) ^ poly) : (crc << 1);
+        }
       }
-      crc ^= (in << (this->size - 8));
     }
+    this->crc = crc;
+    return;
+  }
+  uint32_t (*table)[256] = RadioLibCRC::tables[this->tableIndex].data;
 
-    if(crc & ((uint32_t)1 << (this->size - 1))) {
-      crc <<= (uint32_t)1;
-      crc ^= this->poly;
+  #if RADIOLIB_CRC_TABLE_SLICES > 1
+  // process the bulk of the data several bytes at a time
+  while(len >= RADIOLIB_CRC_TABLE_SLICES) {
+    // the first input byte is combined with the LSB of reflected CRC, or the MSB of normal CRC
+    uint32_t prev = crc;
+    if(!this->refIn) {
+      prev = (crc >> 24) | ((crc >> 8) & 0xFF00) | ((crc << 8) & 0xFF0000) | (crc << 24);
+    }
+    crc = 0;
+    for(uint8_t i = 0; i < RADIOLIB_CRC_TABLE_SLICES; i++) {
+      uint8_t index = buff[i];
+      if(i < 4) {
+        index ^= (uint8_t)(prev >> (8*i));
+      }
+      crc ^= table[RADIOLIB_CRC_TABLE_SLICES - 1 - i][index];
+    }
+    buff += RADIOLIB_CRC_TABLE_SLICES;
+    len -= RADIOLIB_CRC_TABLE_SLICES;
+  }
+  #endif
+
+  // process the rest byte-by-byte
+  if(this->refIn) {
+    for(size_t i = 0; i < len; i++) {
+      crc = (crc >> 8) ^ table[0][(crc ^ buff[i]) & 0xFF];
+    }
+  } else {
+    for(size_t i = 0; i < len; i++) {
+      crc = (crc << 8) ^ table[0][((crc >> 24) ^ buff[i]) & 0xFF];
+    }
+  }
+
+  this->crc = crc;
+}
+
+uint32_t RadioLibCRC::finalize() {
+  uint32_t res = 0;
+  if(this->refIn) {
+    // the register already holds the reflected CRC
+    if(this->refOut) {
+      res = this->crc ^ Module::reflect(this->out, this->size);
     } else {
-      crc <<= (uint32_t)1;
+      res = Module::reflect(this->crc, this->size) ^ this->out;
+    }
+  } else {
+    res = (this->crc >> (32 - this->size)) ^ this->out;
+    if(this->refOut) {
+      res = Module::reflect(res, this->size);
+    }
+  }
+
+  res &= (uint32_t)0xFFFFFFFF >> (32 - this->size);
+  return(res);
+}
+
+void RadioLibCRC::acquireTable() {
+  // use the tables generated for the same configuration, or the first unused ones
+  uint8_t unused = RADIOLIB_CRC_TABLE_NONE;
+  for(uint8_t i = 0; i < RADIOLIB_CRC_MAX_TABLES; i++) {
+    Table* table = &RadioLibCRC::tables[i];
+    if((table->size == this->size) && (table->poly == this->poly) && (table->refIn == this->refIn)) {
+      table->users++;
+      this->tableIndex = i;
+      return;
+    }
+    if((table->users == 0) && (unused == RADIOLIB_CRC_TABLE_NONE)) {
+      unused = i;
+    }
+  }
+  if(unused == RADIOLIB_CRC_TABLE_NONE) {
+    return;
+  }
+
+  Table* table = &RadioLibCRC::tables[unused];
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  table->data = new uint32_t[RADIOLIB_CRC_TABLE_SLICES][256];
+  #endif
+  table->size = this->size;
+  table->poly = this->poly;
+  table->refIn = this->refIn;
+  table->users = 1;
+  RadioLibCRC::generateTable(table);
+  this->tableIndex = unused;
+}
+
+void RadioLibCRC::releaseTable() {
+  if(this->tableIndex == RADIOLIB_CRC_TABLE_NONE) {
+    return;
+  }
+
+  // static tables are kept, so that they do not have to be generated again for the same configuration
+  Table* table = &RadioLibCRC::tables[this->tableIndex];
+  table->users--;
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  if(table->users == 0) {
+    delete[] table->data;
+    table->data = NULL;
+    table->size = 0;
+  }
+  #endif
+  this->tableIndex = RADIOLIB_CRC_TABLE_NONE;
+}
+
+void RadioLibCRC::generateTable(Table* table) {
+  // generate the basic byte-wise table
+  if(table->refIn) {
+    uint32_t poly = Module::reflect(table->poly, table->size);
+    for(uint16_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for(uint8_t j = 0; j < 8; j++) {
+        crc = (crc & 1) ? ((crc >> 1) ^ poly) : (crc >> 1);
+      }
+      table->data[0][i] = crc;
+    }
+  } else {
+    uint32_t poly = table->poly << (32 - table->size);
+    for(uint16_t i = 0; i < 256; i++) {
+      uint32_t crc = (uint32_t)i << 24;
+      for(uint8_t j = 0; j < 8; j++) {
+        crc = (crc & ((uint32_t)1 << 31)) ? ((crc << 1) ^ poly) : (crc << 1);
+      }
+      table->data[0][i] = crc;
     }
   }
 
-  crc ^= this->out;
-  if(this->refOut) {
-    crc = Module::reflect(crc, this->size);
+  // each additional slice corresponds to one more zero byte appended to the input
+  for(uint8_t n = 1; n < RADIOLIB_CRC_TABLE_SLICES; n++) {
+    for(uint16_t i = 0; i < 256; i++) {
+      uint32_t prev = table->data[n - 1][i];
+      if(table->refIn) {
+        table->data[n][i] = (prev >> 8) ^ table->data[0][prev & 0xFF];
+      } else {
+        table->data[n][i] = (prev << 8) ^ table->data[0][prev >> 24];
+      }
+    }
   }
-  crc &= (uint32_t)0xFFFFFFFF >> (32 - this->size);
-  return(crc);
 }
 
 RadioLibCRC RadioLibCRCInstance;
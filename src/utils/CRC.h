@@ -12,9 +12,27 @@
 #define RADIOLIB_CRC_CCITT_INIT                                 (0xFFFF)
 #define RADIOLIB_CRC_CCITT_OUT                                  (0xFFFF)
 
+#if (RADIOLIB_CRC_TABLE_SLICES != 1) && (RADIOLIB_CRC_TABLE_SLICES != 4) && (RADIOLIB_CRC_TABLE_SLICES != 8)
+  #error "Unsupported number of CRC table slices, only 1, 4 and 8 are supported!"
+#endif
+
+#if (RADIOLIB_CRC_MAX_TABLES < 1) || (RADIOLIB_CRC_MAX_TABLES > 254)
+  #error "Unsupported number of CRC tables, only 1 to 254 are supported!"
+#endif
+
+// no lookup tables are used by the instance
+#define RADIOLIB_CRC_TABLE_NONE                                 (0xFF)
+
 /*!
   \class RadioLibCRC
   \brief Class to calculate CRCs of varying formats.
+  The checksum is calculated using lookup tables, which are generated
+  automatically whenever size, polynomial or input reflection is changed.
+  The tables are shared by all instances with the same configuration, at most RADIOLIB_CRC_MAX_TABLES
+  of them exist at a time, and configurations beyond that are calculated bit-by-bit.
+  Unless RADIOLIB_STATIC_ONLY is defined, the tables are only allocated while used,
+  so instances that are never used (such as the global singleton) take up no space for them.
+  Reflected-input CRCs use natively reflected tables, so no per-byte reflection is performed.
 */
 class RadioLibCRC {
   public:
@@ -53,6 +71,26 @@ class RadioLibCRC {
     */
     RadioLibCRC();
 
+    /*!
+      \brief Constructor with full CRC configuration, allows each user to keep its own instance.
+      \param size CRC size in bits.
+      \param poly CRC polynomial.
+      \param init Initial value.
+      \param out Final XOR value.
+      \param refIn Whether to reflect input bytes.
+      \param refOut Whether to reflect the result.
+    */
+    RadioLibCRC(uint8_t size, uint32_t poly, uint32_t init, uint32_t out, bool refIn, bool refOut);
+
+    /*!
+      \brief Default destructor.
+    */
+    ~RadioLibCRC();
+
+    // the instance holds a reference to the shared tables, so it must not be copied
+    RadioLibCRC(const RadioLibCRC&) = delete;
+    RadioLibCRC& operator=(const RadioLibCRC&) = delete;
+
     /*!
       \brief Calculate checksum of a buffer.
       \param buff Buffer to calculate the checksum over.
@@ -60,9 +98,216 @@ class RadioLibCRC {
       \returns The resulting checksum.
     */
     uint32_t checksum(uint8_t* buff, size_t len);
+
+    /*!
+      \brief Start incremental checksum calculation, resets the running CRC to the initial value.
+    */
+    void reset();
+
+    /*!
+      \brief Feed more data into incremental checksum calculation.
+      \param buff Buffer to add to the checksum.
+      \param len Size of the buffer in bytes.
+    */
+    void update(const uint8_t* buff, size_t len);
+
+    /*!
+      \brief Finish incremental checksum calculation.
+      \returns The checksum of all data passed to update() since the last call to reset().
+    */
+    uint32_t finalize();
+
+  private:
+    uint32_t crc = 0;
+
+    // index of the shared tables used by this instance, or RADIOLIB_CRC_TABLE_NONE
+    uint8_t tableIndex = RADIOLIB_CRC_TABLE_NONE;
+
+    // lookup tables shared by all instances with the same configuration
+    struct Table {
+      uint8_t size;
+      uint32_t poly;
+      bool refIn;
+      uint8_t users;
+      #if defined(RADIOLIB_STATIC_ONLY)
+      uint32_t data[RADIOLIB_CRC_TABLE_SLICES][256];
+      #else
+      uint32_t (*data)[256];
+      #endif
+    };
+    static Table tables[RADIOLIB_CRC_MAX_TABLES];
+
+    void acquireTable();
+    void releaseTable();
+    static void generateTable(Table* table);
 };
 
 // the global singleton
 extern RadioLibCRC RadioLibCRCInstance;
 
+/*!
+  \struct RadioLibCRCTableEntry
+  \brief Selects the narrowest type able to hold a lookup table entry of CRC with the given size.
+  \tparam SIZE CRC size in bits.
+*/
+template<uint8_t SIZE, bool BYTE = (SIZE <= 8), bool WORD = (SIZE <= 16)>
+struct RadioLibCRCTableEntry {
+  /*! \brief Type of the table entry */
+  typedef uint32_t type;
+};
+
+template<uint8_t SIZE, bool WORD>
+struct RadioLibCRCTableEntry<SIZE, true, WORD> {
+  typedef uint8_t type;
+};
+
+template<uint8_t SIZE>
+struct RadioLibCRCTableEntry<SIZE, false, true> {
+  typedef uint16_t type;
+};
+
+/*!
+  \class RadioLibCRCDescriptor
+  \brief Immutable, compile-time CRC configuration.
+  The lookup table is generated by the compiler and placed in program storage (usually Flash),
+  its entries are only as wide as the CRC itself,
+  and the running CRC is kept by the caller, so any number of users (including interrupt service routines)
+  can calculate checksums concurrently without locking.
+  \tparam SIZE CRC size in bits.
+  \tparam POLY CRC polynomial.
+  \tparam INIT Initial value.
+  \tparam OUT Final XOR value.
+  \tparam REF_IN Whether to reflect input bytes.
+  \tparam REF_OUT Whether to reflect the result.
+*/
+template<uint8_t SIZE, uint32_t POLY, uint32_t INIT, uint32_t OUT, bool REF_IN, bool REF_OUT>
+class RadioLibCRCDescriptor {
+  public:
+    /*!
+      \brief Type of the lookup table entries.
+    */
+    typedef typename RadioLibCRCTableEntry<SIZE>::type entry_t;
+
+    /*!
+      \brief Lookup table, generated at compile time. Entries of normal (non-reflected) CRCs are stored
+      without the alignment to the MSB of the running CRC.
+    */
+    static const entry_t table[256];
+
+    /*!
+      \brief Get the initial value of the running CRC.
+      \returns Running CRC to pass into the first call of update().
+    */
+    static constexpr uint32_t begin() {
+      return(REF_IN ? reflect(INIT, SIZE) : (INIT << (32 - SIZE)));
+    }
+
+    /*!
+      \brief Feed more data into the running CRC.
+      \param crc Running CRC, as returned by begin() or the previous call to update().
+      \param buff Buffer to add to the checksum.
+      \param len Size of the buffer in bytes.
+      \returns The updated running CRC.
+    */
+    static uint32_t update(uint32_t crc, const uint8_t* buff, size_t len) {
+      for(size_t i = 0; i < len; i++) {
+        if(REF_IN) {
+          crc = (crc >> 8) ^ read((crc ^ buff[i]) & 0xFF);
+        } else {
+          crc = (crc << 8) ^ (read(((crc >> 24) ^ buff[i]) & 0xFF) << (32 - SIZE));
+        }
+      }
+      return(crc);
+    }
+
+    /*!
+      \brief Read lookup table entry from program storage.
+      \param index Table index.
+      \returns The table entry.
+    */
+    static uint32_t read(uint8_t index) {
+      return(readEntry(&table[index]));
+    }
+
+    // overloads for each of the table entry types
+    static uint32_t readEntry(const uint8_t* ptr) {
+      return(RADIOLIB_NONVOLATILE_READ_BYTE(ptr));
+    }
+
+    static uint32_t readEntry(const uint16_t* ptr) {
+      return(RADIOLIB_NONVOLATILE_READ_WORD(ptr));
+    }
+
+    static uint32_t readEntry(const uint32_t* ptr) {
+      return(RADIOLIB_NONVOLATILE_READ_DWORD(ptr));
+    }
+
+    /*!
+      \brief Convert the running CRC into the final checksum.
+      \param crc Running CRC, as returned by update().
+      \returns The resulting checksum.
+    */
+    static constexpr uint32_t finalize(uint32_t crc) {
+      return((REF_IN ?
+        (REF_OUT ? (crc ^ reflect(OUT, SIZE)) : (reflect(crc, SIZE) ^ OUT)) :
+        (REF_OUT ? reflect((crc >> (32 - SIZE)) ^ OUT, SIZE) : ((crc >> (32 - SIZE)) ^ OUT)))
+        & ((uint32_t)0xFFFFFFFF >> (32 - SIZE)));
+    }
+
+    /*!
+      \brief Calculate checksum of a buffer.
+      \param buff Buffer to calculate the checksum over.
+      \param len Size of the buffer in bytes.
+      \returns The resulting checksum.
+    */
+    static uint32_t checksum(const uint8_t* buff, size_t len) {
+      return(finalize(update(begin(), buff, len)));
+    }
+
+    /*!
+      \brief Compile-time bit reflection, equivalent to Module::reflect.
+      \param in The input to reflect.
+      \param bits Number of bits to reflect.
+      \returns The reflected input.
+    */
+    static constexpr uint32_t reflect(uint32_t in, uint8_t bits) {
+      return((bits == 0) ? 0 : (((in & 0x01) << (bits - 1)) | reflect(in >> 1, bits - 1)));
+    }
+
+    /*!
+      \brief Compile-time lookup table entry generation.
+      \param crc Table index for the first call, intermediate result for recursive calls.
+      \param bits Number of bits left to process.
+      \returns The lookup table entry.
+    */
+    static constexpr uint32_t entry(uint32_t crc, uint8_t bits = 8) {
+      return((bits == 0) ? crc : (REF_IN ?
+        entry((crc & 0x01) ? ((crc >> 1) ^ reflect(POLY, SIZE)) : (crc >> 1), bits - 1) :
+        entry((crc & ((uint32_t)1 << 31)) ? ((crc << 1) ^ (POLY << (32 - SIZE))) : (crc << 1), bits - 1)));
+    }
+};
+
+// macros to expand the table initializer, reflected tables are indexed by the LSB, normal ones by the MSB
+#define RADIOLIB_CRC_TABLE_1(N)     (entry_t)(REF_IN ? entry((uint32_t)(N)) : (entry((uint32_t)(N) << 24) >> (32 - SIZE)))
+#define RADIOLIB_CRC_TABLE_4(N)     RADIOLIB_CRC_TABLE_1(N), RADIOLIB_CRC_TABLE_1(N + 1), RADIOLIB_CRC_TABLE_1(N + 2), RADIOLIB_CRC_TABLE_1(N + 3)
+#define RADIOLIB_CRC_TABLE_16(N)    RADIOLIB_CRC_TABLE_4(N), RADIOLIB_CRC_TABLE_4(N + 4), RADIOLIB_CRC_TABLE_4(N + 8), RADIOLIB_CRC_TABLE_4(N + 12)
+#define RADIOLIB_CRC_TABLE_64(N)    RADIOLIB_CRC_TABLE_16(N), RADIOLIB_CRC_TABLE_16(N + 16), RADIOLIB_CRC_TABLE_16(N + 32), RADIOLIB_CRC_TABLE_16(N + 48)
+#define RADIOLIB_CRC_TABLE_256      RADIOLIB_CRC_TABLE_64(0), RADIOLIB_CRC_TABLE_64(64), RADIOLIB_CRC_TABLE_64(128), RADIOLIB_CRC_TABLE_64(192)
+
+template<uint8_t SIZE, uint32_t POLY, uint32_t INIT, uint32_t OUT, bool REF_IN, bool REF_OUT>
+const typename RadioLibCRCDescriptor<SIZE, POLY, INIT, OUT, REF_IN, REF_OUT>::entry_t RadioLibCRCDescriptor<SIZE, POLY, INIT, OUT, REF_IN, REF_OUT>::table[256] RADIOLIB_NONVOLATILE = {
+  RADIOLIB_CRC_TABLE_256
+};
+
+#undef RADIOLIB_CRC_TABLE_1
+#undef RADIOLIB_CRC_TABLE_4
+#undef RADIOLIB_CRC_TABLE_16
+#undef RADIOLIB_CRC_TABLE_64
+#undef RADIOLIB_CRC_TABLE_256
+
+/*!
+  \brief CCITT CRC (used by AX.25).
+*/
+typedef RadioLibCRCDescriptor<16, RADIOLIB_CRC_CCITT_POLY, RADIOLIB_CRC_CCITT_INIT, RADIOLIB_CRC_CCITT_OUT, false, false> RadioLibCRCCCITT;
+
 #endif
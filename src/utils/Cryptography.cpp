@@ -2,16 +2,58 @@
 
 #include <string.h>
 
+#if defined(RADIOLIB_AES128_T_TABLES)
+// T-tables combining SubBytes and MixColumns (encryption) or InvSubBytes and InvMixColumns (decryption)
+// only the first table is stored, the others are byte rotations of it
+static uint32_t aesTe[256];
+static uint32_t aesTd[256];
+static bool aesTablesReady = false;
+
+#define RADIOLIB_AES128_ROR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+#define RADIOLIB_AES128_GET_WORD(buff)   (((uint32_t)(buff)[0] << 24) | ((uint32_t)(buff)[1] << 16) | ((uint32_t)(buff)[2] << 8) | (uint32_t)(buff)[3])
+#define RADIOLIB_AES128_SET_WORD(buff, word) { \
+  (buff)[0] = (uint8_t)((word) >> 24); \
+  (buff)[1] = (uint8_t)((word) >> 16); \
+  (buff)[2] = (uint8_t)((word) >> 8); \
+  (buff)[3] = (uint8_t)(word); \
+}
+#endif
+
 RadioLibAES128::RadioLibAES128() {
 
 }
 
 void RadioLibAES128::init(uint8_t* key) {
-  this->keyPtr = key;
-  this->keyExpansion(this->roundKey, key);
+  // the first round key is the key itself, so there is nothing to do if the key did not change
+  if(this->keyReady && (memcmp(this->key.roundKey, key, RADIOLIB_AES128_KEY_SIZE) == 0)) {
+    return;
+  }
+
+  RadioLibAES128::initKey(&this->key, key);
+  this->keyReady = true;
+
+  #if defined(RADIOLIB_AES128_T_TABLES)
+  this->roundKeyInvReady = false;
+  #endif
+}
+
+void RadioLibAES128::initKey(RadioLibAES128Key_t* ctx, uint8_t* key) {
+  #if defined(RADIOLIB_AES128_T_TABLES)
+  RadioLibAES128::generateTables();
+  #endif
+  RadioLibAES128::keyExpansion(ctx->roundKey, key);
+
+  // CMAC subkeys only depend on the key, so generate the first one now
+  uint8_t L[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
+  RadioLibAES128::cipher((state_t*)L, ctx->roundKey);
+  RadioLibAES128::nextSubkey(ctx->cmacKey1, L);
 }
 
 size_t RadioLibAES128::encryptECB(uint8_t* in, size_t len, uint8_t* out) {
+  return(RadioLibAES128::encryptECB(&this->key, in, len, out));
+}
+
+size_t RadioLibAES128::encryptECB(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* out) {
   size_t num_blocks = len / RADIOLIB_AES128_BLOCK_SIZE;
   if(len % RADIOLIB_AES128_BLOCK_SIZE) {
     num_blocks++;
@@ -21,7 +63,7 @@ size_t RadioLibAES128::encryptECB(uint8_t* in, size_t len, uint8_t* out) {
   memcpy(out, in, len);
 
   for(size_t i = 0; i < num_blocks; i++) {
-    this->cipher((state_t*)(out + (RADIOLIB_AES128_BLOCK_SIZE * i)), this->roundKey);
+    RadioLibAES128::cipher((state_t*)(out + (RADIOLIB_AES128_BLOCK_SIZE * i)), ctx->roundKey);
   }
 
   return(num_blocks*RADIOLIB_AES128_BLOCK_SIZE);
@@ -36,50 +78,128 @@ size_t RadioLibAES128::decryptECB(uint8_t* in, size_t len, uint8_t* out) {
   memset(out, 0x00, RADIOLIB_AES128_BLOCK_SIZE * num_blocks);
   memcpy(out, in, len);
 
+  #if defined(RADIOLIB_AES128_T_TABLES)
+  if(!this->roundKeyInvReady) {
+    RadioLibAES128::invKeyExpansion(this->roundKeyInv, this->key.roundKey);
+    this->roundKeyInvReady = true;
+  }
+  uint8_t* decKey = this->roundKeyInv;
+  #else
+  uint8_t* decKey = this->key.roundKey;
+  #endif
+
   for(size_t i = 0; i < num_blocks; i++) {
-    this->decipher((state_t*)(out + (RADIOLIB_AES128_BLOCK_SIZE * i)), this->roundKey);
+    RadioLibAES128::decipher((state_t*)(out + (RADIOLIB_AES128_BLOCK_SIZE * i)), decKey);
   }
 
   return(num_blocks*RADIOLIB_AES128_BLOCK_SIZE);
 }
 
+size_t RadioLibAES128::encryptCTR(uint8_t* in, size_t len, uint8_t* ctr, uint8_t* out) {
+  return(RadioLibAES128::encryptCTR(&this->key, in, len, ctr, out));
+}
+
+size_t RadioLibAES128::encryptCTR(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* ctr, uint8_t* out) {
+  uint8_t keystream[RADIOLIB_AES128_BLOCK_SIZE];
+  for(size_t i = 0; i < len; i += RADIOLIB_AES128_BLOCK_SIZE) {
+    memcpy(keystream, ctr, RADIOLIB_AES128_BLOCK_SIZE);
+    RadioLibAES128::cipher((state_t*)keystream, ctx->roundKey);
+
+    size_t blockLen = len - i;
+    if(blockLen > RADIOLIB_AES128_BLOCK_SIZE) {
+      blockLen = RADIOLIB_AES128_BLOCK_SIZE;
+    }
+    for(size_t j = 0; j < blockLen; j++) {
+      out[i + j] = in[i + j] ^ keystream[j];
+    }
+
+    // increment the counter block
+    for(int8_t j = RADIOLIB_AES128_BLOCK_SIZE - 1; j >= 0; j--) {
+      if(++ctr[j] != 0) {
+        break;
+      }
+    }
+  }
+
+  return(len);
+}
+
 void RadioLibAES128::generateCMAC(uint8_t* in, size_t len, uint8_t* cmac) {
-  uint8_t key1[RADIOLIB_AES128_BLOCK_SIZE];
-  uint8_t key2[RADIOLIB_AES128_BLOCK_SIZE];
-  this->generateSubkeys(key1, key2);
+  RadioLibAES128::generateCMAC(&this->key, in, len, cmac);
+}
 
-  size_t num_blocks = len / RADIOLIB_AES128_BLOCK_SIZE;
-  bool flag = true;
-  if(len % RADIOLIB_AES128_BLOCK_SIZE) {
-    num_blocks++;
-    flag = false;
+void RadioLibAES128::generateCMAC(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* cmac) {
+  uint8_t state[RADIOLIB_AES128_BLOCK_SIZE] = { 0 };
+
+  // all blocks except the last one are processed directly from the input
+  while(len > RADIOLIB_AES128_BLOCK_SIZE) {
+    RadioLibAES128::blockXor(state, state, in);
+    RadioLibAES128::cipher((state_t*)state, ctx->roundKey);
+    in += RADIOLIB_AES128_BLOCK_SIZE;
+    len -= RADIOLIB_AES128_BLOCK_SIZE;
   }
 
-  uint8_t* buff = new uint8_t[num_blocks * RADIOLIB_AES128_BLOCK_SIZE];
-  memset(buff, 0, num_blocks * RADIOLIB_AES128_BLOCK_SIZE);
-  memcpy(buff, in, len);
-  if (flag) {
-    this->blockXor(&buff[(num_blocks - 1)*RADIOLIB_AES128_BLOCK_SIZE], &buff[(num_blocks - 1)*RADIOLIB_AES128_BLOCK_SIZE], key1);
-  } else {
-    buff[len] = 0x80;
-    this->blockXor(&buff[(num_blocks - 1)*RADIOLIB_AES128_BLOCK_SIZE], &buff[(num_blocks - 1)*RADIOLIB_AES128_BLOCK_SIZE], key2);
+  uint8_t last[RADIOLIB_AES128_BLOCK_SIZE];
+  if(len > 0) {
+    memcpy(last, in, len);
   }
+  RadioLibAES128::finishCMAC(ctx, state, last, len, cmac);
+}
 
-  uint8_t X[] = {
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00
-  };
-  uint8_t Y[RADIOLIB_AES128_BLOCK_SIZE];
+void RadioLibAES128::cmacInit() {
+  memset(this->cmacState, 0x00, RADIOLIB_AES128_BLOCK_SIZE);
+  this->cmacBuffLen = 0;
+}
+
+void RadioLibAES128::cmacUpdate(uint8_t* in, size_t len) {
+  while(len > 0) {
+    // the last block is treated differently, so a full buffer is only processed once more data arrives
+    if(this->cmacBuffLen == RADIOLIB_AES128_BLOCK_SIZE) {
+      RadioLibAES128::blockXor(this->cmacState, this->cmacState, this->cmacBuff);
+      RadioLibAES128::cipher((state_t*)this->cmacState, this->key.roundKey);
+      this->cmacBuffLen = 0;
+    }
+
+    // process complete blocks directly from the input, without copying them to the buffer
+    while((this->cmacBuffLen == 0) && (len > RADIOLIB_AES128_BLOCK_SIZE)) {
+      RadioLibAES128::blockXor(this->cmacState, this->cmacState, in);
+      RadioLibAES128::cipher((state_t*)this->cmacState, this->key.roundKey);
+      in += RADIOLIB_AES128_BLOCK_SIZE;
+      len -= RADIOLIB_AES128_BLOCK_SIZE;
+    }
 
-  for(size_t i = 0; i < num_blocks - 1; i++) {
-    this->blockXor(Y, &buff[i*RADIOLIB_AES128_BLOCK_SIZE], X);
-    this->encryptECB(Y, RADIOLIB_AES128_BLOCK_SIZE, X);
+    size_t copyLen = RADIOLIB_AES128_BLOCK_SIZE - this->cmacBuffLen;
+    if(copyLen > len) {
+      copyLen = len;
+    }
+    memcpy(&this->cmacBuff[this->cmacBuffLen], in, copyLen);
+    this->cmacBuffLen += copyLen;
+    in += copyLen;
+    len -= copyLen;
   }
-  this->blockXor(Y, &buff[(num_blocks - 1)*RADIOLIB_AES128_BLOCK_SIZE], X);
-  this->encryptECB(Y, RADIOLIB_AES128_BLOCK_SIZE, cmac);
-  delete[] buff;
+}
+
+void RadioLibAES128::cmacFinal(uint8_t* cmac) {
+  RadioLibAES128::finishCMAC(&this->key, this->cmacState, this->cmacBuff, this->cmacBuffLen, cmac);
+  this->cmacBuffLen = 0;
+}
+
+void RadioLibAES128::finishCMAC(const RadioLibAES128Key_t* ctx, uint8_t* state, uint8_t* last, size_t lastLen, uint8_t* cmac) {
+  if(lastLen == RADIOLIB_AES128_BLOCK_SIZE) {
+    // complete last block
+    RadioLibAES128::blockXor(last, last, ctx->cmacKey1);
+  } else {
+    // incomplete last block, pad it and use the second subkey
+    last[lastLen] = 0x80;
+    memset(&last[lastLen + 1], 0x00, RADIOLIB_AES128_BLOCK_SIZE - lastLen - 1);
+    uint8_t cmacKey2[RADIOLIB_AES128_BLOCK_SIZE];
+    RadioLibAES128::nextSubkey(cmacKey2, ctx->cmacKey1);
+    RadioLibAES128::blockXor(last, last, cmacKey2);
+  }
+
+  RadioLibAES128::blockXor(state, state, last);
+  RadioLibAES128::cipher((state_t*)state, ctx->roundKey);
+  memcpy(cmac, state, RADIOLIB_AES128_BLOCK_SIZE);
 }
 
 bool RadioLibAES128::verifyCMAC(uint8_t* in, size_t len, uint8_t* cmac) {
@@ -93,7 +213,7 @@ bool RadioLibAES128::verifyCMAC(uint8_t* in, size_t len, uint8_t* cmac) {
   return(true);
 }
 
-void RadioLibAES128::keyExpansion(uint8_t* roundKey, uint8_t* key) {
+void RadioLibAES128::keyExpansion(uint8_t* roundKey, const uint8_t* key) {
   uint8_t tmp[4];
 
   // the first round key is the key itself
@@ -111,8 +231,8 @@ void RadioLibAES128::keyExpansion(uint8_t* roundKey, uint8_t* key) {
     }
 
     if(i % RADIOLIB_AES128_N_K == 0) {
-      this->rotWord(tmp);
-      this->subWord(tmp);
+      RadioLibAES128::rotWord(tmp);
+      RadioLibAES128::subWord(tmp);
       tmp[0] = tmp[0] ^ aesRcon[i/RADIOLIB_AES128_N_K];
     }
 
@@ -124,34 +244,135 @@ void RadioLibAES128::keyExpansion(uint8_t* roundKey, uint8_t* key) {
   }
 }
 
-void RadioLibAES128::cipher(state_t* state, uint8_t* roundKey) {
-  this->addRoundKey(0, state, roundKey);
+#if defined(RADIOLIB_AES128_T_TABLES)
+void RadioLibAES128::generateTables() {
+  if(aesTablesReady) {
+    return;
+  }
+
+  for(uint16_t i = 0; i < 256; i++) {
+    // column (2, 1, 1, 3) * S[i] for encryption, (14, 9, 13, 11) * InvS[i] for decryption
+    uint8_t s = RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[i]);
+    aesTe[i] = ((uint32_t)RadioLibAES128::mul(0x02, s) << 24) | ((uint32_t)s << 16) | ((uint32_t)s << 8) | (uint32_t)RadioLibAES128::mul(0x03, s);
+    s = RADIOLIB_NONVOLATILE_READ_BYTE(&aesSboxInv[i]);
+    aesTd[i] = ((uint32_t)RadioLibAES128::mul(0x0e, s) << 24) | ((uint32_t)RadioLibAES128::mul(0x09, s) << 16) | ((uint32_t)RadioLibAES128::mul(0x0d, s) << 8) | (uint32_t)RadioLibAES128::mul(0x0b, s);
+  }
+  aesTablesReady = true;
+}
+
+void RadioLibAES128::invKeyExpansion(uint8_t* roundKeyInv, const uint8_t* roundKey) {
+  // equivalent inverse cipher needs InvMixColumns applied to all round keys except the first and the last one
+  // Td(S(x)) is InvMixColumns of a single byte, since InvSubBytes cancels out SubBytes
+  for(uint8_t i = 0; i < RADIOLIB_AES128_N_B * (RADIOLIB_AES128_N_R + 1); i++) {
+    uint32_t w = RADIOLIB_AES128_GET_WORD(&roundKey[4*i]);
+    if((i >= RADIOLIB_AES128_N_B) && (i < RADIOLIB_AES128_N_B * RADIOLIB_AES128_N_R)) {
+      uint32_t t0 = aesTd[RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[w >> 24])];
+      uint32_t t1 = aesTd[RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[(w >> 16) & 0xFF])];
+      uint32_t t2 = aesTd[RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[(w >> 8) & 0xFF])];
+      uint32_t t3 = aesTd[RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[w & 0xFF])];
+      w = t0 ^ RADIOLIB_AES128_ROR(t1, 8) ^ RADIOLIB_AES128_ROR(t2, 16) ^ RADIOLIB_AES128_ROR(t3, 24);
+    }
+    RADIOLIB_AES128_SET_WORD(&roundKeyInv[4*i], w);
+  }
+}
+
+void RadioLibAES128::cipher(state_t* state, const uint8_t* roundKey) {
+  uint8_t* buff = (uint8_t*)state;
+  uint32_t s[4];
+  uint32_t t[4];
+
+  // initial round key
+  for(uint8_t c = 0; c < 4; c++) {
+    s[c] = RADIOLIB_AES128_GET_WORD(&buff[4*c]) ^ RADIOLIB_AES128_GET_WORD(&roundKey[4*c]);
+  }
+
+  // SubBytes, ShiftRows, MixColumns and AddRoundKey in one step per column
+  for(uint8_t round = 1; round < RADIOLIB_AES128_N_R; round++) {
+    for(uint8_t c = 0; c < 4; c++) {
+      t[c] = aesTe[s[c] >> 24] ^
+             RADIOLIB_AES128_ROR(aesTe[(s[(c + 1) % 4] >> 16) & 0xFF], 8) ^
+             RADIOLIB_AES128_ROR(aesTe[(s[(c + 2) % 4] >> 8) & 0xFF], 16) ^
+             RADIOLIB_AES128_ROR(aesTe[s[(c + 3) % 4] & 0xFF], 24) ^
+             RADIOLIB_AES128_GET_WORD(&roundKey[16*round + 4*c]);
+    }
+    memcpy(s, t, sizeof(s));
+  }
+
+  // final round without MixColumns
+  for(uint8_t c = 0; c < 4; c++) {
+    t[c] = ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[s[c] >> 24]) << 24) |
+           ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[(s[(c + 1) % 4] >> 16) & 0xFF]) << 16) |
+           ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[(s[(c + 2) % 4] >> 8) & 0xFF]) << 8) |
+           (uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSbox[s[(c + 3) % 4] & 0xFF]);
+    t[c] ^= RADIOLIB_AES128_GET_WORD(&roundKey[16*RADIOLIB_AES128_N_R + 4*c]);
+    RADIOLIB_AES128_SET_WORD(&buff[4*c], t[c]);
+  }
+}
+
+void RadioLibAES128::decipher(state_t* state, const uint8_t* roundKey) {
+  // the round keys must be those of the equivalent inverse cipher, see invKeyExpansion
+  uint8_t* buff = (uint8_t*)state;
+  uint32_t s[4];
+  uint32_t t[4];
+
+  // initial round key
+  for(uint8_t c = 0; c < 4; c++) {
+    s[c] = RADIOLIB_AES128_GET_WORD(&buff[4*c]) ^ RADIOLIB_AES128_GET_WORD(&roundKey[16*RADIOLIB_AES128_N_R + 4*c]);
+  }
+
+  // InvSubBytes, InvShiftRows, InvMixColumns and AddRoundKey in one step per column
+  for(uint8_t round = RADIOLIB_AES128_N_R - 1; round > 0; round--) {
+    for(uint8_t c = 0; c < 4; c++) {
+      t[c] = aesTd[s[c] >> 24] ^
+             RADIOLIB_AES128_ROR(aesTd[(s[(c + 3) % 4] >> 16) & 0xFF], 8) ^
+             RADIOLIB_AES128_ROR(aesTd[(s[(c + 2) % 4] >> 8) & 0xFF], 16) ^
+             RADIOLIB_AES128_ROR(aesTd[s[(c + 1) % 4] & 0xFF], 24) ^
+             RADIOLIB_AES128_GET_WORD(&roundKey[16*round + 4*c]);
+    }
+    memcpy(s, t, sizeof(s));
+  }
+
+  // final round without InvMixColumns
+  for(uint8_t c = 0; c < 4; c++) {
+    t[c] = ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSboxInv[s[c] >> 24]) << 24) |
+           ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSboxInv[(s[(c + 3) % 4] >> 16) & 0xFF]) << 16) |
+           ((uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSboxInv[(s[(c + 2) % 4] >> 8) & 0xFF]) << 8) |
+           (uint32_t)RADIOLIB_NONVOLATILE_READ_BYTE(&aesSboxInv[s[(c + 1) % 4] & 0xFF]);
+    t[c] ^= RADIOLIB_AES128_GET_WORD(&roundKey[4*c]);
+    RADIOLIB_AES128_SET_WORD(&buff[4*c], t[c]);
+  }
+}
+
+#else
+void RadioLibAES128::cipher(state_t* state, const uint8_t* roundKey) {
+  RadioLibAES128::addRoundKey(0, state, roundKey);
   for(uint8_t round = 1; round < RADIOLIB_AES128_N_R; round++) {
-    this->subBytes(state, aesSbox);
-    this->shiftRows(state, false);
-    this->mixColumns(state, false);
-    this->addRoundKey(round, state, roundKey);
+    RadioLibAES128::subBytes(state, aesSbox);
+    RadioLibAES128::shiftRows(state, false);
+    RadioLibAES128::mixColumns(state, false);
+    RadioLibAES128::addRoundKey(round, state, roundKey);
   }
 
-  this->subBytes(state, aesSbox);
-  this->shiftRows(state, false);
-  this->addRoundKey(RADIOLIB_AES128_N_R, state, roundKey);
+  RadioLibAES128::subBytes(state, aesSbox);
+  RadioLibAES128::shiftRows(state, false);
+  RadioLibAES128::addRoundKey(RADIOLIB_AES128_N_R, state, roundKey);
 }
 
 
-void RadioLibAES128::decipher(state_t* state, uint8_t* roundKey) {
-  this->addRoundKey(RADIOLIB_AES128_N_R, state, roundKey);
+void RadioLibAES128::decipher(state_t* state, const uint8_t* roundKey) {
+  RadioLibAES128::addRoundKey(RADIOLIB_AES128_N_R, state, roundKey);
   for(uint8_t round = RADIOLIB_AES128_N_R - 1; round > 0; --round) {
-    this->shiftRows(state, true);
-    this->subBytes(state, aesSboxInv);
-    this->addRoundKey(round, state, roundKey);
-    this->mixColumns(state, true);
+    RadioLibAES128::shiftRows(state, true);
+    RadioLibAES128::subBytes(state, aesSboxInv);
+    RadioLibAES128::addRoundKey(round, state, roundKey);
+    RadioLibAES128::mixColumns(state, true);
   }
 
-  this->shiftRows(state, true);
-  this->subBytes(state, aesSboxInv);
-  this->addRoundKey(0, state, roundKey);
+  RadioLibAES128::shiftRows(state, true);
+  RadioLibAES128::subBytes(state, aesSboxInv);
+  RadioLibAES128::addRoundKey(0, state, roundKey);
 }
+#endif
 
 void RadioLibAES128::subWord(uint8_t* word) {
   for(size_t i = 0; i < 4; i++) {
@@ -167,7 +388,7 @@ void RadioLibAES128::rotWord(uint8_t* word) {
   }
 }
 
-void RadioLibAES128::addRoundKey(uint8_t round, state_t* state, uint8_t* roundKey) {
+void RadioLibAES128::addRoundKey(uint8_t round, state_t* state, const uint8_t* roundKey) {
   for(size_t row = 0; row < 4; row++) {
     for(size_t col = 0; col < 4; col++) {
       (*state)[row][col] ^= roundKey[(round * RADIOLIB_AES128_N_B * 4) + (row * RADIOLIB_AES128_N_B) + col];
@@ -175,46 +396,22 @@ void RadioLibAES128::addRoundKey(uint8_t round, state_t* state, uint8_t* roundKe
   }
 }
 
-void RadioLibAES128::blockXor(uint8_t* dst, uint8_t* a, uint8_t* b) {
+void RadioLibAES128::blockXor(uint8_t* dst, const uint8_t* a, const uint8_t* b) {
   for(uint8_t j = 0; j < RADIOLIB_AES128_BLOCK_SIZE; j++) {
     dst[j] = a[j] ^ b[j];
   }
 }
 
-void RadioLibAES128::blockLeftshift(uint8_t* dst, uint8_t* src) {
+void RadioLibAES128::nextSubkey(uint8_t* dst, const uint8_t* src) {
+  // multiplication by x in GF(2^128), see RFC 4493 section 2.3
   uint8_t ovf = 0x00;
   for(int8_t i = RADIOLIB_AES128_BLOCK_SIZE - 1; i >= 0; i--) {
-    dst[i] = src[i] << 1;
-    dst[i] |= ovf;
-    ovf = (src[i] & 0x80) ? 1 : 0;
-  }
-}
-
-void RadioLibAES128::generateSubkeys(uint8_t* key1, uint8_t* key2) {
-  uint8_t const_Zero[] = {
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00
-  };
-
-  uint8_t const_Rb[] = {
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x00,
-    0x00, 0x00, 0x00, 0x87
-  };
-
-  uint8_t L[RADIOLIB_AES128_BLOCK_SIZE];
-  this->encryptECB(const_Zero, RADIOLIB_AES128_BLOCK_SIZE, L);
-  this->blockLeftshift(key1, L);
-  if(L[0] & 0x80) {
-    this->blockXor(key1, key1, const_Rb);
+    uint8_t msb = src[i] >> 7;
+    dst[i] = (src[i] << 1) | ovf;
+    ovf = msb;
   }
-
-  this->blockLeftshift(key2, key1);
-  if(key1[0] & 0x80) {
-    this->blockXor(key2, key2, const_Rb);
+  if(ovf) {
+    dst[RADIOLIB_AES128_BLOCK_SIZE - 1] ^= 0x87;
   }
 }
 
@@ -88,10 +88,25 @@ static const uint8_t aesSboxInv[] RADIOLIB_NONVOLATILE = {
 
 static const uint8_t aesRcon[] = { 0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
 
+/*!
+  \struct RadioLibAES128Key_t
+  \brief Expanded AES-128 key for the operations that only use the forward cipher (ECB encryption, CTR and CMAC).
+  It is much smaller than a RadioLibAES128 object, so that keys used repeatedly can be kept expanded.
+  Initialize it with RadioLibAES128::initKey.
+*/
+struct RadioLibAES128Key_t {
+  /*! \brief Round keys. */
+  uint8_t roundKey[RADIOLIB_AES128_KEY_EXP_SIZE];
+
+  /*! \brief First CMAC subkey, the second one is derived from it when needed. */
+  uint8_t cmacKey1[RADIOLIB_AES128_BLOCK_SIZE];
+};
+
 /*!
   \class RadioLibAES128
   Most of the implementation here is adapted from https://github.com/kokke/tiny-AES-c
   Additional code and CMAC calculation is from https://github.com/megrxu/AES-CMAC
+  When RADIOLIB_AES128_T_TABLES is defined, the block cipher uses 32-bit T-tables instead.
   \brief Class to perform AES encryption, decryption and CMAC.
 */
 class RadioLibAES128 {
@@ -127,6 +142,17 @@ class RadioLibAES128 {
     */
     size_t decryptECB(uint8_t* in, size_t len, uint8_t* out);
 
+    /*!
+      \brief Perform CTR-type AES encryption. Since CTR is symmetric, the same method is used for decryption.
+      \param in Input data (unpadded).
+      \param len Length of the input data.
+      \param ctr 16-byte initial counter block. It is incremented as a 128-bit big-endian integer
+      after each processed block, so a subsequent call continues the keystream.
+      \param out Buffer to save the output into, at least len bytes long. May be the same as the input buffer.
+      \returns The number of bytes saved into the output buffer.
+    */
+    size_t encryptCTR(uint8_t* in, size_t len, uint8_t* ctr, uint8_t* out);
+
     /*!
       \brief Calculate message authentication code according to RFC4493.
       \param in Input data (unpadded).
@@ -135,6 +161,24 @@ class RadioLibAES128 {
     */
     void generateCMAC(uint8_t* in, size_t len, uint8_t* cmac);
 
+    /*!
+      \brief Start incremental CMAC calculation with the current key.
+    */
+    void cmacInit();
+
+    /*!
+      \brief Feed more data into incremental CMAC calculation.
+      \param in Input data (unpadded), may be split into chunks of arbitrary length.
+      \param len Length of the input data.
+    */
+    void cmacUpdate(uint8_t* in, size_t len);
+
+    /*!
+      \brief Finish incremental CMAC calculation.
+      \param cmac Buffer to save the output MAC into. The buffer must be at least 16 bytes long!
+    */
+    void cmacFinal(uint8_t* cmac);
+
     /*!
       \brief Verify the received CMAC. This just calculates the CMAC again and compares the results.
       \param in Input data (unpadded).
@@ -143,29 +187,80 @@ class RadioLibAES128 {
       \returns True if valid, false otherwise.
     */
     bool verifyCMAC(uint8_t* in, size_t len, uint8_t* cmac);
+
+    /*!
+      \brief Expand a key into a compact key context, without using any RadioLibAES128 object.
+      \param ctx Key context to initialize.
+      \param key AES key to expand.
+    */
+    static void initKey(RadioLibAES128Key_t* ctx, uint8_t* key);
+
+    /*!
+      \brief Perform ECB-type AES encryption with an expanded key.
+      \param ctx Key context initialized by initKey.
+      \param in Input plaintext data (unpadded).
+      \param len Length of the input data.
+      \param out Buffer to save the output ciphertext into, see encryptECB(uint8_t*, size_t, uint8_t*).
+      \returns The number of bytes saved into the output buffer.
+    */
+    static size_t encryptECB(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* out);
+
+    /*!
+      \brief Perform CTR-type AES encryption or decryption with an expanded key.
+      \param ctx Key context initialized by initKey.
+      \param in Input data (unpadded).
+      \param len Length of the input data.
+      \param ctr 16-byte initial counter block, incremented in the same way as by encryptCTR(uint8_t*, size_t, uint8_t*, uint8_t*).
+      \param out Buffer to save the output into, may be the same as the input buffer.
+      \returns The number of bytes saved into the output buffer.
+    */
+    static size_t encryptCTR(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* ctr, uint8_t* out);
+
+    /*!
+      \brief Calculate message authentication code according to RFC4493 with an expanded key.
+      \param ctx Key context initialized by initKey.
+      \param in Input data (unpadded).
+      \param len Length of the input data.
+      \param cmac Buffer to save the output MAC into. The buffer must be at least 16 bytes long!
+    */
+    static void generateCMAC(const RadioLibAES128Key_t* ctx, uint8_t* in, size_t len, uint8_t* cmac);
   
   private:
-    uint8_t* keyPtr;
-    uint8_t roundKey[RADIOLIB_AES128_KEY_EXP_SIZE];
+    RadioLibAES128Key_t key;
+    bool keyReady = false;
+
+    // incremental CMAC state
+    uint8_t cmacState[RADIOLIB_AES128_BLOCK_SIZE];
+    uint8_t cmacBuff[RADIOLIB_AES128_BLOCK_SIZE];
+    size_t cmacBuffLen = 0;
+
+    #if defined(RADIOLIB_AES128_T_TABLES)
+    // round keys for the equivalent inverse cipher, derived on first decryption with the current key
+    uint8_t roundKeyInv[RADIOLIB_AES128_KEY_EXP_SIZE];
+    bool roundKeyInvReady = false;
+
+    static void generateTables();
+    static void invKeyExpansion(uint8_t* roundKeyInv, const uint8_t* roundKey);
+    #endif
 
-    void keyExpansion(uint8_t* roundKey, uint8_t* key);
-    void cipher(state_t* state, uint8_t* roundKey);
-    void decipher(state_t* state, uint8_t* roundKey);
+    static void keyExpansion(uint8_t* roundKey, const uint8_t* key);
+    static void cipher(state_t* state, const uint8_t* roundKey);
+    static void decipher(state_t* state, const uint8_t* roundKey);
 
-    void subWord(uint8_t* word);
-    void rotWord(uint8_t* word);
+    static void subWord(uint8_t* word);
+    static void rotWord(uint8_t* word);
 
-    void addRoundKey(uint8_t round, state_t* state, uint8_t* roundKey);
+    static void addRoundKey(uint8_t round, state_t* state, const uint8_t* roundKey);
 
-    void blockXor(uint8_t* dst, uint8_t* a, uint8_t* b);
-    void blockLeftshift(uint8_t* dst, uint8_t* src);
-    void generateSubkeys(uint8_t* key1, uint8_t* key2);
+    static void blockXor(uint8_t* dst, const uint8_t* a, const uint8_t* b);
+    static void nextSubkey(uint8_t* dst, const uint8_t* src);
+    static void finishCMAC(const RadioLibAES128Key_t* ctx, uint8_t* state, uint8_t* last, size_t lastLen, uint8_t* cmac);
 
-    void subBytes(state_t* state, const uint8_t* box);
-    void shiftRows(state_t* state, bool inv);
-    void mixColumns(state_t* state, bool inv);
+    static void subBytes(state_t* state, const uint8_t* box);
+    static void shiftRows(state_t* state, bool inv);
+    static void mixColumns(state_t* state, bool inv);
 
-    uint8_t mul(uint8_t a, uint8_t b);
+    static uint8_t mul(uint8_t a, uint8_t b);
 };
 
 // the global singleton
@@ -5,19 +5,35 @@ RadioLibBCH::RadioLibBCH() {
   
 }
 
+RadioLibBCH::~RadioLibBCH() {
+  #if !defined(RADIOLIB_STATIC_ONLY)
+  delete[] this->alphaTo;
+  delete[] this->indexOf;
+  #endif
+}
+
 /*
   BCH Encoder based on https://www.codeproject.com/articles/13189/pocsag-encoder
 
   Significantly cleaned up and slightly fixed.
 */
 void RadioLibBCH::begin(uint8_t n, uint8_t k, uint32_t poly) {
+  // nothing to do if the tables were already generated for this code
+  if((this->n == n) && (this->k == k) && (this->poly == poly)) {
+    return;
+  }
+
   this->n = n;
   this->k = k;
   this->poly = poly;
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  this->alphaTo = new int32_t[n + 1];
-  this->indexOf = new int32_t[n + 1];
-  this->generator = new int32_t[n - k + 1];
+  #if defined(RADIOLIB_STATIC_ONLY)
+    int32_t generator[RADIOLIB_BCH_MAX_N - RADIOLIB_BCH_MAX_K + 1];
+  #else
+    delete[] this->alphaTo;
+    delete[] this->indexOf;
+    this->alphaTo = new int32_t[n + 1];
+    this->indexOf = new int32_t[n + 1];
+    int32_t* generator = new int32_t[n - k + 1];
   #endif
 
   // find the maximum power of the polynomial
@@ -158,136 +174,147 @@ void RadioLibBCH::begin(uint8_t n, uint8_t k, uint32_t poly) {
   #endif
 
 	// Compute generator polynomial
-	this->generator[0] = this->alphaTo[zeros[1]];
-	this->generator[1] = 1;		// g(x) = (X + zeros[1]) initially
+	generator[0] = this->alphaTo[zeros[1]];
+	generator[1] = 1;		// g(x) = (X + zeros[1]) initially
 
 	for(ii = 2; ii <= rdncy; ii++) {
-	  this->generator[ii] = 1;
+	  generator[ii] = 1;
 	  for(jj = ii - 1; jj > 0; jj--) {
-      if(this->generator[jj] != 0) {
-        this->generator[jj] = this->generator[jj - 1] ^ this->alphaTo[(this->indexOf[this->generator[jj]] + zeros[ii]) % this->n];
+      if(generator[jj] != 0) {
+        generator[jj] = generator[jj - 1] ^ this->alphaTo[(this->indexOf[generator[jj]] + zeros[ii]) % this->n];
       } else {
-        this->generator[jj] = this->generator[jj - 1];
+        generator[jj] = generator[jj - 1];
       }
     }
-		this->generator[0] = this->alphaTo[(this->indexOf[this->generator[0]] + zeros[ii]) % this->n];
+		generator[0] = this->alphaTo[(this->indexOf[generator[0]] + zeros[ii]) % this->n];
 	}
 
+  // pack the generator polynomial into a single word, for polynomial division
+  this->generatorPoly = 0;
+  for(ii = 0; ii <= rdncy; ii++) {
+    if(generator[ii]) {
+      this->generatorPoly |= ((uint32_t)1 << ii);
+    }
+  }
+
   #if !defined(RADIOLIB_STATIC_ONLY)
   delete[] zeros;
+  delete[] generator;
   #endif
 }
 
-/*
-  BCH Encoder based on https://www.codeproject.com/articles/13189/pocsag-encoder
-
-  Significantly cleaned up and slightly fixed.
-*/
 uint32_t RadioLibBCH::encode(uint32_t dataword) {
   // we only use the "k" most significant bits
-  #if defined(RADIOLIB_STATIC_ONLY)
-    int32_t data[RADIOLIB_BCH_MAX_K];
-  #else
-    int32_t* data = new int32_t[this->k];
-  #endif
-	int32_t j1 = 0;
-	for(int32_t i = this->n; i > (this->n - this->k); i--) {
-		if(dataword & ((uint32_t)1<<i)) {
-      data[j1++]=1;
-    } else {
-      data[j1++]=0;
-    }
-	}
+  uint8_t parityLen = this->n - this->k;
+  uint32_t data = (dataword >> (parityLen + 1)) & ((uint32_t)0xFFFFFFFF >> (32 - this->k));
 
-  // reset the M(x)+r array elements
-  #if defined(RADIOLIB_STATIC_ONLY)
-    int32_t Mr[RADIOLIB_BCH_MAX_N];
-  #else
-    int32_t* Mr = new int32_t[this->n];
-  #endif
-  memset(Mr, 0x00, this->n*sizeof(int32_t));
-
-  // copy the contents of data into Mr and add the zeros
-  memcpy(Mr, data, this->k*sizeof(int32_t));
-
-  int32_t j = 0;
-  int32_t start = 0;
-  int32_t end = this->n - this->k;
-  while(end < this->n) {
-    for(int32_t i = end; i > start-2; --i) {
-      if(Mr[start]) {
-        Mr[i] ^= this->generator[j];
-        ++j;
-      } else {
-        ++start;
-        j = 0;
-        end = start + this->n - this->k;
-        break;
+  // systematic code word - data followed by the remainder, and even parity in the lowest bit
+  uint32_t res = ((data << parityLen) | this->remainder(data)) << 1;
+  return(res | this->parity(res));
+}
+
+void RadioLibBCH::encode(const uint32_t* in, uint32_t* out, size_t len) {
+  for(size_t i = 0; i < len; i++) {
+    out[i] = this->encode(in[i]);
+  }
+}
+
+int16_t RadioLibBCH::decode(uint32_t* codeword) {
+  // the lowest bit is the even parity, code word polynomial starts at bit 1
+  uint32_t mask = (uint32_t)0xFFFFFFFF >> (32 - this->n);
+  uint32_t recd = (*codeword >> 1) & mask;
+
+  // calculate remainder after division by the generator polynomial
+  // this is the remainder of the data portion, with the received check bits added
+  uint8_t parityLen = this->n - this->k;
+  uint32_t rem = this->remainder(recd >> parityLen) ^ (recd & ((uint32_t)0xFFFFFFFF >> (32 - parityLen)));
+
+  uint8_t numErrors = 0;
+  if(rem != 0) {
+    // generator polynomial has roots alpha^1 and alpha^3, so the syndromes can be evaluated from the remainder
+    int32_t s1 = 0;
+    int32_t s3 = 0;
+    for(uint8_t i = 0; i < parityLen; i++) {
+      if(rem & ((uint32_t)1 << i)) {
+        s1 ^= this->alphaTo[i % this->n];
+        s3 ^= this->alphaTo[(3*i) % this->n];
       }
     }
-  }
 
-  #if defined(RADIOLIB_STATIC_ONLY)
-    int32_t bb[RADIOLIB_BCH_MAX_N - RADIOLIB_BCH_MAX_K + 1];
-  #else
-    int32_t* bb = new int32_t[this->n - this->k + 1];
-  #endif
-  j = 0;
-  for(int32_t i = start; i < end; ++i) {
-    bb[j] = Mr[i];
-    ++j;
-  }
+    // non-zero remainder with zero first syndrome means at least 3 errors
+    if(s1 == 0) {
+      return(RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD);
+    }
 
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  delete[] Mr;
-  #endif
+    int32_t s1Index = this->indexOf[s1];
+    int32_t s1Cube = this->alphaTo[(3*s1Index) % this->n];
+    if(s3 == s1Cube) {
+      // single error, its location is given directly by the first syndrome
+      recd ^= ((uint32_t)1 << s1Index);
+      numErrors = 1;
 
-	int32_t iEvenParity = 0;
-  #if defined(RADIOLIB_STATIC_ONLY)
-    int32_t recd[RADIOLIB_BCH_MAX_N + 1];
-  #else
-    int32_t* recd = new int32_t[this->n + 1];
-  #endif
-	for(uint8_t i = 0; i < this->k; i++) {
-		recd[this->n - i] = data[i];
-		if(data[i] == 1) {
-      iEvenParity++;
+    } else {
+      // two errors, error locator polynomial is x^2 + s1*x + (s3 + s1^3)/s1
+      int32_t sigma2Index = (this->indexOf[s3 ^ s1Cube] - s1Index + this->n) % this->n;
+      int32_t sigma2 = this->alphaTo[sigma2Index];
+
+      // find its roots by Chien search
+      uint32_t errorMask = 0;
+      for(uint8_t i = 0; i < this->n; i++) {
+        if((this->alphaTo[(2*i) % this->n] ^ this->alphaTo[(s1Index + i) % this->n] ^ sigma2) == 0) {
+          errorMask |= ((uint32_t)1 << i);
+          numErrors++;
+        }
+      }
+
+      if(numErrors != 2) {
+        return(RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD);
+      }
+      recd ^= errorMask;
     }
-	}
-  
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  delete[] data;
-  #endif
+  }
 
-	for(uint8_t i = 0; i < this->n - this->k + 1; i++) {
-		recd[this->n - this->k - i] = bb[i];
-		if(bb[i] == 1) {
-      iEvenParity++;
+  // check the even parity of the corrected code word
+  uint32_t res = (recd << 1) | (*codeword & 0x01);
+  if(this->parity(res)) {
+    // the parity bit itself is wrong, unless we already used up all correction capability
+    if(numErrors >= 2) {
+      return(RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD);
     }
-	}
-  
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  delete[] bb;
-  #endif
+    res ^= 0x01;
+    numErrors++;
+  }
+
+  *codeword = res;
+  return(numErrors);
+}
+
+uint32_t RadioLibBCH::remainder(uint32_t data) {
+  uint8_t parityLen = this->n - this->k;
 
-	if((iEvenParity % 2) == 0) {
-    recd[0] = 0;
-  } else {
-    recd[0] = 1;
+  // for the pager code, use the lookup table, at most 3 bytes are needed for the 21-bit data
+  if((parityLen == RADIOLIB_PAGER_BCH_N - RADIOLIB_PAGER_BCH_K) && (this->generatorPoly == RADIOLIB_PAGER_BCH_GENERATOR_POLY) && (this->k <= 24)) {
+    uint8_t buff[] = { (uint8_t)(data >> 16), (uint8_t)(data >> 8), (uint8_t)data };
+    return(RadioLibBCHPagerRemainder::checksum(buff, sizeof(buff)));
   }
 
-  int32_t res = 0;
-	for(int32_t i = 0; i < this->n + 1; i++) {
-		if(recd[i]) {
-      res |= ((uint32_t)1<<i);
+  // otherwise do the polynomial division bit-by-bit
+  uint32_t rem = data << parityLen;
+  for(int8_t i = this->n - 1; i >= parityLen; i--) {
+    if(rem & ((uint32_t)1 << i)) {
+      rem ^= this->generatorPoly << (i - parityLen);
     }
-	}
-
-  #if !defined(RADIOLIB_STATIC_ONLY)
-  delete[] recd;
-  #endif
+  }
+  return(rem);
+}
 
-	return(res);
+uint32_t RadioLibBCH::parity(uint32_t word) {
+  word ^= word >> 16;
+  word ^= word >> 8;
+  word ^= word >> 4;
+  word ^= word >> 2;
+  word ^= word >> 1;
+  return(word & 0x01);
 }
 
 RadioLibBCH RadioLibBCHInstance;
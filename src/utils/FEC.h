@@ -6,12 +6,23 @@
 #if defined(RADIOLIB_BUILD_ARDUINO)
 #include "../ArduinoHal.h"
 #endif
+#include "CRC.h"
 
 // BCH(31, 21) code constants
 #define RADIOLIB_PAGER_BCH_N                                    (31)
 #define RADIOLIB_PAGER_BCH_K                                    (21)
 #define RADIOLIB_PAGER_BCH_PRIMITIVE_POLY                       (0x25)
 
+// BCH(31, 21) generator polynomial x^10 + x^9 + x^8 + x^6 + x^5 + x^3 + 1
+#define RADIOLIB_PAGER_BCH_GENERATOR_POLY                       (0x769)
+
+/*!
+  \brief Remainder of division by the BCH(31, 21) generator polynomial, calculated byte-wise
+  using a lookup table generated at compile time. This is the same as a 10-bit CRC,
+  with the generator polynomial (without the x^10 term) as the CRC polynomial.
+*/
+typedef RadioLibCRCDescriptor<RADIOLIB_PAGER_BCH_N - RADIOLIB_PAGER_BCH_K, RADIOLIB_PAGER_BCH_GENERATOR_POLY & 0x3FF, 0, 0, false, false> RadioLibBCHPagerRemainder;
+
 #if defined(RADIOLIB_STATIC_ONLY)
 #define RADIOLIB_BCH_MAX_N                                      (63)
 #define RADIOLIB_BCH_MAX_K                                      (31)
@@ -31,8 +42,13 @@ class RadioLibBCH {
     RadioLibBCH();
 
     /*!
-      \brief Initialization method.
-      \param n Code word length in bits, up to 32.
+      \brief Default destructor.
+    */
+    ~RadioLibBCH();
+
+    /*!
+      \brief Initialization method. Lookup tables are only generated when the code parameters change.
+      \param n Code word length in bits, up to 31.
       \param k Data portion length in bits, up to "n".
       \param poly Powers of the irreducible polynomial.
     */
@@ -40,27 +56,51 @@ class RadioLibBCH {
 
     /*!
       \brief Encoding method - encodes one data word (without check bits) into a code word (with check bits).
+      For BCH(31, 21), the check bits are calculated using byte-wise table lookup,
+      other codes fall back to bit-by-bit polynomial division.
       \param dataword Data word without check bits. The caller is responsible to make sure the data is
       on the correct bit positions!
       \returns Code word with error check bits.
     */
     uint32_t encode(uint32_t dataword);
 
+    /*!
+      \brief Bulk encoding method - encodes a batch of data words in one pass.
+      \param in Data words without check bits. The caller is responsible to make sure the data is
+      on the correct bit positions!
+      \param out Buffer to save the code words into, may be the same as the input buffer.
+      \param len Number of data words to encode.
+    */
+    void encode(const uint32_t* in, uint32_t* out, size_t len);
+
+    /*!
+      \brief Decoding method - checks one code word (with check bits) and corrects up to 2 bit errors.
+      Errors in the BCH-protected bits are located using syndromes and Chien search,
+      the remaining error in the even parity bit (bit 0) is then fixed as well.
+      \param codeword Pointer to the code word, will be overwritten by the corrected code word.
+      The caller is responsible to make sure the data is on the same bit positions as returned by encode()!
+      \returns Number of corrected bit errors, or RADIOLIB_ERR_UNCORRECTABLE_CODE_WORD when too many errors were found.
+      In that case, the code word is left unchanged.
+    */
+    int16_t decode(uint32_t* codeword);
+
   private:
-    uint8_t n;
-    uint8_t k;
-    uint32_t poly;
+    uint8_t n = 0;
+    uint8_t k = 0;
+    uint32_t poly = 0;
     uint8_t m;
+    uint32_t generatorPoly;
     
     #if defined(RADIOLIB_STATIC_ONLY)
       int32_t alphaTo[RADIOLIB_BCH_MAX_N + 1];
       int32_t indexOf[RADIOLIB_BCH_MAX_N + 1];
-      int32_t generator[RADIOLIB_BCH_MAX_N - RADIOLIB_BCH_MAX_K + 1];
     #else
-      int32_t* alphaTo;
-      int32_t* indexOf;
-      int32_t* generator;
+      int32_t* alphaTo = nullptr;
+      int32_t* indexOf = nullptr;
     #endif
+
+    uint32_t remainder(uint32_t data);
+    uint32_t parity(uint32_t word);
 };
 
 // the global singleton
@@ -0,0 +1,158 @@
+#include "Journal.h"
+#include <string.h>
+
+RadioLibJournal::RadioLibJournal() {
+  for(uint8_t i = 0; i < RADIOLIB_JOURNAL_NUM_IDS; i++) {
+    this->values[i] = 0;
+    this->slots[i] = RADIOLIB_JOURNAL_SLOT_NONE;
+  }
+}
+
+void RadioLibJournal::begin(RadioLibHal* hal, uint32_t addr, size_t len) {
+  this->hal = hal;
+  this->addr = addr;
+  size_t numSlots = len / RADIOLIB_JOURNAL_RECORD_LEN;
+  if(numSlots > RADIOLIB_JOURNAL_MAX_RECORDS) {
+    numSlots = RADIOLIB_JOURNAL_MAX_RECORDS;
+  }
+  this->numSlots = numSlots;
+
+  // find the last reset of each counter, and the most recently written record
+  bool found = false;
+  uint16_t seqMax = 0;
+  uint8_t seqMaxSlot = 0;
+  bool reset[RADIOLIB_JOURNAL_NUM_IDS];
+  uint16_t resetSeq[RADIOLIB_JOURNAL_NUM_IDS];
+  for(uint8_t i = 0; i < RADIOLIB_JOURNAL_NUM_IDS; i++) {
+    this->values[i] = 0;
+    this->slots[i] = RADIOLIB_JOURNAL_SLOT_NONE;
+    reset[i] = false;
+    resetSeq[i] = 0;
+  }
+  for(uint8_t slot = 0; slot < this->numSlots; slot++) {
+    uint8_t id = 0;
+    uint32_t value = 0;
+    uint16_t seq = 0;
+    if(!this->readRecord(slot, &id, &value, &seq)) {
+      continue;
+    }
+
+    // sequence number wraps around, so compare the difference
+    if(id & RADIOLIB_JOURNAL_RECORD_RESET) {
+      id &= ~RADIOLIB_JOURNAL_RECORD_RESET;
+      if(!reset[id] || ((int16_t)(seq - resetSeq[id]) > 0)) {
+        reset[id] = true;
+        resetSeq[id] = seq;
+      }
+    }
+    if(!found || ((int16_t)(seq - seqMax) > 0)) {
+      found = true;
+      seqMax = seq;
+      seqMaxSlot = slot;
+    }
+  }
+
+  // find the newest value of each counter, records written before the last reset do not count
+  for(uint8_t slot = 0; slot < this->numSlots; slot++) {
+    uint8_t id = 0;
+    uint32_t value = 0;
+    uint16_t seq = 0;
+    if(!this->readRecord(slot, &id, &value, &seq) || (id & RADIOLIB_JOURNAL_RECORD_RESET)) {
+      continue;
+    }
+    if(reset[id] && ((int16_t)(seq - resetSeq[id]) < 0)) {
+      continue;
+    }
+
+    if((this->slots[id] == RADIOLIB_JOURNAL_SLOT_NONE) || (value >= this->values[id])) {
+      this->values[id] = value;
+      this->slots[id] = slot;
+    }
+  }
+
+  // continue right after the last record
+  this->seq = seqMax;
+  this->head = found ? (seqMaxSlot + 1) % this->numSlots : 0;
+}
+
+uint32_t RadioLibJournal::read(uint8_t id) {
+  if(id >= RADIOLIB_JOURNAL_NUM_IDS) {
+    return(0);
+  }
+  return(this->values[id]);
+}
+
+void RadioLibJournal::write(uint8_t id, uint32_t value) {
+  if(!this->hal || (id >= RADIOLIB_JOURNAL_NUM_IDS) || (this->numSlots <= RADIOLIB_JOURNAL_NUM_IDS)) {
+    return;
+  }
+
+  this->slots[id] = this->append(id, value);
+  this->values[id] = value;
+}
+
+void RadioLibJournal::reset(uint8_t id) {
+  if(!this->hal || (id >= RADIOLIB_JOURNAL_NUM_IDS) || (this->numSlots <= RADIOLIB_JOURNAL_NUM_IDS)) {
+    return;
+  }
+
+  // a single record, so that power loss can not leave only some of the old records invalidated
+  this->append(id | RADIOLIB_JOURNAL_RECORD_RESET, 0);
+  this->values[id] = 0;
+  this->slots[id] = RADIOLIB_JOURNAL_SLOT_NONE;
+}
+
+bool RadioLibJournal::readRecord(uint8_t slot, uint8_t* id, uint32_t* value, uint16_t* seq) {
+  uint8_t rec[RADIOLIB_JOURNAL_RECORD_LEN];
+  this->hal->readPersistentStorage(this->addr + slot*RADIOLIB_JOURNAL_RECORD_LEN, rec, RADIOLIB_JOURNAL_RECORD_LEN);
+
+  // erased or partially written records fail the check
+  uint8_t check = RadioLibJournalCRC::checksum(rec, RADIOLIB_JOURNAL_RECORD_CHECK_POS);
+  if((rec[RADIOLIB_JOURNAL_RECORD_CHECK_POS] != check) || ((rec[RADIOLIB_JOURNAL_RECORD_ID_POS] & ~RADIOLIB_JOURNAL_RECORD_RESET) >= RADIOLIB_JOURNAL_NUM_IDS)) {
+    return(false);
+  }
+
+  *id = rec[RADIOLIB_JOURNAL_RECORD_ID_POS];
+  *value = 0;
+  for(uint8_t i = 0; i < sizeof(uint32_t); i++) {
+    *value |= (uint32_t)rec[RADIOLIB_JOURNAL_RECORD_VALUE_POS + i] << (8*i);
+  }
+  *seq = (uint16_t)rec[RADIOLIB_JOURNAL_RECORD_SEQ_POS] | ((uint16_t)rec[RADIOLIB_JOURNAL_RECORD_SEQ_POS + 1] << 8);
+  return(true);
+}
+
+void RadioLibJournal::writeRecord(uint8_t slot, uint8_t id, uint32_t value, uint16_t seq) {
+  // the whole record is written at once
+  uint8_t rec[RADIOLIB_JOURNAL_RECORD_LEN];
+  rec[RADIOLIB_JOURNAL_RECORD_ID_POS] = id;
+  for(uint8_t i = 0; i < sizeof(uint32_t); i++) {
+    rec[RADIOLIB_JOURNAL_RECORD_VALUE_POS + i] = (uint8_t)(value >> (8*i));
+  }
+  rec[RADIOLIB_JOURNAL_RECORD_SEQ_POS] = (uint8_t)seq;
+  rec[RADIOLIB_JOURNAL_RECORD_SEQ_POS + 1] = (uint8_t)(seq >> 8);
+  rec[RADIOLIB_JOURNAL_RECORD_CHECK_POS] = RadioLibJournalCRC::checksum(rec, RADIOLIB_JOURNAL_RECORD_CHECK_POS);
+  this->hal->writePersistentStorage(this->addr + slot*RADIOLIB_JOURNAL_RECORD_LEN, rec, RADIOLIB_JOURNAL_RECORD_LEN);
+}
+
+uint8_t RadioLibJournal::append(uint8_t id, uint32_t value) {
+  // there is at least one free slot on top of those holding the newest values,
+  // skip those, so that an interrupted write never loses the newest value
+  uint8_t slot = this->head;
+  for(uint8_t i = 0; i < RADIOLIB_JOURNAL_NUM_IDS; i++) {
+    bool live = false;
+    for(uint8_t j = 0; j < RADIOLIB_JOURNAL_NUM_IDS; j++) {
+      if(this->slots[j] == slot) {
+        live = true;
+        break;
+      }
+    }
+    if(!live) {
+      break;
+    }
+    slot = (slot + 1) % this->numSlots;
+  }
+
+  this->writeRecord(slot, id, value, ++this->seq);
+  this->head = (slot + 1) % this->numSlots;
+  return(slot);
+}
@@ -0,0 +1,98 @@
+#if !defined(_RADIOLIB_JOURNAL_H)
+#define _RADIOLIB_JOURNAL_H
+
+#include "../TypeDef.h"
+#include "../Hal.h"
+#include "CRC.h"
+
+// journal record layout
+#define RADIOLIB_JOURNAL_RECORD_LEN                             (8)
+#define RADIOLIB_JOURNAL_RECORD_ID_POS                          (0)
+#define RADIOLIB_JOURNAL_RECORD_VALUE_POS                       (1)
+#define RADIOLIB_JOURNAL_RECORD_SEQ_POS                         (5)
+#define RADIOLIB_JOURNAL_RECORD_CHECK_POS                       (7)
+
+// flag in record ID marking a reset of the counter, older records of that counter are ignored
+#define RADIOLIB_JOURNAL_RECORD_RESET                           (0x80)
+
+// maximum number of records in the journal region
+#define RADIOLIB_JOURNAL_MAX_RECORDS                            (255)
+#define RADIOLIB_JOURNAL_SLOT_NONE                              (0xFF)
+
+// list of counters kept in the journal
+#define RADIOLIB_JOURNAL_ID_LORAWAN_FCNT_UP                     (0)
+#define RADIOLIB_JOURNAL_ID_LORAWAN_DEV_NONCE                   (1)
+#define RADIOLIB_JOURNAL_ID_LORAWAN_N_FCNT_DOWN                 (2)
+#define RADIOLIB_JOURNAL_ID_LORAWAN_A_FCNT_DOWN                 (3)
+#define RADIOLIB_JOURNAL_NUM_IDS                                (4)
+
+/*!
+  \brief CRC-8 used to validate journal records.
+*/
+typedef RadioLibCRCDescriptor<8, 0x07, 0xFF, 0x00, false, false> RadioLibJournalCRC;
+
+/*!
+  \class RadioLibJournal
+  \brief Log-structured storage of monotonic counters in persistent storage.
+  Every update is appended as a new record instead of overwriting the previous value in place,
+  so the writes rotate across the whole journal region. The newest value of a counter is the
+  highest one found in valid records written after its last reset, so an interrupted write
+  only loses the update in progress.
+*/
+class RadioLibJournal {
+  public:
+    /*!
+      \brief Default constructor.
+    */
+    RadioLibJournal();
+
+    /*!
+      \brief Load the journal from persistent storage.
+      \param hal Hardware abstraction layer providing the persistent storage.
+      \param addr Address of the journal region.
+      \param len Size of the journal region in bytes.
+    */
+    void begin(RadioLibHal* hal, uint32_t addr, size_t len);
+
+    /*!
+      \brief Get the newest value of a counter.
+      \param id Counter ID.
+      \returns The counter value, 0 if it was never written.
+    */
+    uint32_t read(uint8_t id);
+
+    /*!
+      \brief Append a new value of a counter. The value must not be lower than the current one.
+      \param id Counter ID.
+      \param value New value.
+    */
+    void write(uint8_t id, uint32_t value);
+
+    /*!
+      \brief Reset a counter back to 0 by appending a reset record. All older records of the counter
+      are ignored from then on, so the reset either happens completely, or not at all.
+      \param id Counter ID.
+    */
+    void reset(uint8_t id);
+
+#if !defined(RADIOLIB_GODMODE)
+  private:
+#endif
+    RadioLibHal* hal = NULL;
+    uint32_t addr = 0;
+    uint8_t numSlots = 0;
+
+    // slot where the next record will be written, and its sequence number
+    uint8_t head = 0;
+    uint16_t seq = 0;
+
+    // newest value of each counter and the slot holding it
+    uint32_t values[RADIOLIB_JOURNAL_NUM_IDS];
+    uint8_t slots[RADIOLIB_JOURNAL_NUM_IDS];
+
+    bool readRecord(uint8_t slot, uint8_t* id, uint32_t* value, uint16_t* seq);
+    void writeRecord(uint8_t slot, uint8_t id, uint32_t value, uint16_t seq);
+    uint8_t append(uint8_t id, uint32_t value);
+};
+
+#endif
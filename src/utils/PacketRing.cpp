@@ -0,0 +1,57 @@
+#include "PacketRing.h"
+
+// the position written by one side must only be seen by the other side after the slot itself,
+// use acquire/release ordering where the compiler provides it
+#if defined(__GNUC__)
+  #define RADIOLIB_RING_LOAD(VAR)           __atomic_load_n(&(VAR), __ATOMIC_ACQUIRE)
+  #define RADIOLIB_RING_STORE(VAR, VAL)     __atomic_store_n(&(VAR), (VAL), __ATOMIC_RELEASE)
+#else
+  #define RADIOLIB_RING_LOAD(VAR)           (VAR)
+  #define RADIOLIB_RING_STORE(VAR, VAL)     (VAR) = (VAL)
+#endif
+
+RadioLibPacketRing::RadioLibPacketRing(RadioLibPacket_t* slots, size_t numSlots) {
+  this->slots = slots;
+  this->numSlots = numSlots;
+}
+
+RadioLibPacket_t* RadioLibPacketRing::reserve() {
+  if((this->slots == NULL) || (available() >= this->numSlots)) {
+    return(NULL);
+  }
+  return(&this->slots[this->head % this->numSlots]);
+}
+
+void RadioLibPacketRing::commit() {
+  RADIOLIB_RING_STORE(this->head, next(this->head));
+}
+
+RadioLibPacket_t* RadioLibPacketRing::front() {
+  size_t tail = this->tail;
+  size_t head = RADIOLIB_RING_LOAD(this->head);
+  if((this->slots == NULL) || (head == tail)) {
+    return(NULL);
+  }
+  return(&this->slots[tail % this->numSlots]);
+}
+
+void RadioLibPacketRing::release() {
+  RADIOLIB_RING_STORE(this->tail, next(this->tail));
+}
+
+size_t RadioLibPacketRing::available() {
+  if(this->numSlots == 0) {
+    return(0);
+  }
+  size_t head = RADIOLIB_RING_LOAD(this->head);
+  size_t tail = RADIOLIB_RING_LOAD(this->tail);
+  return((head + 2*this->numSlots - tail) % (2*this->numSlots));
+}
+
+size_t RadioLibPacketRing::next(size_t pos) {
+  pos++;
+  if(pos >= 2*this->numSlots) {
+    pos = 0;
+  }
+  return(pos);
+}
@@ -0,0 +1,93 @@
+#if !defined(_RADIOLIB_PACKET_RING_H)
+#define _RADIOLIB_PACKET_RING_H
+
+#include "../TypeDef.h"
+
+// maximum length of a packet stored in a ring slot
+#if !defined(RADIOLIB_PACKET_RING_MAX_LEN)
+  #define RADIOLIB_PACKET_RING_MAX_LEN                          (255)
+#endif
+
+/*!
+  \struct RadioLibPacket_t
+  \brief Received packet together with its metadata, as stored in a slot of RadioLibPacketRing.
+*/
+struct RadioLibPacket_t {
+  /*! \brief Packet payload */
+  uint8_t data[RADIOLIB_PACKET_RING_MAX_LEN];
+
+  /*! \brief Number of valid bytes in data */
+  size_t len;
+
+  /*! \brief RSSI of the packet in dBm */
+  float rssi;
+
+  /*! \brief SNR of the packet in dB (LoRa only, 0 otherwise) */
+  float snr;
+
+  /*! \brief Timestamp of the moment the packet was read from the radio, in microseconds */
+  uint32_t timestamp;
+
+  /*! \brief Outcome of the reception, e.g. RADIOLIB_ERR_CRC_MISMATCH for packets with invalid CRC */
+  int16_t state;
+};
+
+/*!
+  \class RadioLibPacketRing
+  \brief Lock-free single-producer, single-consumer ring of received packets.
+  The radio reads each packet directly into a free slot (producer side), and another thread or the main loop
+  processes it in place (consumer side), so the payload is never copied. The slots are provided by the user.
+  Only one producer and one consumer may use the ring at the same time.
+*/
+class RadioLibPacketRing {
+  public:
+    /*!
+      \brief Default constructor.
+      \param slots Array of slots to store the packets in.
+      \param numSlots Number of slots in the array.
+    */
+    RadioLibPacketRing(RadioLibPacket_t* slots, size_t numSlots);
+
+    /*!
+      \brief Get the next free slot (producer side). The slot is only passed to the consumer after calling commit.
+      \returns Pointer to the free slot, or NULL if the ring is full.
+    */
+    RadioLibPacket_t* reserve();
+
+    /*!
+      \brief Pass the slot returned by the last call to reserve to the consumer (producer side).
+    */
+    void commit();
+
+    /*!
+      \brief Get the oldest packet in the ring (consumer side). The slot remains valid until release is called.
+      \returns Pointer to the oldest packet, or NULL if the ring is empty.
+    */
+    RadioLibPacket_t* front();
+
+    /*!
+      \brief Return the slot returned by the last call to front back to the producer (consumer side).
+    */
+    void release();
+
+    /*!
+      \brief Get the number of packets waiting in the ring.
+      \returns Number of committed packets that were not released yet.
+    */
+    size_t available();
+
+#if !defined(RADIOLIB_GODMODE)
+  private:
+#endif
+    RadioLibPacket_t* slots;
+    size_t numSlots;
+
+    // positions run from 0 to 2*numSlots, so that full and empty ring can be told apart
+    // head is only written by the producer, tail only by the consumer
+    volatile size_t head = 0;
+    volatile size_t tail = 0;
+
+    size_t next(size_t pos);
+};
+
+#endif